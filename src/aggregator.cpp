@@ -0,0 +1,238 @@
+#include "aggregator.h"
+#include "wifi_scanner.h"
+#include "locator.h"
+#include "logger.h"
+#include "time_base.h"
+#include <LittleFS.h>
+#include <Arduino.h>
+
+// Só alocada no modo de estatísticas (~3,7 KB)
+static AggWindow* window = nullptr;
+
+#define AGG_INDEX_SEED 0x51ED
+static_assert((AGG_INDEX_SLOTS & (AGG_INDEX_SLOTS - 1)) == 0 && AGG_INDEX_SLOTS >= 2 * AGG_AP_SLOTS,
+              "índice precisa ser potência de 2 com ocupação de no máximo 1/2");
+
+static uint32_t hashBssid(const uint8_t* bssid, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (int i = 0; i < 6; i++) {
+    hash = (hash ^ bssid[i]) * 16777619u;
+  }
+  hash ^= hash >> 15;
+  return hash * 0x2C1B3C6Du;
+}
+
+static void resetWindow(unsigned long now) {
+  memset(window, 0, sizeof(*window));
+  window->boot = currentBootId();
+  window->start = now;
+}
+
+bool aggregatorBegin() {
+  if (window) return true;
+  window = (AggWindow*)malloc(sizeof(AggWindow));
+  if (!window) {
+    LOG_E("AGG", "Sem memória para as estatísticas");
+    return false;
+  }
+  resetWindow(timeTicks());
+  LOG_I("AGG", "Estatísticas por janela de %ds (%u bytes)", config.aggregateWindowS, (unsigned)sizeof(AggWindow));
+  return true;
+}
+
+static uint16_t cmsAdd(const uint8_t* bssid) {
+  uint16_t estimate = 0xFFFF;
+  for (int row = 0; row < AGG_CMS_DEPTH; row++) {
+    uint16_t& counter = window->cms[row][hashBssid(bssid, row) % AGG_CMS_WIDTH];
+    if (counter < 0xFFFF) counter++;
+    estimate = min(estimate, counter);
+  }
+  return estimate;
+}
+
+static uint16_t cmsEstimate(const uint8_t* bssid) {
+  uint16_t estimate = 0xFFFF;
+  for (int row = 0; row < AGG_CMS_DEPTH; row++) {
+    estimate = min(estimate, window->cms[row][hashBssid(bssid, row) % AGG_CMS_WIDTH]);
+  }
+  return estimate;
+}
+
+// Sondagem linear a partir do hash; ocupação máxima de 1/2, então sempre
+// há posição livre. Retorna a posição do BSSID ou a livre onde ele entraria
+static int indexProbe(const uint8_t* bssid) {
+  int pos = hashBssid(bssid, AGG_INDEX_SEED) & (AGG_INDEX_SLOTS - 1);
+  while (window->index[pos] && memcmp(window->aps[window->index[pos] - 1].bssid, bssid, 6) != 0) {
+    pos = (pos + 1) & (AGG_INDEX_SLOTS - 1);
+  }
+  return pos;
+}
+
+// Remove sem marcador: puxa para trás os que vinham depois na mesma
+// sequência de sondagem e podem ocupar o buraco
+static void indexRemove(int hole) {
+  int pos = (hole + 1) & (AGG_INDEX_SLOTS - 1);
+  while (window->index[pos]) {
+    int home = hashBssid(window->aps[window->index[pos] - 1].bssid, AGG_INDEX_SEED) & (AGG_INDEX_SLOTS - 1);
+    if (((pos - home) & (AGG_INDEX_SLOTS - 1)) >= ((pos - hole) & (AGG_INDEX_SLOTS - 1))) {
+      window->index[hole] = window->index[pos];
+      hole = pos;
+    }
+    pos = (pos + 1) & (AGG_INDEX_SLOTS - 1);
+  }
+  window->index[hole] = 0;
+}
+
+static int rssiBucket(int rssi) {
+  return constrain((rssi + 100) / 10, 0, AGG_RSSI_BUCKETS - 1);
+}
+
+// Tabela cheia: um AP novo só entra no lugar do menos visto se o count-min
+// disser que ele já apareceu mais vezes (heavy hitters)
+static void updateAp(const WiFiNetwork& net, const uint8_t* bssid, uint16_t estimate) {
+  int pos = indexProbe(bssid);
+  AggAp* slot = window->index[pos] ? &window->aps[window->index[pos] - 1] : nullptr;
+
+  if (!slot) {
+    if (window->apCount < AGG_AP_SLOTS) {
+      slot = &window->aps[window->apCount++];
+    } else {
+      // Os counts só crescem: abaixo do menor já visto, nem procura
+      if (estimate <= window->minCount) return;
+      AggAp* weakest = &window->aps[0];
+      for (int i = 1; i < AGG_AP_SLOTS; i++) {
+        if (window->aps[i].count < weakest->count) weakest = &window->aps[i];
+      }
+      window->minCount = weakest->count;
+      if (estimate <= weakest->count) return;
+      indexRemove(indexProbe(weakest->bssid));
+      pos = indexProbe(bssid); // a remoção pode ter deslocado a posição livre
+      slot = weakest;
+      window->minCount = 1; // o novo AP entra com count 1
+      window->evicted++;
+    }
+    window->index[pos] = slot - window->aps + 1;
+    memcpy(slot->bssid, bssid, 6);
+    slot->rssiMin = 0;
+    slot->rssiMax = -128;
+    slot->count = 0;
+    slot->rssiSum = 0;
+  }
+
+  slot->channel = net.channel;
+  slot->rssiMin = slot->count == 0 ? net.rssi : min((int)slot->rssiMin, net.rssi);
+  slot->rssiMax = max((int)slot->rssiMax, net.rssi);
+  slot->rssiSum += net.rssi;
+  if (slot->count < 0xFFFF) slot->count++;
+}
+
+static String formatBssid(const uint8_t* bssid) {
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+           bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
+  return String(buf);
+}
+
+// Contagem linear: n ~ -m ln(zeros / m)
+static uint32_t distinctEstimate() {
+  int zeros = 0;
+  for (int i = 0; i < AGG_DISTINCT_BITS / 8; i++) {
+    for (int bit = 0; bit < 8; bit++) {
+      if (!(window->distinct[i] & (1 << bit))) zeros++;
+    }
+  }
+  if (zeros == 0) zeros = 1;
+  return (uint32_t)(-(float)AGG_DISTINCT_BITS * log((float)zeros / AGG_DISTINCT_BITS) + 0.5f);
+}
+
+static void writeWindow() {
+  // canais: [canal, avistamentos, máx por scan, [histograma de RSSI]]
+  String data = "{\"boot\":" + String(window->boot);
+  data += ",\"start\":" + String(window->start);
+  data += ",\"end\":" + String(window->last);
+  data += ",\"scans\":" + String(window->scans);
+  data += ",\"sightings\":" + String(window->sightings);
+  data += ",\"distinct\":" + String(distinctEstimate());
+  data += ",\"evicted\":" + String(window->evicted);
+  data += ",\"channels\":[";
+  bool first = true;
+  for (int c = 0; c < AGG_CHANNELS; c++) {
+    const AggChannel& ch = window->channels[c];
+    if (ch.sightings == 0) continue;
+    if (!first) data += ",";
+    first = false;
+    data += "[" + String(c + 1) + "," + String(ch.sightings) + "," + String(ch.maxPerScan) + ",[";
+    for (int b = 0; b < AGG_RSSI_BUCKETS; b++) {
+      if (b > 0) data += ",";
+      data += String(ch.histogram[b]);
+    }
+    data += "]]";
+  }
+
+  // aps: [bssid, canal, vezes na tabela, mín, médio, máx, estimativa do count-min],
+  // os mais vistos primeiro
+  data += "],\"aps\":[";
+  bool reported[AGG_AP_SLOTS] = {false};
+  for (int n = 0; n < min(window->apCount, (uint8_t)AGG_REPORT_APS); n++) {
+    int best = -1;
+    for (int i = 0; i < window->apCount; i++) {
+      if (!reported[i] && (best < 0 || window->aps[i].count > window->aps[best].count)) best = i;
+    }
+    reported[best] = true;
+    const AggAp& ap = window->aps[best];
+    if (n > 0) data += ",";
+    data += "[\"" + formatBssid(ap.bssid) + "\"," + String(ap.channel) + "," + String(ap.count);
+    data += "," + String(ap.rssiMin) + "," + String(ap.rssiSum / ap.count) + "," + String(ap.rssiMax);
+    data += "," + String(cmsEstimate(ap.bssid)) + "]";
+  }
+  data += "]}";
+
+  String filename = "/agg_" + String(window->boot) + "_" + String(window->start) + ".json";
+  File file = LittleFS.open(filename.c_str(), "w");
+  if (file) {
+    file.print(data);
+    file.close();
+  }
+  LOG_I("AGG", "Janela encerrada: %u scans, %u APs (~%u distintos), %u bytes", window->scans,
+        window->apCount, (unsigned)distinctEstimate(), data.length());
+}
+
+void aggregateFlush() {
+  if (!window) return;
+  if (window->scans > 0) writeWindow();
+  resetWindow(timeTicks());
+}
+
+void aggregateScan(const WiFiNetwork* nets, int count, unsigned long now) {
+  if (!window && !aggregatorBegin()) return;
+  if (window->scans > 0 && now - window->start >= (unsigned long)config.aggregateWindowS * 1000) {
+    writeWindow();
+    resetWindow(now);
+  }
+
+  if (window->scans == 0) window->start = now;
+
+  uint8_t perChannel[AGG_CHANNELS] = {0};
+  for (int i = 0; i < count; i++) {
+    uint8_t bssid[6];
+    if (isOwnNetwork(nets[i].ssid) || !parseBssid(nets[i].bssid, bssid)) continue;
+
+    if (nets[i].channel >= 1 && nets[i].channel <= AGG_CHANNELS) {
+      AggChannel& ch = window->channels[nets[i].channel - 1];
+      uint16_t& bucket = ch.histogram[rssiBucket(nets[i].rssi)];
+      if (bucket < 0xFFFF) bucket++;
+      ch.sightings++;
+      perChannel[nets[i].channel - 1]++;
+    }
+    uint32_t bit = hashBssid(bssid, 0x9E37) % AGG_DISTINCT_BITS;
+    window->distinct[bit / 8] |= 1 << (bit % 8);
+    updateAp(nets[i], bssid, cmsAdd(bssid));
+    window->sightings++;
+  }
+
+  for (int c = 0; c < AGG_CHANNELS; c++) {
+    window->channels[c].maxPerScan = max(window->channels[c].maxPerScan, perChannel[c]);
+  }
+  window->scans++;
+  window->last = now;
+}
@@ -0,0 +1,57 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include "config.h"
+#include <Arduino.h>
+
+// Estatísticas por janela (modo RECORD_AGGREGATE), em memória fixa: o
+// resumo de uma janela tem o mesmo tamanho máximo em qualquer ambiente.
+#define AGG_CHANNELS 14
+#define AGG_RSSI_BUCKETS 8      // faixas de 10 dB: < -90, -90..-81, ..., >= -30
+#define AGG_AP_SLOTS 64         // APs com RSSI mín/médio/máx por janela
+#define AGG_INDEX_SLOTS 128     // índice por hash do BSSID sobre aps (potência de 2)
+#define AGG_REPORT_APS 32       // os mais vistos entram no resumo
+#define AGG_CMS_DEPTH 4         // count-min: linhas x colunas de contadores
+#define AGG_CMS_WIDTH 256
+#define AGG_DISTINCT_BITS 1024  // contagem linear de APs distintos
+#define AGG_DEFAULT_WINDOW_S 300
+
+struct AggChannel {
+  uint16_t histogram[AGG_RSSI_BUCKETS];
+  uint32_t sightings;
+  uint8_t maxPerScan;
+};
+
+struct AggAp {
+  uint8_t bssid[6];
+  uint8_t channel;
+  int8_t rssiMin;
+  int8_t rssiMax;
+  uint16_t count; // desde que entrou na tabela
+  int32_t rssiSum;
+};
+
+struct AggWindow {
+  uint32_t boot;
+  unsigned long start;
+  unsigned long last;
+  uint16_t scans;
+  uint32_t sightings;
+  AggChannel channels[AGG_CHANNELS];
+  AggAp aps[AGG_AP_SLOTS];
+  uint8_t index[AGG_INDEX_SLOTS]; // endereçamento aberto: posição em aps + 1, 0 = livre
+  uint8_t apCount;
+  uint16_t minCount; // tabela cheia: nenhum AP tem count menor que isso
+  uint16_t evicted;
+  uint16_t cms[AGG_CMS_DEPTH][AGG_CMS_WIDTH];
+  uint8_t distinct[AGG_DISTINCT_BITS / 8];
+};
+
+bool aggregatorBegin();
+// Soma o scan à janela; fecha e grava a janela anterior quando ela passou de
+// config.aggregateWindowS
+void aggregateScan(const WiFiNetwork* nets, int count, unsigned long now);
+// Grava a janela aberta (se tiver scans) e começa outra
+void aggregateFlush();
+
+#endif
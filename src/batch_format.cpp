@@ -0,0 +1,393 @@
+#include "batch_format.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ---- escrita ----
+
+static void putByte(BatchWriter& w, uint8_t value) {
+  if (w.length >= w.capacity) {
+    w.overflow = true;
+    return;
+  }
+  w.buf[w.length++] = value;
+}
+
+static void putBytes(BatchWriter& w, const void* data, size_t length) {
+  if (w.length + length > w.capacity) {
+    w.overflow = true;
+    return;
+  }
+  memcpy(w.buf + w.length, data, length);
+  w.length += length;
+}
+
+static void putVarint(BatchWriter& w, uint64_t value) {
+  while (value >= 0x80) {
+    putByte(w, (uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  putByte(w, (uint8_t)value);
+}
+
+static void putZigzag(BatchWriter& w, int64_t value) {
+  putVarint(w, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void putSsid(BatchWriter& w, const char* ssid) {
+  size_t length = strnlen(ssid, 32);
+  for (int i = 0; i < w.ssidCount; i++) {
+    const uint8_t* literal = w.buf + w.ssidOffsets[i];
+    if (literal[0] == length && memcmp(literal + 1, ssid, length) == 0) {
+      putVarint(w, i + 1);
+      return;
+    }
+  }
+  putVarint(w, 0);
+  if (w.ssidCount < BATCH_SSID_DICT) w.ssidOffsets[w.ssidCount++] = w.length;
+  putByte(w, (uint8_t)length);
+  putBytes(w, ssid, length);
+}
+
+static void putBssid(BatchWriter& w, const uint8_t* bssid) {
+  for (int i = 0; i < w.bssidCount; i++) {
+    if (memcmp(w.buf + w.bssidOffsets[i], bssid, 6) == 0) {
+      putVarint(w, i + 1);
+      return;
+    }
+  }
+  putVarint(w, 0);
+  if (w.bssidCount < BATCH_BSSID_DICT) w.bssidOffsets[w.bssidCount++] = w.length;
+  putBytes(w, bssid, 6);
+}
+
+void batchBegin(BatchWriter& w, uint8_t* buf, size_t capacity, const char* bikeId) {
+  memset(&w, 0, sizeof(w));
+  w.buf = buf;
+  w.capacity = capacity;
+
+  size_t idLength = strnlen(bikeId, BATCH_BIKE_ID_MAX);
+  putBytes(w, BATCH_MAGIC, 4);
+  putByte(w, BATCH_VERSION);
+  putByte(w, 0);
+  putByte(w, (uint8_t)idLength);
+  putBytes(w, bikeId, idLength);
+  w.countOffset = w.length;
+  putByte(w, 0);
+  putByte(w, 0);
+}
+
+bool batchAdd(BatchWriter& w, const BatchRecord& r) {
+  if (w.overflow || w.recordCount == 0xFFFF) return false;
+
+  // Guarda o estado para desfazer o registro se não couber
+  size_t start = w.length;
+  uint8_t ssidCount = w.ssidCount;
+  uint8_t bssidCount = w.bssidCount;
+
+  putByte(w, r.type);
+  putVarint(w, r.boot);
+  if (w.recordCount > 0 && r.boot == w.lastBoot) {
+    putZigzag(w, (int64_t)r.ticks - (int64_t)w.lastTicks);
+  } else {
+    putVarint(w, r.ticks);
+  }
+  putZigzag(w, (int64_t)r.epoch - (int64_t)w.lastEpoch);
+
+  switch (r.type) {
+    case BATCH_SCAN:
+      putByte(w, r.networkCount);
+      for (int i = 0; i < r.networkCount; i++) {
+        putSsid(w, r.networks[i].ssid);
+        putBssid(w, r.networks[i].bssid);
+        putByte(w, (uint8_t)r.networks[i].rssi);
+        putByte(w, r.networks[i].channel);
+      }
+      break;
+    case BATCH_POSITION:
+      putZigzag(w, r.latE7);
+      putZigzag(w, r.lonE7);
+      putByte(w, r.confidence);
+      putByte(w, r.matched);
+      break;
+    default:
+      putVarint(w, r.jsonLength);
+      putBytes(w, r.json, r.jsonLength);
+      break;
+  }
+
+  if (w.overflow) {
+    w.length = start;
+    w.ssidCount = ssidCount;
+    w.bssidCount = bssidCount;
+    w.overflow = false;
+    return false;
+  }
+
+  w.lastBoot = r.boot;
+  w.lastTicks = r.ticks;
+  w.lastEpoch = r.epoch;
+  w.recordCount++;
+  return true;
+}
+
+size_t batchFinish(BatchWriter& w) {
+  w.buf[w.countOffset] = w.recordCount & 0xFF;
+  w.buf[w.countOffset + 1] = w.recordCount >> 8;
+  return w.length;
+}
+
+// ---- leitura ----
+
+static uint8_t getByte(BatchReader& r) {
+  if (r.pos >= r.length) {
+    r.error = true;
+    return 0;
+  }
+  return r.buf[r.pos++];
+}
+
+static uint64_t getVarint(BatchReader& r) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8_t b = getByte(r);
+    value |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return value;
+  }
+  r.error = true;
+  return 0;
+}
+
+static int64_t getZigzag(BatchReader& r) {
+  uint64_t value = getVarint(r);
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void getSsid(BatchReader& r, char* out) {
+  uint64_t index = getVarint(r);
+  size_t offset;
+  if (index == 0) {
+    offset = r.pos;
+    if (r.ssidCount < BATCH_SSID_DICT) r.ssidOffsets[r.ssidCount++] = offset;
+    r.pos += 1 + (r.pos < r.length ? r.buf[r.pos] : 0);
+  } else if (index <= r.ssidCount) {
+    offset = r.ssidOffsets[index - 1];
+  } else {
+    r.error = true;
+    out[0] = '\0';
+    return;
+  }
+  if (r.pos > r.length || r.buf[offset] > 32) {
+    r.error = true;
+    out[0] = '\0';
+    return;
+  }
+  memcpy(out, r.buf + offset + 1, r.buf[offset]);
+  out[r.buf[offset]] = '\0';
+}
+
+static void getBssid(BatchReader& r, uint8_t* out) {
+  uint64_t index = getVarint(r);
+  size_t offset;
+  if (index == 0) {
+    offset = r.pos;
+    if (r.bssidCount < BATCH_BSSID_DICT) r.bssidOffsets[r.bssidCount++] = offset;
+    r.pos += 6;
+  } else if (index <= r.bssidCount) {
+    offset = r.bssidOffsets[index - 1];
+  } else {
+    r.error = true;
+    return;
+  }
+  if (r.pos > r.length) {
+    r.error = true;
+    return;
+  }
+  memcpy(out, r.buf + offset, 6);
+}
+
+bool batchOpen(BatchReader& r, const uint8_t* buf, size_t length) {
+  memset(&r, 0, sizeof(r));
+  r.buf = buf;
+  r.length = length;
+
+  if (length < 9 || memcmp(buf, BATCH_MAGIC, 4) != 0 || buf[4] != BATCH_VERSION) {
+    r.error = true;
+    return false;
+  }
+  r.pos = 5;
+  r.flags = getByte(r);
+  uint8_t idLength = getByte(r);
+  if (idLength > BATCH_BIKE_ID_MAX || r.pos + idLength + 2 > length) {
+    r.error = true;
+    return false;
+  }
+  memcpy(r.bikeId, buf + r.pos, idLength);
+  r.bikeId[idLength] = '\0';
+  r.pos += idLength;
+  r.remaining = getByte(r);
+  r.remaining |= getByte(r) << 8;
+  r.total = r.remaining;
+
+  // Compressão ainda não definida: rejeita em vez de ler lixo
+  if (r.flags & BATCH_FLAG_COMPRESSED) r.error = true;
+  return !r.error;
+}
+
+bool batchNext(BatchReader& r, BatchRecord& record) {
+  if (r.error || r.remaining == 0) return false;
+
+  bool first = r.remaining == r.total;
+  memset(&record, 0, sizeof(record));
+  record.type = getByte(r);
+  record.boot = getVarint(r);
+  if (!first && record.boot == r.lastBoot) {
+    record.ticks = (uint32_t)(r.lastTicks + getZigzag(r));
+  } else {
+    record.ticks = getVarint(r);
+  }
+  record.epoch = (uint32_t)(r.lastEpoch + getZigzag(r));
+
+  switch (record.type) {
+    case BATCH_SCAN:
+      record.networkCount = getByte(r);
+      if (record.networkCount > BATCH_MAX_NETWORKS) {
+        r.error = true;
+        return false;
+      }
+      for (int i = 0; i < record.networkCount && !r.error; i++) {
+        getSsid(r, record.networks[i].ssid);
+        getBssid(r, record.networks[i].bssid);
+        record.networks[i].rssi = (int8_t)getByte(r);
+        record.networks[i].channel = getByte(r);
+      }
+      break;
+    case BATCH_POSITION:
+      record.latE7 = (int32_t)getZigzag(r);
+      record.lonE7 = (int32_t)getZigzag(r);
+      record.confidence = getByte(r);
+      record.matched = getByte(r);
+      break;
+    case BATCH_TRIP:
+    case BATCH_STATUS:
+    case BATCH_SUMMARY:
+      record.jsonLength = getVarint(r);
+      if (r.pos + record.jsonLength > r.length) {
+        r.error = true;
+        return false;
+      }
+      record.json = (const char*)r.buf + r.pos;
+      r.pos += record.jsonLength;
+      break;
+    default:
+      r.error = true;
+      return false;
+  }
+
+  if (r.error) return false;
+  r.lastBoot = record.boot;
+  r.lastTicks = record.ticks;
+  r.lastEpoch = record.epoch;
+  r.remaining--;
+  return true;
+}
+
+// ---- registro compacto do storeData() ----
+
+static const char* skipSpaces(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+  return p;
+}
+
+static const char* parseNumber(const char* p, const char* end, long long& value) {
+  p = skipSpaces(p, end);
+  char* stop;
+  value = strtoll(p, &stop, 10);
+  return stop == p || stop > end ? nullptr : stop;
+}
+
+static const char* expect(const char* p, const char* end, char c) {
+  p = skipSpaces(p, end);
+  return p < end && *p == c ? p + 1 : nullptr;
+}
+
+static const char* parseString(const char* p, const char* end, char* out, size_t max) {
+  p = expect(p, end, '"');
+  if (!p) return nullptr;
+  size_t n = 0;
+  while (p < end && *p != '"') {
+    if (*p == '\\' && p + 1 < end) p++;
+    if (n < max - 1) out[n++] = *p;
+    p++;
+  }
+  out[n] = '\0';
+  return p < end ? p + 1 : nullptr;
+}
+
+static bool parseBssidText(const char* text, uint8_t* out) {
+  for (int i = 0; i < 6; i++) {
+    char* stop;
+    long value = strtol(text, &stop, 16);
+    if (stop == text || value < 0 || value > 255) return false;
+    if (i < 5 && *stop != ':') return false;
+    out[i] = (uint8_t)value;
+    text = stop + 1;
+  }
+  return true;
+}
+
+bool parseScanRecord(const char* text, size_t length, BatchRecord& record) {
+  const char* end = text + length;
+  long long value;
+  memset(&record, 0, sizeof(record));
+
+  const char* p = expect(text, end, '[');
+  if (!p || !(p = parseNumber(p, end, value))) return false;
+  record.ticks = (uint32_t)value;
+  if (!(p = expect(p, end, ',')) || !(p = parseNumber(p, end, value))) return false;
+  record.epoch = (uint32_t)value;
+  if (!(p = expect(p, end, ',')) || !(p = expect(p, end, '['))) return false;
+
+  p = skipSpaces(p, end);
+  if (p < end && (*p == '[' || *p == ']')) {
+    // Lista de redes: [[ssid,bssid,rssi,canal],...]
+    record.type = BATCH_SCAN;
+    while ((p = skipSpaces(p, end)) < end && *p == '[') {
+      if (record.networkCount >= BATCH_MAX_NETWORKS) return false;
+      BatchNetwork& net = record.networks[record.networkCount++];
+      char bssid[18];
+      if (!(p = parseString(p + 1, end, net.ssid, sizeof(net.ssid)))) return false;
+      if (!(p = expect(p, end, ',')) || !(p = parseString(p, end, bssid, sizeof(bssid)))) return false;
+      if (!parseBssidText(bssid, net.bssid)) return false;
+      if (!(p = expect(p, end, ',')) || !(p = parseNumber(p, end, value))) return false;
+      net.rssi = (int8_t)value;
+      if (!(p = expect(p, end, ',')) || !(p = parseNumber(p, end, value))) return false;
+      net.channel = (uint8_t)value;
+      if (!(p = expect(p, end, ']'))) return false;
+      p = skipSpaces(p, end);
+      if (p < end && *p == ',') p++;
+    }
+    if (!(p = expect(p, end, ']'))) return false;
+  } else {
+    // Posição: [latE7,lonE7,confiança,aps]
+    record.type = BATCH_POSITION;
+    long long fields[4];
+    for (int i = 0; i < 4; i++) {
+      if (i > 0 && !(p = expect(p, end, ','))) return false;
+      if (!(p = parseNumber(p, end, fields[i]))) return false;
+    }
+    record.latE7 = (int32_t)fields[0];
+    record.lonE7 = (int32_t)fields[1];
+    record.confidence = (uint8_t)fields[2];
+    record.matched = (uint8_t)fields[3];
+    if (!(p = expect(p, end, ']'))) return false;
+  }
+
+  // Boot (ausente no formato antigo)
+  const char* q = expect(p, end, ',');
+  if (q) {
+    if (!(q = parseNumber(q, end, value))) return false;
+    record.boot = (uint32_t)value;
+    p = q;
+  }
+  return expect(p, end, ']') != nullptr;
+}
@@ -0,0 +1,110 @@
+#ifndef BATCH_FORMAT_H
+#define BATCH_FORMAT_H
+
+// Formato binário de lote para o coletor próprio. Só C++ puro: compilado
+// tanto no firmware quanto nas ferramentas do host (tools/collector).
+//
+// Lote:     "BPRB" | versão u8 | flags u8 | len u8 + bikeId | registros u16 | registros...
+// Registro: tipo u8 | boot varint | ticks varint* | época varint zigzag (delta) | corpo
+//   * delta zigzag do registro anterior quando o boot é o mesmo, senão absoluto
+// Corpo:
+//   SCAN:     n u8 | n x (ssid | bssid | rssi i8 | canal u8)
+//   POSITION: latE7 zigzag | lonE7 zigzag | confiança u8 | aps u8
+//   TRIP/STATUS/SUMMARY: len varint | JSON
+// SSID e BSSID usam dicionário por lote: varint 0 + literal na primeira
+// vez (len u8 + bytes / 6 bytes), índice+1 depois. Os dois lados só
+// adicionam ao dicionário enquanto ele não está cheio.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BATCH_MAGIC "BPRB"
+#define BATCH_VERSION 1
+#define BATCH_FLAG_COMPRESSED 0x01 // reservado; ainda não usado
+#define BATCH_MAX_NETWORKS 10
+#define BATCH_SSID_DICT 64
+#define BATCH_BSSID_DICT 128
+#define BATCH_BIKE_ID_MAX 16
+
+// Pior caso em bytes, para dimensionar buffers: cabeçalho com o bikeId mais
+// longo e um varint de 32 bits (ou zigzag de um delta entre dois uint32)
+#define BATCH_HEADER_MAX (4 + 1 + 1 + 1 + BATCH_BIKE_ID_MAX + 2)
+#define BATCH_VARINT_MAX 5
+// Registro TRIP/STATUS/SUMMARY sem o JSON: tipo, boot, ticks, época, tamanho
+#define BATCH_JSON_RECORD_MAX (1 + 4 * BATCH_VARINT_MAX)
+
+enum BatchRecordType {
+  BATCH_SCAN = 1,
+  BATCH_POSITION = 2,
+  BATCH_TRIP = 3,
+  BATCH_STATUS = 4,
+  BATCH_SUMMARY = 5, // resumo de janela de estatísticas (aggregator.h)
+};
+
+struct BatchNetwork {
+  char ssid[33];
+  uint8_t bssid[6];
+  int8_t rssi;
+  uint8_t channel;
+};
+
+struct BatchRecord {
+  uint8_t type;
+  uint32_t boot;
+  uint32_t ticks;
+  uint32_t epoch; // 0 = desconhecida
+  uint8_t networkCount;
+  BatchNetwork networks[BATCH_MAX_NETWORKS];
+  int32_t latE7;
+  int32_t lonE7;
+  uint8_t confidence;
+  uint8_t matched;
+  const char* json; // TRIP/STATUS; aponta para o buffer de origem
+  uint16_t jsonLength;
+};
+
+struct BatchWriter {
+  uint8_t* buf;
+  size_t capacity;
+  size_t length;
+  bool overflow;
+  size_t countOffset;
+  uint16_t recordCount;
+  uint32_t lastBoot;
+  uint32_t lastTicks;
+  uint32_t lastEpoch;
+  uint16_t ssidOffsets[BATCH_SSID_DICT]; // posição do literal no próprio buffer
+  uint8_t ssidCount;
+  uint16_t bssidOffsets[BATCH_BSSID_DICT];
+  uint8_t bssidCount;
+};
+
+struct BatchReader {
+  const uint8_t* buf;
+  size_t length;
+  size_t pos;
+  bool error;
+  char bikeId[BATCH_BIKE_ID_MAX + 1];
+  uint8_t flags;
+  uint16_t total;
+  uint16_t remaining;
+  uint32_t lastBoot;
+  uint32_t lastTicks;
+  uint32_t lastEpoch;
+  uint16_t ssidOffsets[BATCH_SSID_DICT];
+  uint8_t ssidCount;
+  uint16_t bssidOffsets[BATCH_BSSID_DICT];
+  uint8_t bssidCount;
+};
+
+// Registro compacto gravado por storeData(): [ticks,realTime,dados,boot]
+bool parseScanRecord(const char* text, size_t length, BatchRecord& record);
+
+void batchBegin(BatchWriter& writer, uint8_t* buf, size_t capacity, const char* bikeId);
+bool batchAdd(BatchWriter& writer, const BatchRecord& record);
+size_t batchFinish(BatchWriter& writer);
+
+bool batchOpen(BatchReader& reader, const uint8_t* buf, size_t length);
+bool batchNext(BatchReader& reader, BatchRecord& record);
+
+#endif
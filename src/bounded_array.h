@@ -0,0 +1,69 @@
+#ifndef BOUNDED_ARRAY_H
+#define BOUNDED_ARRAY_H
+
+#include <stddef.h>
+
+// Vetor de capacidade fixa N: memória estática, sem alocação. push() falha
+// (retorna false) quando cheio em vez de escrever fora do array
+template <typename T, size_t N>
+class BoundedArray {
+ public:
+  static constexpr size_t kCapacity = N;
+
+  bool push(const T& item) {
+    if (count >= N) return false;
+    items[count++] = item;
+    return true;
+  }
+  // Próxima posição livre, para preencher no lugar; nullptr quando cheio
+  T* append() {
+    return count < N ? &items[count++] : nullptr;
+  }
+  void clear() { count = 0; }
+  // Só encurta: usado depois de compactar no lugar
+  void truncate(size_t n) {
+    if (n < count) count = n;
+  }
+
+  size_t size() const { return count; }
+  bool full() const { return count >= N; }
+  T* data() { return items; }
+  const T* data() const { return items; }
+  T& operator[](size_t i) { return items[i]; }
+  const T& operator[](size_t i) const { return items[i]; }
+
+ private:
+  T items[N];
+  size_t count = 0;
+};
+
+// Histórico circular dos N últimos itens: push() descarta o mais antigo
+// quando cheio, sem deslocar os outros. [0] é o mais antigo
+template <typename T, size_t N>
+class RingHistory {
+ public:
+  static constexpr size_t kCapacity = N;
+
+  T& push() {
+    size_t slot = (head + count) % N;
+    if (count < N) {
+      count++;
+    } else {
+      head = (head + 1) % N;
+    }
+    return items[slot];
+  }
+  void push(const T& item) { push() = item; }
+  void clear() { head = count = 0; }
+
+  size_t size() const { return count; }
+  const T& operator[](size_t i) const { return items[(head + i) % N]; }
+  const T& back() const { return (*this)[count - 1]; }
+
+ private:
+  T items[N];
+  size_t head = 0;
+  size_t count = 0;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "capacity.h"
+#include "config.h"
+#include "status_tracker.h"
+#include "batch_format.h"
+#include "logger.h"
+#include "web_server.h"
+#include "aggregator.h"
+#include "trip_segmenter.h"
+#include "known_aps.h"
+#include "known_aps_format.h"
+#include "locator.h"
+#include <stddef.h>
+
+// Conferência do perfil na compilação. Os tamanhos são os do ESP8266 (long,
+// size_t e ponteiros de 4 bytes), calculados campo a campo para a conta
+// valer também no host de 64 bits, onde as estruturas crescem
+constexpr size_t align4(size_t n) {
+  return (n + 3) & ~(size_t)3;
+}
+constexpr size_t ESP_WIFI_NETWORK = align4(SSID_LEN + BSSID_STR_LEN) + 3 * 4; // + rssi, canal, criptografia
+constexpr size_t ESP_CONNECTION_EVENT = align4(4 + 4 + SSID_LEN + IP_STR_LEN + 1);
+constexpr size_t ESP_BATTERY_EVENT = 4 + 4 + 4;
+// start e last são unsigned long; do vetor de canais em diante nada muda
+constexpr size_t ESP_AGG_WINDOW =
+    4 + 4 + 4 + 4 + 4 +
+    align4(offsetof(AggWindow, distinct) + sizeof(AggWindow::distinct) - offsetof(AggWindow, channels));
+constexpr size_t ESP_TRIP_DWELL = 4 + 4 + align4(6);
+constexpr size_t ESP_TRIP_WAYPOINT = 4 + align4(6 + 1) + 4 + 4;
+constexpr size_t ESP_TRIP_SUMMARY = align4(4 + 4 + 1 + 1 + 2 + TRIP_MAX_STATIONS + 1) +
+                                    TRIP_MAX_DWELLS * ESP_TRIP_DWELL + 4 +
+                                    TRIP_MAX_WAYPOINTS * ESP_TRIP_WAYPOINT + 4;
+// Arquivo aberto no LittleFS: objeto do arquivo, lfs_file_t e cache de 64
+// bytes (cache_size do core), com folga para o cabeçalho do malloc
+constexpr size_t LFS_OPEN_FILE_BYTES = 192;
+// Buffer do Updater (um setor de flash), alocado só durante o OTA
+constexpr size_t OTA_UPDATER_BYTES = 4096;
+
+// BoundedArray guarda count; RingHistory, head e count (size_t)
+constexpr size_t capacityProfileBytes() {
+  return CAPACITY.scanNetworks * ESP_WIFI_NETWORK + 4 +
+         CAPACITY.connectionHistory * ESP_CONNECTION_EVENT + 8 +
+         CAPACITY.batteryHistory * ESP_BATTERY_EVENT + 8 + LOG_BUFFER_SIZE;
+}
+
+// Sempre presentes: resumo da viagem e assinatura do segmentador; contadores,
+// cabeçalho e arquivo aberto do filtro de APs conhecidos
+constexpr size_t capacityFixedBytes() {
+  return ESP_TRIP_SUMMARY + TRIP_SIGNATURE_SIZE * 4 +
+         KNOWN_COUNTER_SLOTS * 8 + sizeof(KnownApsHeader) + LFS_OPEN_FILE_BYTES;
+}
+
+// Um modo de registro por vez: janela do agregador (malloc) ou blocos do
+// índice de APs da localização (malloc) com o índice aberto
+constexpr size_t capacityModeBytes() {
+  return ESP_AGG_WINDOW > AP_INDEX_FENCE_MAX * 6 + LFS_OPEN_FILE_BYTES
+             ? ESP_AGG_WINDOW
+             : AP_INDEX_FENCE_MAX * 6 + LFS_OPEN_FILE_BYTES;
+}
+
+constexpr size_t capacityRamBytes() {
+  return capacityProfileBytes() + capacityFixedBytes() + capacityModeBytes();
+}
+
+static_assert(sizeof(void*) != 4 ||
+                  capacityProfileBytes() == sizeof(ScanNetworks) + sizeof(ConnectionHistory) +
+                                                sizeof(BatteryHistory) + LOG_BUFFER_SIZE,
+              "tamanhos de 32 bits em capacity.cpp desatualizados");
+static_assert(sizeof(void*) != 4 || (ESP_AGG_WINDOW == sizeof(AggWindow) &&
+                                     ESP_TRIP_SUMMARY == sizeof(TripSummary)),
+              "tamanhos de 32 bits do agregador/viagem em capacity.cpp desatualizados");
+static_assert(capacityRamBytes() <= CAPACITY.ramBudget(),
+              "buffers do perfil passam do limite de RAM (HEAP_AT_BOOT - minFreeHeap)");
+static_assert(WEB_MIN_HEAP <= HEAP_WEB_RESERVE, "reserva do portal menor que WEB_MIN_HEAP");
+static_assert(CAPACITY.minFreeHeap >= HEAP_WEB_RESERVE, "minFreeHeap não cobre o portal");
+static_assert(CAPACITY.minFreeHeap >= (CAPACITY.firebase ? HEAP_TLS_PEAK : HEAP_TCP_PEAK),
+              "minFreeHeap não cobre o pico do upload");
+// O OTA só roda pelo coletor, depois do upload e com a conexão dele fechada
+static_assert(OTA_UPDATER_BYTES + LFS_OPEN_FILE_BYTES <= HEAP_TCP_PEAK, "buffer do OTA acima do pico do coletor");
+static_assert(CAPACITY.topK >= 1 && CAPACITY.topK <= CAPACITY.maxTopK, "topK padrão fora do limite do perfil");
+static_assert(CAPACITY.maxTopK <= CAPACITY.scanNetworks, "maxTopK maior que as redes guardadas do scan");
+static_assert(CAPACITY.maxTopK <= BATCH_MAX_NETWORKS, "maxTopK não cabe num registro do lote");
+static_assert(CAPACITY.connectionHistory > 0 && CAPACITY.batteryHistory > 0, "histórico vazio");
+
+size_t capacityRamUsage() {
+  return capacityRamBytes();
+}
+
+static uint32_t bootHeap = 0;
+
+void capacityCheckHeap() {
+  bootHeap = ESP.getFreeHeap();
+  if (bootHeap < CAPACITY.minFreeHeap) {
+    LOG_W("CAP", "Heap livre no boot: %u bytes, abaixo dos %u do perfil %s", (unsigned)bootHeap,
+          (unsigned)CAPACITY.minFreeHeap, CAPACITY.name);
+  } else {
+    LOG_I("CAP", "Heap livre no boot: %u bytes (perfil %s pede %u)", (unsigned)bootHeap, CAPACITY.name,
+          (unsigned)CAPACITY.minFreeHeap);
+  }
+}
+
+uint32_t capacityBootHeap() {
+  return bootHeap;
+}
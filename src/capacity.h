@@ -0,0 +1,77 @@
+#ifndef CAPACITY_H
+#define CAPACITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Perfis de capacidade: tamanhos dos buffers fixos escolhidos na compilação
+// (-D CAPACITY_PROFILE=... no platformio.ini), sem custo em tempo de
+// execução. Os limites de RAM de cada perfil são conferidos por
+// static_assert em capacity.cpp
+#define CAPACITY_LOW_MEMORY 0 // bateria longa: menos redes e histórico curto
+#define CAPACITY_STANDARD 1
+#define CAPACITY_SURVEY_MAX 2 // levantamento detalhado: todas as redes do scan
+
+#ifndef CAPACITY_PROFILE
+#define CAPACITY_PROFILE CAPACITY_STANDARD
+#endif
+
+// HEAP_AT_BOOT: heap livre no setup() de um nodemcuv2 com o WiFi ligado,
+// somado aos buffers que capacityRamBytes() conta (os de .bss já saíram
+// dele). É uma referência, não uma medida deste build: o setup() lê
+// ESP.getFreeHeap() depois de alocar tudo, registra no log e no status
+// (heapBoot) e avisa quando sobra menos que o minFreeHeap do perfil.
+// Cada perfil diz quanto precisa sobrar; o resto é o limite dos buffers
+#define HEAP_AT_BOOT 40960
+// Picos acima do heap do boot, medidos com tools/replay (city_ride). O
+// portal e os uploads não rodam juntos: o modo configuração para a coleta
+#define HEAP_TLS_PEAK 24576   // upload ao Firebase (~23 KB)
+#define HEAP_TCP_PEAK 14336   // upload ao coletor próprio (~13,5 KB)
+#define HEAP_WEB_RESERVE 8192 // WEB_MIN_HEAP do portal de configuração
+
+struct CapacityProfile {
+  const char* name;
+  uint8_t scanNetworks;      // redes guardadas de cada scan (networks)
+  uint8_t topK;              // redes gravadas por scan, padrão
+  uint8_t maxTopK;           // limite do topK configurável
+  uint8_t connectionHistory; // eventos de conexão no status
+  uint8_t batteryHistory;    // leituras de bateria no status
+  uint16_t logBuffer;        // buffer circular do log (bytes)
+  uint16_t minFreeHeap;      // heap que precisa sobrar no boot (bytes)
+  bool firebase;             // upload direto ao Firebase (TLS) cabe no perfil
+
+  // Limite para os buffers contados em capacityRamBytes()
+  constexpr size_t ramBudget() const { return HEAP_AT_BOOT - minFreeHeap; }
+};
+
+// minFreeHeap: pico do upload + folga para fragmentação. O survey-max só
+// comporta o coletor próprio (sem TLS); loadConfig() recusa o Firebase nele
+constexpr CapacityProfile CAPACITY_PROFILES[] = {
+    {"low-memory", 16, 3, 5, 5, 10, 1024, HEAP_TLS_PEAK + 4096, true},
+    {"standard", 30, 5, 10, 10, 20, 2048, HEAP_TLS_PEAK + 2048, true},
+    {"survey-max", 48, 10, 10, 32, 64, 4096, HEAP_TCP_PEAK + 4096, false},
+};
+
+static_assert(CAPACITY_PROFILE >= 0 && CAPACITY_PROFILE < 3, "CAPACITY_PROFILE inválido");
+constexpr CapacityProfile CAPACITY = CAPACITY_PROFILES[CAPACITY_PROFILE];
+
+// Tamanhos dos campos de texto (com o '\0'); iguais em todos os perfis
+#define SSID_LEN 32
+#define PASSWORD_LEN 32
+#define BSSID_STR_LEN 18
+#define BIKE_ID_LEN 10
+#define IP_STR_LEN 16
+#define FIREBASE_URL_LEN 128
+#define FIREBASE_KEY_LEN 64
+#define COLLECTOR_URL_LEN 64 // host:porta
+
+// Pior caso dos buffers contados no limite do perfil: os do perfil
+// (networks, históricos, log), os fixos dos módulos e os do modo de
+// registro que mais ocupa
+size_t capacityRamUsage();
+// Lê o heap livre no fim do setup(), com os buffers já alocados, e avisa
+// quando ele está abaixo do minFreeHeap do perfil
+void capacityCheckHeap();
+uint32_t capacityBootHeap();
+
+#endif
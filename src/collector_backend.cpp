@@ -0,0 +1,233 @@
+#include "upload_backend.h"
+#include "batch_format.h"
+#include "config.h"
+#include "known_aps.h"
+#include "logger.h"
+#include "time_base.h"
+#include <ESP8266WiFi.h>
+#include <Arduino.h>
+
+#define COLLECTOR_DEFAULT_PORT 8080
+#define COLLECTOR_TIMEOUT_MS 5000
+
+static bool collectorConfigured() {
+  return strlen(config.collectorUrl) > 0;
+}
+
+static bool collectorConnect(WiFiClient& client, String& host) {
+  String url = String(config.collectorUrl);
+  url.replace("http://", "");
+  int slash = url.indexOf('/');
+  if (slash >= 0) url = url.substring(0, slash);
+  int colon = url.indexOf(':');
+  host = colon < 0 ? url : url.substring(0, colon);
+  int port = colon < 0 ? COLLECTOR_DEFAULT_PORT : url.substring(colon + 1).toInt();
+
+  client.setTimeout(COLLECTOR_TIMEOUT_MS);
+  if (!client.connect(host.c_str(), port)) {
+    LOG_W("COL", "Falha ao conectar no coletor %s:%d", host.c_str(), port);
+    return false;
+  }
+  return true;
+}
+
+// POST /ingest com um lote binário; o coletor responde 200 depois de gravar
+static bool collectorPost(const uint8_t* body, size_t length) {
+  WiFiClient client;
+  String host;
+  if (!collectorConnect(client, host)) return false;
+
+  client.print("POST /ingest HTTP/1.1\r\n");
+  client.print("Host: " + host + "\r\n");
+  client.print("Content-Type: application/octet-stream\r\n");
+  client.print("Content-Length: " + String(length) + "\r\n");
+  client.print("Connection: close\r\n\r\n");
+  client.write(body, length);
+
+  String status = client.readStringUntil('\n');
+  client.stop();
+  LOG_D("COL", "Resposta coletor: %s", status.c_str());
+  return status.startsWith("HTTP/1.1 200") || status.startsWith("HTTP/1.0 200");
+}
+
+static int collectorSendScans(const String* keys, const String* records, int count) {
+  uint8_t* buf = (uint8_t*)malloc(UPLOAD_BATCH_BYTES);
+  BatchRecord* record = (BatchRecord*)malloc(sizeof(BatchRecord));
+  if (!buf || !record) {
+    free(buf);
+    free(record);
+    LOG_E("COL", "Sem memória para o lote");
+    return 0;
+  }
+
+  BatchWriter writer;
+  batchBegin(writer, buf, UPLOAD_BATCH_BYTES, config.bikeId);
+  int taken = 0;
+  size_t jsonBytes = 0;
+  for (; taken < count; taken++) {
+    if (!parseScanRecord(records[taken].c_str(), records[taken].length(), *record)) {
+      // Registro corrompido travaria a fila para sempre: descarta
+      LOG_W("COL", "Registro inválido descartado: %s", keys[taken].c_str());
+      continue;
+    }
+    if (!batchAdd(writer, *record)) break;
+    jsonBytes += keys[taken].length() + records[taken].length() + 4;
+  }
+  size_t length = batchFinish(writer);
+  free(record);
+
+  bool ok = writer.recordCount == 0 || collectorPost(buf, length);
+  free(buf);
+  if (!ok) return 0;
+
+  LOG_I("COL", "Lote: %d scans, %u bytes (JSON: %u)", writer.recordCount,
+        (unsigned)length, (unsigned)jsonBytes);
+  return taken;
+}
+
+static bool collectorSendJson(uint8_t type, uint32_t boot, uint32_t ticks, const String& json) {
+  size_t capacity = BATCH_HEADER_MAX + BATCH_JSON_RECORD_MAX + json.length();
+  uint8_t* buf = (uint8_t*)malloc(capacity);
+  if (!buf || json.length() > 0xFFFF) {
+    free(buf);
+    return false;
+  }
+
+  BatchRecord record;
+  memset(&record, 0, sizeof(record));
+  record.type = type;
+  record.boot = boot;
+  record.ticks = ticks;
+  record.epoch = epochFor(boot, ticks);
+  record.json = json.c_str();
+  record.jsonLength = json.length();
+
+  BatchWriter writer;
+  batchBegin(writer, buf, capacity, config.bikeId);
+  bool ok = batchAdd(writer, record) && collectorPost(buf, batchFinish(writer));
+  free(buf);
+  return ok;
+}
+
+// Chave <boot>_<inicio> vira o boot/ticks do registro
+static bool collectorSendTrip(const String& key, const String& json) {
+  int sep = key.indexOf('_');
+  return collectorSendJson(BATCH_TRIP, key.substring(0, sep).toInt(),
+                           key.substring(sep + 1).toInt(), json);
+}
+
+static bool collectorSendSummary(const String& key, const String& json) {
+  int sep = key.indexOf('_');
+  return collectorSendJson(BATCH_SUMMARY, key.substring(0, sep).toInt(),
+                           key.substring(sep + 1).toInt(), json);
+}
+
+static bool collectorSendStatus(const String& json) {
+  return collectorSendJson(BATCH_STATUS, currentBootId(), timeTicks(), json);
+}
+
+// GET /known_aps com a geração e o tamanho do filtro local; o coletor
+// responde com um patch desde essa geração ou com o filtro inteiro
+static bool collectorFetchKnownAps() {
+  WiFiClient client;
+  String host;
+  if (!collectorConnect(client, host)) return false;
+
+  client.print("GET /known_aps?gen=" + String(knownApsGeneration()) + "&blocks=" +
+               String(knownApsBlocks()) + " HTTP/1.1\r\n");
+  client.print("Host: " + host + "\r\n");
+  client.print("Connection: close\r\n\r\n");
+
+  String status = client.readStringUntil('\n');
+  size_t length = 0;
+  while (client.connected() || client.available()) {
+    String line = client.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) break;
+    line.toLowerCase();
+    if (line.startsWith("content-length:")) length = line.substring(15).toInt();
+  }
+  bool ok = (status.startsWith("HTTP/1.1 200") || status.startsWith("HTTP/1.0 200")) &&
+            knownApsReceive(client, length);
+  client.stop();
+  if (!ok) LOG_D("COL", "Resposta filtro: %s", status.c_str());
+  return ok;
+}
+
+// GET de um arquivo estático com Range; o que chegar antes de a conexão
+// cair já vale (o chamador retoma a partir daí)
+static long collectorFetchFile(const char* path, uint32_t offset, uint32_t length, Print& out) {
+  WiFiClient client;
+  String host;
+  if (!collectorConnect(client, host)) return -1;
+
+  client.print("GET " + String(path) + " HTTP/1.1\r\n");
+  client.print("Host: " + host + "\r\n");
+  if (offset > 0 || length > 0) {
+    client.print("Range: bytes=" + String(offset) + "-" + (length > 0 ? String(offset + length - 1) : String("")) + "\r\n");
+  }
+  client.print("Connection: close\r\n\r\n");
+
+  String status = client.readStringUntil('\n');
+  long contentLength = -1;
+  while (client.connected() || client.available()) {
+    String line = client.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) break;
+    line.toLowerCase();
+    if (line.startsWith("content-length:")) contentLength = line.substring(15).toInt();
+  }
+
+  // 200 só serve se pedimos desde o início (servidor sem Range)
+  bool partial = status.startsWith("HTTP/1.1 206") || status.startsWith("HTTP/1.0 206");
+  bool full = status.startsWith("HTTP/1.1 200") || status.startsWith("HTTP/1.0 200");
+  if (!partial && !(full && offset == 0)) {
+    LOG_D("COL", "Resposta %s: %s", path, status.c_str());
+    client.stop();
+    return -1;
+  }
+
+  long wanted = contentLength;
+  if (length > 0 && (wanted < 0 || wanted > (long)length)) wanted = length;
+  uint8_t buf[512];
+  long received = 0;
+  while (wanted < 0 || received < wanted) {
+    size_t chunk = wanted < 0 ? sizeof(buf) : min((long)sizeof(buf), wanted - received);
+    size_t n = client.readBytes(buf, chunk);
+    if (n == 0) break;
+    out.write(buf, n);
+    received += n;
+    yield();
+  }
+  client.stop();
+  return received;
+}
+
+// GET /time: época em texto. Pelo gateway do depósito é o único horário
+// que a bike recebe (o AP dele não tem rota para o SNTP)
+static uint32_t collectorFetchTime() {
+  WiFiClient client;
+  String host;
+  if (!collectorConnect(client, host)) return 0;
+
+  client.print("GET /time HTTP/1.1\r\n");
+  client.print("Host: " + host + "\r\n");
+  client.print("Connection: close\r\n\r\n");
+
+  String status = client.readStringUntil('\n');
+  while (client.connected() || client.available()) {
+    String line = client.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) break;
+  }
+  bool ok = status.startsWith("HTTP/1.1 200") || status.startsWith("HTTP/1.0 200");
+  uint32_t epoch = ok ? (uint32_t)client.readStringUntil('\n').toInt() : 0;
+  client.stop();
+  if (!ok) LOG_D("COL", "Resposta horário: %s", status.c_str());
+  return epoch;
+}
+
+const UploadBackend collectorBackend = {
+  "coletor", collectorConfigured, collectorSendScans, collectorSendTrip, collectorSendStatus,
+  collectorSendSummary, collectorFetchKnownAps, collectorFetchFile, collectorFetchTime
+};
@@ -1,11 +1,17 @@
 #include "config.h"
+#include "logger.h"
 #include <LittleFS.h>
 #include <Arduino.h>
 
+Config config;
+ScanNetworks networks;
+int dataCount = 0;
+bool configMode = false;
+
 String readFile(const char* path) {
   File file = LittleFS.open(path, "r");
   if (!file) {
-    Serial.printf("Falha ao abrir arquivo: %s\n", path);
+    LOG_W("CFG", "Falha ao abrir arquivo: %s", path);
     return "";
   }
   String content = file.readString();
@@ -16,13 +22,26 @@ String readFile(const char* path) {
 void writeFile(const char* path, const String& content) {
   File file = LittleFS.open(path, "w");
   if (!file) {
-    Serial.printf("Falha ao criar arquivo: %s\n", path);
+    LOG_W("CFG", "Falha ao criar arquivo: %s", path);
     return;
   }
   file.print(content);
   file.close();
 }
 
+String fileLine(const String& content, int line) {
+  int start = 0;
+  for (int i = 0; i < line; i++) {
+    start = content.indexOf('\n', start);
+    if (start < 0) return "";
+    start++;
+  }
+  int end = content.indexOf('\n', start);
+  String value = end < 0 ? content.substring(start) : content.substring(start, end);
+  value.trim();
+  return value;
+}
+
 void loadConfig() {
   strcpy(config.bikeId, "sl01");
   config.scanTimeActive = 5000;
@@ -35,19 +54,27 @@ void loadConfig() {
   strcpy(config.basePassword3, "");
   strcpy(config.firebaseUrl, "");
   strcpy(config.firebaseKey, "");
+  strcpy(config.collectorUrl, "");
+  config.topK = CAPACITY.topK;
+  config.mergeMesh = false;
+  config.recordMode = RECORD_RAW;
+  config.tripOnly = false;
+  config.tripWaypointEvery = 6;
+  config.suppressKnown = true;
+  config.aggregateWindowS = 300;
   
   if (!LittleFS.begin()) {
-    Serial.println("Sistema de arquivos não disponível - usando configuração padrão");
+    LOG_W("CFG", "Sistema de arquivos não disponível - usando configuração padrão");
     return;
   }
   
-  Serial.println("Carregando configurações dos arquivos...");
+  LOG_I("CFG", "Carregando configurações dos arquivos...");
   
   String bikeId = readFile("/bike.txt");
   if (bikeId.length() > 0) {
     bikeId.trim();
-    bikeId.toCharArray(config.bikeId, 10);
-    Serial.printf("Bike ID carregado: %s\n", config.bikeId);
+    bikeId.toCharArray(config.bikeId, sizeof(config.bikeId));
+    LOG_I("CFG", "Bike ID carregado: %s", config.bikeId);
   }
   
   String timing = readFile("/timing.txt");
@@ -56,35 +83,35 @@ void loadConfig() {
     if (idx > 0) {
       config.scanTimeActive = timing.substring(0, idx).toInt();
       config.scanTimeInactive = timing.substring(idx+1).toInt();
-      Serial.printf("Timing carregado: %d/%d ms\n", config.scanTimeActive, config.scanTimeInactive);
+      LOG_I("CFG", "Timing carregado: %d/%d ms", config.scanTimeActive, config.scanTimeInactive);
     }
   }
   
   String bases = readFile("/bases.txt");
   if (bases.length() > 0) {
-    Serial.println("Carregando bases WiFi do arquivo...");
+    LOG_D("CFG", "Carregando bases WiFi do arquivo...");
     int pos = 0;
     int idx = bases.indexOf('\n');
     if (idx > 0) {
-      bases.substring(pos, idx).toCharArray(config.baseSSID1, 32);
+      bases.substring(pos, idx).toCharArray(config.baseSSID1, sizeof(config.baseSSID1));
       pos = idx + 1;
       idx = bases.indexOf('\n', pos);
       if (idx > 0) {
-        bases.substring(pos, idx).toCharArray(config.basePassword1, 32);
+        bases.substring(pos, idx).toCharArray(config.basePassword1, sizeof(config.basePassword1));
         pos = idx + 1;
         idx = bases.indexOf('\n', pos);
         if (idx > 0) {
-          bases.substring(pos, idx).toCharArray(config.baseSSID2, 32);
+          bases.substring(pos, idx).toCharArray(config.baseSSID2, sizeof(config.baseSSID2));
           pos = idx + 1;
           idx = bases.indexOf('\n', pos);
           if (idx > 0) {
-            bases.substring(pos, idx).toCharArray(config.basePassword2, 32);
+            bases.substring(pos, idx).toCharArray(config.basePassword2, sizeof(config.basePassword2));
             pos = idx + 1;
             idx = bases.indexOf('\n', pos);
             if (idx > 0) {
-              bases.substring(pos, idx).toCharArray(config.baseSSID3, 32);
+              bases.substring(pos, idx).toCharArray(config.baseSSID3, sizeof(config.baseSSID3));
               pos = idx + 1;
-              bases.substring(pos).toCharArray(config.basePassword3, 32);
+              bases.substring(pos).toCharArray(config.basePassword3, sizeof(config.basePassword3));
             }
           }
         }
@@ -92,27 +119,59 @@ void loadConfig() {
     }
   }
   
-  Serial.printf("Base 1: %s\n", config.baseSSID1);
-  Serial.printf("Base 2: %s\n", config.baseSSID2);
-  Serial.printf("Base 3: %s\n", config.baseSSID3);
+  LOG_I("CFG", "Base 1: %s", config.baseSSID1);
+  LOG_I("CFG", "Base 2: %s", config.baseSSID2);
+  LOG_I("CFG", "Base 3: %s", config.baseSSID3);
   
   String firebase = readFile("/firebase.txt");
   if (firebase.length() > 0) {
     int idx = firebase.indexOf('\n');
     if (idx > 0) {
-      firebase.substring(0, idx).toCharArray(config.firebaseUrl, 128);
-      firebase.substring(idx+1).toCharArray(config.firebaseKey, 64);
-      Serial.println("Firebase carregado do arquivo");
+      firebase.substring(0, idx).toCharArray(config.firebaseUrl, sizeof(config.firebaseUrl));
+      firebase.substring(idx+1).toCharArray(config.firebaseKey, sizeof(config.firebaseKey));
+      LOG_D("CFG", "Firebase carregado do arquivo");
     }
   }
+  // TLS não cabe no heap do perfil: só o coletor é usado (firebase.cpp)
+  if (!CAPACITY.firebase && strlen(config.firebaseUrl) > 0) {
+    LOG_E("CFG", "Firebase ignorado no perfil %s (sem heap para TLS); use o coletor", CAPACITY.name);
+  }
   
-  Serial.printf("Firebase: %s\n", strlen(config.firebaseUrl) > 0 ? "Configurado" : "Não configurado");
-  Serial.println("Configurações carregadas");
+  String collector = readFile("/collector.txt");
+  if (collector.length() > 0) {
+    collector.trim();
+    collector.toCharArray(config.collectorUrl, sizeof(config.collectorUrl));
+  }
+
+  String scan = readFile("/scan.txt");
+  if (scan.length() > 0) {
+    int topK = fileLine(scan, 0).toInt();
+    if (topK > 0) config.topK = min(topK, MAX_TOP_K);
+    config.mergeMesh = fileLine(scan, 1) == "1";
+    int mode = fileLine(scan, 2).toInt();
+    config.recordMode = mode == RECORD_POSITION || mode == RECORD_AGGREGATE ? mode : RECORD_RAW;
+    config.tripOnly = fileLine(scan, 3) == "1";
+    String waypoints = fileLine(scan, 4);
+    if (waypoints.length() > 0) config.tripWaypointEvery = max(0, (int)waypoints.toInt());
+    config.suppressKnown = fileLine(scan, 5) != "0";
+    int windowS = fileLine(scan, 6).toInt();
+    if (windowS > 0) config.aggregateWindowS = max(30, windowS);
+  }
+  LOG_I("CFG", "Scan: top %d redes, mesh %s, registro %s", config.topK,
+        config.mergeMesh ? "unido" : "separado",
+        config.recordMode == RECORD_POSITION ? "posição" :
+        config.recordMode == RECORD_AGGREGATE ? "estatísticas" : "redes");
+  LOG_I("CFG", "Viagens: %s, ponto a cada %d scans",
+        config.tripOnly ? "só resumo" : "resumo + scans", config.tripWaypointEvery);
+
+  LOG_I("CFG", "Firebase: %s", strlen(config.firebaseUrl) > 0 ? "Configurado" : "Não configurado");
+  if (strlen(config.collectorUrl) > 0) LOG_I("CFG", "Coletor: %s", config.collectorUrl);
+  LOG_I("CFG", "Configurações carregadas");
 }
 
 void saveConfig() {
   if (!LittleFS.begin()) {
-    Serial.println("Falha ao montar sistema de arquivos");
+    LOG_E("CFG", "Falha ao montar sistema de arquivos");
     return;
   }
   
@@ -131,6 +190,13 @@ void saveConfig() {
   
   String firebase = String(config.firebaseUrl) + "\n" + String(config.firebaseKey);
   writeFile("/firebase.txt", firebase);
+  writeFile("/collector.txt", String(config.collectorUrl));
+
+  String scan = String(config.topK) + "\n" + String(config.mergeMesh ? 1 : 0) + "\n" +
+                String(config.recordMode) + "\n" + String(config.tripOnly ? 1 : 0) + "\n" +
+                String(config.tripWaypointEvery) + "\n" + String(config.suppressKnown ? 1 : 0) + "\n" +
+                String(config.aggregateWindowS);
+  writeFile("/scan.txt", scan);
   
-  Serial.println("Configurações salvas");
+  LOG_I("CFG", "Configurações salvas");
 }
\ No newline at end of file
@@ -1,9 +1,26 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <Arduino.h>
+#include "capacity.h"
+#include "bounded_array.h"
+
+// Versão gravada no firmware (build_flags); "dev" não se atualiza por OTA
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "dev"
+#endif
+
+#define MAX_NETWORKS ((int)CAPACITY.scanNetworks)
+#define MAX_TOP_K ((int)CAPACITY.maxTopK)
+
+// Formato dos registros gravados por storeData()
+#define RECORD_RAW 0      // lista das redes mais fortes
+#define RECORD_POSITION 1 // posição estimada pelo índice de APs local
+#define RECORD_AGGREGATE 2 // só estatísticas por janela (aggregator.h)
+
 struct WiFiNetwork {
-  char ssid[32];
-  char bssid[18];
+  char ssid[SSID_LEN];
+  char bssid[BSSID_STR_LEN];
   int rssi;
   int channel;
   int encryption;
@@ -12,34 +29,35 @@ struct WiFiNetwork {
 struct Config {
   int scanTimeActive = 1000;
   int scanTimeInactive = 1000;
-  char baseSSID1[32] = "";
-  char basePassword1[32] = "";
-  char baseSSID2[32] = "";
-  char basePassword2[32] = "";
-  char baseSSID3[32] = "";
-  char basePassword3[32] = "";
-  char bikeId[10] = "sl01";
+  char baseSSID1[SSID_LEN] = "";
+  char basePassword1[PASSWORD_LEN] = "";
+  char baseSSID2[SSID_LEN] = "";
+  char basePassword2[PASSWORD_LEN] = "";
+  char baseSSID3[SSID_LEN] = "";
+  char basePassword3[PASSWORD_LEN] = "";
+  char bikeId[BIKE_ID_LEN] = "sl01";
   bool isAtBase = false;
-  char firebaseUrl[128] = "";
-  char firebaseKey[64] = "";
+  char firebaseUrl[FIREBASE_URL_LEN] = "";
+  char firebaseKey[FIREBASE_KEY_LEN] = "";
+  char collectorUrl[COLLECTOR_URL_LEN] = ""; // host:porta do coletor próprio (vazio = Firebase)
+  int topK = CAPACITY.topK; // redes mais fortes gravadas por scan
+  bool mergeMesh = false; // une nós de mesh com o mesmo SSID no scan
+  int recordMode = RECORD_RAW;
+  bool tripOnly = false;      // grava só resumos de viagem, sem cada scan
+  int tripWaypointEvery = 6;  // scans entre pontos do trajeto (0 = nenhum)
+  bool suppressKnown = true;  // com /known_aps.bin, grava só o AP conhecido mais forte
+  int aggregateWindowS = 300; // janela das estatísticas (RECORD_AGGREGATE)
 };
 
-struct ScanData {
-  unsigned long timestamp;
-  WiFiNetwork networks[10];
-  int networkCount;
-  float batteryLevel;
-  bool isCharging;
-};
+// Redes do último scan (até MAX_NETWORKS, conforme o perfil)
+typedef BoundedArray<WiFiNetwork, MAX_NETWORKS> ScanNetworks;
 
 extern Config config;
-extern WiFiNetwork networks[30];
-extern int networkCount;
-extern ScanData dataBuffer[20];
+extern ScanNetworks networks;
 extern int dataCount;
 extern bool configMode;
-extern bool timeSync;
 
+String fileLine(const String& content, int line);
 void loadConfig();
 void saveConfig();
 
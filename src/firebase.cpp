@@ -1,45 +1,15 @@
 #include "firebase.h"
+#include "upload_backend.h"
 #include "config.h"
-#include "wifi_scanner.h"
-#include "status_tracker.h"
+#include "logger.h"
 #include <WiFiClientSecure.h>
-#include <ESP8266WiFi.h>
-#include <LittleFS.h>
 #include <Arduino.h>
 
-void syncTime() {
-  if (!timeSync) {
-    timeClient.begin();
-    if (timeClient.update()) {
-      timeSync = true;
-      Serial.println("Horário sincronizado");
-    }
-  }
+bool firebasePut(const String& path, const String& payload) {
+  return firebaseSend("PUT", path, payload);
 }
 
-void uploadData() {
-  if (strlen(config.firebaseUrl) == 0 || dataCount == 0)
-    return;
-
-  Serial.println("=== UPLOAD FIREBASE ===");
-  
-  unsigned long timestamp = timeSync ? timeClient.getEpochTime() : millis();
-  
-  String payload = "{\"bike\":\"" + String(config.bikeId) + "\"";
-  payload += ",\"timestamp\":" + String(timestamp);
-  payload += ",\"networks\":[";
-  
-  int maxNets = min(networkCount, 5);
-  for (int i = 0; i < maxNets; i++) {
-    if (i > 0) payload += ",";
-    payload += "{\"ssid\":\"" + String(networks[i].ssid) + "\"";
-    payload += ",\"rssi\":" + String(networks[i].rssi);
-    payload += ",\"channel\":" + String(networks[i].channel) + "}";
-  }
-  payload += "]}";
-  
-  Serial.printf("Payload: %s\n", payload.c_str());
-  
+bool firebaseSend(const char* method, const String& path, const String& payload) {
   WiFiClientSecure client;
   client.setInsecure();
   
@@ -49,58 +19,66 @@ void uploadData() {
   int slashIndex = url.indexOf('/');
   String host = url.substring(0, slashIndex);
   
-  String path = "/bikes/" + String(config.bikeId) + "/scans/" + String(timestamp) + ".json";
+  LOG_D("FB", "Host: %s", host.c_str());
+  LOG_D("FB", "Path: %s", path.c_str());
   
-  Serial.printf("Host: %s\n", host.c_str());
-  Serial.printf("Path: %s\n", path.c_str());
-  
-  if (client.connect(host.c_str(), 443)) {
-    Serial.println("Conectado ao Firebase!");
-    
-    client.print("PUT " + path + " HTTP/1.1\r\n");
-    client.print("Host: " + host + "\r\n");
-    client.print("Content-Type: application/json\r\n");
-    client.print("Content-Length: " + String(payload.length()) + "\r\n");
-    client.print("Connection: close\r\n\r\n");
-    client.print(payload);
-    
-    delay(500);
-    String response = "";
-    int timeout = 0;
-    while (client.available() && timeout < 50) {
-      response += client.readString();
-      delay(10);
-      timeout++;
-    }
-    
-    Serial.println("Resposta Firebase:");
-    Serial.println(response);
-    
-    if (response.indexOf("200 OK") > 0) {
-      Serial.println("Upload OK! Limpando arquivos locais...");
-      
-      Dir dir = LittleFS.openDir("/");
-      while (dir.next()) {
-        if (dir.fileName().startsWith("scan_")) {
-          LittleFS.remove(dir.fileName());
-          Serial.printf("Removido: %s\n", dir.fileName().c_str());
-        }
-      }
-      dataCount = 0;
-      
-      // Upload status após scans
-      uploadStatus();
-    } else {
-      Serial.println("Erro no upload - mantendo arquivos locais");
-    }
-    
-    client.stop();
-  } else {
-    Serial.println("Falha ao conectar no Firebase");
+  if (!client.connect(host.c_str(), 443)) {
+    LOG_W("FB", "Falha ao conectar no Firebase");
+    return false;
   }
+  LOG_D("FB", "Conectado ao Firebase!");
   
-  // Track disconnection
-  String lastIP = WiFi.localIP().toString();
-  WiFi.disconnect();
-  trackConnection("disconnect", lastIP.c_str(), false);
-}
\ No newline at end of file
+  client.print(String(method) + " " + path + " HTTP/1.1\r\n");
+  client.print("Host: " + host + "\r\n");
+  client.print("Content-Type: application/json\r\n");
+  client.print("Content-Length: " + String(payload.length()) + "\r\n");
+  client.print("Connection: close\r\n\r\n");
+  client.print(payload);
+
+  // A resposta a um PATCH de 4 KB pelo TLS passa fácil de meio segundo:
+  // espera a linha de status, byte a byte, até FIREBASE_TIMEOUT_MS
+  client.setTimeout(FIREBASE_TIMEOUT_MS);
+  String status = client.readStringUntil('\n');
+  client.stop();
+  status.trim();
+  int code = status.startsWith("HTTP/1.") && status.length() >= 12 ? status.substring(9, 12).toInt() : 0;
+
+  LOG_D("FB", "Resposta Firebase: %s", status.c_str());
+  if (code != 200) LOG_W("FB", "%s %s: resposta %d", method, path.c_str(), code);
+  return code == 200;
+}
+
+static bool firebaseConfigured() {
+  return CAPACITY.firebase && strlen(config.firebaseUrl) > 0;
+}
+
+// Um PATCH em /bikes/<id>/scans com todos os registros do lote
+static int firebaseSendScans(const String* keys, const String* records, int count) {
+  String payload = "{";
+  for (int i = 0; i < count; i++) {
+    if (i > 0) payload += ",";
+    payload += "\"" + keys[i] + "\":" + records[i];
+  }
+  payload += "}";
+
+  LOG_D("FB", "Payload: %s", payload.c_str());
+  String path = "/bikes/" + String(config.bikeId) + "/scans.json";
+  return firebaseSend("PATCH", path, payload) ? count : 0;
+}
+
+static bool firebaseSendTrip(const String& key, const String& json) {
+  return firebasePut("/bikes/" + String(config.bikeId) + "/trips/" + key + ".json", json);
+}
+
+static bool firebaseSendSummary(const String& key, const String& json) {
+  return firebasePut("/bikes/" + String(config.bikeId) + "/summaries/" + key + ".json", json);
+}
+
+static bool firebaseSendStatus(const String& json) {
+  return firebasePut("/bikes/" + String(config.bikeId) + "/status.json", json);
+}
+
+const UploadBackend firebaseBackend = {
+  "firebase", firebaseConfigured, firebaseSendScans, firebaseSendTrip, firebaseSendStatus,
+  firebaseSendSummary, nullptr, nullptr, nullptr
+};
@@ -1,13 +1,11 @@
 #ifndef FIREBASE_H
 #define FIREBASE_H
 
-#include <NTPClient.h>
-#include <WiFiUdp.h>
+#include <Arduino.h>
 
-extern WiFiUDP ntpUDP;
-extern NTPClient timeClient;
+#define FIREBASE_TIMEOUT_MS 10000 // espera pela linha de status da resposta
 
-void syncTime();
-void uploadData();
+bool firebaseSend(const char* method, const String& path, const String& payload);
+bool firebasePut(const String& path, const String& payload);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,37 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+// Gateway do depósito: roda o AP da base, recebe os lotes das bikes em
+// HTTP simples e repassa ao coletor numa única conexão persistente. O AP
+// não tem rota para fora: o horário e os GETs do coletor (filtro de APs
+// conhecidos, OTA) passam pelo gateway
+
+#define GATEWAY_CONFIG_PATH "/gateway.txt"
+#define GATEWAY_INGEST_PORT 8080
+#define GATEWAY_MAX_CLIENTS 4
+#define GATEWAY_MAX_BODY 4608       // lote da bike (UPLOAD_BATCH_BYTES) + folga
+#define GATEWAY_CLIENT_TIMEOUT 5000 // ms sem dados antes de fechar a conexão
+#define GATEWAY_RETRY_MS 10000      // espera após falha no envio ao coletor
+
+struct GatewayConfig {
+  char apSSID[32] = "BPR-Base";
+  char apPassword[32] = "";
+  char upstreamSSID[32] = "";     // rede com internet do depósito
+  char upstreamPassword[32] = "";
+  char upstreamUrl[64] = "";      // coletor (host:porta)
+};
+
+extern GatewayConfig gatewayConfig;
+
+void loadGatewayConfig();
+void ingestBegin();
+void ingestPoll();
+void forwardPoll();
+// Repassa um GET ao coletor e devolve a resposta dele à bike; false se o
+// coletor não está acessível (nada foi enviado à bike)
+bool proxyGet(WiFiClient& bike, const char* target, const char* range);
+
+#endif
@@ -0,0 +1,25 @@
+#include "gateway.h"
+#include "../config.h"
+#include "../logger.h"
+#include <LittleFS.h>
+
+GatewayConfig gatewayConfig;
+
+// /gateway.txt: SSID do AP, senha do AP, SSID da rede do depósito,
+// senha dessa rede, coletor (host:porta)
+void loadGatewayConfig() {
+  File file = LittleFS.open(GATEWAY_CONFIG_PATH, "r");
+  if (!file) {
+    LOG_W("GW", "Sem %s - usando AP padrão %s", GATEWAY_CONFIG_PATH, gatewayConfig.apSSID);
+    return;
+  }
+  String content = file.readString();
+  file.close();
+
+  String apSSID = fileLine(content, 0);
+  if (apSSID.length() > 0) apSSID.toCharArray(gatewayConfig.apSSID, sizeof(gatewayConfig.apSSID));
+  fileLine(content, 1).toCharArray(gatewayConfig.apPassword, sizeof(gatewayConfig.apPassword));
+  fileLine(content, 2).toCharArray(gatewayConfig.upstreamSSID, sizeof(gatewayConfig.upstreamSSID));
+  fileLine(content, 3).toCharArray(gatewayConfig.upstreamPassword, sizeof(gatewayConfig.upstreamPassword));
+  fileLine(content, 4).toCharArray(gatewayConfig.upstreamUrl, sizeof(gatewayConfig.upstreamUrl));
+}
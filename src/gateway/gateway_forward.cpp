@@ -0,0 +1,151 @@
+#include "gateway.h"
+#include "gateway_spool.h"
+#include "../logger.h"
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+
+// Conexão mantida aberta entre os envios (keep-alive): um handshake TCP
+// por sessão do depósito, não por bike
+static WiFiClient upstream;
+static unsigned long lastFailure = 0;
+static bool failed = false;
+
+static bool upstreamReachable() {
+  return strlen(gatewayConfig.upstreamUrl) > 0 && WiFi.status() == WL_CONNECTED;
+}
+
+static bool connectTo(WiFiClient& client, String& host, bool reuse) {
+  String url = String(gatewayConfig.upstreamUrl);
+  url.replace("http://", "");
+  int colon = url.indexOf(':');
+  host = colon < 0 ? url : url.substring(0, colon);
+  int port = colon < 0 ? GATEWAY_INGEST_PORT : url.substring(colon + 1).toInt();
+
+  if (reuse && client.connected()) return true;
+  client.stop();
+  client.setTimeout(GATEWAY_CLIENT_TIMEOUT);
+  if (!client.connect(host.c_str(), port)) {
+    LOG_W("GW", "Falha ao conectar no coletor %s:%d", host.c_str(), port);
+    return false;
+  }
+  client.setNoDelay(true);
+  if (reuse) LOG_I("GW", "Conectado ao coletor %s:%d", host.c_str(), port);
+  return true;
+}
+
+static bool upstreamConnect(String& host) {
+  return connectTo(upstream, host, true);
+}
+
+// Lê a resposta inteira para a conexão poder ser reaproveitada
+static int readResponse() {
+  String status = upstream.readStringUntil('\n');
+  int code = status.length() > 12 ? status.substring(9, 12).toInt() : 0;
+  size_t contentLength = 0;
+  bool keepAlive = true;
+
+  for (;;) {
+    String header = upstream.readStringUntil('\n');
+    header.trim();
+    if (header.length() == 0) break;
+    String lower = header;
+    lower.toLowerCase();
+    if (lower.startsWith("content-length:")) contentLength = lower.substring(15).toInt();
+    if (lower.startsWith("connection:") && lower.indexOf("close") > 0) keepAlive = false;
+  }
+  while (contentLength > 0 && upstream.connected()) {
+    if (upstream.available()) {
+      upstream.read();
+      contentLength--;
+    } else {
+      yield();
+    }
+  }
+  if (!keepAlive) upstream.stop();
+  return code;
+}
+
+static bool forwardSegment(const String& path, size_t size) {
+  String host;
+  if (!upstreamConnect(host)) return false;
+
+  File file = LittleFS.open(path.c_str(), "r");
+  if (!file) return false;
+
+  upstream.print("POST /ingest HTTP/1.1\r\n");
+  upstream.print("Host: " + host + "\r\n");
+  upstream.print("Content-Type: application/octet-stream\r\n");
+  upstream.print("Content-Length: " + String(size) + "\r\n");
+  upstream.print("Connection: keep-alive\r\n\r\n");
+
+  uint8_t chunk[512];
+  size_t sent = 0;
+  while (sent < size) {
+    size_t n = file.read(chunk, sizeof(chunk));
+    if (n == 0 || upstream.write(chunk, n) != n) break;
+    sent += n;
+    ingestPoll(); // segmento grande não trava as bikes que estão chegando
+  }
+  file.close();
+
+  int code = sent == size ? readResponse() : 0;
+  if (code != 200) {
+    LOG_W("GW", "Coletor respondeu %d para %s", code, path.c_str());
+    upstream.stop();
+    return false;
+  }
+  return true;
+}
+
+void forwardPoll() {
+  if (!upstreamReachable()) return;
+  if (failed && millis() - lastFailure < GATEWAY_RETRY_MS) return;
+
+  String path;
+  size_t size;
+  if (!spoolOldest(path, size)) return;
+
+  unsigned long start = millis();
+  if (forwardSegment(path, size)) {
+    spoolRemove(path);
+    failed = false;
+    LOG_I("GW", "Enviado %s: %u bytes em %lu ms (fila %u)", path.c_str(), (unsigned)size,
+          millis() - start, (unsigned)spoolBytes());
+  } else {
+    failed = true;
+    lastFailure = millis();
+  }
+}
+
+// Conexão própria (não a keep-alive da fila), fechada no fim: a resposta
+// do coletor passa byte a byte para a bike, cabeçalhos incluídos
+bool proxyGet(WiFiClient& bike, const char* target, const char* range) {
+  if (!upstreamReachable()) return false;
+  WiFiClient client;
+  String host;
+  if (!connectTo(client, host, false)) return false;
+
+  client.print("GET " + String(target) + " HTTP/1.1\r\n");
+  client.print("Host: " + host + "\r\n");
+  if (range[0]) client.print("Range: " + String(range) + "\r\n");
+  client.print("Connection: close\r\n\r\n");
+
+  uint8_t chunk[512];
+  size_t total = 0;
+  unsigned long lastData = millis();
+  while (millis() - lastData < GATEWAY_CLIENT_TIMEOUT && bike.connected()) {
+    int available = client.available();
+    if (available <= 0) {
+      if (!client.connected()) break;
+      delay(1);
+      continue;
+    }
+    size_t n = client.read(chunk, min((size_t)available, sizeof(chunk)));
+    if (bike.write(chunk, n) != n) break;
+    total += n;
+    lastData = millis();
+  }
+  client.stop();
+  LOG_I("GW", "GET %s: %u bytes do coletor", target, (unsigned)total);
+  return total > 0;
+}
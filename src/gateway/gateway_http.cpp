@@ -0,0 +1,112 @@
+#include "gateway_http.h"
+#include "../batch_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+void ingestParserBegin(IngestParser& p, uint8_t* body, size_t capacity) {
+  memset(&p, 0, sizeof(p));
+  p.state = INGEST_HEADERS;
+  p.requestLine = true;
+  p.body = body;
+  p.capacity = capacity;
+}
+
+static void fail(IngestParser& p, int status) {
+  p.state = INGEST_ERROR;
+  p.errorStatus = status;
+}
+
+static void headerLine(IngestParser& p) {
+  p.line[p.lineLength] = '\0';
+
+  if (p.requestLine) {
+    p.requestLine = false;
+    if (strncmp(p.line, "POST /ingest ", 13) == 0) {
+      p.request = INGEST_POST;
+    } else if (strncmp(p.line, "GET /time ", 10) == 0) {
+      p.request = INGEST_TIME;
+    } else if (strncmp(p.line, "GET /known_aps?", 15) == 0 || strncmp(p.line, "GET /firmware/", 14) == 0) {
+      const char* target = p.line + 4;
+      const char* end = strchr(target, ' ');
+      size_t length = end ? (size_t)(end - target) : strlen(target);
+      if (length >= INGEST_TARGET_MAX) {
+        fail(p, 414);
+        return;
+      }
+      memcpy(p.target, target, length);
+      p.target[length] = '\0';
+      p.request = INGEST_PROXY;
+    } else {
+      fail(p, 404);
+    }
+    return;
+  }
+
+  if (p.lineLength == 0) {
+    // Fim dos cabeçalhos; GET não tem corpo
+    if (p.request != INGEST_POST) {
+      p.state = INGEST_DONE;
+    } else if (p.contentLength == 0) {
+      fail(p, 400);
+    } else if (p.contentLength > p.capacity) {
+      fail(p, 413);
+    } else {
+      p.state = INGEST_BODY;
+    }
+    return;
+  }
+
+  if (strncasecmp(p.line, "Content-Length:", 15) == 0) {
+    p.contentLength = strtoul(p.line + 15, nullptr, 10);
+  } else if (strncasecmp(p.line, "Range:", 6) == 0) {
+    const char* value = p.line + 6;
+    while (*value == ' ') value++;
+    snprintf(p.range, sizeof(p.range), "%s", value);
+  }
+}
+
+size_t ingestParserFeed(IngestParser& p, const uint8_t* data, size_t length) {
+  size_t used = 0;
+
+  while (used < length && p.state == INGEST_HEADERS) {
+    char c = data[used++];
+    if (c == '\r') continue;
+    if (c == '\n') {
+      headerLine(p);
+      p.lineLength = 0;
+    } else if (p.lineLength < INGEST_LINE_MAX - 1) {
+      p.line[p.lineLength++] = c;
+    }
+  }
+
+  if (p.state == INGEST_BODY && used < length) {
+    size_t take = p.contentLength - p.bodyLength;
+    if (take > length - used) take = length - used;
+    memcpy(p.body + p.bodyLength, data + used, take);
+    p.bodyLength += take;
+    used += take;
+  }
+  if (p.state == INGEST_BODY && p.bodyLength == p.contentLength) {
+    p.state = INGEST_DONE;
+  }
+  return used;
+}
+
+bool ingestValidate(const uint8_t* body, size_t length, int* batches, int* records) {
+  static BatchRecord record; // ~450 bytes: fora da pilha
+  size_t offset = 0;
+  *batches = 0;
+  *records = 0;
+
+  while (offset < length) {
+    BatchReader reader;
+    if (!batchOpen(reader, body + offset, length - offset)) return false;
+    while (batchNext(reader, record)) (*records)++;
+    if (reader.error || reader.remaining != 0) return false;
+    offset += reader.pos;
+    (*batches)++;
+  }
+  return *batches > 0;
+}
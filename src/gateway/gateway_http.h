@@ -0,0 +1,50 @@
+#ifndef GATEWAY_HTTP_H
+#define GATEWAY_HTTP_H
+
+// Leitura incremental das requisições das bikes: POST /ingest com o lote,
+// GET /time e os GETs repassados ao coletor (filtro de APs conhecidos e
+// OTA). Só C++ puro, para compilar também no host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define INGEST_LINE_MAX 128
+#define INGEST_TARGET_MAX 96 // caminho de um GET repassado
+#define INGEST_RANGE_MAX 40  // valor do cabeçalho Range
+
+enum IngestState {
+  INGEST_HEADERS,
+  INGEST_BODY,
+  INGEST_DONE,
+  INGEST_ERROR,
+};
+
+enum IngestRequest {
+  INGEST_POST,  // lote para a fila
+  INGEST_TIME,  // horário do gateway, respondido na hora
+  INGEST_PROXY, // GET /known_aps?... ou /firmware/..., repassado ao coletor
+};
+
+struct IngestParser {
+  IngestState state;
+  int errorStatus;        // resposta HTTP quando state == INGEST_ERROR
+  bool requestLine;       // true até ler a linha de requisição
+  IngestRequest request;
+  char target[INGEST_TARGET_MAX]; // caminho do GET repassado
+  char range[INGEST_RANGE_MAX];   // Range do GET repassado, "" se não veio
+  char line[INGEST_LINE_MAX];
+  size_t lineLength;
+  size_t contentLength;
+  uint8_t* body;
+  size_t capacity;
+  size_t bodyLength;
+};
+
+void ingestParserBegin(IngestParser& parser, uint8_t* body, size_t capacity);
+// Consome até length bytes; retorna quantos usou
+size_t ingestParserFeed(IngestParser& parser, const uint8_t* data, size_t length);
+
+// Confere todos os lotes concatenados do corpo; conta registros
+bool ingestValidate(const uint8_t* body, size_t length, int* batches, int* records);
+
+#endif
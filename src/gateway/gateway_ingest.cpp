@@ -0,0 +1,115 @@
+#include "gateway.h"
+#include "gateway_http.h"
+#include "gateway_spool.h"
+#include "../logger.h"
+#include "../time_base.h"
+#include <time.h>
+#include <ESP8266WiFi.h>
+
+// Uma vaga por bike conectada; o corpo só é alocado enquanto a conexão dura
+struct IngestSlot {
+  WiFiClient client;
+  IngestParser parser;
+  uint8_t* body;
+  unsigned long lastData;
+};
+
+static WiFiServer ingestServer(GATEWAY_INGEST_PORT);
+static IngestSlot slots[GATEWAY_MAX_CLIENTS];
+
+static void reply(WiFiClient& client, int status, const char* text) {
+  client.printf("HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status, text);
+  client.flush();
+}
+
+static void closeSlot(IngestSlot& slot) {
+  slot.client.stop();
+  free(slot.body);
+  slot.body = nullptr;
+}
+
+static void finishSlot(IngestSlot& slot) {
+  IngestParser& p = slot.parser;
+  int batches, records;
+
+  if (p.state == INGEST_ERROR) {
+    reply(slot.client, p.errorStatus, "Erro");
+  } else if (p.request == INGEST_TIME) {
+    // SNTP do gateway, pela rede do depósito; 503 até sincronizar
+    time_t now = time(nullptr);
+    if ((uint32_t)now < TIME_VALID_EPOCH) {
+      reply(slot.client, 503, "Service Unavailable");
+    } else {
+      String body = String((uint32_t)now) + "\n";
+      slot.client.printf("HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %u\r\n"
+                         "Connection: close\r\n\r\n%s", (unsigned)body.length(), body.c_str());
+      slot.client.flush();
+    }
+  } else if (p.request == INGEST_PROXY) {
+    if (!proxyGet(slot.client, p.target, p.range)) {
+      LOG_W("GW", "GET %s sem coletor", p.target);
+      reply(slot.client, 502, "Bad Gateway");
+    }
+  } else if (!ingestValidate(p.body, p.bodyLength, &batches, &records)) {
+    LOG_W("GW", "Lote inválido de %s", slot.client.remoteIP().toString().c_str());
+    reply(slot.client, 400, "Bad Request");
+  } else if (!spoolAppend(p.body, p.bodyLength)) {
+    // A bike mantém os arquivos e tenta na próxima visita
+    reply(slot.client, 503, "Service Unavailable");
+  } else {
+    // Confirmado assim que está no flash; o envio ao coletor é depois
+    reply(slot.client, 200, "OK");
+    LOG_I("GW", "%s: %d registros, %u bytes (fila %u)", slot.client.remoteIP().toString().c_str(),
+          records, (unsigned)p.bodyLength, (unsigned)spoolBytes());
+  }
+  closeSlot(slot);
+}
+
+void ingestBegin() {
+  ingestServer.begin();
+  LOG_I("GW", "Recebendo lotes na porta %d", GATEWAY_INGEST_PORT);
+}
+
+void ingestPoll() {
+  WiFiClient incoming = ingestServer.available();
+  if (incoming) {
+    IngestSlot* open = nullptr;
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+      if (!slots[i].body) {
+        open = &slots[i];
+        break;
+      }
+    }
+    uint8_t* body = open ? (uint8_t*)malloc(GATEWAY_MAX_BODY) : nullptr;
+    if (!body) {
+      reply(incoming, 503, "Service Unavailable");
+      incoming.stop();
+    } else {
+      open->client = incoming;
+      open->body = body;
+      open->lastData = millis();
+      ingestParserBegin(open->parser, body, GATEWAY_MAX_BODY);
+    }
+  }
+
+  for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+    IngestSlot& slot = slots[i];
+    if (!slot.body) continue;
+
+    uint8_t chunk[256];
+    while (slot.parser.state < INGEST_DONE && slot.client.available()) {
+      size_t n = slot.client.read(chunk, sizeof(chunk));
+      size_t used = 0;
+      while (used < n && slot.parser.state < INGEST_DONE) {
+        used += ingestParserFeed(slot.parser, chunk + used, n - used);
+      }
+      slot.lastData = millis();
+    }
+
+    if (slot.parser.state >= INGEST_DONE) {
+      finishSlot(slot);
+    } else if (!slot.client.connected() || millis() - slot.lastData > GATEWAY_CLIENT_TIMEOUT) {
+      closeSlot(slot);
+    }
+  }
+}
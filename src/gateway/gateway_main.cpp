@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include "gateway.h"
+#include "gateway_spool.h"
+#include "../logger.h"
+
+static unsigned long lastStatus = 0;
+
+void setup() {
+  Serial.begin(115200);
+  delay(100);
+  LOG_I("GW", "=== Gateway do depósito ===");
+
+  if (!LittleFS.begin()) {
+    LOG_E("GW", "Falha ao montar o sistema de arquivos");
+  }
+  loadGatewayConfig();
+  spoolBegin();
+
+  // AP para as bikes (mesmo SSID/senha de uma base delas) + estação na
+  // rede do depósito para falar com o coletor
+  WiFi.mode(WIFI_AP_STA);
+  WiFi.softAP(gatewayConfig.apSSID, strlen(gatewayConfig.apPassword) >= 8 ? gatewayConfig.apPassword : nullptr);
+  LOG_I("GW", "AP %s em %s", gatewayConfig.apSSID, WiFi.softAPIP().toString().c_str());
+  if (strlen(gatewayConfig.upstreamSSID) > 0) {
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(gatewayConfig.upstreamSSID, gatewayConfig.upstreamPassword);
+    LOG_I("GW", "Conectando em %s, coletor %s", gatewayConfig.upstreamSSID, gatewayConfig.upstreamUrl);
+  }
+  // Horário para as bikes (GET /time): elas não alcançam o SNTP pelo AP
+  configTime(0, 0, "pool.ntp.org", "a.st1.ntp.br");
+
+  ingestBegin();
+  logFlush();
+}
+
+void loop() {
+  logDrain();
+  ingestPoll();
+  forwardPoll();
+
+  if (millis() - lastStatus > 60000) {
+    lastStatus = millis();
+    LOG_I("GW", "Bikes: %d | Rede: %s | Fila: %d segmentos, %u bytes", WiFi.softAPgetStationNum(),
+          WiFi.status() == WL_CONNECTED ? "ok" : "sem conexão", spoolSegments(), (unsigned)spoolBytes());
+  }
+  delay(1);
+}
@@ -0,0 +1,100 @@
+#include "gateway_spool.h"
+#include "../logger.h"
+#include <LittleFS.h>
+
+static uint32_t firstSeq = 0; // segmento mais antigo ainda no flash
+static uint32_t writeSeq = 0; // segmento recebendo lotes
+static size_t writeBytes = 0;
+static size_t totalBytes = 0;
+static unsigned long lastAppend = 0;
+
+static String segmentPath(uint32_t seq) {
+  return "/spool_" + String(seq) + ".bin";
+}
+
+void spoolBegin() {
+  // Retoma a fila que sobrou de antes do reinício
+  bool any = false;
+  totalBytes = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    String name = dir.fileName();
+    if (!name.startsWith("spool_")) continue;
+    uint32_t seq = name.substring(6).toInt();
+    if (!any || seq < firstSeq) firstSeq = seq;
+    if (!any || seq > writeSeq) writeSeq = seq;
+    totalBytes += dir.fileSize();
+    any = true;
+  }
+  if (any) writeSeq++; // nunca continua um segmento que pode estar pela metade
+  else firstSeq = writeSeq = 0;
+  writeBytes = 0;
+
+  LOG_I("GW", "Fila: %d segmentos, %u bytes", spoolSegments(), (unsigned)totalBytes);
+}
+
+bool spoolAppend(const uint8_t* data, size_t length) {
+  if (totalBytes + length > SPOOL_MAX_BYTES) {
+    LOG_W("GW", "Fila cheia (%u bytes) - recusando lote", (unsigned)totalBytes);
+    return false;
+  }
+  if (writeBytes >= SPOOL_SEGMENT_BYTES) {
+    writeSeq++;
+    writeBytes = 0;
+  }
+
+  File file = LittleFS.open(segmentPath(writeSeq).c_str(), "a");
+  if (!file) {
+    LOG_E("GW", "Falha ao abrir segmento %u", writeSeq);
+    return false;
+  }
+  size_t written = file.write(data, length);
+  file.close();
+  if (written != length) {
+    LOG_E("GW", "Flash cheia: %u de %u bytes gravados", (unsigned)written, (unsigned)length);
+    return false;
+  }
+
+  writeBytes += length;
+  totalBytes += length;
+  lastAppend = millis();
+  return true;
+}
+
+bool spoolOldest(String& path, size_t& size) {
+  // Segmento atual ocioso: fecha para não segurar os lotes indefinidamente
+  if (firstSeq == writeSeq && writeBytes > 0 && millis() - lastAppend >= SPOOL_IDLE_CLOSE_MS) {
+    writeSeq++;
+    writeBytes = 0;
+  }
+
+  while (firstSeq < writeSeq) {
+    path = segmentPath(firstSeq);
+    File file = LittleFS.open(path.c_str(), "r");
+    if (file) {
+      size = file.size();
+      file.close();
+      if (size > 0) return true;
+    }
+    firstSeq++; // buraco na sequência ou segmento vazio
+  }
+  return false;
+}
+
+void spoolRemove(const String& path) {
+  File file = LittleFS.open(path.c_str(), "r");
+  if (file) {
+    totalBytes -= min(totalBytes, (size_t)file.size());
+    file.close();
+  }
+  LittleFS.remove(path.c_str());
+  if (path == segmentPath(firstSeq)) firstSeq++;
+}
+
+size_t spoolBytes() {
+  return totalBytes;
+}
+
+int spoolSegments() {
+  return writeSeq - firstSeq + (writeBytes > 0 ? 1 : 0);
+}
@@ -0,0 +1,21 @@
+#ifndef GATEWAY_SPOOL_H
+#define GATEWAY_SPOOL_H
+
+#include <Arduino.h>
+
+// Fila em segmentos /spool_<seq>.bin, cada um com lotes concatenados.
+// O segmento atual recebe os lotes; os fechados vão inteiros ao coletor.
+
+#define SPOOL_SEGMENT_BYTES 16384   // fecha o segmento ao passar disso
+#define SPOOL_IDLE_CLOSE_MS 3000    // ou após esse tempo sem lotes novos
+#define SPOOL_MAX_BYTES 1048576     // acima disso recusa lotes (503)
+
+void spoolBegin();
+bool spoolAppend(const uint8_t* data, size_t length);
+// Segmento mais antigo pronto para envio; false se não há nenhum
+bool spoolOldest(String& path, size_t& size);
+void spoolRemove(const String& path);
+size_t spoolBytes();
+int spoolSegments();
+
+#endif
@@ -0,0 +1,219 @@
+#include "known_aps.h"
+#include "locator.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <Arduino.h>
+
+// Como o índice de APs, o filtro fica na flash: cada consulta lê um bloco de
+// 64 bytes. Na RAM só o arquivo aberto, o cabeçalho e os contadores.
+static File filterFile;
+static KnownApsHeader header;
+static bool ready = false;
+
+// Avistamentos de APs conhecidos por AP (32 bits baixos do hash, que o
+// backend recalcula para os APs que ele conhece); o que não cabe vai para other
+struct KnownCounter {
+  uint32_t tag;
+  uint16_t count;
+};
+static KnownCounter counters[KNOWN_COUNTER_SLOTS];
+static uint8_t counterCount = 0;
+static uint32_t knownSightings = 0;
+static uint32_t novelSightings = 0;
+static uint32_t otherSightings = 0;
+
+bool knownApsBegin() {
+  knownApsEnd();
+  if (!LittleFS.exists(KNOWN_APS_PATH)) return false;
+
+  filterFile = LittleFS.open(KNOWN_APS_PATH, "r");
+  if (!filterFile || filterFile.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      !knownApsHeaderValid(header) ||
+      filterFile.size() != sizeof(header) + header.blocks * KNOWN_APS_BLOCK_BYTES) {
+    LOG_E("KNOWN", "Filtro de APs conhecidos inválido");
+    knownApsEnd();
+    return false;
+  }
+
+  ready = true;
+  LOG_I("KNOWN", "Filtro de APs conhecidos: %u APs, %u KB, geração %u", (unsigned)header.count,
+        (unsigned)(header.blocks * KNOWN_APS_BLOCK_BYTES / 1024), (unsigned)header.generation);
+  return true;
+}
+
+void knownApsEnd() {
+  if (filterFile) filterFile.close();
+  ready = false;
+}
+
+bool knownApsReady() {
+  return ready;
+}
+
+uint32_t knownApsGeneration() {
+  return ready ? header.generation : 0;
+}
+
+uint32_t knownApsBlocks() {
+  return ready ? header.blocks : 0;
+}
+
+static void countKnown(uint32_t tag) {
+  knownSightings++;
+  for (int i = 0; i < counterCount; i++) {
+    if (counters[i].tag == tag) {
+      if (counters[i].count < 0xFFFF) counters[i].count++;
+      return;
+    }
+  }
+  if (counterCount < KNOWN_COUNTER_SLOTS) {
+    counters[counterCount++] = {tag, 1};
+  } else {
+    otherSightings++;
+  }
+}
+
+bool knownApsSighting(const WiFiNetwork& net) {
+  if (!ready) return false;
+  uint8_t bssid[6];
+  if (!parseBssid(net.bssid, bssid)) return false;
+
+  uint64_t hash = knownApHash(bssid, net.channel, net.ssid);
+  uint8_t block[KNOWN_APS_BLOCK_BYTES];
+  uint32_t offset = sizeof(header) + knownApBlock(hash, header.blocks) * KNOWN_APS_BLOCK_BYTES;
+  if (!filterFile.seek(offset) || filterFile.read(block, sizeof(block)) != sizeof(block)) return false;
+
+  uint16_t bits[KNOWN_APS_HASHES];
+  knownApBits(hash, bits);
+  for (int i = 0; i < KNOWN_APS_HASHES; i++) {
+    if (!(block[bits[i] >> 3] & (1 << (bits[i] & 7)))) {
+      novelSightings++;
+      return false;
+    }
+  }
+  countKnown((uint32_t)hash);
+  return true;
+}
+
+// Filtro inteiro: grava num temporário e só troca se chegou completo
+static bool receiveFilter(Stream& in, size_t length, uint32_t magic) {
+  KnownApsHeader fresh;
+  fresh.magic = magic;
+  if (in.readBytes((uint8_t*)&fresh + 4, sizeof(fresh) - 4) != sizeof(fresh) - 4 ||
+      !knownApsHeaderValid(fresh) || length != sizeof(fresh) + fresh.blocks * KNOWN_APS_BLOCK_BYTES) {
+    LOG_W("KNOWN", "Filtro recebido inválido");
+    return false;
+  }
+
+  File file = LittleFS.open(KNOWN_APS_TMP_PATH, "w");
+  if (!file) return false;
+  bool ok = file.write((const uint8_t*)&fresh, sizeof(fresh)) == sizeof(fresh);
+  uint8_t buf[256];
+  size_t left = length - sizeof(fresh);
+  while (ok && left > 0) {
+    size_t n = in.readBytes(buf, min(left, sizeof(buf)));
+    ok = n > 0 && file.write(buf, n) == n;
+    left -= n;
+    yield();
+  }
+  file.close();
+  if (!ok) {
+    LittleFS.remove(KNOWN_APS_TMP_PATH);
+    LOG_W("KNOWN", "Download do filtro incompleto");
+    return false;
+  }
+
+  knownApsEnd();
+  LittleFS.remove(KNOWN_APS_PATH);
+  LittleFS.rename(KNOWN_APS_TMP_PATH, KNOWN_APS_PATH);
+  return knownApsBegin();
+}
+
+// Patch: OR dos bits novos no arquivo, byte a byte (os índices vêm em ordem,
+// então cada byte é lido e escrito uma vez). A geração só muda no fim; se
+// cair no meio, o mesmo patch volta na próxima visita e o OR se repete.
+static bool receivePatch(Stream& in, size_t length, uint32_t magic) {
+  KnownApsPatchHeader patch;
+  patch.magic = magic;
+  // count vem da rede: comparado por divisão, count * 4 poderia estourar
+  if (length < sizeof(patch) || (length - sizeof(patch)) % 4 != 0 ||
+      in.readBytes((uint8_t*)&patch + 4, sizeof(patch) - 4) != sizeof(patch) - 4 ||
+      patch.version != KNOWN_APS_VERSION || patch.fromGeneration != knownApsGeneration() ||
+      patch.count != (length - sizeof(patch)) / 4) {
+    LOG_W("KNOWN", "Patch do filtro inválido");
+    return false;
+  }
+
+  if (patch.count == 0 && patch.toGeneration == patch.fromGeneration) return true;
+
+  KnownApsHeader current = header;
+  knownApsEnd();
+  File file = LittleFS.open(KNOWN_APS_PATH, "r+");
+  if (!file) {
+    knownApsBegin();
+    return false;
+  }
+
+  uint32_t limit = current.blocks * KNOWN_APS_BLOCK_BITS;
+  int32_t pendingOffset = -1;
+  uint8_t pending = 0;
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < patch.count; i++) {
+    uint32_t bit;
+    ok = in.readBytes((uint8_t*)&bit, 4) == 4 && bit < limit;
+    if (!ok) break;
+    int32_t offset = sizeof(current) + bit / 8;
+    if (offset != pendingOffset) {
+      if (pendingOffset >= 0) ok = file.seek(pendingOffset) && file.write(pending) == 1;
+      ok = ok && file.seek(offset) && file.read(&pending, 1) == 1;
+      pendingOffset = offset;
+    }
+    pending |= 1 << (bit % 8);
+    if ((i & 63) == 63) yield();
+  }
+  if (ok && pendingOffset >= 0) ok = file.seek(pendingOffset) && file.write(pending) == 1;
+  if (ok) {
+    current.generation = patch.toGeneration;
+    current.count = patch.apCount;
+    ok = file.seek(0) && file.write((const uint8_t*)&current, sizeof(current)) == sizeof(current);
+  }
+  file.close();
+  if (ok) {
+    LOG_I("KNOWN", "Patch do filtro: %u bits, geração %u -> %u", (unsigned)patch.count,
+          (unsigned)patch.fromGeneration, (unsigned)patch.toGeneration);
+  } else {
+    LOG_W("KNOWN", "Patch do filtro interrompido");
+  }
+  return knownApsBegin() && ok;
+}
+
+bool knownApsReceive(Stream& in, size_t length) {
+  uint32_t magic = 0;
+  if (length < 4 || in.readBytes((uint8_t*)&magic, 4) != 4) return false;
+  if (magic == KNOWN_APS_MAGIC) return receiveFilter(in, length, magic);
+  if (magic == KNOWN_APS_PATCH_MAGIC) return receivePatch(in, length, magic);
+  LOG_W("KNOWN", "Resposta do filtro desconhecida");
+  return false;
+}
+
+String knownApsStatusJson() {
+  String json = "{\"generation\":" + String(knownApsGeneration());
+  json += ",\"known\":" + String(knownSightings);
+  json += ",\"novel\":" + String(novelSightings);
+  json += ",\"other\":" + String(otherSightings);
+  json += ",\"counts\":[";
+  char tag[9];
+  for (int i = 0; i < counterCount; i++) {
+    if (i > 0) json += ",";
+    snprintf(tag, sizeof(tag), "%08x", (unsigned)counters[i].tag);
+    json += "[\"" + String(tag) + "\"," + String(counters[i].count) + "]";
+  }
+  return json + "]}";
+}
+
+void knownApsResetCounters() {
+  counterCount = 0;
+  knownSightings = 0;
+  novelSightings = 0;
+  otherSightings = 0;
+}
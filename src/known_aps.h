@@ -0,0 +1,30 @@
+#ifndef KNOWN_APS_H
+#define KNOWN_APS_H
+
+#include "config.h"
+#include "known_aps_format.h"
+#include <Arduino.h>
+
+#define KNOWN_APS_PATH "/known_aps.bin"
+#define KNOWN_APS_TMP_PATH "/known_aps.tmp"
+#define KNOWN_APS_SYNC_MS 3600000UL // no máximo uma sincronização por hora na base
+#define KNOWN_APS_RETRY_MS 300000UL
+#define KNOWN_COUNTER_SLOTS 32
+
+bool knownApsBegin();
+void knownApsEnd();
+bool knownApsReady();
+uint32_t knownApsGeneration(); // 0 sem filtro
+uint32_t knownApsBlocks();
+
+// Consulta o filtro e conta o avistamento; true se o AP já é conhecido
+bool knownApsSighting(const WiFiNetwork& net);
+
+// Corpo da resposta do backend: filtro inteiro ("BPRK") ou patch ("BPRP")
+bool knownApsReceive(Stream& in, size_t length);
+
+// Contadores desde o último status enviado, em JSON
+String knownApsStatusJson();
+void knownApsResetCounters();
+
+#endif
@@ -0,0 +1,35 @@
+#include "known_aps_format.h"
+
+// FNV-1a seguido da finalização do splitmix64, para espalhar bem os bits
+// mesmo com BSSIDs do mesmo fabricante (só os últimos bytes mudam)
+uint64_t knownApHash(const uint8_t bssid[6], uint8_t channel, const char* ssid) {
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for (int i = 0; i < 6; i++) h = (h ^ bssid[i]) * 0x100000001B3ULL;
+  h = (h ^ channel) * 0x100000001B3ULL;
+  for (const char* p = ssid; *p; p++) h = (h ^ (uint8_t)*p) * 0x100000001B3ULL;
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  return h;
+}
+
+uint32_t knownApBlock(uint64_t hash, uint32_t blocks) {
+  return (uint32_t)(hash >> 32) % blocks;
+}
+
+// Hash duplo dentro do bloco: passo ímpar, então os bits são distintos
+void knownApBits(uint64_t hash, uint16_t bits[KNOWN_APS_HASHES]) {
+  uint32_t low = (uint32_t)hash;
+  uint32_t first = low % KNOWN_APS_BLOCK_BITS;
+  uint32_t step = ((low >> 9) % KNOWN_APS_BLOCK_BITS) | 1;
+  for (int i = 0; i < KNOWN_APS_HASHES; i++) {
+    bits[i] = (first + i * step) % KNOWN_APS_BLOCK_BITS;
+  }
+}
+
+bool knownApsHeaderValid(const KnownApsHeader& header) {
+  return header.magic == KNOWN_APS_MAGIC && header.version == KNOWN_APS_VERSION &&
+         header.hashes == KNOWN_APS_HASHES && header.blocks > 0 && header.blocks <= KNOWN_APS_MAX_BLOCKS;
+}
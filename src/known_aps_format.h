@@ -0,0 +1,54 @@
+#ifndef KNOWN_APS_FORMAT_H
+#define KNOWN_APS_FORMAT_H
+
+// Filtro de APs já mapeados, montado pelo backend e baixado pela bike
+// (src/known_aps.h). Só C++ puro, little endian; também usado pelo coletor.
+//
+// Filtro ("BPRK"): KnownApsHeader + blocks x 64 bytes de bits. É um Bloom em
+//   blocos: o hash escolhe um bloco e KNOWN_APS_HASHES bits dentro dele, e
+//   uma consulta lê só esses 64 bytes.
+// Patch ("BPRP"): KnownApsPatchHeader + count x u32, os índices de bit
+//   (no arquivo inteiro, em ordem crescente) ligados entre as duas gerações.
+//   Um Bloom só ganha bits, então o patch é só um OR.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define KNOWN_APS_MAGIC 0x4B525042       // "BPRK"
+#define KNOWN_APS_PATCH_MAGIC 0x50525042 // "BPRP"
+#define KNOWN_APS_VERSION 1
+#define KNOWN_APS_BLOCK_BYTES 64
+#define KNOWN_APS_BLOCK_BITS (KNOWN_APS_BLOCK_BYTES * 8)
+#define KNOWN_APS_HASHES 7
+#define KNOWN_APS_DEFAULT_BLOCKS 1024 // 64 KB: ~45 mil APs com ~1% de falso positivo
+#define KNOWN_APS_MAX_BLOCKS 4096     // 256 KB
+
+struct KnownApsHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t hashes;
+  uint8_t reserved;
+  uint32_t blocks;
+  uint32_t generation; // sobe a cada mudança no backend
+  uint32_t count;      // APs inseridos
+};
+
+struct KnownApsPatchHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t fromGeneration;
+  uint32_t toGeneration;
+  uint32_t count;   // índices de bit que seguem
+  uint32_t apCount; // APs no filtro na geração nova
+};
+
+// Identidade do AP: BSSID, canal e SSID. Trocar de canal ou de nome o torna
+// novo de novo.
+uint64_t knownApHash(const uint8_t bssid[6], uint8_t channel, const char* ssid);
+uint32_t knownApBlock(uint64_t hash, uint32_t blocks);
+// Os KNOWN_APS_HASHES bits (0..511) do AP dentro do seu bloco
+void knownApBits(uint64_t hash, uint16_t bits[KNOWN_APS_HASHES]);
+bool knownApsHeaderValid(const KnownApsHeader& header);
+
+#endif
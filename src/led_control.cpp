@@ -2,6 +2,10 @@
 #include "config.h"
 #include <Arduino.h>
 
+unsigned long lastLedBlink = 0;
+int ledState = LOW;
+int ledStep = 0;
+
 void updateLED() {
   unsigned long now = millis();
   
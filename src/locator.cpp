@@ -0,0 +1,179 @@
+#include "locator.h"
+#include "wifi_scanner.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <Arduino.h>
+
+// O índice fica na flash; na RAM só o arquivo aberto e uma "cerca" com o
+// primeiro BSSID de cada bloco (até 256 x 6 bytes), que reduz a busca
+// binária no arquivo a um único bloco
+PositionFix lastFix = {false, 0, 0, 0, 0};
+
+static File indexFile;
+static uint32_t indexCount = 0;
+static uint32_t fenceStride = 0;
+static uint16_t fenceCount = 0;
+static uint8_t (*fences)[6] = nullptr;
+
+static int compareBssid(const uint8_t* a, const uint8_t* b) {
+  return memcmp(a, b, 6);
+}
+
+static bool readRecord(uint32_t i, ApIndexRecord& record) {
+  if (!indexFile.seek(sizeof(ApIndexHeader) + i * sizeof(ApIndexRecord))) return false;
+  return indexFile.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+}
+
+bool locatorBegin() {
+  locatorEnd();
+
+  if (!LittleFS.exists(AP_INDEX_PATH)) {
+    LOG_W("LOC", "Índice de APs não encontrado (%s)", AP_INDEX_PATH);
+    return false;
+  }
+
+  indexFile = LittleFS.open(AP_INDEX_PATH, "r");
+  ApIndexHeader header;
+  if (!indexFile || indexFile.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != AP_INDEX_MAGIC || header.version != AP_INDEX_VERSION ||
+      header.recordSize != sizeof(ApIndexRecord) || header.count == 0) {
+    LOG_E("LOC", "Índice de APs inválido");
+    locatorEnd();
+    return false;
+  }
+
+  indexCount = header.count;
+  fenceStride = (indexCount + AP_INDEX_FENCE_MAX - 1) / AP_INDEX_FENCE_MAX;
+  fenceCount = (indexCount + fenceStride - 1) / fenceStride;
+  fences = (uint8_t (*)[6])malloc(fenceCount * 6);
+  if (!fences) {
+    LOG_E("LOC", "Sem memória para o índice de APs");
+    locatorEnd();
+    return false;
+  }
+
+  ApIndexRecord record;
+  for (uint16_t i = 0; i < fenceCount; i++) {
+    if (!readRecord(i * fenceStride, record)) {
+      LOG_E("LOC", "Índice de APs truncado");
+      locatorEnd();
+      return false;
+    }
+    memcpy(fences[i], record.bssid, 6);
+  }
+
+  LOG_I("LOC", "Índice de APs: %u registros, %u blocos", (unsigned)indexCount, (unsigned)fenceCount);
+  return true;
+}
+
+void locatorEnd() {
+  if (indexFile) indexFile.close();
+  free(fences);
+  fences = nullptr;
+  indexCount = 0;
+  fenceCount = 0;
+}
+
+bool locatorReady() {
+  return fences != nullptr;
+}
+
+bool parseBssid(const char* str, uint8_t out[6]) {
+  for (int i = 0; i < 6; i++) {
+    char* end;
+    long value = strtol(str, &end, 16);
+    if (end == str || value < 0 || value > 255) return false;
+    out[i] = value;
+    if (i < 5 && *end != ':') return false;
+    str = end + 1;
+  }
+  return true;
+}
+
+bool lookupAp(const uint8_t bssid[6], ApIndexRecord& record) {
+  if (!locatorReady()) return false;
+
+  // Último bloco cujo primeiro BSSID é <= bssid
+  int lo = 0, hi = fenceCount - 1, block = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (compareBssid(fences[mid], bssid) <= 0) {
+      block = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  if (block < 0) return false;
+
+  int32_t first = block * fenceStride;
+  int32_t last = min((uint32_t)(block + 1) * fenceStride, indexCount) - 1;
+  while (first <= last) {
+    int32_t mid = (first + last) / 2;
+    if (!readRecord(mid, record)) return false;
+    int cmp = compareBssid(record.bssid, bssid);
+    if (cmp == 0) return true;
+    if (cmp < 0) first = mid + 1;
+    else last = mid - 1;
+  }
+  return false;
+}
+
+PositionFix locateScan(const WiFiNetwork* nets, int count) {
+  PositionFix fix = {false, 0, 0, 0, 0};
+  if (!locatorReady()) return fix;
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  unsigned long start = micros();
+#endif
+
+  struct Match {
+    int32_t latE7;
+    int32_t lonE7;
+    uint32_t weight;
+  };
+  Match matches[MAX_NETWORKS];
+  int matched = 0;
+  int64_t sumLat = 0, sumLon = 0, sumWeight = 0;
+
+  for (int i = 0; i < count; i++) {
+    if (isOwnNetwork(nets[i].ssid)) continue;
+    uint8_t bssid[6];
+    ApIndexRecord record;
+    if (!parseBssid(nets[i].bssid, bssid) || !lookupAp(bssid, record)) continue;
+
+    // Peso do índice x sinal acima do piso de -100 dBm
+    uint32_t signal = constrain(nets[i].rssi + 100, 1, 70);
+    uint32_t weight = (uint32_t)max(record.weight, (uint16_t)1) * signal;
+    matches[matched++] = {record.latE7, record.lonE7, weight};
+    sumLat += (int64_t)record.latE7 * weight;
+    sumLon += (int64_t)record.lonE7 * weight;
+    sumWeight += weight;
+  }
+
+  if (matched == 0) return fix;
+
+  fix.valid = true;
+  fix.matched = matched;
+  fix.latE7 = sumLat / sumWeight;
+  fix.lonE7 = sumLon / sumWeight;
+
+  // Espalhamento ponderado (m) em torno do centróide; 1e-7 grau ~ 1,1 cm
+  float cosLat = cos(fix.latE7 / 1e7 * PI / 180.0);
+  float spreadSq = 0;
+  for (int i = 0; i < matched; i++) {
+    float dy = (matches[i].latE7 - fix.latE7) * 0.0111f;
+    float dx = (matches[i].lonE7 - fix.lonE7) * 0.0111f * cosLat;
+    spreadSq += (dx * dx + dy * dy) * matches[i].weight;
+  }
+  float spread = sqrt(spreadSq / sumWeight);
+
+  // Até 60 pontos pela quantidade de APs, até 40 por espalhamento pequeno
+  int countScore = min(matched, 5) * 12;
+  int spreadScore = spread <= 25 ? 40 : (spread >= 200 ? 0 : (int)(40 * (200 - spread) / 175));
+  fix.confidence = countScore + spreadScore;
+
+  LOG_D("LOC", "Posição %d APs, espalhamento %dm, confiança %d%% em %luus",
+        matched, (int)spread, fix.confidence, micros() - start);
+  return fix;
+}
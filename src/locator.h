@@ -0,0 +1,45 @@
+#ifndef LOCATOR_H
+#define LOCATOR_H
+
+#include "config.h"
+#include <Arduino.h>
+
+#define AP_INDEX_PATH "/ap_index.bin"
+#define AP_INDEX_MAGIC 0x49525042 // "BPRI"
+#define AP_INDEX_VERSION 1
+#define AP_INDEX_FENCE_MAX 256
+
+// Arquivo: cabeçalho + registros ordenados por BSSID (little endian)
+struct ApIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+struct ApIndexRecord {
+  uint8_t bssid[6];
+  uint16_t weight;
+  int32_t latE7;
+  int32_t lonE7;
+};
+
+struct PositionFix {
+  bool valid;
+  int32_t latE7;
+  int32_t lonE7;
+  uint8_t confidence; // 0-100
+  uint8_t matched;
+};
+
+extern PositionFix lastFix;
+
+bool locatorBegin();
+void locatorEnd();
+bool locatorReady();
+bool parseBssid(const char* str, uint8_t out[6]);
+bool lookupAp(const uint8_t bssid[6], ApIndexRecord& record);
+PositionFix locateScan(const WiFiNetwork* nets, int count);
+
+#endif
@@ -0,0 +1,91 @@
+#include "logger.h"
+#include <Arduino.h>
+
+// Buffer circular: logWrite() só copia para RAM; logDrain() envia para a
+// serial apenas o que cabe na FIFO da UART, sem bloquear o loop
+static char logBuffer[LOG_BUFFER_SIZE];
+static uint32_t logHead = 0;    // total de bytes escritos
+static uint32_t logDrained = 0; // total de bytes enviados para a serial
+static uint32_t logDropped = 0;
+static bool logHeld = false;
+
+static const char levelChars[] = "-EWID";
+
+static void logPut(const char* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    logBuffer[logHead % LOG_BUFFER_SIZE] = data[i];
+    logHead++;
+  }
+  // Serial muito atrasada: descarta o mais antigo
+  if (logHead - logDrained > LOG_BUFFER_SIZE) {
+    logDropped += logHead - logDrained - LOG_BUFFER_SIZE;
+    logDrained = logHead - LOG_BUFFER_SIZE;
+  }
+}
+
+void logWrite(uint8_t level, PGM_P tag, PGM_P fmt, ...) {
+  char line[LOG_LINE_MAX];
+  char tagBuf[12];
+  strncpy_P(tagBuf, tag, sizeof(tagBuf) - 1);
+  tagBuf[sizeof(tagBuf) - 1] = '\0';
+
+  int len = snprintf(line, sizeof(line), "[%c][%s] ", levelChars[level], tagBuf);
+
+  va_list args;
+  va_start(args, fmt);
+  int msgLen = vsnprintf_P(line + len, sizeof(line) - len - 1, fmt, args);
+  va_end(args);
+
+  if (msgLen < 0) msgLen = 0;
+  len += min(msgLen, (int)sizeof(line) - len - 2);
+  line[len++] = '\n';
+  logPut(line, len);
+}
+
+void logHold(bool hold) {
+  logHeld = hold;
+}
+
+void logDrain() {
+  if (logHeld) return;
+  int room = Serial.availableForWrite();
+  while (room > 0 && logDrained < logHead) {
+    uint32_t pos = logDrained % LOG_BUFFER_SIZE;
+    size_t chunk = min((uint32_t)room, logHead - logDrained);
+    chunk = min(chunk, (size_t)(LOG_BUFFER_SIZE - pos));
+    Serial.write((const uint8_t*)&logBuffer[pos], chunk);
+    logDrained += chunk;
+    room -= chunk;
+  }
+}
+
+void logFlush() {
+  while (!logHeld && logDrained < logHead) {
+    logDrain();
+    yield();
+  }
+  Serial.flush();
+}
+
+String logTail(size_t maxBytes) {
+  size_t available = min(logHead, (uint32_t)LOG_BUFFER_SIZE);
+  size_t len = min(maxBytes, available);
+  uint32_t start = logHead - len;
+
+  // Começa numa linha inteira
+  while (len > 0 && start != logHead - available && logBuffer[(start - 1) % LOG_BUFFER_SIZE] != '\n') {
+    start++;
+    len--;
+  }
+
+  String tail;
+  tail.reserve(len);
+  for (uint32_t i = start; i < logHead; i++) {
+    tail += logBuffer[i % LOG_BUFFER_SIZE];
+  }
+  return tail;
+}
+
+uint32_t logDroppedBytes() {
+  return logDropped;
+}
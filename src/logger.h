@@ -0,0 +1,58 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "capacity.h"
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// Nível máximo compilado; definido por env no platformio.ini
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE ((size_t)CAPACITY.logBuffer)
+#endif
+
+#define LOG_LINE_MAX 160
+
+void logWrite(uint8_t level, PGM_P tag, PGM_P fmt, ...);
+void logDrain();
+void logFlush();
+// Retém o log na RAM (descartando o mais antigo se encher) enquanto outra
+// saída usa a serial sem ser interrompida
+void logHold(bool hold);
+String logTail(size_t maxBytes);
+uint32_t logDroppedBytes();
+
+// Formatos e tags ficam na flash (PSTR); níveis acima de LOG_LEVEL somem do binário
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(tag, fmt, ...) logWrite(LOG_LEVEL_ERROR, PSTR(tag), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_E(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(tag, fmt, ...) logWrite(LOG_LEVEL_WARN, PSTR(tag), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_W(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(tag, fmt, ...) logWrite(LOG_LEVEL_INFO, PSTR(tag), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_I(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(tag, fmt, ...) logWrite(LOG_LEVEL_DEBUG, PSTR(tag), PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_D(tag, fmt, ...) do {} while (0)
+#endif
+
+#endif
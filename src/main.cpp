@@ -4,26 +4,26 @@
 #include "config.h"
 #include "wifi_scanner.h"
 #include "web_server.h"
-#include "firebase.h"
+#include "upload_backend.h"
 #include "led_control.h"
 #include "serial_menu.h"
 #include "status_tracker.h"
+#include "logger.h"
+#include "locator.h"
+#include "known_aps.h"
+#include "aggregator.h"
+#include "ota.h"
+#include "power_governor.h"
+#include "trip_segmenter.h"
+#include "time_base.h"
+#include "trace_recorder.h"
+#include "profiler.h"
 
-// Global variables
-Config config;
-WiFiNetwork networks[30];
-int networkCount = 0;
-ScanData dataBuffer[20];
-int dataCount = 0;
-ESP8266WebServer server(80);
-bool configMode = false;
-bool timeSync = false;
-unsigned long lastLedBlink = 0;
-int ledState = LOW;
-int ledStep = 0;
+// Os globais compartilhados ficam nos módulos (config.cpp, web_server.cpp,
+// led_control.cpp): o resto do src/ linka sem este arquivo nos testes
 unsigned long lastStatusUpload = 0;
-WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP, "pool.ntp.org", -3 * 3600, 60000);
+bool visitStatusSent = false; // status já enviado nesta visita à base
+unsigned long lastScanCycle = 0;
 
 void setup() {
   Serial.begin(115200);
@@ -32,32 +32,42 @@ void setup() {
   delay(2000);
   
   if (!LittleFS.begin()) {
-    Serial.println("Falha ao montar sistema de arquivos. Formatando...");
+    LOG_E("MAIN", "Falha ao montar sistema de arquivos. Formatando...");
     LittleFS.format();
     if (!LittleFS.begin()) {
-      Serial.println("Falha ao montar sistema de arquivos mesmo após formatação");
+      LOG_E("MAIN", "Falha ao montar sistema de arquivos mesmo após formatação");
     }
   }
   
   loadConfig();
+  timeBaseBegin();
+  traceBegin();
+  dataCount = countStoredScans();
+  if (config.recordMode == RECORD_POSITION && !locatorBegin()) {
+    LOG_W("MAIN", "Localização indisponível - gravando lista de redes");
+  }
+  knownApsBegin();
+  if (config.recordMode == RECORD_AGGREGATE) aggregatorBegin();
+  powerBegin();
+  capacityCheckHeap();
 
   pinMode(0, INPUT_PULLUP);
   delay(100);
   bool forceConfig = digitalRead(0) == LOW;
   bool nearBase = false;
   
-  Serial.println("\n=== WIFI RANGE SCANNER ===");
-  Serial.printf("Bicicleta: %s\n", config.bikeId);
-  Serial.printf("Botão FLASH: %s\n", forceConfig ? "PRESSIONADO" : "LIVRE");
+  LOG_I("MAIN", "=== WIFI RANGE SCANNER ===");
+  LOG_I("MAIN", "Bicicleta: %s", config.bikeId);
+  LOG_I("MAIN", "Botão FLASH: %s", forceConfig ? "PRESSIONADO" : "LIVRE");
   
   if (forceConfig) {
-    Serial.println("Botão FLASH detectado - Modo configuração");
+    LOG_I("MAIN", "Botão FLASH detectado - Modo configuração");
   } else if (strlen(config.baseSSID1) > 0) {
-    Serial.println("Verificando bases WiFi...");
+    LOG_I("MAIN", "Verificando bases WiFi...");
     scanWiFiNetworks();
     nearBase = checkAtBase();
     if (nearBase) {
-      Serial.println("Base WiFi detectada - Modo configuração");
+      LOG_I("MAIN", "Base WiFi detectada - Modo configuração");
     }
   }
   
@@ -67,72 +77,93 @@ void setup() {
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
     delay(100);
-    Serial.println("Iniciando scanner WiFi...");
-    Serial.println("=========================");
+    LOG_I("MAIN", "Iniciando scanner WiFi...");
   }
+  logFlush();
 }
 
 void loop() {
   updateLED();
+  logDrain();
+  timeBaseUpdate();
   
   if (configMode) {
-    server.handleClient();
+    webServerLoop();
     return;
   }
 
-  if (Serial.available()) {
-    char cmd = Serial.peek();
-    if (cmd == 'm' || cmd == 'M') {
-      Serial.read();
-      Serial.println("\n=== MENU ATIVADO ===");
-      showMenu();
-      
-      unsigned long menuStart = millis();
-      while (millis() - menuStart < 30000) { // Timeout 30s
-        handleSerialMenu();
-        if (Serial.available() && (Serial.peek() == 'q' || Serial.peek() == 'Q')) {
-          Serial.read();
-          Serial.println("\nVoltando ao modo normal...");
-          break;
-        }
-        delay(50); // Reduzido para ser mais responsivo
-        yield(); // Permite outras tarefas do ESP8266
-      }
-      if (millis() - menuStart >= 30000) {
-        Serial.println("\nMenu timeout - voltando ao modo normal...");
-      }
-    } else {
-      Serial.read();
-    }
+  handleSerialConsole();
+
+  // Agenda o ciclo de coleta sem delay(), para o console e o LED
+  // continuarem respondendo entre os scans
+  unsigned long scanDelay = powerScanInterval(config.isAtBase ? config.scanTimeInactive : config.scanTimeActive);
+  unsigned long now = millis();
+  if (lastScanCycle != 0 && now - lastScanCycle < scanDelay) {
+    delay(10);
+    return;
   }
+  lastScanCycle = now;
 
+  PROFILE_BEGIN(STAGE_SCAN);
+  powerWakeRadio();
   scanWiFiNetworks();
+  PROFILE_END(STAGE_SCAN);
+  PROFILE_BEGIN(STAGE_STORE);
   storeData();
+  PROFILE_END(STAGE_STORE);
+
+  PROFILE_BEGIN(STAGE_TRIP);
+  int baseIndex = findBase(BASE_MIN_RSSI);
+  // Ao chegar à base, fecha a janela de estatísticas para ela subir já
+  bool arrived = baseIndex > 0 && !config.isAtBase;
+  config.isAtBase = baseIndex > 0;
+  if (!config.isAtBase) visitStatusSent = false;
+  if (arrived && config.recordMode == RECORD_AGGREGATE) aggregateFlush();
+  tripUpdate(timeTicks(), baseIndex, config.isAtBase);
+  powerUpdate(config.isAtBase);
+  PROFILE_END(STAGE_TRIP);
 
-  config.isAtBase = checkAtBase();
+  // Pedidos do console (teste de base, upload, status) usam a conexão da
+  // visita à base; longe dela são recusados sem tentar conectar
+  bool consoleTasks = consoleTasksPending();
+  if (consoleTasks && !config.isAtBase) runConsoleTasks(false);
 
-  if (config.isAtBase) {
-    if (connectToBase()) {
+  // Nos níveis de economia, tentativas de upload mais espaçadas
+  bool upload = config.isAtBase && powerAllowUpload();
+  if (upload || (consoleTasks && config.isAtBase)) {
+    PROFILE_BEGIN(STAGE_UPLOAD);
+    bool connected = connectToBase();
+    if (consoleTasks) runConsoleTasks(connected);
+    if (connected && !upload) disconnectFromBase();
+    if (connected && upload) {
+      unsigned long uploadStart = millis();
       syncTime();
-      
-      // Upload scans se houver dados
-      if (dataCount > 0) {
-        uploadData();
-      }
-      
-      // Upload status automaticamente a cada 5 minutos
-      unsigned long now = millis();
-      if (now - lastStatusUpload > 300000) { // 5 minutos
-        uploadStatus();
+      // Viagens, resumos e scans, conforme o modo de registro
+      int finished = uploadTrips() + uploadSummaries();
+      syncKnownAps();
+      // Antes dos scans: eles ficam no flash se a atualização reiniciar a bike
+      otaUpdate();
+      uploadData();
+
+      // Status na chegada e quando sobem viagens ou resumos; parada na base,
+      // a cada 5 minutos (os scans de bike parada sobem a cada ciclo)
+      now = millis();
+      if (!visitStatusSent || finished > 0 || now - lastStatusUpload > 300000) {
+        if (uploadStatus()) visitStatusSent = true;
         lastStatusUpload = now;
       }
+      disconnectFromBase();
+      powerRecord(POWER_UPLOAD, millis() - uploadStart);
     }
+    PROFILE_END(STAGE_UPLOAD);
   }
 
-  int scanDelay = config.isAtBase ? config.scanTimeInactive : config.scanTimeActive;
-  float battery = getBatteryLevel();
-  Serial.printf("=== Bike %s - %d redes - Bat: %.1f%% ===\n", config.bikeId, networkCount, battery);
-  Serial.printf("Status: %s | Buffer: %d | Próximo: %ds | Digite 'm' para menu\n",
-                config.isAtBase ? "BASE" : "MOVIMENTO", dataCount, scanDelay / 1000);
-  delay(scanDelay);
+  // Longe da base, nos níveis de economia, o rádio dorme até o próximo scan
+  if (!config.isAtBase) powerSleepRadio();
+
+  scanDelay = powerScanInterval(config.isAtBase ? config.scanTimeInactive : config.scanTimeActive);
+  float battery = lastBatteryLevel();
+  LOG_I("MAIN", "Bike %s | %d redes | Bat: %.1f%% | %s | Buffer: %d | Energia: %d | Próximo: %lus",
+        config.bikeId, (int)networks.size(), battery, config.isAtBase ? "BASE" : "MOVIMENTO",
+        dataCount, powerLevel(), scanDelay / 1000);
 }
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "ota.h"
+#include "config.h"
+#include "upload_backend.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <Updater.h>
+#include <bearssl/bearssl_hash.h>
+#include <Arduino.h>
+
+struct OtaManifest {
+  String version;
+  String path;   // imagem no servidor
+  uint32_t size; // bytes da imagem gzip
+  String sha256; // hex minúsculo da imagem gzip
+};
+
+static uint32_t pendingSize = 0;
+
+static uint32_t fileSize(const char* path) {
+  File file = LittleFS.open(path, "r");
+  if (!file) return 0;
+  uint32_t size = file.size();
+  file.close();
+  return size;
+}
+
+static void discardImage() {
+  LittleFS.remove(OTA_IMAGE_PATH);
+  LittleFS.remove(OTA_STATE_PATH);
+  pendingSize = 0;
+}
+
+// Manifesto: versão, caminho da imagem, tamanho, SHA-256 (uma por linha)
+static bool fetchManifest(const UploadBackend& backend, OtaManifest& manifest) {
+  File file = LittleFS.open(OTA_MANIFEST_PATH, "w");
+  if (!file) return false;
+  long received = backend.fetchFile(OTA_MANIFEST_URL, 0, 512, file);
+  file.close();
+  if (received <= 0) {
+    LittleFS.remove(OTA_MANIFEST_PATH);
+    return false;
+  }
+
+  file = LittleFS.open(OTA_MANIFEST_PATH, "r");
+  manifest.version = file.readStringUntil('\n');
+  manifest.path = file.readStringUntil('\n');
+  String size = file.readStringUntil('\n');
+  manifest.sha256 = file.readStringUntil('\n');
+  file.close();
+  LittleFS.remove(OTA_MANIFEST_PATH);
+
+  manifest.version.trim();
+  manifest.path.trim();
+  size.trim();
+  manifest.sha256.trim();
+  manifest.sha256.toLowerCase();
+  manifest.size = size.toInt();
+  return manifest.version.length() > 0 && manifest.path.startsWith("/") && manifest.size > 0 &&
+         manifest.sha256.length() == 64;
+}
+
+// O download em /ota.gz só continua se for da mesma imagem
+static bool stateMatches(const OtaManifest& manifest) {
+  File file = LittleFS.open(OTA_STATE_PATH, "r");
+  if (!file) return false;
+  String version = file.readStringUntil('\n');
+  String sha256 = file.readStringUntil('\n');
+  file.close();
+  version.trim();
+  sha256.trim();
+  return version == manifest.version && sha256 == manifest.sha256;
+}
+
+static bool hasSpaceFor(const OtaManifest& manifest, uint32_t downloaded) {
+  if (manifest.size > ESP.getFreeSketchSpace()) {
+    LOG_W("OTA", "Imagem de %u bytes não cabe na partição (%u livres)", manifest.size,
+          ESP.getFreeSketchSpace());
+    return false;
+  }
+  FSInfo info;
+  LittleFS.info(info);
+  uint32_t free = info.totalBytes > info.usedBytes ? info.totalBytes - info.usedBytes : 0;
+  if (manifest.size - downloaded + OTA_FS_RESERVE > free) {
+    LOG_W("OTA", "Sem espaço no flash para a imagem (%u livres)", free);
+    return false;
+  }
+  return true;
+}
+
+static bool verifyImage(const OtaManifest& manifest) {
+  File file = LittleFS.open(OTA_IMAGE_PATH, "r");
+  if (!file) return false;
+  br_sha256_context ctx;
+  br_sha256_init(&ctx);
+  uint8_t buf[512];
+  size_t n;
+  while ((n = file.read(buf, sizeof(buf))) > 0) {
+    br_sha256_update(&ctx, buf, n);
+    yield();
+  }
+  file.close();
+
+  uint8_t hash[br_sha256_SIZE];
+  br_sha256_out(&ctx, hash);
+  char hex[2 * br_sha256_SIZE + 1];
+  for (int i = 0; i < br_sha256_SIZE; i++) sprintf(hex + 2 * i, "%02x", hash[i]);
+  return manifest.sha256 == hex;
+}
+
+// Grava a imagem gzip como veio: o Updater aceita gzip e o eboot
+// descompacta no próximo boot
+static bool installImage(const OtaManifest& manifest) {
+  File file = LittleFS.open(OTA_IMAGE_PATH, "r");
+  if (!file) return false;
+  if (!Update.begin(manifest.size)) {
+    LOG_E("OTA", "Update.begin falhou (erro %u)", Update.getError());
+    file.close();
+    return false;
+  }
+  size_t written = Update.writeStream(file);
+  file.close();
+  if (written != manifest.size || !Update.end()) {
+    LOG_E("OTA", "Gravação falhou: %u de %u bytes (erro %u)", (unsigned)written, manifest.size,
+          Update.getError());
+    return false;
+  }
+  return true;
+}
+
+// Baixa pedaços com Range até completar ou esgotar o tempo da visita
+static bool download(const UploadBackend& backend, const OtaManifest& manifest, uint32_t& downloaded) {
+  unsigned long start = millis();
+  while (downloaded < manifest.size && millis() - start < OTA_VISIT_MS) {
+    File file = LittleFS.open(OTA_IMAGE_PATH, "a");
+    if (!file) return false;
+    uint32_t chunk = min((uint32_t)OTA_CHUNK_BYTES, manifest.size - downloaded);
+    long received = backend.fetchFile(manifest.path.c_str(), downloaded, chunk, file);
+    file.close();
+    if (received > 0) downloaded += received;
+    if (received < (long)chunk) {
+      LOG_W("OTA", "Download interrompido em %u de %u bytes", downloaded, manifest.size);
+      return false;
+    }
+    yield();
+  }
+  return true;
+}
+
+static bool runUpdate(const UploadBackend& backend) {
+  OtaManifest manifest;
+  if (!fetchManifest(backend, manifest)) {
+    LOG_W("OTA", "Manifesto de firmware indisponível");
+    return false;
+  }
+  if (manifest.version == FIRMWARE_VERSION) {
+    if (pendingSize > 0 || LittleFS.exists(OTA_IMAGE_PATH)) discardImage();
+    return true;
+  }
+
+  if (!stateMatches(manifest)) {
+    discardImage();
+    File state = LittleFS.open(OTA_STATE_PATH, "w");
+    if (!state) return false;
+    state.print(manifest.version + "\n" + manifest.sha256 + "\n");
+    state.close();
+    LOG_I("OTA", "Nova versão %s (atual %s): %u bytes", manifest.version.c_str(), FIRMWARE_VERSION,
+          manifest.size);
+  }
+
+  uint32_t downloaded = fileSize(OTA_IMAGE_PATH);
+  if (downloaded > manifest.size) {
+    discardImage();
+    return false;
+  }
+  if (!hasSpaceFor(manifest, downloaded)) return false;
+
+  pendingSize = manifest.size;
+  uint32_t before = downloaded;
+  bool ok = download(backend, manifest, downloaded);
+  LOG_I("OTA", "Imagem %s: %u/%u bytes (+%u)", manifest.version.c_str(), downloaded, manifest.size,
+        downloaded - before);
+  if (!ok || downloaded < manifest.size) return ok;
+
+  if (!verifyImage(manifest)) {
+    LOG_E("OTA", "SHA-256 não confere - imagem descartada");
+    discardImage();
+    return false;
+  }
+  if (!installImage(manifest)) {
+    discardImage();
+    return false;
+  }
+
+  discardImage();
+  LOG_I("OTA", "Firmware %s gravado - reiniciando", manifest.version.c_str());
+  logFlush();
+  delay(100);
+  ESP.restart();
+  return true;
+}
+
+// Manifesto na primeira visita depois do boot e depois a cada OTA_CHECK_MS;
+// com download pela metade, continua a cada ciclo na base
+static bool lastOk = false;
+
+void otaUpdate() {
+  static unsigned long lastAttempt = 0;
+  static bool attempted = false;
+  if (strcmp(FIRMWARE_VERSION, "dev") == 0) return;
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured() || !backend.fetchFile) return;
+
+  unsigned long wait = !lastOk ? OTA_RETRY_MS : pendingSize > 0 ? 0 : OTA_CHECK_MS;
+  if (attempted && millis() - lastAttempt < wait) return;
+
+  attempted = true;
+  lastAttempt = millis();
+  lastOk = runUpdate(backend);
+}
+
+uint32_t otaDownloaded() {
+  return pendingSize > 0 ? fileSize(OTA_IMAGE_PATH) : 0;
+}
+
+uint32_t otaPendingSize() {
+  return pendingSize;
+}
+
+bool otaCheckOk() {
+  return lastOk;
+}
@@ -0,0 +1,29 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include <Arduino.h>
+
+// Atualização do firmware pela base: o servidor do backend publica um
+// manifesto e uma imagem gzip; a bike baixa a imagem em pedaços para o
+// flash (retomando na visita seguinte), confere o SHA-256 e só então grava.
+#define OTA_MANIFEST_URL "/firmware/manifest.txt"
+#define OTA_MANIFEST_PATH "/ota_manifest.txt"
+#define OTA_IMAGE_PATH "/ota.gz"
+#define OTA_STATE_PATH "/ota_state.txt"  // versão e hash da imagem em /ota.gz
+#define OTA_CHUNK_BYTES 16384
+#define OTA_VISIT_MS 30000UL             // tempo máximo de download por ciclo na base
+#define OTA_CHECK_MS 3600000UL
+#define OTA_RETRY_MS 300000UL
+#define OTA_FS_RESERVE 32768             // espaço que os scans continuam tendo
+
+// Na base, depois dos uploads: confere o manifesto e avança o download.
+// Com a imagem completa e verificada, grava e reinicia (não retorna)
+void otaUpdate();
+
+// Bytes já baixados e tamanho da imagem pendente (0/0 sem download)
+uint32_t otaDownloaded();
+uint32_t otaPendingSize();
+// false enquanto a última busca do manifesto falhou (ou nenhuma foi feita)
+bool otaCheckOk();
+
+#endif
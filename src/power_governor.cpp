@@ -0,0 +1,296 @@
+#include "power_governor.h"
+#include "config.h"
+#include "logger.h"
+#include "status_tracker.h"
+#include "bounded_array.h"
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <Arduino.h>
+
+struct OpStats {
+  uint32_t count;
+  uint32_t ms;
+};
+
+// Leitura de bateria com o consumo modelado naquele momento
+struct BatterySample {
+  float pct;
+  float mah;
+};
+
+static const uint16_t opMa[POWER_OP_COUNT] = {POWER_SCAN_MA, POWER_FLASH_MA, POWER_CONNECT_MA, POWER_UPLOAD_MA};
+static const uint8_t intervalScale[POWER_LEVELS] = {1, 2, 4};
+static const unsigned long uploadGapMs[POWER_LEVELS] = {0, 1800000UL, 7200000UL};
+
+static OpStats ops[POWER_OP_COUNT];
+static float modeledMah = 0;   // desde o boot, sem o fator
+static float factor = 1.0f;    // consumo real / modelado
+static float typicalAwayH = 0; // 0 = sem histórico
+static float averageMa = 0;
+static float batteryPct = -1;  // média móvel das leituras do histórico
+static RingHistory<BatterySample, POWER_FIT_SAMPLES> samples; // desde a última carga
+static uint32_t seenReadings = 0;
+static bool charging = false;
+static uint8_t level = 0;
+static float runtimeH[POWER_LEVELS];
+static float needH = 0;
+
+static unsigned long lastUpdate = 0;
+static float lastUpdateMah = 0;
+static bool lastAtBase = true;
+static unsigned long awayStart = 0;
+static bool away = false;
+
+static float scanMsPerCycle = 0;  // médias por ciclo, para a previsão
+static float flashMsPerCycle = 0;
+static uint32_t cycleScanMs = 0;
+static uint32_t cycleFlashMs = 0;
+
+static bool radioAsleep = false;
+static unsigned long sleepStart = 0;
+static unsigned long sleptMs = 0;   // desde o último powerUpdate()
+
+static bool uploadAttempted = false;
+static unsigned long lastUploadAttempt = 0;
+
+static float mahFor(unsigned long ms, float ma) {
+  return ms * ma / 3600000.0f;
+}
+
+static void saveModel() {
+  File file = LittleFS.open(POWER_PATH, "w");
+  if (!file) return;
+  file.print(String((int)(factor * 1000)) + "\n" + String((int)(typicalAwayH * 60)) + "\n");
+  file.close();
+}
+
+void powerBegin() {
+  if (!LittleFS.exists(POWER_PATH)) return;
+  File file = LittleFS.open(POWER_PATH, "r");
+  if (!file) return;
+  String content = file.readString();
+  file.close();
+
+  int scaled = fileLine(content, 0).toInt();
+  if (scaled > 0) factor = constrain(scaled / 1000.0f, 0.25f, 4.0f);
+  typicalAwayH = max(0L, fileLine(content, 1).toInt()) / 60.0f;
+  LOG_I("PWR", "Modelo de energia: fator %.2f, saída típica %.1f h", factor, typicalAwayH);
+}
+
+void powerRecord(uint8_t op, unsigned long ms) {
+  if (op >= POWER_OP_COUNT) return;
+  ops[op].count++;
+  ops[op].ms += ms;
+  modeledMah += mahFor(ms, opMa[op]);
+  if (op == POWER_SCAN) cycleScanMs += ms;
+  if (op == POWER_FLASH) cycleFlashMs += ms;
+}
+
+// Corrente média prevista longe da base no nível dado, já com o fator
+static float forecastMa(uint8_t forLevel) {
+  float interval = (float)max(1, config.scanTimeActive) * intervalScale[forLevel];
+  float base = forLevel == 0 ? POWER_IDLE_MA : POWER_SLEEP_MA;
+  float scanShare = min(1.0f, scanMsPerCycle / interval);
+  float ma = base + (POWER_IDLE_MA - base + POWER_SCAN_MA) * scanShare;
+  ma += POWER_FLASH_MA * min(1.0f, flashMsPerCycle / interval);
+  return ma * factor;
+}
+
+// Mínimos quadrados de bateria (%) x consumo modelado (mAh) na janela: a
+// inclinação dá os mAh reais por mAh modelado. Só com queda suficiente
+// para o ruído do ADC não dominar
+static void fitFactor() {
+  size_t n = samples.size();
+  if (n < 3 || samples[0].pct - samples.back().pct < POWER_CALIBRATE_PCT) return;
+
+  float meanMah = 0, meanPct = 0;
+  for (size_t i = 0; i < n; i++) {
+    meanMah += samples[i].mah;
+    meanPct += samples[i].pct;
+  }
+  meanMah /= n;
+  meanPct /= n;
+  float sxy = 0, sxx = 0;
+  for (size_t i = 0; i < n; i++) {
+    float dx = samples[i].mah - meanMah;
+    sxy += dx * (samples[i].pct - meanPct);
+    sxx += dx * dx;
+  }
+  if (sxx < 1.0f) return; // consumo modelado parado: inclinação sem sentido
+
+  float fitted = -sxy / sxx / 100.0f * POWER_BATTERY_MAH;
+  if (fitted <= 0) return;
+  fitted = constrain(fitted, 0.25f, 4.0f);
+  // Grava no flash só mudanças que alteram a previsão
+  if (fabsf(fitted - factor) >= 0.05f) {
+    LOG_I("PWR", "Fator de consumo: %.2f -> %.2f (%d leituras, %.0f mAh modelados)", factor, fitted, (int)n,
+          samples.back().mah - samples[0].mah);
+    factor = fitted;
+    saveModel();
+  }
+  factor = fitted;
+}
+
+// Leituras novas do histórico do status. Subida é carga: a janela recomeça
+// no pico e a carga termina depois de POWER_CALIBRATE_PCT de queda
+static void readBattery() {
+  const BatteryHistory& history = batteryReadings();
+  uint32_t count = batteryReadingCount();
+  size_t fresh = min((size_t)(count - seenReadings), history.size());
+  seenReadings = count;
+
+  for (size_t i = history.size() - fresh; i < history.size(); i++) {
+    float pct = history[i].percentage;
+    if (samples.size() > 0 && pct > samples.back().pct + 2.0f) {
+      charging = true;
+      samples.clear();
+    } else if (charging && samples.size() > 0 && pct > samples[0].pct) {
+      samples.clear();
+    } else if (charging && samples.size() > 0 && pct <= samples[0].pct - POWER_CALIBRATE_PCT) {
+      charging = false;
+    }
+    samples.push({pct, modeledMah});
+    batteryPct = batteryPct < 0 ? pct : batteryPct * 0.9f + pct * 0.1f;
+  }
+  if (fresh > 0 && !charging) fitFactor();
+}
+
+static void trackAway(bool atBase, unsigned long now) {
+  if (!atBase && (lastAtBase || lastUpdate == 0)) {
+    away = true;
+    awayStart = now;
+  } else if (atBase && !lastAtBase && away) {
+    away = false;
+    float hours = (now - awayStart) / 3600000.0f;
+    if (hours > 0.05f) {
+      typicalAwayH = typicalAwayH == 0 ? hours : typicalAwayH * 0.7f + hours * 0.3f;
+      saveModel();
+    }
+  }
+  lastAtBase = atBase;
+}
+
+void powerUpdate(bool atBase) {
+  unsigned long now = millis();
+  if (radioAsleep) {
+    sleptMs += now - sleepStart;
+    sleepStart = now;
+  }
+
+  // Consumo de fundo desde o último ciclo; as operações já somaram o extra
+  if (lastUpdate != 0) {
+    unsigned long dt = now - lastUpdate;
+    unsigned long slept = min(sleptMs, dt);
+    modeledMah += mahFor(slept, POWER_SLEEP_MA) + mahFor(dt - slept, POWER_IDLE_MA);
+    if (dt > 0) {
+      float ma = (modeledMah - lastUpdateMah) * 3600000.0f / dt * factor;
+      averageMa = averageMa == 0 ? ma : averageMa * 0.9f + ma * 0.1f;
+    }
+  }
+  lastUpdateMah = modeledMah;
+  sleptMs = 0;
+  if (!atBase) {
+    scanMsPerCycle = scanMsPerCycle == 0 ? cycleScanMs : scanMsPerCycle * 0.9f + cycleScanMs * 0.1f;
+    flashMsPerCycle = flashMsPerCycle * 0.9f + cycleFlashMs * 0.1f;
+  }
+  cycleScanMs = 0;
+  cycleFlashMs = 0;
+
+  readBattery();
+  trackAway(atBase, now);
+  lastUpdate = now;
+  if (batteryPct < 0) return; // ainda sem leitura
+
+  // Quanto falta até a volta esperada; passando da saída típica, pelo
+  // menos um quarto dela
+  float expected = typicalAwayH > 0 ? typicalAwayH : POWER_DEFAULT_AWAY_H;
+  float elapsed = away ? (now - awayStart) / 3600000.0f : 0;
+  needH = max(max(expected - elapsed, expected * 0.25f), POWER_MIN_RESERVE_H);
+
+  float remainingMah = batteryPct / 100.0f * POWER_BATTERY_MAH;
+  for (uint8_t l = 0; l < POWER_LEVELS; l++) runtimeH[l] = remainingMah / forecastMa(l);
+
+  // Também na base, onde o nível espaça os uploads: com bateria para a
+  // próxima saída (ou carregando) eles voltam ao normal
+  uint8_t chosen = POWER_LEVELS - 1;
+  for (uint8_t l = 0; l < POWER_LEVELS; l++) {
+    float margin = l < level ? 1.5f : 1.2f; // relaxar pede mais folga
+    if (runtimeH[l] >= needH * margin) {
+      chosen = l;
+      break;
+    }
+  }
+  if (batteryPct < POWER_CRITICAL_PCT) chosen = POWER_LEVELS - 1;
+  if (charging) chosen = 0;
+
+  if (chosen != level) {
+    LOG_I("PWR", "Nível de energia %d -> %d (bateria %.0f%%, %.1f h previstas, %.1f h até a base)", level,
+          chosen, batteryPct, runtimeH[chosen], needH);
+    level = chosen;
+    if (level == 0) powerWakeRadio();
+  }
+}
+
+uint8_t powerLevel() {
+  return level;
+}
+
+unsigned long powerScanInterval(int intervalMs) {
+  return (unsigned long)max(0, intervalMs) * intervalScale[level];
+}
+
+int powerTopK(int topK) {
+  if (level == 1) return min(topK, 3);
+  if (level >= 2) return 1;
+  return topK;
+}
+
+bool powerAllowUpload() {
+  unsigned long now = millis();
+  if (uploadAttempted && now - lastUploadAttempt < uploadGapMs[level]) return false;
+  uploadAttempted = true;
+  lastUploadAttempt = now;
+  return true;
+}
+
+void powerWakeRadio() {
+  if (!radioAsleep) return;
+  WiFi.forceSleepWake();
+  delay(1);
+  sleptMs += millis() - sleepStart;
+  radioAsleep = false;
+}
+
+// Só nos níveis de economia: o rádio dorme até o próximo scan
+void powerSleepRadio() {
+  if (level == 0 || radioAsleep) return;
+  WiFi.forceSleepBegin();
+  radioAsleep = true;
+  sleepStart = millis();
+}
+
+// Estimativas do modelo para o status: nível, bateria, fator, corrente
+// média, horas previstas por nível, horas até a base, saída típica e, por
+// operação (scan, flash, conexão, upload), [vezes, ms, mAh]
+String powerStatusJson() {
+  String json = "{\"level\":" + String(level);
+  json += ",\"battery\":" + String(batteryPct < 0 ? 0 : batteryPct, 1);
+  json += ",\"factor\":" + String(factor, 2);
+  json += ",\"mA\":" + String(averageMa, 1);
+  json += ",\"mAh\":" + String(modeledMah * factor, 1);
+  json += ",\"runtimeH\":[";
+  for (uint8_t l = 0; l < POWER_LEVELS; l++) {
+    if (l > 0) json += ",";
+    json += String(runtimeH[l], 1);
+  }
+  json += "],\"needH\":" + String(needH, 1);
+  json += ",\"awayH\":" + String(typicalAwayH, 1);
+  json += ",\"ops\":[";
+  for (int i = 0; i < POWER_OP_COUNT; i++) {
+    if (i > 0) json += ",";
+    json += "[" + String(ops[i].count) + "," + String(ops[i].ms) + "," +
+            String(mahFor(ops[i].ms, opMa[i]) * factor, 2) + "]";
+  }
+  json += "]}";
+  return json;
+}
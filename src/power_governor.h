@@ -0,0 +1,56 @@
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <Arduino.h>
+
+// Orçamento de energia: um modelo de corrente por operação (tempo medido de
+// rádio ligado x corrente nominal), corrigido por um fator ajustado por
+// regressão linear das leituras de bateria (histórico do status_tracker)
+// contra o consumo modelado, prevê quanto a bateria dura em cada nível.
+// O governador escolhe o nível menos restritivo que chega até a volta
+// esperada à base (duração típica das saídas anteriores).
+#define POWER_PATH "/power.txt"     // fator de correção e duração típica fora da base
+#define POWER_BATTERY_MAH 2000
+#define POWER_IDLE_MA 70            // CPU + rádio ligado entre scans
+#define POWER_SLEEP_MA 18           // rádio desligado entre scans (forceSleepBegin)
+#define POWER_SCAN_MA 80            // a mais que o ocioso, durante o scan
+#define POWER_FLASH_MA 15           // gravação no flash
+#define POWER_CONNECT_MA 60         // associação/DHCP na base
+#define POWER_UPLOAD_MA 100         // envio (TLS/TCP)
+#define POWER_CALIBRATE_PCT 3.0f    // queda mínima na janela para ajustar o fator
+#define POWER_FIT_SAMPLES 24        // leituras na janela da regressão (~2 h)
+#define POWER_DEFAULT_AWAY_H 10.0f  // sem histórico de saídas
+#define POWER_MIN_RESERVE_H 1.0f
+#define POWER_CRITICAL_PCT 10.0f
+
+enum PowerOp {
+  POWER_SCAN,
+  POWER_FLASH,
+  POWER_CONNECT,
+  POWER_UPLOAD,
+  POWER_OP_COUNT,
+};
+
+// Níveis: 0 = normal, 1 = economia (scan 2x mais espaçado, até 3 redes,
+// rádio dormindo entre scans, upload a cada 30 min), 2 = crítico (4x,
+// 1 rede, upload a cada 2 h)
+#define POWER_LEVELS 3
+
+void powerBegin();
+// Tempo de uma operação com o rádio (ou o flash) em uso
+void powerRecord(uint8_t op, unsigned long ms);
+// Uma vez por ciclo, depois do scan: leituras novas do histórico de
+// bateria, base e escolha do nível (também na base, onde limita os uploads)
+void powerUpdate(bool atBase);
+uint8_t powerLevel();
+
+// Ajustes do nível atual
+unsigned long powerScanInterval(int intervalMs);
+int powerTopK(int topK);
+bool powerAllowUpload();
+void powerWakeRadio();
+void powerSleepRadio();
+
+String powerStatusJson();
+
+#endif
@@ -0,0 +1,37 @@
+#include "profiler.h"
+
+#if PROFILE_STAGES
+
+static StageStats stages[STAGE_COUNT];
+static uint32_t started[STAGE_COUNT];
+static uint32_t minFreeHeap = UINT32_MAX;
+static const char* const names[STAGE_COUNT] = {"scan", "store", "trip", "upload"};
+
+void profileBegin(uint8_t stage) {
+  started[stage] = ESP.getCycleCount();
+}
+
+void profileEnd(uint8_t stage) {
+  uint32_t us = (ESP.getCycleCount() - started[stage]) / 80;
+  StageStats& s = stages[stage];
+  s.calls++;
+  s.totalUs += us;
+  if (us > s.maxUs) s.maxUs = us;
+
+  uint32_t heap = ESP.getFreeHeap();
+  if (heap < minFreeHeap) minFreeHeap = heap;
+}
+
+const StageStats& profileStats(uint8_t stage) {
+  return stages[stage];
+}
+
+const char* profileName(uint8_t stage) {
+  return names[stage];
+}
+
+uint32_t profileMinFreeHeap() {
+  return minFreeHeap;
+}
+
+#endif
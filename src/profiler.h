@@ -0,0 +1,41 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+// Tempo por etapa do ciclo de coleta, em ciclos de CPU (ESP.getCycleCount,
+// 80 por µs). O contador de 32 bits dá a volta em ~53 s, então uma etapa
+// mais longa que isso sai errada. Ligado só com -D PROFILE_STAGES=1.
+
+#ifndef PROFILE_STAGES
+#define PROFILE_STAGES 0
+#endif
+
+enum ProfileStage {
+  STAGE_SCAN,
+  STAGE_STORE,
+  STAGE_TRIP,
+  STAGE_UPLOAD,
+  STAGE_COUNT,
+};
+
+struct StageStats {
+  uint32_t calls;
+  uint64_t totalUs;
+  uint32_t maxUs;
+};
+
+#if PROFILE_STAGES
+void profileBegin(uint8_t stage);
+void profileEnd(uint8_t stage);
+const StageStats& profileStats(uint8_t stage);
+const char* profileName(uint8_t stage);
+uint32_t profileMinFreeHeap();
+#define PROFILE_BEGIN(stage) profileBegin(stage)
+#define PROFILE_END(stage) profileEnd(stage)
+#else
+#define PROFILE_BEGIN(stage) do {} while (0)
+#define PROFILE_END(stage) do {} while (0)
+#endif
+
+#endif
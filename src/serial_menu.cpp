@@ -1,180 +1,460 @@
 #include "serial_menu.h"
 #include "config.h"
 #include "wifi_scanner.h"
-#include "firebase.h"
+#include "upload_backend.h"
 #include "status_tracker.h"
+#include "known_aps.h"
+#include "trace_recorder.h"
+#include "profiler.h"
+#include "logger.h"
 #include <LittleFS.h>
 #include <ESP8266WiFi.h>
 #include <Arduino.h>
 
-void showMenu() {
-  Serial.println("\n=== MENU ===");
-  Serial.println("1) Monitorar redes");
-  Serial.println("2) Verificar conexao com base");
-  Serial.println("3) Testar conexao Firebase");
-  Serial.println("4) Mostrar configuracoes");
-  Serial.println("5) Ver dados salvos");
-  Serial.println("6) Transferir dados (copy/paste)");
-  Serial.println("7) Upload status (conexoes/bateria)");
-  Serial.println("8) Ativar modo AP/Configuracao");
-  Serial.println("q) Sair do menu");
-  Serial.print("Escolha: ");
-}
-
-void handleSerialMenu() {
-  if (Serial.available()) {
-    char choice = Serial.read();
-    Serial.println(choice);
-    
-    switch(choice) {
-      case '1':
-        Serial.println("\n=== REDES DETECTADAS ===");
-        scanWiFiNetworks();
-        for (int i = 0; i < networkCount; i++) {
-          Serial.printf("%s | %d dBm | Canal %d\n", networks[i].ssid, networks[i].rssi, networks[i].channel);
-        }
-        showMenu();
-        break;
-        
-      case '2':
-        Serial.println("\n=== TESTE CONEXAO BASE ===");
-        scanWiFiNetworks();
-        if (checkAtBase()) {
-          Serial.println("Base WiFi detectada!");
-          if (connectToBase()) {
-            Serial.println("Conectado com sucesso!");
-            Serial.println("IP: " + WiFi.localIP().toString());
-            WiFi.disconnect();
-          } else {
-            Serial.println("Falha na conexao");
-          }
-        } else {
-          Serial.println("Nenhuma base WiFi detectada");
-        }
-        showMenu();
-        break;
-        
-      case '3':
-        Serial.println("\n=== TESTE FIREBASE ===");
-        if (strlen(config.firebaseUrl) == 0) {
-          Serial.println("Firebase nao configurado");
-        } else {
-          Serial.printf("URL: %s\n", config.firebaseUrl);
-          Serial.printf("Key: %s...\n", String(config.firebaseKey).substring(0, 10).c_str());
-          
-          if (connectToBase()) {
-            Serial.println("Conectado! Testando upload...");
-            dataCount = 1;
-            uploadData();
-          } else {
-            Serial.println("Falha ao conectar na base para teste");
-          }
-        }
-        showMenu();
-        break;
-        
-      case '4':
-        Serial.println("\n=== CONFIGURACOES ===");
-        Serial.printf("Bike ID: %s\n", config.bikeId);
-        Serial.printf("Scan Ativo: %d ms\n", config.scanTimeActive);
-        Serial.printf("Scan Inativo: %d ms\n", config.scanTimeInactive);
-        Serial.printf("Base 1: '%s' / '%s'\n", config.baseSSID1, config.basePassword1);
-        Serial.printf("Base 2: '%s' / '%s'\n", config.baseSSID2, config.basePassword2);
-        Serial.printf("Base 3: '%s' / '%s'\n", config.baseSSID3, config.basePassword3);
-        Serial.printf("Firebase URL: %s\n", config.firebaseUrl);
-        Serial.printf("Firebase Key: %s...\n", String(config.firebaseKey).substring(0, 15).c_str());
-        showMenu();
-        break;
-        
-      case '5':
-        Serial.println("\n=== DADOS SALVOS ===");
-        {
-          Dir dir = LittleFS.openDir("/");
-          int count = 0;
-          while (dir.next()) {
-            if (dir.fileName().startsWith("scan_")) {
-              count++;
-              Serial.printf("Arquivo: %s (%d bytes)\n", dir.fileName().c_str(), dir.fileSize());
-              File file = LittleFS.open(dir.fileName().c_str(), "r");
-              if (file) {
-                String content = file.readString();
-                file.close();
-                Serial.printf("Conteúdo: %s\n", content.c_str());
-              }
-              Serial.println("---");
-              yield(); // Permite outras tarefas
-              if (count >= 5) {
-                Serial.println("(mostrando apenas os primeiros 5 arquivos)");
-                break;
-              }
-            }
-          }
-          if (count == 0) {
-            Serial.println("Nenhum arquivo de dados encontrado");
-          }
-        }
-        showMenu();
-        break;
-        
-      case '6':
-        Serial.println("\n=== TRANSFERIR DADOS ===");
-        Serial.println("Copie os dados abaixo e cole em um arquivo:");
-        Serial.println("--- INICIO DOS DADOS ---");
-        {
-          Dir dir = LittleFS.openDir("/");
-          Serial.println("{");
-          Serial.println("\"bikeId\":\"" + String(config.bikeId) + "\",");
-          Serial.println("\"exportTime\":" + String(millis()) + ",");
-          Serial.println("\"scans\":[");
-          
-          bool first = true;
-          while (dir.next()) {
-            if (dir.fileName().startsWith("scan_")) {
-              if (!first) Serial.println(",");
-              File file = LittleFS.open(dir.fileName().c_str(), "r");
-              if (file) {
-                String content = file.readString();
-                file.close();
-                Serial.print(content);
-              }
-              first = false;
-              yield(); // Permite outras tarefas
-            }
-          }
-          Serial.println("");
-          Serial.println("]}");
-        }
+bool consoleMachineOutput = false;
+
+static char lineBuffer[CONSOLE_LINE_MAX];
+static int lineLength = 0;
+static bool lineOverflow = false;
+
+// Tarefas de rede pedidas pelo console rodam na próxima visita à base,
+// na mesma conexão dos uploads, para não bloquear a leitura da serial nem
+// pular coletas
+static bool baseTestPending = false;
+static bool firebaseTestPending = false;
+static bool statusUploadPending = false;
+
+static void printJsonString(const char* s) {
+  Serial.print('"');
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') Serial.print('\\');
+    if ((uint8_t)*s < 0x20) continue;
+    Serial.print(*s);
+  }
+  Serial.print('"');
+}
+
+static void replyOk(const char* cmd, const char* msg) {
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":");
+    printJsonString(cmd);
+    Serial.print(",\"ok\":true,\"msg\":");
+    printJsonString(msg);
+    Serial.println("}");
+  } else {
+    Serial.println(msg);
+  }
+}
+
+static void replyError(const char* cmd, const char* msg) {
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":");
+    printJsonString(cmd);
+    Serial.print(",\"ok\":false,\"msg\":");
+    printJsonString(msg);
+    Serial.println("}");
+  } else {
+    Serial.printf("Erro: %s\n", msg);
+  }
+}
+
+static void cmdHelp(int argc, char** argv);
+
+static void cmdNetworks(int argc, char** argv) {
+  // Usa o último scan do loop; filtro opcional de RSSI mínimo
+  int minRssi = argc > 1 ? atoi(argv[1]) : -127;
+
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":\"redes\",\"ok\":true,\"networks\":[");
+    bool first = true;
+    for (size_t i = 0; i < networks.size(); i++) {
+      if (networks[i].rssi < minRssi) continue;
+      if (!first) Serial.print(",");
+      Serial.print("[");
+      printJsonString(networks[i].ssid);
+      Serial.print(",");
+      printJsonString(networks[i].bssid);
+      Serial.printf(",%d,%d]", networks[i].rssi, networks[i].channel);
+      first = false;
+    }
+    Serial.println("]}");
+    return;
+  }
+
+  Serial.println("\n=== REDES DETECTADAS (último scan) ===");
+  for (size_t i = 0; i < networks.size(); i++) {
+    if (networks[i].rssi < minRssi) continue;
+    Serial.printf("%s | %s | %d dBm | Canal %d\n", networks[i].ssid, networks[i].bssid,
+                  networks[i].rssi, networks[i].channel);
+  }
+}
+
+static void cmdBase(int argc, char** argv) {
+  bool nearBase = checkAtBase();
+  if (!nearBase) {
+    replyError("base", "Nenhuma base WiFi detectada no ultimo scan");
+    return;
+  }
+  baseTestPending = true;
+  replyOk("base", "Base detectada - teste de conexao agendado para o proximo ciclo");
+}
+
+static void cmdFirebase(int argc, char** argv) {
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured()) {
+    replyError("firebase", "Nenhum destino de upload configurado");
+    return;
+  }
+  if (!consoleMachineOutput) {
+    Serial.printf("Destino: %s\n", backend.name);
+    Serial.printf("URL: %s\n", &backend == &collectorBackend ? config.collectorUrl : config.firebaseUrl);
+    Serial.printf("Key: %s...\n", String(config.firebaseKey).substring(0, 10).c_str());
+  }
+  firebaseTestPending = true;
+  replyOk("firebase", "Teste de upload agendado para o proximo ciclo");
+}
+
+static void cmdConfig(int argc, char** argv) {
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":\"config\",\"ok\":true,\"bike\":");
+    printJsonString(config.bikeId);
+    Serial.printf(",\"active\":%d,\"inactive\":%d,\"topK\":%d,\"mergeMesh\":%s,\"recordMode\":%d,\"bases\":[",
+                  config.scanTimeActive, config.scanTimeInactive, config.topK,
+                  config.mergeMesh ? "true" : "false", config.recordMode);
+    printJsonString(config.baseSSID1);
+    Serial.print(",");
+    printJsonString(config.baseSSID2);
+    Serial.print(",");
+    printJsonString(config.baseSSID3);
+    Serial.print("],\"firebase\":");
+    printJsonString(config.firebaseUrl);
+    Serial.print(",\"collector\":");
+    printJsonString(config.collectorUrl);
+    Serial.println("}");
+    return;
+  }
+
+  Serial.println("\n=== CONFIGURACOES ===");
+  Serial.printf("Bike ID: %s | Firmware: %s\n", config.bikeId, FIRMWARE_VERSION);
+  Serial.printf("Perfil: %s | %d redes/scan | buffers %u bytes | heap no boot %u bytes\n", CAPACITY.name,
+                MAX_NETWORKS, (unsigned)capacityRamUsage(), (unsigned)capacityBootHeap());
+  Serial.printf("Scan Ativo: %d ms\n", config.scanTimeActive);
+  Serial.printf("Scan Inativo: %d ms\n", config.scanTimeInactive);
+  Serial.printf("Top redes: %d | Mesh: %s\n", config.topK, config.mergeMesh ? "unido" : "separado");
+  if (config.recordMode == RECORD_AGGREGATE)
+    Serial.printf("Registro: estatísticas (janela %d s)\n", config.aggregateWindowS);
+  else
+    Serial.printf("Registro: %s\n", config.recordMode == RECORD_POSITION ? "posição" : "redes");
+  Serial.printf("Viagens: %s | Ponto a cada %d scans\n", config.tripOnly ? "só resumo" : "resumo + scans",
+                config.tripWaypointEvery);
+  Serial.printf("APs conhecidos: %s | filtro %s (geração %u)\n", config.suppressKnown ? "suprimidos" : "gravados",
+                knownApsReady() ? "carregado" : "ausente", (unsigned)knownApsGeneration());
+  Serial.printf("Base 1: '%s' / '%s'\n", config.baseSSID1, config.basePassword1);
+  Serial.printf("Base 2: '%s' / '%s'\n", config.baseSSID2, config.basePassword2);
+  Serial.printf("Base 3: '%s' / '%s'\n", config.baseSSID3, config.basePassword3);
+  Serial.printf("Firebase URL: %s\n", config.firebaseUrl);
+  Serial.printf("Firebase Key: %s...\n", String(config.firebaseKey).substring(0, 15).c_str());
+  Serial.printf("Coletor: %s\n", strlen(config.collectorUrl) > 0 ? config.collectorUrl : "(Firebase)");
+}
+
+static void cmdData(int argc, char** argv) {
+  int limit = argc > 1 ? atoi(argv[1]) : 5;
+  if (limit <= 0) limit = 5;
+
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":\"dados\",\"ok\":true,\"files\":[");
+  } else {
+    Serial.println("\n=== DADOS SALVOS ===");
+  }
+
+  Dir dir = LittleFS.openDir("/");
+  int count = 0;
+  while (dir.next()) {
+    if (!dir.fileName().startsWith("scan_") && !dir.fileName().startsWith("trip_")) continue;
+    count++;
+    if (count > limit) {
+      if (!consoleMachineOutput) {
+        Serial.printf("(mostrando apenas os primeiros %d arquivos)\n", limit);
+      }
+      break;
+    }
+    if (consoleMachineOutput) {
+      if (count > 1) Serial.print(",");
+      Serial.print("{\"name\":");
+      printJsonString(dir.fileName().c_str());
+      Serial.printf(",\"size\":%d}", (int)dir.fileSize());
+    } else {
+      Serial.printf("Arquivo: %s (%d bytes)\n", dir.fileName().c_str(), (int)dir.fileSize());
+      File file = LittleFS.open(dir.fileName().c_str(), "r");
+      if (file) {
+        String content = file.readString();
+        file.close();
+        Serial.printf("Conteúdo: %s\n", content.c_str());
+      }
+      Serial.println("---");
+    }
+    yield();
+  }
+
+  if (consoleMachineOutput) {
+    Serial.println("]}");
+  } else if (count == 0) {
+    Serial.println("Nenhum arquivo de dados encontrado");
+  }
+}
+
+// Exportação em andamento: handleSerialConsole() manda CONSOLE_EXPORT_FILES
+// arquivos por chamada, sem parar os scans e o LED; o log fica retido e
+// a entrada fica na fila da UART até o fim, para não cortar a saída
+static bool exportActive = false;
+static bool exportFirst = true;
+static Dir exportDir;
+
+static const char* exportSeparator() {
+  // No modo json sai tudo numa linha só, como as outras respostas
+  return consoleMachineOutput ? "" : "\n";
+}
+
+static void exportStep() {
+  const char* sep = exportSeparator();
+  int sent = 0;
+  while (sent < CONSOLE_EXPORT_FILES) {
+    if (!exportDir.next()) {
+      Serial.printf("%s]}\n", sep);
+      if (!consoleMachineOutput) {
         Serial.println("--- FIM DOS DADOS ---");
         Serial.println("Dados prontos para backup!");
-        showMenu();
-        break;
-        
-      case '7':
-        Serial.println("\n=== UPLOAD STATUS ===");
-        if (connectToBase()) {
-          uploadStatus();
-          WiFi.disconnect();
-        } else {
-          Serial.println("Falha ao conectar na base");
-        }
-        showMenu();
-        break;
-        
-      case '8':
-        Serial.println("\n=== ATIVANDO MODO AP ===");
-        Serial.println("Reiniciando em modo configuracao...");
-        delay(1000);
-        ESP.restart();
-        break;
-        
-      case 'q':
-      case 'Q':
-        Serial.println("Saindo do menu...");
-        break;
-        
-      default:
-        showMenu();
-        break;
+      }
+      exportActive = false;
+      logHold(false);
+      return;
     }
+    if (!exportDir.fileName().startsWith("scan_")) continue;
+
+    if (!exportFirst) Serial.printf(",%s", sep);
+    File file = LittleFS.open(exportDir.fileName().c_str(), "r");
+    if (file) {
+      String content = file.readString();
+      file.close();
+      content.trim();
+      Serial.print(content);
+    }
+    exportFirst = false;
+    sent++;
   }
-}
\ No newline at end of file
+}
+
+static void cmdExport(int argc, char** argv) {
+  const char* sep = exportSeparator();
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":\"exportar\",\"ok\":true,");
+  } else {
+    Serial.println("\n=== TRANSFERIR DADOS ===");
+    Serial.println("Copie os dados abaixo e cole em um arquivo:");
+    Serial.println("--- INICIO DOS DADOS ---");
+    Serial.println("{");
+  }
+
+  Serial.print("\"bikeId\":");
+  printJsonString(config.bikeId);
+  Serial.printf(",%s\"exportTime\":%lu,%s\"scans\":[%s", sep, millis(), sep, sep);
+
+  exportDir = LittleFS.openDir("/");
+  exportFirst = true;
+  exportActive = true;
+  logHold(true);
+}
+
+static void cmdStatus(int argc, char** argv) {
+  statusUploadPending = true;
+  replyOk("status", "Upload de status agendado para o proximo ciclo");
+}
+
+#if TRACE_RECORD || PROFILE_STAGES
+static void cmdProfile(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "apagar") == 0) {
+    traceClear();
+    replyOk("perfil", "Trace apagado");
+    return;
+  }
+
+  if (consoleMachineOutput) {
+    Serial.printf("{\"cmd\":\"perfil\",\"ok\":true,\"trace\":%u", (unsigned)traceSize());
+#if PROFILE_STAGES
+    Serial.printf(",\"minHeap\":%u,\"stages\":{", profileMinFreeHeap());
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      const StageStats& s = profileStats(i);
+      Serial.printf("%s\"%s\":{\"calls\":%u,\"totalUs\":%llu,\"maxUs\":%u}", i > 0 ? "," : "",
+                    profileName(i), s.calls, (unsigned long long)s.totalUs, s.maxUs);
+    }
+    Serial.print("}");
+#endif
+    Serial.println("}");
+    return;
+  }
+
+  Serial.println("\n=== PERFIL ===");
+  Serial.printf("Trace: %u bytes em %s\n", (unsigned)traceSize(), TRACE_PATH);
+#if PROFILE_STAGES
+  Serial.printf("Heap livre mínimo: %u bytes\n", profileMinFreeHeap());
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    const StageStats& s = profileStats(i);
+    Serial.printf("%-7s %6u chamadas | média %7lu us | máx %7u us\n", profileName(i), s.calls,
+                  s.calls ? (unsigned long)(s.totalUs / s.calls) : 0UL, s.maxUs);
+  }
+#endif
+}
+#endif
+
+static void cmdAccessPoint(int argc, char** argv) {
+  replyOk("ap", "Reiniciando em modo configuracao...");
+  Serial.flush();
+  ESP.restart();
+}
+
+static void cmdOutput(int argc, char** argv) {
+  if (argc < 2) {
+    replyOk("saida", consoleMachineOutput ? "json" : "texto");
+    return;
+  }
+  if (strcmp(argv[1], "json") == 0) {
+    consoleMachineOutput = true;
+  } else if (strcmp(argv[1], "texto") == 0) {
+    consoleMachineOutput = false;
+  } else {
+    replyError("saida", "Use: saida json|texto");
+    return;
+  }
+  replyOk("saida", argv[1]);
+}
+
+static const ConsoleCommand commands[] = {
+  {"redes",    '1', "Listar redes do ultimo scan [rssi_min]", cmdNetworks},
+  {"base",     '2', "Verificar/testar conexao com base",      cmdBase},
+  {"firebase", '3', "Testar upload (Firebase/coletor)",       cmdFirebase},
+  {"config",   '4', "Mostrar configuracoes",                  cmdConfig},
+  {"dados",    '5', "Ver dados salvos [quantidade]",          cmdData},
+  {"exportar", '6', "Transferir dados (copy/paste)",          cmdExport},
+  {"status",   '7', "Upload status (conexoes/bateria)",       cmdStatus},
+  {"ap",       '8', "Ativar modo AP/Configuracao",            cmdAccessPoint},
+  {"saida",    0,   "Formato de saida: json|texto",           cmdOutput},
+#if TRACE_RECORD || PROFILE_STAGES
+  {"perfil",   0,   "Trace e tempo por etapa [apagar]",        cmdProfile},
+#endif
+  {"ajuda",    'm', "Mostrar este menu",                      cmdHelp},
+};
+static const int commandCount = sizeof(commands) / sizeof(commands[0]);
+
+void showMenu() {
+  Serial.println("\n=== CONSOLE ===");
+  for (int i = 0; i < commandCount; i++) {
+    if (commands[i].alias) {
+      Serial.printf("%c) %-9s %s\n", commands[i].alias, commands[i].name, commands[i].help);
+    } else {
+      Serial.printf("   %-9s %s\n", commands[i].name, commands[i].help);
+    }
+  }
+  Serial.println("A coleta continua rodando enquanto o console e usado.");
+}
+
+static void cmdHelp(int argc, char** argv) {
+  if (consoleMachineOutput) {
+    Serial.print("{\"cmd\":\"ajuda\",\"ok\":true,\"commands\":[");
+    for (int i = 0; i < commandCount; i++) {
+      if (i > 0) Serial.print(",");
+      printJsonString(commands[i].name);
+    }
+    Serial.println("]}");
+    return;
+  }
+  showMenu();
+}
+
+static void dispatchLine(char* line) {
+  char* argv[CONSOLE_MAX_ARGS];
+  int argc = 0;
+
+  char* token = strtok(line, " \t");
+  while (token && argc < CONSOLE_MAX_ARGS) {
+    argv[argc++] = token;
+    token = strtok(nullptr, " \t");
+  }
+  if (argc == 0) return;
+
+  for (int i = 0; i < commandCount; i++) {
+    const ConsoleCommand& cmd = commands[i];
+    bool aliasMatch = cmd.alias && argv[0][0] == cmd.alias && argv[0][1] == '\0';
+    if (aliasMatch || strcasecmp(argv[0], cmd.name) == 0) {
+      cmd.handler(argc, argv);
+      return;
+    }
+  }
+  replyError(argv[0], "Comando desconhecido - digite 'ajuda'");
+}
+
+void handleSerialConsole() {
+  if (exportActive) {
+    exportStep();
+    return;
+  }
+
+  // Consome só o que já chegou; nunca espera por entrada
+  while (Serial.available()) {
+    char c = Serial.read();
+
+    if (c == '\r' || c == '\n') {
+      if (lineOverflow) {
+        replyError("console", "Linha muito longa");
+      } else if (lineLength > 0) {
+        lineBuffer[lineLength] = '\0';
+        dispatchLine(lineBuffer);
+      }
+      lineLength = 0;
+      lineOverflow = false;
+      continue;
+    }
+
+    if (lineLength < CONSOLE_LINE_MAX - 1) {
+      lineBuffer[lineLength++] = c;
+    } else {
+      lineOverflow = true;
+    }
+  }
+}
+
+bool consoleTasksPending() {
+  return baseTestPending || firebaseTestPending || statusUploadPending;
+}
+
+void runConsoleTasks(bool connected) {
+  if (baseTestPending) {
+    baseTestPending = false;
+    if (connected) {
+      String msg = "Conectado com sucesso! IP: " + WiFi.localIP().toString();
+      replyOk("base", msg.c_str());
+    } else {
+      replyError("base", "Falha na conexao");
+    }
+  }
+
+  if (firebaseTestPending) {
+    firebaseTestPending = false;
+    // O status é o teste: sempre há o que enviar, sem mexer na fila de scans
+    if (!connected) {
+      replyError("firebase", "Falha ao conectar na base para teste");
+    } else if (uploadStatus()) {
+      replyOk("firebase", "Upload de teste (status) aceito");
+    } else {
+      replyError("firebase", "Upload de teste (status) recusado");
+    }
+  }
+
+  if (statusUploadPending) {
+    statusUploadPending = false;
+    if (connected) {
+      uploadStatus();
+    } else {
+      replyError("status", "Falha ao conectar na base");
+    }
+  }
+}
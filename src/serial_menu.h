@@ -1,7 +1,24 @@
 #ifndef SERIAL_MENU_H
 #define SERIAL_MENU_H
 
+#define CONSOLE_LINE_MAX 64
+#define CONSOLE_MAX_ARGS 4
+#define CONSOLE_EXPORT_FILES 4 // arquivos por chamada de handleSerialConsole()
+
+struct ConsoleCommand {
+  const char* name;
+  char alias; // atalho de uma tecla (compatível com o menu antigo)
+  const char* help;
+  void (*handler)(int argc, char** argv);
+};
+
+extern bool consoleMachineOutput;
+
 void showMenu();
-void handleSerialMenu();
+void handleSerialConsole();
+// Pedidos do console que precisam da base; main.cpp conecta na próxima
+// visita e chama runConsoleTasks() com o resultado
+bool consoleTasksPending();
+void runConsoleTasks(bool connected);
 
-#endif
\ No newline at end of file
+#endif
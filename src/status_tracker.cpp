@@ -1,79 +1,95 @@
 #include "status_tracker.h"
 #include "config.h"
-#include "firebase.h"
-#include <WiFiClientSecure.h>
+#include "upload_backend.h"
+#include "logger.h"
+#include "time_base.h"
+#include "known_aps.h"
+#include "ota.h"
+#include "power_governor.h"
 #include <ESP8266WiFi.h>
 #include <LittleFS.h>
 
-ConnectionEvent connectionHistory[10];
-int connectionCount = 0;
-BatteryEvent batteryHistory[20];
-int batteryCount = 0;
+ConnectionHistory connectionHistory;
+BatteryHistory batteryHistory;
 unsigned long lastBatteryCheck = 0;
+static uint32_t batteryCount = 0;
 
 void trackConnection(const char* baseSSID, const char* ip, bool connected) {
-  if (connectionCount >= 10) {
-    // Shift array para remover o mais antigo
-    for (int i = 0; i < 9; i++) {
-      connectionHistory[i] = connectionHistory[i + 1];
-    }
-    connectionCount = 9;
-  }
-  
-  ConnectionEvent& event = connectionHistory[connectionCount];
-  event.timestamp = timeSync ? timeClient.getEpochTime() : millis();
-  strcpy(event.baseSSID, baseSSID);
-  strcpy(event.ip, ip);
+  // Cheio: o evento mais antigo é descartado
+  ConnectionEvent& event = connectionHistory.push();
+  event.bootId = currentBootId();
+  event.timestamp = timeTicks();
+  snprintf(event.baseSSID, sizeof(event.baseSSID), "%s", baseSSID);
+  snprintf(event.ip, sizeof(event.ip), "%s", ip);
   event.connected = connected;
-  connectionCount++;
   
-  Serial.printf("Status: %s %s (IP: %s)\n", 
-                connected ? "Conectado" : "Desconectado", 
-                baseSSID, ip);
+  LOG_I("STATUS", "%s %s (IP: %s)",
+        connected ? "Conectado" : "Desconectado",
+        baseSSID, ip);
 }
 
 void trackBattery(float percentage) {
   unsigned long now = millis();
   
   // Só registra se mudou significativamente ou passou muito tempo
-  if (batteryCount == 0 || 
-      abs(percentage - batteryHistory[batteryCount-1].percentage) > 2.0 ||
+  if (batteryHistory.size() == 0 || 
+      abs(percentage - batteryHistory.back().percentage) > 2.0 ||
       now - lastBatteryCheck > 300000) { // 5 minutos
     
-    if (batteryCount >= 20) {
-      // Shift array para remover o mais antigo
-      for (int i = 0; i < 19; i++) {
-        batteryHistory[i] = batteryHistory[i + 1];
-      }
-      batteryCount = 19;
-    }
-    
-    BatteryEvent& event = batteryHistory[batteryCount];
-    event.timestamp = timeSync ? timeClient.getEpochTime() : millis();
+    BatteryEvent& event = batteryHistory.push();
+    event.bootId = currentBootId();
+    event.timestamp = timeTicks();
     event.percentage = percentage;
-    batteryCount++;
     lastBatteryCheck = now;
+    batteryCount++;
   }
 }
 
-void uploadStatus() {
-  if (strlen(config.firebaseUrl) == 0) {
-    Serial.println("Firebase não configurado para status");
-    return;
+const BatteryHistory& batteryReadings() {
+  return batteryHistory;
+}
+
+uint32_t batteryReadingCount() {
+  return batteryCount;
+}
+
+float lastBatteryLevel() {
+  return batteryHistory.size() > 0 ? batteryHistory.back().percentage : -1;
+}
+
+bool uploadStatus() {
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured()) {
+    LOG_W("STATUS", "Nenhum destino de upload configurado para status");
+    return false;
   }
 
-  Serial.println("=== UPLOAD STATUS ===");
+  LOG_I("STATUS", "=== UPLOAD STATUS ===");
   
-  unsigned long timestamp = timeSync ? timeClient.getEpochTime() : millis();
+  uint32_t timestamp = epochNow();
   
   String payload = "{\"bike\":\"" + String(config.bikeId) + "\"";
+  payload += ",\"fw\":\"" FIRMWARE_VERSION "\"";
+  if (otaPendingSize() > 0) {
+    payload += ",\"ota\":[" + String(otaDownloaded()) + "," + String(otaPendingSize()) + "]";
+  }
   payload += ",\"lastUpdate\":" + String(timestamp);
+  payload += ",\"heapBoot\":" + String(capacityBootHeap());
+
+  // O que a bike conseguiu buscar do servidor (pelo gateway, só se ele
+  // repassa): horário, filtro de APs conhecidos, manifesto do OTA
+  payload += ",\"sync\":{\"time\":" + String(timeSynced() ? "true" : "false");
+  if (backend.fetchKnownAps) payload += ",\"knownAps\":" + String(knownApsSyncOk() ? "true" : "false");
+  if (backend.fetchFile) payload += ",\"ota\":" + String(otaCheckOk() ? "true" : "false");
+  payload += "}";
   
   // Histórico de conexões
   payload += ",\"connections\":[";
-  for (int i = 0; i < connectionCount; i++) {
+  for (size_t i = 0; i < connectionHistory.size(); i++) {
     if (i > 0) payload += ",";
-    payload += "{\"time\":" + String(connectionHistory[i].timestamp);
+    payload += "{\"time\":" + String(epochFor(connectionHistory[i].bootId, connectionHistory[i].timestamp));
+    payload += ",\"boot\":" + String(connectionHistory[i].bootId);
+    payload += ",\"ticks\":" + String(connectionHistory[i].timestamp);
     payload += ",\"base\":\"" + String(connectionHistory[i].baseSSID) + "\"";
     payload += ",\"ip\":\"" + String(connectionHistory[i].ip) + "\"";
     payload += ",\"event\":\"" + String(connectionHistory[i].connected ? "connect" : "disconnect") + "\"}";
@@ -82,47 +98,24 @@ void uploadStatus() {
   
   // Histórico de bateria
   payload += ",\"battery\":[";
-  for (int i = 0; i < batteryCount; i++) {
+  for (size_t i = 0; i < batteryHistory.size(); i++) {
     if (i > 0) payload += ",";
-    payload += "{\"time\":" + String(batteryHistory[i].timestamp);
+    payload += "{\"time\":" + String(epochFor(batteryHistory[i].bootId, batteryHistory[i].timestamp));
     payload += ",\"level\":" + String(batteryHistory[i].percentage, 1) + "}";
   }
-  payload += "]}";
-  
-  WiFiClientSecure client;
-  client.setInsecure();
-  
-  String url = String(config.firebaseUrl);
-  url.replace("https://", "");
-  url.replace("http://", "");
-  int slashIndex = url.indexOf('/');
-  String host = url.substring(0, slashIndex);
-  
-  String path = "/bikes/" + String(config.bikeId) + "/status.json";
+  payload += "]";
+
+  // Modelo de energia (power_governor.h)
+  payload += ",\"power\":" + powerStatusJson();
+
+  // Avistamentos de APs conhecidos (não gravados nos scans)
+  payload += ",\"knownAps\":" + knownApsStatusJson() + "}";
   
-  if (client.connect(host.c_str(), 443)) {
-    client.print("PUT " + path + " HTTP/1.1\r\n");
-    client.print("Host: " + host + "\r\n");
-    client.print("Content-Type: application/json\r\n");
-    client.print("Content-Length: " + String(payload.length()) + "\r\n");
-    client.print("Connection: close\r\n\r\n");
-    client.print(payload);
-    
-    delay(500); // Reduzido para não bloquear muito
-    String response = "";
-    int timeout = 0;
-    while (client.available() && timeout < 50) { // Timeout para não travar
-      response += client.readString();
-      delay(10);
-      timeout++;
-    }
-    
-    if (response.indexOf("200 OK") > 0) {
-      Serial.println("Status upload OK!");
-    } else {
-      Serial.println("Erro no upload de status");
-    }
-    
-    client.stop();
+  if (backend.sendStatus(payload)) {
+    knownApsResetCounters();
+    LOG_I("STATUS", "Status upload OK!");
+    return true;
   }
+  LOG_W("STATUS", "Erro no upload de status");
+  return false;
 }
\ No newline at end of file
@@ -2,21 +2,34 @@
 #define STATUS_TRACKER_H
 
 #include <Arduino.h>
+#include "capacity.h"
+#include "bounded_array.h"
 
 struct ConnectionEvent {
-  unsigned long timestamp;
-  char baseSSID[32];
-  char ip[16];
+  uint32_t bootId;
+  unsigned long timestamp; // ticks do boot; época resolvida no upload
+  char baseSSID[SSID_LEN];
+  char ip[IP_STR_LEN];
   bool connected; // true = conectou, false = desconectou
 };
 
 struct BatteryEvent {
+  uint32_t bootId;
   unsigned long timestamp;
   float percentage;
 };
 
+// Últimos eventos enviados no status (tamanho conforme o perfil)
+typedef RingHistory<ConnectionEvent, CAPACITY.connectionHistory> ConnectionHistory;
+typedef RingHistory<BatteryEvent, CAPACITY.batteryHistory> BatteryHistory;
+
 void trackConnection(const char* baseSSID, const char* ip, bool connected);
 void trackBattery(float percentage);
-void uploadStatus();
+// Leituras guardadas para o status; o contador cresce a cada leitura nova,
+// para quem consome o histórico (power_governor) saber quais ainda não viu
+const BatteryHistory& batteryReadings();
+uint32_t batteryReadingCount();
+float lastBatteryLevel(); // -1 antes da primeira leitura
+bool uploadStatus();
 
 #endif
\ No newline at end of file
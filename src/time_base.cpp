@@ -0,0 +1,278 @@
+#include "time_base.h"
+#include "config.h"
+#include "logger.h"
+#include <LittleFS.h>
+#include <coredecls.h>
+#include <time.h>
+#include <Arduino.h>
+
+// Sobrevive a resets (não a falta de energia): boot e último horário conhecido
+struct RtcTimeState {
+  uint32_t magic;
+  uint32_t bootId;
+  uint32_t lastEpoch; // 0 = boot sem horário
+  uint32_t checksum;
+};
+
+static uint32_t bootId = 0;
+static BootEpoch bootEpochs[TIME_MAX_BOOT_EPOCHS];
+static int bootEpochCount = 0;
+static volatile bool sntpReceived = false;
+static bool synced = false;
+static unsigned long lastTicks = 0;
+static unsigned long lastRtcWrite = 0;
+
+static uint32_t rtcChecksum(const RtcTimeState& state) {
+  return state.magic ^ state.bootId ^ (state.lastEpoch * 2654435761u) ^ 0xA5A5A5A5;
+}
+
+static void writeRtc() {
+  RtcTimeState state;
+  state.magic = TIME_RTC_MAGIC;
+  state.bootId = bootId;
+  state.lastEpoch = epochNow();
+  state.checksum = rtcChecksum(state);
+  ESP.rtcUserMemoryWrite(TIME_RTC_OFFSET, (uint32_t*)&state, sizeof(state));
+}
+
+static void saveBootEpochs() {
+  File file = LittleFS.open(TIME_EPOCHS_PATH, "w");
+  if (!file) return;
+  for (int i = 0; i < bootEpochCount; i++) {
+    file.printf("%u %u %d\n", (unsigned)bootEpochs[i].bootId, (unsigned)bootEpochs[i].offset,
+                bootEpochs[i].exact ? 1 : 0);
+  }
+  file.close();
+}
+
+static void loadBootEpochs() {
+  bootEpochCount = 0;
+  File file = LittleFS.open(TIME_EPOCHS_PATH, "r");
+  if (!file) return;
+  while (file.available() && bootEpochCount < TIME_MAX_BOOT_EPOCHS) {
+    String line = file.readStringUntil('\n');
+    unsigned id, offset;
+    int exact;
+    if (sscanf(line.c_str(), "%u %u %d", &id, &offset, &exact) == 3) {
+      bootEpochs[bootEpochCount++] = {id, offset, exact != 0};
+    }
+  }
+  file.close();
+}
+
+// Preenche o realTime (2º campo) de [ticks,realTime,dados,boot] com a
+// época do boot em que o scan foi feito, se já conhecida
+String backfillScanRecord(const String& record) {
+  int first = record.indexOf(',');
+  int second = record.indexOf(',', first + 1);
+  int last = record.lastIndexOf(',');
+  if (first < 0 || second < 0 || record.charAt(record.length() - 2) == ']') {
+    return record; // formato antigo, sem boot
+  }
+  if (record.substring(first + 1, second).toInt() != 0) return record;
+
+  unsigned long ticks = record.substring(1, first).toInt();
+  uint32_t boot = record.substring(last + 1, record.length() - 1).toInt();
+  uint32_t epoch = epochFor(boot, ticks);
+  if (epoch == 0) return record;
+
+  return record.substring(0, first + 1) + String(epoch) + record.substring(second);
+}
+
+// Grava a época nos arquivos do boot ainda no flash: scans com o realTime
+// preenchido e viagens/resumos com "epoch" do início, como no upload
+static void backfillBootFiles(uint32_t id) {
+  String tag = String(id) + "_";
+  int rewritten = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    String name = dir.fileName();
+    bool scan = name.startsWith("scan_");
+    int sep = name.indexOf('_');
+    if (!scan && !name.startsWith("trip_") && !name.startsWith("agg_")) continue;
+    if (!name.substring(sep + 1).startsWith(tag)) continue;
+
+    File file = LittleFS.open(name.c_str(), "r");
+    if (!file) continue;
+    String content = file.readString();
+    file.close();
+
+    String updated;
+    if (scan) {
+      updated = backfillScanRecord(content);
+    } else if (!content.startsWith("{\"epoch\":")) {
+      unsigned long start = name.substring(sep + 1 + tag.length(), name.length() - 5).toInt();
+      updated = "{\"epoch\":" + String(epochFor(id, start)) + "," + content.substring(1);
+    }
+    if (updated.length() == 0 || updated == content) continue;
+    file = LittleFS.open(name.c_str(), "w");
+    if (!file) continue;
+    file.print(updated);
+    file.close();
+    rewritten++;
+  }
+  if (rewritten > 0) LOG_I("TIME", "Boot %u: época gravada em %d arquivos", (unsigned)id, rewritten);
+}
+
+// Marca as entradas da tabela citadas por algum arquivo ainda não enviado
+// (scan_/trip_/agg_<boot>_*), numa passada só pelo diretório
+static void markReferencedBoots(bool* referenced) {
+  memset(referenced, 0, sizeof(bool) * bootEpochCount);
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    String name = dir.fileName();
+    if (!name.startsWith("scan_") && !name.startsWith("trip_") && !name.startsWith("agg_")) continue;
+    int sep = name.indexOf('_');
+    int end = name.indexOf('_', sep + 1);
+    if (end < 0) continue;
+    uint32_t id = name.substring(sep + 1, end).toInt();
+    for (int i = 0; i < bootEpochCount; i++) {
+      if (bootEpochs[i].bootId == id) referenced[i] = true;
+    }
+  }
+}
+
+// Entrada a descartar com a tabela cheia: o boot mais antigo sem arquivos
+// no flash. Se todos ainda têm, o mais antigo, com a época já gravada nos
+// arquivos dele
+static void evictBootEpoch() {
+  bool referenced[TIME_MAX_BOOT_EPOCHS];
+  markReferencedBoots(referenced);
+  int victim = -1;
+  for (int i = 0; i < bootEpochCount && victim < 0; i++) {
+    if (bootEpochs[i].bootId != bootId && !referenced[i]) victim = i;
+  }
+  if (victim < 0) {
+    victim = bootEpochs[0].bootId != bootId ? 0 : 1;
+    backfillBootFiles(bootEpochs[victim].bootId);
+  }
+  memmove(&bootEpochs[victim], &bootEpochs[victim + 1], sizeof(BootEpoch) * (bootEpochCount - victim - 1));
+  bootEpochCount--;
+}
+
+static void setBootEpoch(uint32_t id, uint32_t offset, bool exact) {
+  int slot = -1;
+  for (int i = 0; i < bootEpochCount; i++) {
+    if (bootEpochs[i].bootId == id) slot = i;
+  }
+  if (slot < 0) {
+    if (bootEpochCount >= TIME_MAX_BOOT_EPOCHS) evictBootEpoch();
+    slot = bootEpochCount++;
+  }
+  bootEpochs[slot] = {id, offset, exact};
+  saveBootEpochs();
+}
+
+static void onTimeSet() {
+  // Callback do SNTP (lwIP); o trabalho de flash fica para timeBaseUpdate()
+  sntpReceived = true;
+}
+
+void timeBaseBegin() {
+  RtcTimeState state;
+  bool rtcValid = ESP.rtcUserMemoryRead(TIME_RTC_OFFSET, (uint32_t*)&state, sizeof(state)) &&
+                  state.magic == TIME_RTC_MAGIC && state.checksum == rtcChecksum(state);
+
+  if (rtcValid) {
+    bootId = state.bootId + 1;
+  } else {
+    // Sem RTC (falta de energia): continua a contagem salva na flash
+    File file = LittleFS.open(TIME_BOOT_PATH, "r");
+    bootId = file ? file.readString().toInt() + 1 : 1;
+    if (file) file.close();
+  }
+
+  File file = LittleFS.open(TIME_BOOT_PATH, "w");
+  if (file) {
+    file.print(bootId);
+    file.close();
+  }
+
+  loadBootEpochs();
+
+  // Reset sem perda de energia: o relógio parou no máximo alguns segundos,
+  // então o último horário do boot anterior é um bom limite inferior
+  if (rtcValid && state.lastEpoch >= TIME_VALID_EPOCH) {
+    setBootEpoch(bootId, state.lastEpoch - millis() / 1000, false);
+    LOG_I("TIME", "Boot %u: horário estimado do boot anterior", (unsigned)bootId);
+  } else {
+    LOG_I("TIME", "Boot %u: aguardando SNTP", (unsigned)bootId);
+  }
+
+  // SNTP do lwIP: não bloqueia, sincroniza sozinho quando houver rede
+  settimeofday_cb(onTimeSet);
+  configTime(0, 0, "pool.ntp.org", "a.st1.ntp.br");
+
+  writeRtc();
+  lastRtcWrite = millis();
+}
+
+void timeBaseUpdate() {
+  unsigned long ticks = millis();
+
+  // millis() deu a volta (~49 dias): abre um novo segmento como se fosse
+  // um novo boot, mantendo o offset quando conhecido
+  if (ticks < lastTicks) {
+    uint32_t previous = bootId;
+    bootId++;
+    for (int i = 0; i < bootEpochCount; i++) {
+      if (bootEpochs[i].bootId == previous) {
+        setBootEpoch(bootId, bootEpochs[i].offset + 4294967UL, bootEpochs[i].exact);
+        break;
+      }
+    }
+    File file = LittleFS.open(TIME_BOOT_PATH, "w");
+    if (file) {
+      file.print(bootId);
+      file.close();
+    }
+  }
+  lastTicks = ticks;
+
+  if (sntpReceived) {
+    sntpReceived = false;
+    time_t now = time(nullptr);
+    if ((uint32_t)now >= TIME_VALID_EPOCH) {
+      synced = true;
+      setBootEpoch(bootId, (uint32_t)now - ticks / 1000, true);
+      LOG_I("TIME", "Horário sincronizado via SNTP: %u", (unsigned)now);
+    }
+  }
+
+  if (ticks - lastRtcWrite > 60000) {
+    writeRtc();
+    lastRtcWrite = ticks;
+  }
+}
+
+void timeBaseSetEpoch(uint32_t epoch) {
+  if (synced || epoch < TIME_VALID_EPOCH) return;
+  synced = true;
+  setBootEpoch(bootId, epoch - millis() / 1000, true);
+  LOG_I("TIME", "Horário recebido do servidor: %u", (unsigned)epoch);
+}
+
+bool timeSynced() {
+  return synced;
+}
+
+uint32_t currentBootId() {
+  return bootId;
+}
+
+unsigned long timeTicks() {
+  return millis();
+}
+
+uint32_t epochNow() {
+  return epochFor(bootId, millis());
+}
+
+uint32_t epochFor(uint32_t id, unsigned long ticks) {
+  for (int i = 0; i < bootEpochCount; i++) {
+    if (bootEpochs[i].bootId == id) {
+      return bootEpochs[i].offset + ticks / 1000;
+    }
+  }
+  return 0;
+}
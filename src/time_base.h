@@ -0,0 +1,35 @@
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include <Arduino.h>
+
+#define TIME_VALID_EPOCH 1600000000UL // antes disso o relógio não foi ajustado
+#define TIME_BOOT_PATH "/boot.txt"
+#define TIME_EPOCHS_PATH "/epochs.txt"
+#define TIME_MAX_BOOT_EPOCHS 16       // cheio, sai um boot sem arquivos no flash
+#define TIME_RTC_OFFSET 0             // bloco de 4 bytes na memória RTC do usuário
+#define TIME_RTC_MAGIC 0x54494D45     // "TIME"
+
+// Registros guardam (bootId, ticks desde o boot); a época é resolvida no
+// upload com o offset conhecido de cada boot
+struct BootEpoch {
+  uint32_t bootId;
+  uint32_t offset;  // época (s) no tick zero desse boot
+  bool exact;       // false = estimado a partir do boot anterior
+};
+
+void timeBaseBegin();
+void timeBaseUpdate();
+bool timeSynced();
+// Época (s) vinda de um servidor quando o SNTP não alcança (bike no AP do
+// gateway); ignorada depois que o relógio já foi sincronizado
+void timeBaseSetEpoch(uint32_t epoch);
+uint32_t currentBootId();
+unsigned long timeTicks();
+uint32_t epochNow();
+uint32_t epochFor(uint32_t bootId, unsigned long ticks);
+// [ticks,realTime,dados,boot] com o realTime preenchido, se o offset do
+// boot é conhecido
+String backfillScanRecord(const String& record);
+
+#endif
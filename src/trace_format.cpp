@@ -0,0 +1,100 @@
+#include "trace_format.h"
+#include <string.h>
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+static uint16_t get16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+size_t traceHeader(uint8_t* buf) {
+  memcpy(buf, TRACE_MAGIC, 4);
+  buf[4] = TRACE_VERSION;
+  buf[5] = buf[6] = buf[7] = 0;
+  return TRACE_HEADER_SIZE;
+}
+
+size_t traceEncode(const TraceScan& scan, uint8_t* buf, size_t capacity) {
+  size_t n = 0;
+  if (scan.type == TRACE_REPEAT) {
+    if (capacity < 13) return 0;
+    buf[0] = TRACE_REPEAT;
+    put32(buf + 1, scan.ticks);
+    put32(buf + 5, scan.interval);
+    put32(buf + 9, scan.repeat);
+    return 13;
+  }
+
+  if (capacity < 10) return 0;
+  buf[0] = TRACE_SCAN;
+  put32(buf + 1, scan.ticks);
+  put16(buf + 5, scan.scanMs);
+  put16(buf + 7, scan.batteryAdc);
+  buf[9] = scan.count;
+  n = 10;
+  for (int i = 0; i < scan.count; i++) {
+    const TraceNetwork& net = scan.networks[i];
+    size_t len = strnlen(net.ssid, 32);
+    if (n + 1 + len + 9 > capacity) return 0;
+    buf[n++] = len;
+    memcpy(buf + n, net.ssid, len);
+    n += len;
+    memcpy(buf + n, net.bssid, 6);
+    n += 6;
+    buf[n++] = (uint8_t)net.rssi;
+    buf[n++] = net.channel;
+    buf[n++] = net.encryption;
+  }
+  return n;
+}
+
+bool traceDecode(const uint8_t* buf, size_t length, size_t* pos, TraceScan& scan) {
+  size_t n = *pos;
+  if (n >= length) return false;
+
+  scan.type = buf[n];
+  if (scan.type == TRACE_REPEAT) {
+    if (n + 13 > length) return false;
+    scan.ticks = get32(buf + n + 1);
+    scan.interval = get32(buf + n + 5);
+    scan.repeat = get32(buf + n + 9);
+    *pos = n + 13;
+    return true;
+  }
+  if (scan.type != TRACE_SCAN || n + 10 > length) return false;
+
+  scan.ticks = get32(buf + n + 1);
+  scan.scanMs = get16(buf + n + 5);
+  scan.batteryAdc = get16(buf + n + 7);
+  scan.count = buf[n + 9];
+  if (scan.count > TRACE_MAX_NETWORKS) return false;
+  n += 10;
+  for (int i = 0; i < scan.count; i++) {
+    TraceNetwork& net = scan.networks[i];
+    if (n + 1 > length) return false;
+    size_t len = buf[n++];
+    if (len > 32 || n + len + 9 > length) return false;
+    memcpy(net.ssid, buf + n, len);
+    net.ssid[len] = '\0';
+    n += len;
+    memcpy(net.bssid, buf + n, 6);
+    n += 6;
+    net.rssi = (int8_t)buf[n++];
+    net.channel = buf[n++];
+    net.encryption = buf[n++];
+  }
+  *pos = n;
+  return true;
+}
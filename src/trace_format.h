@@ -0,0 +1,51 @@
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+// Trace de scans gravado pelo env de trace e reproduzido no host
+// (tools/replay). Só C++ puro, little endian.
+//
+// Arquivo:  "BPRT" | versão u8 | 3 bytes reservados | registros...
+// SCAN:     tipo u8 | ticks u32 | duração do scan ms u16 | ADC bateria u16 |
+//           n u8 | n x (len u8 + ssid | bssid 6 | rssi i8 | canal u8 | cripto u8)
+// REPEAT:   tipo u8 | ticks u32 | intervalo ms u32 | vezes u32
+//           (repete o último SCAN, com ticks, ticks + intervalo, ...)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_MAGIC "BPRT"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 8
+#define TRACE_MAX_NETWORKS 48
+
+enum TraceRecordType {
+  TRACE_SCAN = 1,
+  TRACE_REPEAT = 2,
+};
+
+struct TraceNetwork {
+  char ssid[33];
+  uint8_t bssid[6];
+  int8_t rssi;
+  uint8_t channel;
+  uint8_t encryption;
+};
+
+struct TraceScan {
+  uint8_t type;
+  uint32_t ticks;
+  uint16_t scanMs;
+  uint16_t batteryAdc;
+  uint8_t count;
+  TraceNetwork networks[TRACE_MAX_NETWORKS];
+  uint32_t interval; // REPEAT
+  uint32_t repeat;   // REPEAT
+};
+
+size_t traceHeader(uint8_t* buf);
+// Retorna o tamanho codificado; 0 se não couber em capacity
+size_t traceEncode(const TraceScan& scan, uint8_t* buf, size_t capacity);
+// Lê o registro em buf[*pos]; avança *pos. false no fim ou em erro.
+bool traceDecode(const uint8_t* buf, size_t length, size_t* pos, TraceScan& scan);
+
+#endif
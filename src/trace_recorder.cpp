@@ -0,0 +1,71 @@
+#include "trace_recorder.h"
+
+#if TRACE_RECORD
+
+#include "trace_format.h"
+#include "logger.h"
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+
+// Estáticos: ~4 KB que só existem no env de trace
+static TraceScan scan;
+static uint8_t encoded[10 + TRACE_MAX_NETWORKS * 45];
+static size_t fileSize = 0;
+static bool full = false;
+
+void traceBegin() {
+  File file = LittleFS.open(TRACE_PATH, "r");
+  fileSize = file ? file.size() : 0;
+  if (file) file.close();
+
+  if (fileSize == 0) {
+    file = LittleFS.open(TRACE_PATH, "w");
+    if (!file) return;
+    fileSize = file.write(encoded, traceHeader(encoded));
+    file.close();
+  }
+  full = fileSize >= TRACE_MAX_BYTES;
+  LOG_I("TRACE", "Gravando scans em %s (%u bytes)", TRACE_PATH, (unsigned)fileSize);
+}
+
+void traceRecordScan(int n, unsigned long scanMs) {
+  if (full) return;
+
+  scan.type = TRACE_SCAN;
+  scan.ticks = millis();
+  scan.scanMs = min(scanMs, 65535UL);
+  scan.batteryAdc = analogRead(A0);
+  scan.count = 0;
+  for (int i = 0; i < n && scan.count < TRACE_MAX_NETWORKS; i++) {
+    TraceNetwork& net = scan.networks[scan.count++];
+    WiFi.SSID(i).toCharArray(net.ssid, sizeof(net.ssid));
+    memcpy(net.bssid, WiFi.BSSID(i), 6);
+    net.rssi = WiFi.RSSI(i);
+    net.channel = WiFi.channel(i);
+    net.encryption = WiFi.encryptionType(i);
+  }
+
+  size_t length = traceEncode(scan, encoded, sizeof(encoded));
+  if (fileSize + length > TRACE_MAX_BYTES) {
+    full = true;
+    LOG_W("TRACE", "Trace cheio (%u bytes) - gravação parada", (unsigned)fileSize);
+    return;
+  }
+  File file = LittleFS.open(TRACE_PATH, "a");
+  if (!file) return;
+  fileSize += file.write(encoded, length);
+  file.close();
+}
+
+size_t traceSize() {
+  return fileSize;
+}
+
+void traceClear() {
+  LittleFS.remove(TRACE_PATH);
+  fileSize = 0;
+  full = false;
+  traceBegin();
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+
+// Gravação dos scans crus para replay no host (env nodemcuv2_trace).
+// Fora desse env tudo vira no-op.
+
+#ifndef TRACE_RECORD
+#define TRACE_RECORD 0
+#endif
+
+#define TRACE_PATH "/trace.bin"
+#define TRACE_MAX_BYTES 524288 // para de gravar ao chegar nisso
+
+#if TRACE_RECORD
+void traceBegin();
+// Chamada logo após WiFi.scanNetworks(), com os n resultados ainda disponíveis
+void traceRecordScan(int n, unsigned long scanMs);
+size_t traceSize();
+void traceClear();
+#else
+inline void traceBegin() {}
+inline void traceRecordScan(int, unsigned long) {}
+inline size_t traceSize() { return 0; }
+inline void traceClear() {}
+#endif
+
+#endif
@@ -0,0 +1,228 @@
+#include "trip_segmenter.h"
+#include "config.h"
+#include "wifi_scanner.h"
+#include "locator.h"
+#include "logger.h"
+#include "time_base.h"
+#include <LittleFS.h>
+#include <Arduino.h>
+
+static TripSummary trip;
+static bool riding = false;
+static uint8_t parkedBase = 0;
+static int movingScans = 0;
+
+// Assinatura do ambiente: hash dos BSSIDs mais fortes do scan anterior
+static uint32_t prevSignature[TRIP_SIGNATURE_SIZE];
+static int prevSignatureCount = -1;
+static float changeRate = 0;
+
+static unsigned long stillSince = 0;
+static uint8_t stillBssid[6];
+
+static int waypointEvery = 0;
+static int scansSinceWaypoint = 0;
+
+static uint32_t hashBssid(const char* bssid) {
+  uint32_t hash = 2166136261u;
+  for (; *bssid; bssid++) {
+    hash = (hash ^ (uint8_t)*bssid) * 16777619u;
+  }
+  return hash;
+}
+
+// Distância de Jaccard entre os conjuntos de APs de dois scans seguidos
+static float updateSignature(int& strongest) {
+  int count = selectStrongest(networks.data(), networks.size(), TRIP_SIGNATURE_SIZE);
+  strongest = count > 0 ? 0 : -1;
+
+  uint32_t signature[TRIP_SIGNATURE_SIZE];
+  for (int i = 0; i < count; i++) {
+    signature[i] = hashBssid(networks[i].bssid);
+  }
+
+  float change = 0;
+  if (prevSignatureCount >= 0) {
+    int common = 0;
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < prevSignatureCount; j++) {
+        if (signature[i] == prevSignature[j]) {
+          common++;
+          break;
+        }
+      }
+    }
+    int total = count + prevSignatureCount - common;
+    change = total > 0 ? 1.0f - (float)common / total : 0;
+  }
+
+  memcpy(prevSignature, signature, count * sizeof(uint32_t));
+  prevSignatureCount = count;
+  return change;
+}
+
+static void addStation(uint8_t base) {
+  if (base == 0) return;
+  if (trip.stationCount > 0 && trip.stations[trip.stationCount - 1] == base) return;
+  if (trip.stationCount < TRIP_MAX_STATIONS) {
+    trip.stations[trip.stationCount++] = base;
+  }
+}
+
+static void addWaypoint(unsigned long now, int strongest) {
+  if (waypointEvery <= 0 || strongest < 0) return;
+  if (++scansSinceWaypoint < waypointEvery) return;
+  scansSinceWaypoint = 0;
+
+  // Cheio: descarta um ponto sim, um não e dobra o intervalo
+  if (trip.waypointCount >= TRIP_MAX_WAYPOINTS) {
+    for (int i = 0; i < TRIP_MAX_WAYPOINTS / 2; i++) {
+      trip.waypoints[i] = trip.waypoints[i * 2];
+    }
+    trip.waypointCount = TRIP_MAX_WAYPOINTS / 2;
+    waypointEvery *= 2;
+  }
+
+  TripWaypoint& wp = trip.waypoints[trip.waypointCount++];
+  wp.time = now;
+  parseBssid(networks[strongest].bssid, wp.bssid);
+  wp.rssi = networks[strongest].rssi;
+  wp.latE7 = lastFix.valid ? lastFix.latE7 : 0;
+  wp.lonE7 = lastFix.valid ? lastFix.lonE7 : 0;
+}
+
+static String formatBssid(const uint8_t* bssid) {
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+           bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
+  return String(buf);
+}
+
+static void startTrip(unsigned long now) {
+  memset(&trip, 0, sizeof(trip));
+  trip.start = now;
+  trip.startBase = parkedBase;
+  addStation(parkedBase);
+  parkedBase = 0;
+  riding = true;
+  stillSince = 0;
+  waypointEvery = config.tripWaypointEvery;
+  scansSinceWaypoint = 0;
+  LOG_I("TRIP", "Viagem iniciada (base %d, troca %.2f)", trip.startBase, changeRate);
+}
+
+static void endTrip(unsigned long end, uint8_t base) {
+  riding = false;
+  movingScans = 0;
+  trip.end = end;
+  trip.endBase = base;
+  addStation(base);
+
+  if (trip.scans < TRIP_MIN_SCANS) {
+    LOG_D("TRIP", "Viagem curta descartada (%d scans)", trip.scans);
+    return;
+  }
+
+  // Resumo: {"boot","start","end","dur","from","to","scans","stations","dwells","wp"}
+  String data = "{\"boot\":" + String(currentBootId());
+  data += ",\"start\":" + String(trip.start);
+  data += ",\"end\":" + String(trip.end);
+  data += ",\"dur\":" + String((trip.end - trip.start) / 1000);
+  data += ",\"from\":" + String(trip.startBase);
+  data += ",\"to\":" + String(trip.endBase);
+  data += ",\"scans\":" + String(trip.scans);
+  data += ",\"stations\":[";
+  for (int i = 0; i < trip.stationCount; i++) {
+    if (i > 0) data += ",";
+    data += String(trip.stations[i]);
+  }
+  data += "],\"dwells\":[";
+  for (int i = 0; i < trip.dwellCount; i++) {
+    if (i > 0) data += ",";
+    data += "[" + String(trip.dwells[i].start) + "," + String(trip.dwells[i].duration / 1000);
+    data += ",\"" + formatBssid(trip.dwells[i].bssid) + "\"]";
+  }
+  data += "],\"wp\":[";
+  for (int i = 0; i < trip.waypointCount; i++) {
+    const TripWaypoint& wp = trip.waypoints[i];
+    if (i > 0) data += ",";
+    data += "[" + String(wp.time) + ",\"" + formatBssid(wp.bssid) + "\"," + String(wp.rssi);
+    if (wp.latE7 != 0 || wp.lonE7 != 0) {
+      data += "," + String(wp.latE7) + "," + String(wp.lonE7);
+    }
+    data += "]";
+  }
+  data += "]}";
+
+  String filename = "/trip_" + String(currentBootId()) + "_" + String(trip.start) + ".json";
+  File file = LittleFS.open(filename.c_str(), "w");
+  if (file) {
+    file.print(data);
+    file.close();
+  }
+  LOG_I("TRIP", "Viagem encerrada: %lus, %d estações, %d paradas, %d pontos",
+        (trip.end - trip.start) / 1000, trip.stationCount, trip.dwellCount, trip.waypointCount);
+}
+
+void tripUpdate(unsigned long now, int baseIndex, bool atBase) {
+  int strongest;
+  float change = updateSignature(strongest);
+  changeRate = 0.5f * changeRate + 0.5f * change;
+  bool moving = changeRate >= TRIP_MOVING_CHANGE;
+  bool still = changeRate < TRIP_STILL_CHANGE;
+
+  if (!riding) {
+    if (atBase) {
+      parkedBase = baseIndex;
+      movingScans = 0;
+      return;
+    }
+    // Saiu da base, ou o ambiente está mudando fora dela
+    movingScans = moving ? movingScans + 1 : 0;
+    if (parkedBase > 0 || movingScans >= TRIP_START_SCANS) {
+      startTrip(now);
+    } else {
+      return;
+    }
+  }
+
+  trip.scans++;
+
+  if (atBase) {
+    endTrip(now, baseIndex);
+    parkedBase = baseIndex;
+    return;
+  }
+  // Base visível mas fraca: passou perto de uma estação
+  addStation(findBase(-127));
+
+  if (still) {
+    if (stillSince == 0) {
+      stillSince = now;
+      memset(stillBssid, 0, sizeof(stillBssid));
+      if (strongest >= 0) parseBssid(networks[strongest].bssid, stillBssid);
+    } else if (now - stillSince >= TRIP_END_IDLE_MS) {
+      endTrip(stillSince, 0);
+      return;
+    }
+  } else if (stillSince != 0) {
+    if (now - stillSince >= TRIP_DWELL_MIN_MS && trip.dwellCount < TRIP_MAX_DWELLS) {
+      TripDwell& dwell = trip.dwells[trip.dwellCount++];
+      dwell.start = stillSince;
+      dwell.duration = now - stillSince;
+      memcpy(dwell.bssid, stillBssid, 6);
+    }
+    stillSince = 0;
+  }
+
+  // Parada já fica no resumo como dwell; pontos só em movimento
+  if (!still) addWaypoint(now, strongest);
+}
+
+bool tripActive() {
+  return riding;
+}
+
+float tripChangeRate() {
+  return changeRate;
+}
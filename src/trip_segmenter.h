@@ -0,0 +1,50 @@
+#ifndef TRIP_SEGMENTER_H
+#define TRIP_SEGMENTER_H
+
+#include <Arduino.h>
+
+#define TRIP_SIGNATURE_SIZE 8     // APs mais fortes comparados entre scans
+#define TRIP_MAX_STATIONS 8
+#define TRIP_MAX_DWELLS 8
+#define TRIP_MAX_WAYPOINTS 24
+
+#define TRIP_MOVING_CHANGE 0.5    // troca de APs que indica movimento
+#define TRIP_STILL_CHANGE 0.2     // abaixo disso a bike está parada
+#define TRIP_START_SCANS 2        // scans seguidos em movimento para iniciar
+#define TRIP_MIN_SCANS 3          // viagens mais curtas são descartadas
+#define TRIP_DWELL_MIN_MS 60000   // parada mínima registrada no resumo
+#define TRIP_END_IDLE_MS 300000   // parada que encerra a viagem fora da base
+
+struct TripDwell {
+  unsigned long start;
+  unsigned long duration;
+  uint8_t bssid[6];
+};
+
+struct TripWaypoint {
+  unsigned long time;
+  uint8_t bssid[6];
+  int8_t rssi;
+  int32_t latE7; // 0 quando não há posição estimada
+  int32_t lonE7;
+};
+
+struct TripSummary {
+  unsigned long start;
+  unsigned long end;
+  uint8_t startBase; // 1-3, 0 = fora de base
+  uint8_t endBase;
+  uint16_t scans;
+  uint8_t stations[TRIP_MAX_STATIONS];
+  uint8_t stationCount;
+  TripDwell dwells[TRIP_MAX_DWELLS];
+  uint8_t dwellCount;
+  TripWaypoint waypoints[TRIP_MAX_WAYPOINTS];
+  uint8_t waypointCount;
+};
+
+void tripUpdate(unsigned long now, int baseIndex, bool atBase);
+bool tripActive();
+float tripChangeRate();
+
+#endif
@@ -0,0 +1,186 @@
+#include "upload_backend.h"
+#include "config.h"
+#include "status_tracker.h"
+#include "known_aps.h"
+#include "logger.h"
+#include "time_base.h"
+#include "batch_format.h"
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <Arduino.h>
+
+const UploadBackend& activeBackend() {
+  if (collectorBackend.configured()) return collectorBackend;
+  return firebaseBackend;
+}
+
+// Envia os arquivos JSON <prefixo><boot>_<inicio>.json, um por requisição,
+// e apaga cada um aceito; para no primeiro erro. Retorna quantos foram
+static int uploadJsonFiles(const char* prefix, bool (*send)(const String&, const String&), const char* what) {
+  size_t prefixLength = strlen(prefix);
+  int sent = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    String name = dir.fileName();
+    if (!name.startsWith(prefix)) continue;
+
+    File file = LittleFS.open(name.c_str(), "r");
+    if (!file) continue;
+    String payload = file.readString();
+    file.close();
+
+    // <prefixo><boot>_<inicio>.json → chave <boot>_<inicio>, com a época de
+    // início resolvida agora
+    String key = name.substring(prefixLength, name.length() - 5);
+    int sep = key.indexOf('_');
+    if (sep > 0 && !payload.startsWith("{\"epoch\":")) {
+      uint32_t epoch = epochFor(key.substring(0, sep).toInt(), key.substring(sep + 1).toInt());
+      payload = "{\"epoch\":" + String(epoch) + "," + payload.substring(1);
+    }
+    if (send(key, payload)) {
+      LittleFS.remove(name.c_str());
+      LOG_I("UP", "%s enviada: %s", what, name.c_str());
+      sent++;
+    } else {
+      LOG_W("UP", "Erro no envio de %s - mantendo arquivo", name.c_str());
+      break;
+    }
+    yield();
+  }
+  return sent;
+}
+
+int uploadTrips() {
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured())
+    return 0;
+  return uploadJsonFiles("trip_", backend.sendTrip, "Viagem");
+}
+
+// Resumos das janelas de estatísticas (agg_<boot>_<inicio>.json)
+int uploadSummaries() {
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured())
+    return 0;
+  return uploadJsonFiles("agg_", backend.sendSummary, "Estatística");
+}
+
+// Atualiza o filtro de APs conhecidos na primeira visita depois do boot e
+// depois a cada KNOWN_APS_SYNC_MS (KNOWN_APS_RETRY_MS após uma falha)
+static bool knownApsLastOk = false;
+
+void syncKnownAps() {
+  static unsigned long lastAttempt = 0;
+  static bool attempted = false;
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured() || !backend.fetchKnownAps) return;
+  unsigned long wait = knownApsLastOk ? KNOWN_APS_SYNC_MS : KNOWN_APS_RETRY_MS;
+  if (attempted && millis() - lastAttempt < wait) return;
+
+  attempted = true;
+  lastAttempt = millis();
+  knownApsLastOk = backend.fetchKnownAps();
+  if (!knownApsLastOk) LOG_W("UP", "Filtro de APs conhecidos não atualizado");
+}
+
+bool knownApsSyncOk() {
+  return knownApsLastOk;
+}
+
+void syncTime() {
+  const UploadBackend& backend = activeBackend();
+  if (timeSynced() || !backend.configured() || !backend.fetchTime) return;
+  uint32_t epoch = backend.fetchTime();
+  if (epoch == 0) {
+    LOG_W("UP", "Sem horário do servidor - registros sem época até o SNTP");
+    return;
+  }
+  timeBaseSetEpoch(epoch);
+}
+
+int uploadData() {
+  const UploadBackend& backend = activeBackend();
+  if (!backend.configured() || dataCount == 0)
+    return 0;
+
+  LOG_I("UP", "=== UPLOAD (%s) ===", backend.name);
+  
+  // Registro que não passa no parser (arquivo cortado por um brownout,
+  // vazio) tornaria o lote inteiro inválido e travaria a fila: vai para
+  // bad_<boot>_<ticks>.json e fica fora dos envios
+  BatchRecord* parsed = (BatchRecord*)malloc(sizeof(BatchRecord));
+  if (!parsed) {
+    LOG_E("UP", "Sem memória para validar os scans");
+    return 0;
+  }
+
+  // Lotes de vários scans por envio, cada um com a chave <boot>_<ticks>
+  // do arquivo
+  int uploaded = 0;
+  bool ok = true;
+
+  while (ok) {
+    String files[UPLOAD_BATCH_FILES];
+    String keys[UPLOAD_BATCH_FILES];
+    String records[UPLOAD_BATCH_FILES];
+    String bad[UPLOAD_BATCH_FILES];
+    int batchCount = 0;
+    int badCount = 0;
+    size_t batchBytes = 0;
+
+    Dir dir = LittleFS.openDir("/");
+    while (dir.next() && batchCount < UPLOAD_BATCH_FILES && badCount < UPLOAD_BATCH_FILES &&
+           batchBytes < UPLOAD_BATCH_BYTES) {
+      String name = dir.fileName();
+      if (!name.startsWith("scan_")) continue;
+
+      File file = LittleFS.open(name.c_str(), "r");
+      if (!file) continue;
+      String record = backfillScanRecord(file.readString());
+      file.close();
+
+      if (!parseScanRecord(record.c_str(), record.length(), *parsed)) {
+        bad[badCount++] = name;
+        continue;
+      }
+      files[batchCount] = name;
+      keys[batchCount] = name.substring(5, name.length() - 5);
+      records[batchCount] = record;
+      batchBytes += record.length();
+      batchCount++;
+    }
+
+    // Fora da iteração do Dir
+    for (int i = 0; i < badCount; i++) {
+      String moved = "/bad_" + bad[i].substring(5);
+      LOG_W("UP", "Scan inválido, movido para %s", moved.c_str());
+      LittleFS.rename(bad[i].c_str(), moved.c_str());
+      dataCount = max(0, dataCount - 1);
+    }
+
+    if (batchCount == 0) {
+      if (badCount == 0) break;
+      continue;
+    }
+
+    int accepted = backend.sendScans(keys, records, batchCount);
+    ok = accepted > 0;
+    for (int i = 0; i < accepted; i++) {
+      LittleFS.remove(files[i].c_str());
+      LOG_D("UP", "Removido: %s", files[i].c_str());
+    }
+    uploaded += accepted;
+    yield();
+  }
+
+  free(parsed);
+
+  dataCount = max(0, dataCount - uploaded);
+  if (ok) {
+    LOG_I("UP", "Upload OK! %d scans enviados", uploaded);
+    dataCount = 0;
+  } else {
+    LOG_W("UP", "Erro no upload - %d scans enviados, mantendo o restante", uploaded);
+  }
+  return uploaded;
+}
@@ -0,0 +1,48 @@
+#ifndef UPLOAD_BACKEND_H
+#define UPLOAD_BACKEND_H
+
+#include <Arduino.h>
+
+#define UPLOAD_BATCH_FILES 16
+#define UPLOAD_BATCH_BYTES 4096
+
+// Destino dos uploads. uploadData()/uploadTrips()/uploadStatus() leem os
+// arquivos e montam os registros; o backend só decide formato e transporte.
+struct UploadBackend {
+  const char* name;
+  bool (*configured)();
+  // Registros [ticks,realTime,dados,boot] já com a época preenchida;
+  // retorna quantos foram aceitos (os primeiros), 0 em caso de erro
+  int (*sendScans)(const String* keys, const String* records, int count);
+  bool (*sendTrip)(const String& key, const String& json);
+  bool (*sendStatus)(const String& json);
+  bool (*sendSummary)(const String& key, const String& json);
+  // Baixa o filtro de APs conhecidos (ou um patch) e aplica; nullptr se o
+  // backend não serve o filtro
+  bool (*fetchKnownAps)();
+  // Baixa até length bytes (0 = tudo) de um arquivo do servidor a partir de
+  // offset e escreve em out; retorna quantos bytes escreveu, -1 em erro.
+  // nullptr se o backend não serve arquivos (sem OTA)
+  long (*fetchFile)(const char* path, uint32_t offset, uint32_t length, Print& out);
+  // Época (s) do servidor, 0 em erro; nullptr se o backend não serve o
+  // horário (com ele a bike tem rota para o SNTP)
+  uint32_t (*fetchTime)();
+};
+
+extern const UploadBackend firebaseBackend;
+extern const UploadBackend collectorBackend;
+
+// Coletor próprio quando configurado, senão Firebase
+const UploadBackend& activeBackend();
+
+// Cada um retorna quantos registros/arquivos foram aceitos. Não
+// desconectam: a visita à base (main.cpp) envia o status e desconecta no fim
+int uploadTrips();
+int uploadSummaries();
+int uploadData();
+void syncKnownAps();
+bool knownApsSyncOk();
+// Sem SNTP até aqui, pede o horário ao servidor antes dos envios
+void syncTime();
+
+#endif
@@ -1,133 +1,330 @@
 #include "web_server.h"
 #include "config.h"
 #include "wifi_scanner.h"
+#include "logger.h"
+#include "locator.h"
+#include "known_aps.h"
+#include "trace_recorder.h"
 #include <ESP8266WiFi.h>
 #include <LittleFS.h>
 #include <Arduino.h>
+#include <memory>
+
+AsyncWebServer server(80);
+
+// Páginas fixas no flash; %NOME% é trocado por configValue() no envio e
+// %% vira %
+static const char PAGE_HEAD[] PROGMEM =
+  "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>";
+
+static const char BACK_LINK[] PROGMEM =
+  "<a href='/' style='display:block;padding:10px;background:#666;color:white;text-decoration:none;text-align:center;margin:10px 0;width:100px'>Voltar</a>";
+
+static const char ROOT_HTML[] PROGMEM =
+  "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>"
+  "<style>body{font-family:Arial;margin:20px;font-size:18px}.btn{display:block;padding:20px;margin:15px 0;background:#007cba;color:white;text-decoration:none;text-align:center;border-radius:5px;font-size:18px}</style></head>"
+  "<body><h1>Bike %BIKE% - Controle</h1>"
+  "<a href='/config' class='btn'>1) Configurações</a>"
+  "<a href='/wifi' class='btn'>2) Ver WiFi Detectados</a>"
+  "<a href='/dados' class='btn'>3) Ver Dados Gravados</a>"
+  "<a href='/log' class='btn'>4) Ver Log</a>"
+  "</body></html>";
+
+static const char CONFIG_HTML[] PROGMEM =
+  "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>"
+  "<style>body{font-family:Arial;margin:20px;font-size:18px}input,button{padding:15px;font-size:16px;margin:10px 0;width:100%%;box-sizing:border-box}h3{margin-top:30px}</style></head>"
+  "<body><h1>Configurações - Bike %BIKE%</h1>"
+  "<a href='/' style='display:block;padding:10px;background:#666;color:white;text-decoration:none;text-align:center;margin:10px 0'>Voltar</a>"
+  "<form method='post' action='/save'>"
+  "ID da Bicicleta: <input name='bike' value='%BIKE%'><br>"
+  "Tempo Scan Ativo (ms): <input name='active' value='%ACTIVE%'><br>"
+  "Tempo Scan Inativo (ms): <input name='inactive' value='%INACTIVE%'><br>"
+  "Redes gravadas por scan (1-%MAXTOPK%): <input name='topk' value='%TOPK%'><br>"
+  "<label><input type='checkbox' name='mesh' value='1' style='width:auto'%MESH%> Unir nós de mesh (mesmo SSID)</label><br>"
+  "Registro: <select name='mode'>"
+  "<option value='0'%MODE0%>Redes</option>"
+  "<option value='1'%MODE1%>Só a posição (requer " AP_INDEX_PATH ")</option>"
+  "<option value='2'%MODE2%>Só estatísticas por janela</option>"
+  "</select><br>"
+  "Janela das estatísticas (s): <input name='window' value='%WINDOW%'><br>"
+  "<label><input type='checkbox' name='trip' value='1' style='width:auto'%TRIP%> Gravar só resumos de viagem</label><br>"
+  "Scans entre pontos do trajeto (0 = nenhum): <input name='wp' value='%WP%'><br>"
+  "<label><input type='checkbox' name='known' value='1' style='width:auto'%KNOWN%> Gravar só o AP conhecido mais forte (com " KNOWN_APS_PATH ")</label><br>"
+  "Coletor (host:porta, vazio = Firebase): <input name='collector' value='%COLLECTOR%'><br>"
+  "<h3>Base 1:</h3>SSID: <input name='ssid1' value='%SSID1%'><br>"
+  "Senha: <input name='pass1' value='%PASS1%'><br>"
+  "<h3>Base 2:</h3>SSID: <input name='ssid2' value='%SSID2%'><br>"
+  "Senha: <input name='pass2' value='%PASS2%'><br>"
+  "<h3>Base 3:</h3>SSID: <input name='ssid3' value='%SSID3%'><br>"
+  "Senha: <input name='pass3' value='%PASS3%'><br>"
+  "<button type='submit'>Salvar</button></form></body></html>";
+
+static const char SAVED_HTML[] PROGMEM =
+  "<html><body><h1>Salvo! Reiniciando...</h1></body></html>";
+
+static int activeRequests = 0;
+static bool saveRequested = false;
+static bool restartPending = false;
+static unsigned long savedAt = 0;
+static unsigned long wifiPageAt = 0;
+static unsigned long lastUiScan = 0;
+
+// Acima do limite de requisições simultâneas (ou com pouco heap) responde
+// 503 na hora, em vez de segurar memória para mais uma conexão
+static ArRequestHandlerFunction limited(ArRequestHandlerFunction handler) {
+  return [handler](AsyncWebServerRequest* request) {
+    if (activeRequests >= WEB_MAX_REQUESTS || ESP.getFreeHeap() < WEB_MIN_HEAP) {
+      LOG_D("WEB", "Requisição recusada (%d ativas, heap %u)", activeRequests, ESP.getFreeHeap());
+      AsyncWebServerResponse* response = request->beginResponse(503, "text/plain", "Ocupado, tente de novo");
+      response->addHeader("Retry-After", "2");
+      request->send(response);
+      return;
+    }
+    activeRequests++;
+    request->onDisconnect([] { activeRequests--; });
+    handler(request);
+  };
+}
 
 void startConfigMode() {
   configMode = true;
-  
+
   if (digitalRead(0) == LOW) {
     WiFi.mode(WIFI_AP);
     String apName = "Bike-" + String(config.bikeId);
     WiFi.softAP(apName.c_str(), "12345678");
-    Serial.println("=== MODO CONFIGURAÇÃO ATIVO ===");
-    Serial.println("WiFi: " + apName);
-    Serial.println("Senha: 12345678");
-    Serial.println("Acesse: http://192.168.4.1");
-    Serial.println("================================");
+    LOG_I("WEB", "Modo configuração ativo - WiFi: %s / Senha: 12345678", apName.c_str());
+    LOG_I("WEB", "Acesse: http://192.168.4.1");
   } else {
     if (connectToBase()) {
-      Serial.println("=== MODO CONFIGURAÇÃO ATIVO ===");
-      Serial.println("IP: " + WiFi.localIP().toString());
-      Serial.println("Acesse: http://" + WiFi.localIP().toString());
-      Serial.println("================================");
+      LOG_I("WEB", "Modo configuração ativo - Acesse: http://%s", WiFi.localIP().toString().c_str());
     }
   }
 
-  server.on("/", handleRoot);
-  server.on("/config", handleConfig);
-  server.on("/save", HTTP_POST, handleSave);
-  server.on("/wifi", handleWifi);
-  server.on("/dados", handleDados);
+  server.on("/", HTTP_GET, limited(handleRoot));
+  server.on("/config", HTTP_GET, limited(handleConfig));
+  server.on("/save", HTTP_POST, limited(handleSave));
+  server.on("/wifi", HTTP_GET, limited(handleWifi));
+  server.on("/dados", HTTP_GET, limited(handleDados));
+  server.on("/log", HTTP_GET, limited(handleLog));
+#if TRACE_RECORD
+  server.on("/trace", HTTP_GET, limited(handleTrace));
+#endif
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    request->send(404, "text/plain", "Não encontrado");
+  });
   server.begin();
 }
 
-void handleRoot() {
-  String html = "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>";
-  html += "<style>body{font-family:Arial;margin:20px;font-size:18px}.btn{display:block;padding:20px;margin:15px 0;background:#007cba;color:white;text-decoration:none;text-align:center;border-radius:5px;font-size:18px}</style></head>";
-  html += "<body><h1>Bike " + String(config.bikeId) + " - Controle</h1>";
-  html += "<a href='/config' class='btn'>1) Configurações</a>";
-  html += "<a href='/wifi' class='btn'>2) Ver WiFi Detectados</a>";
-  html += "<a href='/dados' class='btn'>3) Ver Dados Gravados</a>";
-  html += "</body></html>";
-  server.send(200, "text/html", html);
-}
-
-void handleConfig() {
-  String html = "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>";
-  html += "<style>body{font-family:Arial;margin:20px;font-size:18px}input,button{padding:15px;font-size:16px;margin:10px 0;width:100%;box-sizing:border-box}h3{margin-top:30px}</style></head>";
-  html += "<body><h1>Configurações - Bike " + String(config.bikeId) + "</h1>";
-  html += "<a href='/' style='display:block;padding:10px;background:#666;color:white;text-decoration:none;text-align:center;margin:10px 0'>Voltar</a>";
-  html += "<form method='post' action='/save'>";
-  html += "ID da Bicicleta: <input name='bike' value='" + String(config.bikeId) + "'><br>";
-  html += "Tempo Scan Ativo (ms): <input name='active' value='" + String(config.scanTimeActive) + "'><br>";
-  html += "Tempo Scan Inativo (ms): <input name='inactive' value='" + String(config.scanTimeInactive) + "'><br>";
-  html += "<h3>Base 1:</h3>SSID: <input name='ssid1' value='" + String(config.baseSSID1) + "'><br>";
-  html += "Senha: <input name='pass1' value='" + String(config.basePassword1) + "'><br>";
-  html += "<h3>Base 2:</h3>SSID: <input name='ssid2' value='" + String(config.baseSSID2) + "'><br>";
-  html += "Senha: <input name='pass2' value='" + String(config.basePassword2) + "'><br>";
-  html += "<h3>Base 3:</h3>SSID: <input name='ssid3' value='" + String(config.baseSSID3) + "'><br>";
-  html += "Senha: <input name='pass3' value='" + String(config.basePassword3) + "'><br>";
-  html += "<button type='submit'>Salvar</button></form></body></html>";
-  server.send(200, "text/html", html);
-}
-
-void handleSave() {
-  server.arg("bike").toCharArray(config.bikeId, 10);
-  config.scanTimeActive = server.arg("active").toInt();
-  config.scanTimeInactive = server.arg("inactive").toInt();
-  server.arg("ssid1").toCharArray(config.baseSSID1, 32);
-  server.arg("pass1").toCharArray(config.basePassword1, 32);
-  server.arg("ssid2").toCharArray(config.baseSSID2, 32);
-  server.arg("pass2").toCharArray(config.basePassword2, 32);
-  server.arg("ssid3").toCharArray(config.baseSSID3, 32);
-  server.arg("pass3").toCharArray(config.basePassword3, 32);
-
-  saveConfig();
-  server.send(200, "text/html", "<html><body><h1>Salvo! Reiniciando...</h1></body></html>");
-  delay(2000);
-  ESP.restart();
-}
-
-void handleWifi() {
-  scanWiFiNetworks();
-  String html = "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>";
-  html += "<style>body{font-family:Arial;margin:20px;font-size:16px}table{width:100%;border-collapse:collapse}th,td{border:1px solid #ddd;padding:12px;text-align:left}th{background:#f2f2f2}.strong{color:green}.weak{color:red}</style>";
-  html += "<script>setTimeout(function(){location.reload()},5000)</script></head>";
-  html += "<body><h1>WiFi Detectados (Bike " + String(config.bikeId) + ")</h1>";
-  html += "<p>Atualizando a cada 5 segundos...</p>";
-  html += "<table><tr><th>SSID</th><th>RSSI</th><th>Canal</th></tr>";
-  for (int i = 0; i < networkCount; i++) {
-    String cssClass = networks[i].rssi > -60 ? "strong" : (networks[i].rssi < -80 ? "weak" : "");
-    html += "<tr class='" + cssClass + "'><td>" + String(networks[i].ssid) + "</td><td>" + String(networks[i].rssi) + " dBm</td><td>" + String(networks[i].channel) + "</td></tr>";
+// O que os handlers não podem fazer no callback do TCP
+void webServerLoop() {
+  unsigned long now = millis();
+  if (saveRequested) {
+    saveRequested = false;
+    saveConfig();
+    restartPending = true;
+    savedAt = now;
+  }
+  if (restartPending && now - savedAt >= WEB_RESTART_MS) {
+    ESP.restart();
+  }
+
+  // Scan só enquanto alguém está olhando /wifi (a página recarrega a cada 5 s)
+  pollWiFiScanAsync();
+  if (wifiPageAt != 0 && now - wifiPageAt < 3 * WEB_SCAN_MS &&
+      (lastUiScan == 0 || now - lastUiScan >= WEB_SCAN_MS)) {
+    lastUiScan = now;
+    startWiFiScanAsync();
+  }
+}
+
+static const char* checked(bool on) {
+  return on ? " checked" : "";
+}
+
+static const char* selected(bool on) {
+  return on ? " selected" : "";
+}
+
+static String configValue(const String& var) {
+  if (var == "BIKE") return String(config.bikeId);
+  if (var == "ACTIVE") return String(config.scanTimeActive);
+  if (var == "INACTIVE") return String(config.scanTimeInactive);
+  if (var == "MAXTOPK") return String(MAX_TOP_K);
+  if (var == "TOPK") return String(config.topK);
+  if (var == "MESH") return checked(config.mergeMesh);
+  if (var == "MODE0") return selected(config.recordMode == RECORD_RAW);
+  if (var == "MODE1") return selected(config.recordMode == RECORD_POSITION);
+  if (var == "MODE2") return selected(config.recordMode == RECORD_AGGREGATE);
+  if (var == "WINDOW") return String(config.aggregateWindowS);
+  if (var == "TRIP") return checked(config.tripOnly);
+  if (var == "WP") return String(config.tripWaypointEvery);
+  if (var == "KNOWN") return checked(config.suppressKnown);
+  if (var == "COLLECTOR") return String(config.collectorUrl);
+  if (var == "SSID1") return String(config.baseSSID1);
+  if (var == "PASS1") return String(config.basePassword1);
+  if (var == "SSID2") return String(config.baseSSID2);
+  if (var == "PASS2") return String(config.basePassword2);
+  if (var == "SSID3") return String(config.baseSSID3);
+  if (var == "PASS3") return String(config.basePassword3);
+  return String();
+}
+
+void handleRoot(AsyncWebServerRequest* request) {
+  request->send_P(200, "text/html", ROOT_HTML, configValue);
+}
+
+void handleConfig(AsyncWebServerRequest* request) {
+  request->send_P(200, "text/html", CONFIG_HTML, configValue);
+}
+
+// Campos do formulário, já lidos do corpo pelo servidor enquanto chegava
+static String formValue(AsyncWebServerRequest* request, const char* name) {
+  AsyncWebParameter* param = request->getParam(name, true);
+  return param ? param->value() : String();
+}
+
+void handleSave(AsyncWebServerRequest* request) {
+  formValue(request, "bike").toCharArray(config.bikeId, sizeof(config.bikeId));
+  config.scanTimeActive = formValue(request, "active").toInt();
+  config.scanTimeInactive = formValue(request, "inactive").toInt();
+  config.topK = constrain((int)formValue(request, "topk").toInt(), 1, MAX_TOP_K);
+  config.mergeMesh = request->hasParam("mesh", true);
+  config.recordMode = constrain((int)formValue(request, "mode").toInt(), RECORD_RAW, RECORD_AGGREGATE);
+  config.aggregateWindowS = max(30, (int)formValue(request, "window").toInt());
+  config.tripOnly = request->hasParam("trip", true);
+  config.tripWaypointEvery = max(0, (int)formValue(request, "wp").toInt());
+  config.suppressKnown = request->hasParam("known", true);
+  formValue(request, "collector").toCharArray(config.collectorUrl, sizeof(config.collectorUrl));
+  formValue(request, "ssid1").toCharArray(config.baseSSID1, sizeof(config.baseSSID1));
+  formValue(request, "pass1").toCharArray(config.basePassword1, sizeof(config.basePassword1));
+  formValue(request, "ssid2").toCharArray(config.baseSSID2, sizeof(config.baseSSID2));
+  formValue(request, "pass2").toCharArray(config.basePassword2, sizeof(config.basePassword2));
+  formValue(request, "ssid3").toCharArray(config.baseSSID3, sizeof(config.baseSSID3));
+  formValue(request, "pass3").toCharArray(config.basePassword3, sizeof(config.basePassword3));
+
+  // Grava e reinicia pelo webServerLoop(), depois desta resposta sair
+  saveRequested = true;
+  request->send_P(200, "text/html", SAVED_HTML);
+}
+
+// Mostra o último scan e pede outro ao webServerLoop()
+void handleWifi(AsyncWebServerRequest* request) {
+  wifiPageAt = millis();
+  if (wifiPageAt == 0) wifiPageAt = 1;
+
+  AsyncResponseStream* response = request->beginResponseStream("text/html");
+  response->print(FPSTR(PAGE_HEAD));
+  response->print(F("<style>body{font-family:Arial;margin:20px;font-size:16px}table{width:100%;border-collapse:collapse}th,td{border:1px solid #ddd;padding:12px;text-align:left}th{background:#f2f2f2}.strong{color:green}.weak{color:red}</style>"));
+  response->print(F("<script>setTimeout(function(){location.reload()},5000)</script></head>"));
+  response->printf("<body><h1>WiFi Detectados (Bike %s)</h1>", config.bikeId);
+  response->print(F("<p>Atualizando a cada 5 segundos...</p>"));
+  response->print(F("<table><tr><th>SSID</th><th>RSSI</th><th>Canal</th></tr>"));
+  for (size_t i = 0; i < networks.size(); i++) {
+    const char* cssClass = networks[i].rssi > -60 ? "strong" : (networks[i].rssi < -80 ? "weak" : "");
+    response->printf("<tr class='%s'><td>%s</td><td>%d dBm</td><td>%d</td></tr>", cssClass,
+                     networks[i].ssid, networks[i].rssi, networks[i].channel);
   }
-  html += "</table><br><a href='/'>Voltar</a></body></html>";
-  server.send(200, "text/html", html);
+  response->print(F("</table><br><a href='/'>Voltar</a></body></html>"));
+  request->send(response);
 }
 
-void handleDados() {
-  String html = "<html><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'>";
-  html += "<style>body{font-family:Arial;margin:20px;font-size:16px}.arquivo{border:1px solid #ddd;padding:10px;margin:10px 0;background:#f9f9f9}</style></head>";
-  html += "<body><h1>Dados Gravados - Bike " + String(config.bikeId) + "</h1>";
-  html += "<a href='/' style='display:block;padding:10px;background:#666;color:white;text-decoration:none;text-align:center;margin:10px 0;width:100px'>Voltar</a>";
-  
-  Dir dir = LittleFS.openDir("/");
+// Estado do /dados entre um pedaço e outro da resposta: cada arquivo vai
+// do flash para o buffer do TCP conforme o cliente consome
+struct DadosStream {
+  Dir dir;
+  File file;
+  String pending; // texto ainda não enviado
+  size_t sent = 0;
   int count = 0;
-  while (dir.next()) {
-    if (dir.fileName().startsWith("scan_")) {
-      count++;
-      html += "<div class='arquivo'>";
-      html += "<strong>" + dir.fileName() + "</strong> (" + String(dir.fileSize()) + " bytes)<br>";
-      File file = LittleFS.open(dir.fileName().c_str(), "r");
-      if (file) {
-        String content = file.readString();
-        file.close();
-        html += "<code>" + content + "</code>";
-      }
-      html += "</div>";
-      if (count >= 10) {
-        html += "<p><em>Mostrando apenas os primeiros 10 arquivos...</em></p>";
-        break;
+  bool finished = false;
+};
+
+#define DADOS_MAX_FILES 10
+
+static String nextDadosPart(DadosStream& s) {
+  while (s.dir.next()) {
+    String name = s.dir.fileName();
+    if (!name.startsWith("scan_") && !name.startsWith("trip_")) continue;
+    if (s.count >= DADOS_MAX_FILES) {
+      s.finished = true;
+      return "<p><em>Mostrando apenas os primeiros " + String(DADOS_MAX_FILES) + " arquivos...</em></p></body></html>";
+    }
+    s.count++;
+    s.file = LittleFS.open(name.c_str(), "r");
+    return "<div class='arquivo'><strong>" + name + "</strong> (" + String(s.dir.fileSize()) + " bytes)<br><code>";
+  }
+  s.finished = true;
+  return s.count == 0 ? F("<p>Nenhum arquivo de dados encontrado.</p></body></html>") : F("</body></html>");
+}
+
+static size_t fillDados(DadosStream& s, uint8_t* buf, size_t maxLen) {
+  size_t length = 0;
+  while (length < maxLen) {
+    if (s.sent < s.pending.length()) {
+      size_t n = min(maxLen - length, s.pending.length() - s.sent);
+      memcpy(buf + length, s.pending.c_str() + s.sent, n);
+      s.sent += n;
+      length += n;
+      continue;
+    }
+    s.sent = 0;
+    s.pending = String();
+    if (s.file) {
+      size_t n = s.file.read(buf + length, maxLen - length);
+      if (n > 0) {
+        length += n;
+        continue;
       }
+      s.file.close();
+      s.pending = F("</code></div>");
+      continue;
     }
+    if (s.finished) break;
+    s.pending = nextDadosPart(s);
   }
-  
-  if (count == 0) {
-    html += "<p>Nenhum arquivo de dados encontrado.</p>";
+  return length;
+}
+
+void handleDados(AsyncWebServerRequest* request) {
+  std::shared_ptr<DadosStream> stream = std::make_shared<DadosStream>();
+  stream->dir = LittleFS.openDir("/");
+  stream->pending = FPSTR(PAGE_HEAD);
+  stream->pending += F("<style>body{font-family:Arial;margin:20px;font-size:16px}.arquivo{border:1px solid #ddd;padding:10px;margin:10px 0;background:#f9f9f9}</style></head>");
+  stream->pending += "<body><h1>Dados Gravados - Bike " + String(config.bikeId) + "</h1>";
+  stream->pending += FPSTR(BACK_LINK);
+
+  request->send(request->beginChunkedResponse("text/html", [stream](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+    return fillDados(*stream, buf, maxLen);
+  }));
+}
+
+void handleLog(AsyncWebServerRequest* request) {
+  String tail = logTail(LOG_BUFFER_SIZE);
+  tail.replace("&", "&amp;");
+  tail.replace("<", "&lt;");
+
+  AsyncResponseStream* response = request->beginResponseStream("text/html");
+  response->print(FPSTR(PAGE_HEAD));
+  response->print(F("<style>body{font-family:Arial;margin:20px;font-size:16px}pre{background:#f9f9f9;border:1px solid #ddd;padding:10px;font-size:12px;white-space:pre-wrap}</style></head>"));
+  response->printf("<body><h1>Log - Bike %s</h1>", config.bikeId);
+  response->print(FPSTR(BACK_LINK));
+  response->printf("<p>Bytes descartados: %u</p>", (unsigned)logDroppedBytes());
+  response->print("<pre>" + tail + "</pre>");
+  response->print(F("</body></html>"));
+  request->send(response);
+}
+
+#if TRACE_RECORD
+// Download do trace para o replay no host (tools/replay), lido do flash
+// aos pedaços pelo servidor
+void handleTrace(AsyncWebServerRequest* request) {
+  if (!LittleFS.exists(TRACE_PATH)) {
+    request->send(404, "text/plain", "Sem trace");
+    return;
   }
-  
-  html += "</body></html>";
-  server.send(200, "text/html", html);
-}
\ No newline at end of file
+  AsyncWebServerResponse* response = request->beginResponse(LittleFS, TRACE_PATH, "application/octet-stream");
+  response->addHeader("Content-Disposition", "attachment; filename=trace_" + String(config.bikeId) + ".bin");
+  request->send(response);
+}
+#endif
@@ -1,15 +1,26 @@
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
-#include <ESP8266WebServer.h>
+#include <ESPAsyncWebServer.h>
 
-extern ESP8266WebServer server;
+// Interface de configuração sobre o servidor assíncrono: os handlers rodam
+// nos callbacks do TCP e não podem bloquear; scan, gravação e reinício
+// ficam para webServerLoop(), chamado pelo loop() no modo configuração.
+#define WEB_MAX_REQUESTS 4   // requisições simultâneas; acima disso, 503
+#define WEB_MIN_HEAP 8192    // heap livre mínimo para aceitar uma requisição
+#define WEB_SCAN_MS 5000     // intervalo do scan enquanto /wifi está aberta
+#define WEB_RESTART_MS 2000  // espera entre salvar e reiniciar
+
+extern AsyncWebServer server;
 
 void startConfigMode();
-void handleRoot();
-void handleConfig();
-void handleSave();
-void handleWifi();
-void handleDados();
+void webServerLoop();
+void handleRoot(AsyncWebServerRequest* request);
+void handleConfig(AsyncWebServerRequest* request);
+void handleSave(AsyncWebServerRequest* request);
+void handleWifi(AsyncWebServerRequest* request);
+void handleDados(AsyncWebServerRequest* request);
+void handleLog(AsyncWebServerRequest* request);
+void handleTrace(AsyncWebServerRequest* request);
 
-#endif
\ No newline at end of file
+#endif
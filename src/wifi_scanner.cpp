@@ -1,5 +1,12 @@
 #include "wifi_scanner.h"
 #include "status_tracker.h"
+#include "locator.h"
+#include "known_aps.h"
+#include "aggregator.h"
+#include "time_base.h"
+#include "logger.h"
+#include "trace_recorder.h"
+#include "power_governor.h"
 #include <ESP8266WiFi.h>
 #include <LittleFS.h>
 #include <Arduino.h>
@@ -14,43 +21,151 @@ String getBasePassword(String ssid) {
   return "";
 }
 
+// Remove BSSIDs repetidos e, com mergeMesh, nós do mesmo SSID,
+// mantendo sempre a entrada de sinal mais forte
+static void mergeDuplicateNetworks() {
+  size_t kept = 0;
+  for (size_t i = 0; i < networks.size(); i++) {
+    int match = -1;
+    for (size_t j = 0; j < kept; j++) {
+      bool sameBssid = strcmp(networks[j].bssid, networks[i].bssid) == 0;
+      bool sameMesh = config.mergeMesh && networks[i].ssid[0] != '\0' &&
+                      strcmp(networks[j].ssid, networks[i].ssid) == 0;
+      if (sameBssid || sameMesh) {
+        match = j;
+        break;
+      }
+    }
+    if (match < 0) {
+      networks[kept++] = networks[i];
+    } else if (networks[i].rssi > networks[match].rssi) {
+      networks[match] = networks[i];
+    }
+  }
+  networks.truncate(kept);
+}
+
+static void loadScanResults(int n) {
+  networks.clear();
+  for (int i = 0; i < n && !networks.full(); i++) {
+    WiFiNetwork& net = *networks.append();
+    WiFi.SSID(i).toCharArray(net.ssid, sizeof(net.ssid));
+    WiFi.BSSIDstr(i).toCharArray(net.bssid, sizeof(net.bssid));
+    net.rssi = WiFi.RSSI(i);
+    net.channel = WiFi.channel(i);
+    net.encryption = WiFi.encryptionType(i);
+  }
+
+  mergeDuplicateNetworks();
+}
+
 void scanWiFiNetworks() {
+  unsigned long start = millis();
   int n = WiFi.scanNetworks();
-  networkCount = 0;
-
-  for (int i = 0; i < n && networkCount < 30; i++) {
-    WiFi.SSID(i).toCharArray(networks[networkCount].ssid, 32);
-    WiFi.BSSIDstr(i).toCharArray(networks[networkCount].bssid, 18);
-    networks[networkCount].rssi = WiFi.RSSI(i);
-    networks[networkCount].channel = WiFi.channel(i);
-    networks[networkCount].encryption = WiFi.encryptionType(i);
-    networkCount++;
+  unsigned long elapsed = millis() - start;
+  traceRecordScan(n, elapsed);
+  powerRecord(POWER_SCAN, elapsed);
+  loadScanResults(n);
+}
+
+static bool asyncScanRunning = false;
+
+void startWiFiScanAsync() {
+  if (asyncScanRunning) return;
+  asyncScanRunning = WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING || WiFi.scanComplete() >= 0;
+}
+
+bool pollWiFiScanAsync() {
+  if (!asyncScanRunning) return false;
+  int n = WiFi.scanComplete();
+  if (n == WIFI_SCAN_RUNNING) return false;
+  asyncScanRunning = false;
+  if (n < 0) return false;
+  loadScanResults(n);
+  WiFi.scanDelete();
+  return true;
+}
+
+bool isOwnNetwork(const char* ssid) {
+  if (ssid[0] == '\0') return false;
+  if (strcmp(ssid, config.baseSSID1) == 0 ||
+      strcmp(ssid, config.baseSSID2) == 0 ||
+      strcmp(ssid, config.baseSSID3) == 0) {
+    return true;
   }
+  // AP de configuração desta ou de outra bike: móvel, não serve de referência
+  return strncmp(ssid, "Bike-", 5) == 0;
 }
 
-bool checkAtBase() {
-  for (int i = 0; i < networkCount; i++) {
-    if (strlen(config.baseSSID1) > 0 && strcmp(networks[i].ssid, config.baseSSID1) == 0) {
-      Serial.printf("Base1 encontrada: %s (RSSI: %d)\n", networks[i].ssid, networks[i].rssi);
-      if (networks[i].rssi > -80) return true;
+int selectStrongest(WiFiNetwork* nets, int count, int k) {
+  // Separa as redes próprias no fim do array, sem descartá-las
+  int candidates = 0;
+  for (int i = 0; i < count; i++) {
+    if (!isOwnNetwork(nets[i].ssid)) {
+      if (i != candidates) {
+        WiFiNetwork tmp = nets[candidates];
+        nets[candidates] = nets[i];
+        nets[i] = tmp;
+      }
+      candidates++;
     }
-    if (strlen(config.baseSSID2) > 0 && strcmp(networks[i].ssid, config.baseSSID2) == 0) {
-      Serial.printf("Base2 encontrada: %s (RSSI: %d)\n", networks[i].ssid, networks[i].rssi);
-      if (networks[i].rssi > -80) return true;
+  }
+
+  // Top-K por inserção: o prefixo [0, K) fica ordenado e cada rede seguinte
+  // só é comparada com a K-ésima, entrando no lugar dela quando é mais forte.
+  // Com RSSI em ordem qualquer, ~N comparações e poucas inserções
+  // (tools/host/select_bench: mais rápido que ordenar tudo para N <= 30)
+  int selected = max(0, min(k, candidates));
+  if (selected == 0) return 0;
+  for (int i = 0; i < candidates; i++) {
+    int last = min(i, selected - 1);
+    if (i >= selected && nets[i].rssi <= nets[last].rssi) continue;
+
+    WiFiNetwork item = nets[i];
+    if (i >= selected) nets[i] = nets[last];
+    int j = last;
+    while (j > 0 && nets[j - 1].rssi < item.rssi) {
+      nets[j] = nets[j - 1];
+      j--;
     }
-    if (strlen(config.baseSSID3) > 0 && strcmp(networks[i].ssid, config.baseSSID3) == 0) {
-      Serial.printf("Base3 encontrada: %s (RSSI: %d)\n", networks[i].ssid, networks[i].rssi);
-      if (networks[i].rssi > -80) return true;
+    nets[j] = item;
+  }
+  return selected;
+}
+
+int selectTopNetworks() {
+  return selectStrongest(networks.data(), networks.size(), powerTopK(config.topK));
+}
+
+int findBase(int minRssi) {
+  const char* bases[] = {config.baseSSID1, config.baseSSID2, config.baseSSID3};
+  int found = 0;
+  int foundRssi = minRssi;
+
+  for (size_t i = 0; i < networks.size(); i++) {
+    for (int b = 0; b < 3; b++) {
+      if (strlen(bases[b]) > 0 && strcmp(networks[i].ssid, bases[b]) == 0) {
+        LOG_D("WIFI", "Base%d encontrada: %s (RSSI: %d)", b + 1, networks[i].ssid, networks[i].rssi);
+        if (networks[i].rssi > foundRssi) {
+          found = b + 1;
+          foundRssi = networks[i].rssi;
+        }
+      }
     }
   }
-  return false;
+  return found;
+}
+
+bool checkAtBase() {
+  return findBase(BASE_MIN_RSSI) > 0;
 }
 
 bool connectToBase() {
-  for (int i = 0; i < networkCount; i++) {
+  unsigned long start = millis();
+  for (size_t i = 0; i < networks.size(); i++) {
     String basePass = getBasePassword(String(networks[i].ssid));
     if (basePass != "") {
-      Serial.printf("Conectando à base: %s\n", networks[i].ssid);
+      LOG_I("WIFI", "Conectando à base: %s", networks[i].ssid);
       WiFi.begin(networks[i].ssid, basePass.c_str());
 
       int attempts = 0;
@@ -60,48 +175,118 @@ bool connectToBase() {
       }
 
       if (WiFi.status() == WL_CONNECTED) {
-        Serial.printf("Conectado à base %s!\n", networks[i].ssid);
-        Serial.printf("IP obtido: %s\n", WiFi.localIP().toString().c_str());
-        Serial.printf("Gateway: %s\n", WiFi.gatewayIP().toString().c_str());
+        LOG_I("WIFI", "Conectado à base %s!", networks[i].ssid);
+        LOG_I("WIFI", "IP obtido: %s", WiFi.localIP().toString().c_str());
+        LOG_D("WIFI", "Gateway: %s", WiFi.gatewayIP().toString().c_str());
         trackConnection(networks[i].ssid, WiFi.localIP().toString().c_str(), true);
+        powerRecord(POWER_CONNECT, millis() - start);
         return true;
       } else {
-        Serial.printf("Falha ao conectar em %s\n", networks[i].ssid);
+        LOG_W("WIFI", "Falha ao conectar em %s", networks[i].ssid);
       }
     }
   }
+  powerRecord(POWER_CONNECT, millis() - start);
   return false;
 }
 
+void disconnectFromBase() {
+  String lastIP = WiFi.localIP().toString();
+  WiFi.disconnect();
+  trackConnection("disconnect", lastIP.c_str(), false);
+}
+
+// SSID é texto livre do AP: aspas e barras escapadas, controles removidos
+// (como printJsonString do console), para o registro continuar JSON válido
+static void appendJsonString(String& out, const char* s) {
+  out += '"';
+  for (; *s; s++) {
+    if ((uint8_t)*s < 0x20) continue;
+    if (*s == '"' || *s == '\\') out += '\\';
+    out += *s;
+  }
+  out += '"';
+}
+
 void storeData() {
-  String filename = "/scan_" + String(millis()) + ".json";
+  lastFix = {false, 0, 0, 0, 0};
+  if (config.recordMode == RECORD_POSITION) {
+    lastFix = locateScan(networks.data(), networks.size());
+  }
+
+  // Estatísticas por janela no lugar dos scans: todas as redes do scan, não
+  // só as mais fortes
+  if (config.recordMode == RECORD_AGGREGATE) {
+    if (!config.isAtBase) aggregateScan(networks.data(), networks.size(), timeTicks());
+    trackBattery(getBatteryLevel());
+    return;
+  }
+
+  // Só resumos de viagem: o scan alimenta o segmentador, mas não é gravado
+  if (config.tripOnly) {
+    trackBattery(getBatteryLevel());
+    return;
+  }
+
+  // Ticks monotônicos + boot; a época é preenchida no upload
+  unsigned long ticks = timeTicks();
+  String filename = "/scan_" + String(currentBootId()) + "_" + String(ticks) + ".json";
   
-  // Formato sem bateria: [timestamp,realTime,[[ssid,bssid,rssi,channel]]]
-  String data = "[" + String(millis());
+  String data = "[" + String(ticks);
   data += ",0"; // realTime (será calculado no upload)
   data += ",[";
-  
-  int maxNets = min(networkCount, 5);
-  for (int i = 0; i < maxNets; i++) {
-    if (i > 0) data += ",";
-    data += "[\"" + String(networks[i].ssid) + "\",\"";
-    data += String(networks[i].bssid) + "\",";
-    data += String(networks[i].rssi) + ",";
-    data += String(networks[i].channel) + "]";
+
+  if (lastFix.valid) {
+    // Formato posição: [ticks,realTime,[latE7,lonE7,confiança,aps],boot]
+    data += String(lastFix.latE7) + "," + String(lastFix.lonE7) + ",";
+    data += String(lastFix.confidence) + "," + String(lastFix.matched);
+  } else {
+    // Formato redes: [ticks,realTime,[[ssid,bssid,rssi,channel]],boot]
+    // (também usado quando nenhum AP do scan está no índice)
+    // Com o filtro de APs conhecidos, os já mapeados só contam avistamento;
+    // o mais forte deles fica no registro como âncora do trajeto
+    int maxNets = selectTopNetworks();
+    bool suppress = config.suppressKnown && knownApsReady();
+    bool anchored = false;
+    int written = 0;
+    for (int i = 0; i < maxNets; i++) {
+      if (suppress && knownApsSighting(networks[i])) {
+        if (anchored) continue;
+        anchored = true;
+      }
+      if (written++ > 0) data += ",";
+      data += "[";
+      appendJsonString(data, networks[i].ssid);
+      data += ",\"";
+      data += String(networks[i].bssid) + "\",";
+      data += String(networks[i].rssi) + ",";
+      data += String(networks[i].channel) + "]";
+    }
   }
-  data += "]]";
+  data += "]," + String(currentBootId()) + "]";
   
+  unsigned long writeStart = millis();
   File file = LittleFS.open(filename.c_str(), "w");
   if (file) {
     file.print(data);
     file.close();
     dataCount++;
   }
+  powerRecord(POWER_FLASH, millis() - writeStart);
   
   // Track battery separately
   trackBattery(getBatteryLevel());
 }
 
+int countStoredScans() {
+  int count = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    if (dir.fileName().startsWith("scan_")) count++;
+  }
+  return count;
+}
+
 float getBatteryLevel() {
   int adcValue = analogRead(A0);
   float voltage = (adcValue / 1024.0) * 4.2;
@@ -4,11 +4,23 @@
 #include "config.h"
 #include <Arduino.h>
 
+#define BASE_MIN_RSSI -80
+
 void scanWiFiNetworks();
+// Scan sem bloquear (interface web): começa e, quando pollWiFiScanAsync()
+// retorna true, networks[] já tem o resultado
+void startWiFiScanAsync();
+bool pollWiFiScanAsync();
+int findBase(int minRssi);
 bool checkAtBase();
 bool connectToBase();
+void disconnectFromBase();
 String getBasePassword(String ssid);
+bool isOwnNetwork(const char* ssid);
+int selectStrongest(WiFiNetwork* nets, int count, int k);
+int selectTopNetworks();
 void storeData();
+int countStoredScans();
 float getBatteryLevel();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,281 @@
+// Lote binário do coletor (src/batch_format.h): escrita e leitura de volta,
+// dicionário de SSID/BSSID, entrada truncada e desfazer com buffer cheio.
+
+#include <unity.h>
+
+#include "batch_format.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uint8_t buf[4096];
+static BatchRecord in[8];
+static BatchRecord out;
+
+static void scanRecord(BatchRecord& r, uint32_t boot, uint32_t ticks, uint32_t epoch, int networks, int variant) {
+  memset(&r, 0, sizeof(r));
+  r.type = BATCH_SCAN;
+  r.boot = boot;
+  r.ticks = ticks;
+  r.epoch = epoch;
+  r.networkCount = networks;
+  for (int i = 0; i < networks; i++) {
+    BatchNetwork& net = r.networks[i];
+    snprintf(net.ssid, sizeof(net.ssid), "Rede-%d", (i + variant) % 4);
+    uint8_t bssid[6] = {0x5C, 0xCF, 0x7F, 0x10, (uint8_t)variant, (uint8_t)i};
+    memcpy(net.bssid, bssid, 6);
+    net.rssi = -40 - i * 7;
+    net.channel = 1 + i;
+  }
+}
+
+static void jsonRecord(BatchRecord& r, uint8_t type, uint32_t boot, uint32_t ticks, uint32_t epoch, const char* json) {
+  memset(&r, 0, sizeof(r));
+  r.type = type;
+  r.boot = boot;
+  r.ticks = ticks;
+  r.epoch = epoch;
+  r.json = json;
+  r.jsonLength = strlen(json);
+}
+
+static void assertSame(const BatchRecord& a, const BatchRecord& b) {
+  TEST_ASSERT_EQUAL(a.type, b.type);
+  TEST_ASSERT_EQUAL_UINT32(a.boot, b.boot);
+  TEST_ASSERT_EQUAL_UINT32(a.ticks, b.ticks);
+  TEST_ASSERT_EQUAL_UINT32(a.epoch, b.epoch);
+  switch (a.type) {
+    case BATCH_SCAN:
+      TEST_ASSERT_EQUAL(a.networkCount, b.networkCount);
+      for (int i = 0; i < a.networkCount; i++) {
+        TEST_ASSERT_EQUAL_STRING(a.networks[i].ssid, b.networks[i].ssid);
+        TEST_ASSERT_EQUAL_MEMORY(a.networks[i].bssid, b.networks[i].bssid, 6);
+        TEST_ASSERT_EQUAL(a.networks[i].rssi, b.networks[i].rssi);
+        TEST_ASSERT_EQUAL(a.networks[i].channel, b.networks[i].channel);
+      }
+      break;
+    case BATCH_POSITION:
+      TEST_ASSERT_EQUAL_INT32(a.latE7, b.latE7);
+      TEST_ASSERT_EQUAL_INT32(a.lonE7, b.lonE7);
+      TEST_ASSERT_EQUAL(a.confidence, b.confidence);
+      TEST_ASSERT_EQUAL(a.matched, b.matched);
+      break;
+    default:
+      TEST_ASSERT_EQUAL(a.jsonLength, b.jsonLength);
+      TEST_ASSERT_EQUAL_MEMORY(a.json, b.json, a.jsonLength);
+      break;
+  }
+}
+
+// Grava in[0..count) e confere a leitura; retorna o tamanho do lote
+static size_t roundTrip(int count, const char* bikeId) {
+  BatchWriter writer;
+  batchBegin(writer, buf, sizeof(buf), bikeId);
+  for (int i = 0; i < count; i++) TEST_ASSERT_TRUE(batchAdd(writer, in[i]));
+  size_t length = batchFinish(writer);
+
+  BatchReader reader;
+  TEST_ASSERT_TRUE(batchOpen(reader, buf, length));
+  TEST_ASSERT_EQUAL_STRING(bikeId, reader.bikeId);
+  TEST_ASSERT_EQUAL(count, reader.total);
+  for (int i = 0; i < count; i++) {
+    TEST_ASSERT_TRUE(batchNext(reader, out));
+    assertSame(in[i], out);
+  }
+  TEST_ASSERT_FALSE(batchNext(reader, out));
+  TEST_ASSERT_FALSE(reader.error);
+  TEST_ASSERT_EQUAL(length, reader.pos);
+  return length;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_round_trip_all_types() {
+  scanRecord(in[0], 3, 1000, 1700000000, 5, 0);
+  // Mesmo boot, ticks para trás: delta negativo
+  scanRecord(in[1], 3, 900, 1699999990, 2, 1);
+  in[2] = {};
+  in[2].type = BATCH_POSITION;
+  in[2].boot = 3;
+  in[2].ticks = 5000;
+  in[2].latE7 = -80471234;
+  in[2].lonE7 = -348812345;
+  in[2].confidence = 87;
+  in[2].matched = 4;
+  jsonRecord(in[3], BATCH_TRIP, 3, 6000, 0, "{\"distancia\":1234}");
+  // Boot novo: ticks absolutos de novo; extremos de 32 bits
+  jsonRecord(in[4], BATCH_STATUS, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, "{\"bateria\":80}");
+  jsonRecord(in[5], BATCH_SUMMARY, 4, 0, 0, "{}");
+  scanRecord(in[6], 4, 10, 1700000100, 0, 2);
+  roundTrip(7, "bike42");
+}
+
+void test_json_record_worst_case() {
+  // O que o backend do coletor aloca para um registro JSON
+  char bikeId[BATCH_BIKE_ID_MAX + 1];
+  memset(bikeId, 'b', BATCH_BIKE_ID_MAX);
+  bikeId[BATCH_BIKE_ID_MAX] = '\0';
+  static char json[70000];
+  memset(json, 'x', 0xFFFF);
+  json[0xFFFF] = '\0';
+
+  uint32_t extremes[] = {0, 0x7F, 0x80, 0xFFFFFFFF};
+  for (uint32_t value : extremes) {
+    jsonRecord(in[0], BATCH_STATUS, value, 0xFFFFFFFF - value, 0xFFFFFFFF, json);
+    static uint8_t big[BATCH_HEADER_MAX + BATCH_JSON_RECORD_MAX + 0xFFFF];
+    BatchWriter writer;
+    batchBegin(writer, big, sizeof(big), bikeId);
+    TEST_ASSERT_TRUE(batchAdd(writer, in[0]));
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(big), batchFinish(writer));
+  }
+}
+
+void test_dictionary_reuse() {
+  for (int i = 0; i < 6; i++) scanRecord(in[i], 1, 1000 + i * 5000, 1700000000 + i * 5, 4, 0);
+  size_t repeated = roundTrip(6, "bike01");
+
+  // As mesmas redes em todos os scans: só o primeiro leva os literais
+  BatchWriter writer;
+  batchBegin(writer, buf, sizeof(buf), "bike01");
+  batchAdd(writer, in[0]);
+  size_t first = writer.length;
+  TEST_ASSERT_EQUAL(4, writer.ssidCount);
+  TEST_ASSERT_EQUAL(4, writer.bssidCount);
+  batchAdd(writer, in[1]);
+  size_t perRecord = writer.length - first;
+  TEST_ASSERT_EQUAL(4, writer.ssidCount);
+  TEST_ASSERT_EQUAL(4, writer.bssidCount);
+  // tipo + boot + ticks + época + n + 4 x (índice SSID, índice BSSID, rssi, canal)
+  TEST_ASSERT_LESS_OR_EQUAL(1 + 1 + 3 + 1 + 1 + 4 * 4, perRecord);
+  TEST_ASSERT_EQUAL(first + 5 * perRecord, repeated);
+
+  // Redes trocando de SSID entre scans: o dicionário é reaproveitado
+  for (int i = 0; i < 6; i++) scanRecord(in[i], 1, 1000 + i * 5000, 1700000000, 4, i);
+  roundTrip(6, "bike01");
+}
+
+void test_dictionary_full() {
+  // Mais BSSIDs do que cabem no dicionário: os excedentes vão como literal
+  int count = 0;
+  BatchWriter writer;
+  batchBegin(writer, buf, sizeof(buf), "bike09");
+  for (int i = 0; i < BATCH_BSSID_DICT / BATCH_MAX_NETWORKS + 3; i++) {
+    scanRecord(in[0], 2, i * 1000, 0, BATCH_MAX_NETWORKS, i);
+    TEST_ASSERT_TRUE(batchAdd(writer, in[0]));
+    count++;
+  }
+  TEST_ASSERT_EQUAL(BATCH_BSSID_DICT, writer.bssidCount);
+  size_t length = batchFinish(writer);
+
+  BatchReader reader;
+  TEST_ASSERT_TRUE(batchOpen(reader, buf, length));
+  for (int i = 0; i < count; i++) {
+    scanRecord(in[0], 2, i * 1000, 0, BATCH_MAX_NETWORKS, i);
+    TEST_ASSERT_TRUE(batchNext(reader, out));
+    assertSame(in[0], out);
+  }
+  TEST_ASSERT_FALSE(reader.error);
+}
+
+void test_truncated_input() {
+  scanRecord(in[0], 7, 100, 1700000000, 3, 0);
+  jsonRecord(in[1], BATCH_TRIP, 7, 200, 1700000010, "{\"pontos\":12}");
+  scanRecord(in[2], 7, 300, 1700000020, 3, 1);
+  size_t length = roundTrip(3, "bike07");
+
+  // Corte em qualquer ponto: erro, nunca leitura fora do buffer
+  static uint8_t cut[4096];
+  for (size_t n = 0; n < length; n++) {
+    memcpy(cut, buf, n);
+    BatchReader reader;
+    if (!batchOpen(reader, cut, n)) continue;
+    int records = 0;
+    while (batchNext(reader, out)) records++;
+    TEST_ASSERT_TRUE(reader.error);
+    TEST_ASSERT_LESS_THAN(3, records);
+  }
+
+  // Cabeçalho inválido
+  BatchReader reader;
+  memcpy(cut, buf, length);
+  cut[0] = 'X';
+  TEST_ASSERT_FALSE(batchOpen(reader, cut, length));
+  memcpy(cut, buf, length);
+  cut[6] = BATCH_BIKE_ID_MAX + 1;
+  TEST_ASSERT_FALSE(batchOpen(reader, cut, length));
+  memcpy(cut, buf, length);
+  cut[5] = BATCH_FLAG_COMPRESSED;
+  TEST_ASSERT_FALSE(batchOpen(reader, cut, length));
+}
+
+void test_rollback_when_full() {
+  scanRecord(in[0], 1, 1000, 1700000000, 4, 0);
+  scanRecord(in[1], 1, 6000, 1700000005, BATCH_MAX_NETWORKS, 5); // redes novas: literais
+  scanRecord(in[2], 1, 11000, 1700000010, 4, 0);                  // só índices
+
+  // Buffer com espaço para o primeiro e pouco mais
+  BatchWriter writer;
+  batchBegin(writer, buf, sizeof(buf), "bike05");
+  TEST_ASSERT_TRUE(batchAdd(writer, in[0]));
+  size_t capacity = writer.length + 40;
+  batchBegin(writer, buf, capacity, "bike05");
+  TEST_ASSERT_TRUE(batchAdd(writer, in[0]));
+
+  size_t length = writer.length;
+  uint8_t ssids = writer.ssidCount;
+  uint8_t bssids = writer.bssidCount;
+  TEST_ASSERT_FALSE(batchAdd(writer, in[1]));
+  // Desfeito por inteiro: tamanho, dicionários e contagem
+  TEST_ASSERT_EQUAL(length, writer.length);
+  TEST_ASSERT_EQUAL(ssids, writer.ssidCount);
+  TEST_ASSERT_EQUAL(bssids, writer.bssidCount);
+  TEST_ASSERT_EQUAL(1, writer.recordCount);
+  TEST_ASSERT_FALSE(writer.overflow);
+
+  // O lote continua válido e aceita um registro que cabe
+  TEST_ASSERT_TRUE(batchAdd(writer, in[2]));
+  length = batchFinish(writer);
+  TEST_ASSERT_LESS_OR_EQUAL(capacity, length);
+
+  BatchReader reader;
+  TEST_ASSERT_TRUE(batchOpen(reader, buf, length));
+  TEST_ASSERT_TRUE(batchNext(reader, out));
+  assertSame(in[0], out);
+  TEST_ASSERT_TRUE(batchNext(reader, out));
+  assertSame(in[2], out); // delta de ticks/época contra o último gravado, não o desfeito
+  TEST_ASSERT_FALSE(batchNext(reader, out));
+  TEST_ASSERT_FALSE(reader.error);
+}
+
+void test_parse_scan_record() {
+  const char* text = "[12345,1700000000,[[\"Rede-1\",\"5C:CF:7F:00:00:01\",-61,6],"
+                     "[\"Casa \\\"A\\\"\",\"aa:bb:cc:dd:ee:ff\",-80,11]],3]";
+  BatchRecord record;
+  TEST_ASSERT_TRUE(parseScanRecord(text, strlen(text), record));
+  TEST_ASSERT_EQUAL(BATCH_SCAN, record.type);
+  TEST_ASSERT_EQUAL_UINT32(3, record.boot);
+  TEST_ASSERT_EQUAL_UINT32(12345, record.ticks);
+  TEST_ASSERT_EQUAL_UINT32(1700000000, record.epoch);
+  TEST_ASSERT_EQUAL(2, record.networkCount);
+  TEST_ASSERT_EQUAL(-80, record.networks[1].rssi);
+  TEST_ASSERT_EQUAL_STRING("Casa \"A\"", record.networks[1].ssid);
+
+  // Arquivos cortados ou vazios (brownout) não passam: uploadData() os
+  // tira da fila
+  TEST_ASSERT_FALSE(parseScanRecord(text, strlen(text) / 2, record));
+  TEST_ASSERT_FALSE(parseScanRecord("", 0, record));
+  TEST_ASSERT_FALSE(parseScanRecord("[12345,0,[[\"Rede\",", 20, record));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_all_types);
+  RUN_TEST(test_json_record_worst_case);
+  RUN_TEST(test_dictionary_reuse);
+  RUN_TEST(test_dictionary_full);
+  RUN_TEST(test_truncated_input);
+  RUN_TEST(test_rollback_when_full);
+  RUN_TEST(test_parse_scan_record);
+  return UNITY_END();
+}
@@ -0,0 +1,6 @@
+// Coletor de referência (tools/collector) no mesmo processo do teste, como
+// upstream do gateway. O main dele vira collectorMain.
+#define main collectorMain
+#include "../../tools/collector/collector.cpp"
+#undef main
+#include "../../tools/common/http_server.cpp"
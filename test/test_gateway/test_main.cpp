@@ -0,0 +1,421 @@
+// Gateway do depósito no host (pio test -e native -f test_gateway): parser
+// do POST /ingest, vagas de conexão, fila em segmentos, envio ao coletor e
+// os GETs que o gateway responde ou repassa.
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include "batch_format.h"
+#include "gateway/gateway.h"
+#include "gateway/gateway_http.h"
+#include "gateway/gateway_spool.h"
+#include "host_env.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int collectorMain(int argc, char** argv);
+
+#define COLLECTOR_PORT 18080
+#define PROXY_COLLECTOR_PORT 18081
+
+static std::string fsDir;
+
+static size_t makeBatch(uint8_t* buf, size_t capacity, const char* bikeId, int records) {
+  BatchWriter writer;
+  batchBegin(writer, buf, capacity, bikeId);
+  for (int i = 0; i < records; i++) {
+    BatchRecord record = {};
+    record.type = BATCH_SCAN;
+    record.boot = 1;
+    record.ticks = 1000 + i * 5000;
+    record.epoch = 1700000000 + i * 5;
+    record.networkCount = 2;
+    for (int n = 0; n < 2; n++) {
+      BatchNetwork& net = record.networks[n];
+      snprintf(net.ssid, sizeof(net.ssid), "Rede-%d", n);
+      uint8_t bssid[6] = {0x5C, 0xCF, 0x7F, 0x00, (uint8_t)n, (uint8_t)i};
+      memcpy(net.bssid, bssid, 6);
+      net.rssi = -60 - n;
+      net.channel = 6;
+    }
+    if (!batchAdd(writer, record)) return 0;
+  }
+  return batchFinish(writer);
+}
+
+static std::string request(const uint8_t* body, size_t length) {
+  return "POST /ingest HTTP/1.1\r\nHost: 192.168.4.1\r\nContent-Type: application/octet-stream\r\n"
+         "Content-Length: " + std::to_string(length) + "\r\n\r\n" +
+         std::string((const char*)body, length);
+}
+
+// Bike do lado de fora: socket POSIX direto, sem passar pela camada host
+static int bikeConnect(int port) {
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(s, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    close(s);
+    return -1;
+  }
+  return s;
+}
+
+// Roda o gateway até a resposta chegar; retorna o status HTTP (0 = nenhum)
+static int bikeResponse(int s) {
+  std::string response;
+  char chunk[256];
+  for (int i = 0; i < 2000 && response.find("\r\n\r\n") == std::string::npos; i++) {
+    ingestPoll();
+    ssize_t n = recv(s, chunk, sizeof(chunk), MSG_DONTWAIT);
+    if (n > 0) response.append(chunk, n);
+    else usleep(1000);
+  }
+  return response.size() > 12 ? atoi(response.c_str() + 9) : 0;
+}
+
+// Resposta inteira, até o gateway fechar a conexão
+static std::string bikeReadAll(int s) {
+  std::string response;
+  char chunk[512];
+  for (int i = 0; i < 2000; i++) {
+    ingestPoll();
+    ssize_t n = recv(s, chunk, sizeof(chunk), MSG_DONTWAIT);
+    if (n > 0) response.append(chunk, n);
+    else if (n == 0) break;
+    else usleep(1000);
+  }
+  return response;
+}
+
+static void startCollector(int port, std::vector<std::string> args) {
+  args.insert(args.begin(), {"collector", "--port", std::to_string(port)});
+  std::thread([args] {
+    std::vector<char*> argv;
+    for (const std::string& arg : args) argv.push_back((char*)arg.c_str());
+    collectorMain((int)argv.size(), argv.data());
+  }).detach();
+  int probe = -1;
+  for (int i = 0; i < 200 && probe < 0; i++) {
+    probe = bikeConnect(port);
+    if (probe < 0) usleep(10000);
+  }
+  TEST_ASSERT_TRUE(probe >= 0);
+  close(probe);
+}
+
+static void pollUntil(int times) {
+  for (int i = 0; i < times; i++) {
+    ingestPoll();
+    usleep(1000);
+  }
+}
+
+void setUp() {
+  char dir[] = "/tmp/gateway_test_XXXXXX";
+  fsDir = mkdtemp(dir);
+  hostSetFsRoot(fsDir);
+  hostSetSerialEcho(false);
+  spoolBegin();
+}
+
+void tearDown() {
+  system(("rm -rf " + fsDir).c_str());
+}
+
+static IngestParser parser;
+static uint8_t body[GATEWAY_MAX_BODY];
+
+static IngestState feedText(const std::string& text) {
+  ingestParserBegin(parser, body, sizeof(body));
+  size_t used = 0;
+  while (used < text.size() && parser.state < INGEST_DONE) {
+    used += ingestParserFeed(parser, (const uint8_t*)text.data() + used, text.size() - used);
+  }
+  return parser.state;
+}
+
+void test_parser_byte_by_byte() {
+  uint8_t batch[512];
+  size_t length = makeBatch(batch, sizeof(batch), "bike07", 3);
+  TEST_ASSERT_GREATER_THAN(0, length);
+  std::string text = request(batch, length);
+
+  // Um byte por vez, como chega numa conexão lenta
+  ingestParserBegin(parser, body, sizeof(body));
+  for (size_t i = 0; i < text.size(); i++) {
+    TEST_ASSERT_TRUE(parser.state < INGEST_DONE);
+    TEST_ASSERT_EQUAL(1, ingestParserFeed(parser, (const uint8_t*)text.data() + i, 1));
+  }
+  TEST_ASSERT_EQUAL(INGEST_DONE, parser.state);
+  TEST_ASSERT_EQUAL(length, parser.bodyLength);
+  TEST_ASSERT_EQUAL_MEMORY(batch, parser.body, length);
+}
+
+void test_parser_partial_body() {
+  uint8_t batch[512];
+  size_t length = makeBatch(batch, sizeof(batch), "bike07", 3);
+  std::string text = request(batch, length);
+
+  // Conexão cai no meio do corpo: continua esperando, nunca DONE
+  TEST_ASSERT_EQUAL(INGEST_BODY, feedText(text.substr(0, text.size() - 10)));
+  TEST_ASSERT_EQUAL(length - 10, parser.bodyLength);
+
+  // Bytes além do Content-Length ficam para quem chamou
+  std::string extra = text + "lixo";
+  ingestParserBegin(parser, body, sizeof(body));
+  size_t used = ingestParserFeed(parser, (const uint8_t*)extra.data(), extra.size());
+  TEST_ASSERT_EQUAL(INGEST_DONE, parser.state);
+  TEST_ASSERT_EQUAL(text.size(), used);
+}
+
+void test_parser_errors() {
+  TEST_ASSERT_EQUAL(INGEST_ERROR, feedText("GET /ingest HTTP/1.1\r\n\r\n"));
+  TEST_ASSERT_EQUAL(404, parser.errorStatus);
+  TEST_ASSERT_EQUAL(INGEST_ERROR, feedText("POST /outro HTTP/1.1\r\nContent-Length: 4\r\n\r\nBPRB"));
+  TEST_ASSERT_EQUAL(404, parser.errorStatus);
+  TEST_ASSERT_EQUAL(INGEST_ERROR, feedText("POST /ingest HTTP/1.1\r\nHost: x\r\n\r\n"));
+  TEST_ASSERT_EQUAL(400, parser.errorStatus);
+  TEST_ASSERT_EQUAL(INGEST_ERROR, feedText("POST /ingest HTTP/1.1\r\nContent-Length: 0\r\n\r\n"));
+  TEST_ASSERT_EQUAL(400, parser.errorStatus);
+  TEST_ASSERT_EQUAL(INGEST_ERROR, feedText("GET /firmware/" + std::string(INGEST_TARGET_MAX, 'a') + " HTTP/1.1\r\n\r\n"));
+  TEST_ASSERT_EQUAL(414, parser.errorStatus);
+  std::string big = "POST /ingest HTTP/1.1\r\ncontent-length: " + std::to_string(GATEWAY_MAX_BODY + 1) + "\r\n\r\n";
+  TEST_ASSERT_EQUAL(INGEST_ERROR, feedText(big));
+  TEST_ASSERT_EQUAL(413, parser.errorStatus);
+}
+
+void test_parser_get() {
+  // GETs terminam nos cabeçalhos, sem corpo nem Content-Length
+  TEST_ASSERT_EQUAL(INGEST_DONE, feedText("GET /time HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n"));
+  TEST_ASSERT_EQUAL(INGEST_TIME, parser.request);
+
+  TEST_ASSERT_EQUAL(INGEST_DONE, feedText("GET /firmware/bpr-1.2.bin.gz HTTP/1.1\r\nHost: x\r\n"
+                                          "range: bytes=16384-32767\r\n\r\n"));
+  TEST_ASSERT_EQUAL(INGEST_PROXY, parser.request);
+  TEST_ASSERT_EQUAL_STRING("/firmware/bpr-1.2.bin.gz", parser.target);
+  TEST_ASSERT_EQUAL_STRING("bytes=16384-32767", parser.range);
+
+  TEST_ASSERT_EQUAL(INGEST_DONE, feedText("GET /known_aps?gen=3&blocks=1024 HTTP/1.1\r\n\r\n"));
+  TEST_ASSERT_EQUAL(INGEST_PROXY, parser.request);
+  TEST_ASSERT_EQUAL_STRING("/known_aps?gen=3&blocks=1024", parser.target);
+  TEST_ASSERT_EQUAL_STRING("", parser.range);
+}
+
+void test_validate() {
+  uint8_t data[1024];
+  size_t first = makeBatch(data, sizeof(data), "bike01", 2);
+  size_t second = makeBatch(data + first, sizeof(data) - first, "bike02", 3);
+  int batches, records;
+
+  // Lotes concatenados de bikes diferentes
+  TEST_ASSERT_TRUE(ingestValidate(data, first + second, &batches, &records));
+  TEST_ASSERT_EQUAL(2, batches);
+  TEST_ASSERT_EQUAL(5, records);
+
+  // Truncado em qualquer ponto: recusa
+  for (size_t cut = 1; cut < first + second; cut++) {
+    if (cut == first) continue;
+    TEST_ASSERT_FALSE(ingestValidate(data, cut, &batches, &records));
+  }
+  TEST_ASSERT_FALSE(ingestValidate(data, 0, &batches, &records));
+
+  const char* garbage = "{\"epoch\":1}";
+  TEST_ASSERT_FALSE(ingestValidate((const uint8_t*)garbage, strlen(garbage), &batches, &records));
+  data[first + 4] = 99; // versão desconhecida no segundo lote
+  TEST_ASSERT_FALSE(ingestValidate(data, first + second, &batches, &records));
+}
+
+void test_ingest_slots() {
+  ingestBegin();
+
+  // Quatro bikes ocupam as vagas sem mandar nada; a quinta leva 503
+  int bikes[GATEWAY_MAX_CLIENTS];
+  for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+    bikes[i] = bikeConnect(GATEWAY_INGEST_PORT);
+    TEST_ASSERT_TRUE(bikes[i] >= 0);
+    pollUntil(5);
+  }
+  int extra = bikeConnect(GATEWAY_INGEST_PORT);
+  TEST_ASSERT_EQUAL(503, bikeResponse(extra));
+  close(extra);
+
+  // As que ocupam a vaga continuam sendo atendidas
+  uint8_t batch[512];
+  size_t length = makeBatch(batch, sizeof(batch), "bike03", 2);
+  std::string text = request(batch, length);
+  send(bikes[2], text.data(), text.size(), 0);
+  TEST_ASSERT_EQUAL(200, bikeResponse(bikes[2]));
+  TEST_ASSERT_EQUAL(length, spoolBytes());
+
+  // Lote inválido: 400 e nada entra na fila
+  text = request((const uint8_t*)"BPRBlixo", 8);
+  send(bikes[0], text.data(), text.size(), 0);
+  TEST_ASSERT_EQUAL(400, bikeResponse(bikes[0]));
+  TEST_ASSERT_EQUAL(length, spoolBytes());
+
+  // Vagas liberadas (respondidas ou fechadas pela bike) aceitam novas conexões
+  close(bikes[1]);
+  close(bikes[3]);
+  pollUntil(5);
+  int again = bikeConnect(GATEWAY_INGEST_PORT);
+  text = request(batch, length);
+  send(again, text.data(), text.size(), 0);
+  TEST_ASSERT_EQUAL(200, bikeResponse(again));
+  close(again);
+  close(bikes[0]);
+  close(bikes[2]);
+  pollUntil(5);
+}
+
+void test_spool_rotation_and_cap() {
+  static uint8_t chunk[4096];
+  memset(chunk, 0xA5, sizeof(chunk));
+
+  // Segmento fecha ao passar de SPOOL_SEGMENT_BYTES
+  for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(spoolAppend(chunk, sizeof(chunk)));
+  TEST_ASSERT_EQUAL(1, spoolSegments());
+  TEST_ASSERT_TRUE(spoolAppend(chunk, sizeof(chunk)));
+  TEST_ASSERT_EQUAL(2, spoolSegments());
+  TEST_ASSERT_TRUE(LittleFS.exists("/spool_1.bin"));
+
+  String path;
+  size_t size;
+  TEST_ASSERT_TRUE(spoolOldest(path, size));
+  TEST_ASSERT_EQUAL_STRING("/spool_0.bin", path.c_str());
+  TEST_ASSERT_EQUAL(SPOOL_SEGMENT_BYTES, size);
+
+  // Até exatamente SPOOL_MAX_BYTES entra; o lote seguinte é recusado
+  while (spoolBytes() + sizeof(chunk) <= SPOOL_MAX_BYTES) TEST_ASSERT_TRUE(spoolAppend(chunk, sizeof(chunk)));
+  TEST_ASSERT_EQUAL(SPOOL_MAX_BYTES, spoolBytes());
+  TEST_ASSERT_FALSE(spoolAppend(chunk, 1));
+  TEST_ASSERT_EQUAL(SPOOL_MAX_BYTES / SPOOL_SEGMENT_BYTES, spoolSegments());
+
+  // Enviar o mais antigo libera espaço
+  spoolRemove(path);
+  TEST_ASSERT_EQUAL(SPOOL_MAX_BYTES - SPOOL_SEGMENT_BYTES, spoolBytes());
+  TEST_ASSERT_TRUE(spoolAppend(chunk, sizeof(chunk)));
+
+  // Reinício: retoma a fila num segmento novo
+  size_t before = spoolBytes();
+  spoolBegin();
+  TEST_ASSERT_EQUAL(before, spoolBytes());
+  TEST_ASSERT_TRUE(spoolOldest(path, size));
+  TEST_ASSERT_EQUAL_STRING("/spool_1.bin", path.c_str());
+}
+
+void test_forward_to_collector() {
+  std::string out = fsDir + "_coletor.ndjson";
+  remove(out.c_str());
+  startCollector(COLLECTOR_PORT, {"--out", out});
+
+  hostSetRealtime(true);
+  hostSetScan({{"Rede-Deposito", "AA:BB:CC:00:00:01", -50, 6, 3}});
+  WiFi.begin("Rede-Deposito", "senha");
+  TEST_ASSERT_EQUAL(WL_CONNECTED, WiFi.status());
+  snprintf(gatewayConfig.upstreamUrl, sizeof(gatewayConfig.upstreamUrl), "127.0.0.1:%d", COLLECTOR_PORT);
+
+  // Três bikes em dois envios; cada segmento fecha por ociosidade
+  uint8_t batch[2048];
+  const char* ids[] = {"bike01", "bike02", "bike03"};
+  int records = 0;
+  uint32_t connects = hostStats().netConnects;
+  for (int i = 0; i < 3; i++) {
+    size_t length = makeBatch(batch, sizeof(batch), ids[i], 4 + i);
+    TEST_ASSERT_TRUE(spoolAppend(batch, length));
+    records += 4 + i;
+    if (i == 1) continue;
+    hostAdvance(SPOOL_IDLE_CLOSE_MS);
+    forwardPoll();
+    TEST_ASSERT_EQUAL(0, spoolSegments());
+  }
+  TEST_ASSERT_EQUAL(0, spoolBytes());
+  // Keep-alive: os dois segmentos na mesma conexão
+  TEST_ASSERT_EQUAL(connects + 1, hostStats().netConnects);
+
+  std::ifstream file(out);
+  std::string line;
+  int lines = 0, bike3 = 0;
+  while (std::getline(file, line)) {
+    lines++;
+    if (line.find("\"bike03\"") != std::string::npos) bike3++;
+  }
+  TEST_ASSERT_EQUAL(records, lines);
+  TEST_ASSERT_EQUAL(6, bike3);
+  remove(out.c_str());
+  hostSetRealtime(false);
+}
+
+void test_proxy_get() {
+  std::string firmware = fsDir + "_firmware";
+  mkdir(firmware.c_str(), 0755);
+  std::string image(40000, '\0');
+  for (size_t i = 0; i < image.size(); i++) image[i] = (char)(i * 7);
+  std::ofstream(firmware + "/bpr.bin.gz", std::ios::binary) << image;
+
+  ingestBegin();
+  hostSetRealtime(true);
+  snprintf(gatewayConfig.upstreamUrl, sizeof(gatewayConfig.upstreamUrl), "127.0.0.1:%d", PROXY_COLLECTOR_PORT);
+
+  // Sem rede do depósito: 502, a bike registra a falha e tenta depois
+  WiFi.disconnect();
+  int bike = bikeConnect(GATEWAY_INGEST_PORT);
+  std::string get = "GET /firmware/bpr.bin.gz HTTP/1.1\r\nHost: 192.168.4.1\r\nRange: bytes=1000-20999\r\n\r\n";
+  send(bike, get.data(), get.size(), 0);
+  TEST_ASSERT_EQUAL(502, bikeResponse(bike));
+  close(bike);
+
+  startCollector(PROXY_COLLECTOR_PORT, {"--firmware", firmware});
+  hostSetScan({{"Rede-Deposito", "AA:BB:CC:00:00:01", -50, 6, 3}});
+  WiFi.begin("Rede-Deposito", "senha");
+
+  // Range repassado; a resposta do coletor chega inteira à bike
+  bike = bikeConnect(GATEWAY_INGEST_PORT);
+  send(bike, get.data(), get.size(), 0);
+  std::string response = bikeReadAll(bike);
+  close(bike);
+  TEST_ASSERT_EQUAL(206, atoi(response.c_str() + 9));
+  size_t body = response.find("\r\n\r\n");
+  TEST_ASSERT_TRUE(body != std::string::npos);
+  TEST_ASSERT_TRUE(response.substr(body + 4) == image.substr(1000, 20000));
+
+  // Horário do próprio gateway
+  bike = bikeConnect(GATEWAY_INGEST_PORT);
+  get = "GET /time HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n";
+  send(bike, get.data(), get.size(), 0);
+  response = bikeReadAll(bike);
+  close(bike);
+  TEST_ASSERT_EQUAL(200, atoi(response.c_str() + 9));
+  long epoch = atol(response.c_str() + response.find("\r\n\r\n") + 4);
+  TEST_ASSERT_INT_WITHIN(5, (int)time(nullptr), (int)epoch);
+
+  system(("rm -rf " + firmware).c_str());
+  hostSetRealtime(false);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parser_byte_by_byte);
+  RUN_TEST(test_parser_partial_body);
+  RUN_TEST(test_parser_errors);
+  RUN_TEST(test_parser_get);
+  RUN_TEST(test_validate);
+  RUN_TEST(test_ingest_slots);
+  RUN_TEST(test_spool_rotation_and_cap);
+  RUN_TEST(test_forward_to_collector);
+  RUN_TEST(test_proxy_get);
+  return UNITY_END();
+}
@@ -0,0 +1,115 @@
+// selectStrongest() (src/wifi_scanner.cpp): as K redes mais fortes no início
+// em ordem decrescente de RSSI, redes próprias (bases e "Bike-") no fim.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "config.h"
+#include "host_env.h"
+#include "wifi_scanner.h"
+
+#include <string.h>
+
+static WiFiNetwork nets[32];
+
+static void net(int i, const char* ssid, int rssi) {
+  memset(&nets[i], 0, sizeof(nets[i]));
+  snprintf(nets[i].ssid, sizeof(nets[i].ssid), "%s", ssid);
+  snprintf(nets[i].bssid, sizeof(nets[i].bssid), "5C:CF:7F:00:00:%02X", i);
+  nets[i].rssi = rssi;
+  nets[i].channel = 1 + i % 13;
+}
+
+static bool own(const WiFiNetwork& n) {
+  return isOwnNetwork(n.ssid);
+}
+
+void setUp() {
+  hostSetSerialEcho(false);
+  snprintf(config.baseSSID1, sizeof(config.baseSSID1), "VALENCA");
+  snprintf(config.baseSSID2, sizeof(config.baseSSID2), "CAIS");
+  config.baseSSID3[0] = '\0';
+}
+
+void tearDown() {}
+
+void test_descending_order() {
+  int rssi[] = {-70, -45, -90, -60, -45, -82, -33, -75, -51, -66};
+  int count = sizeof(rssi) / sizeof(rssi[0]);
+  for (int i = 0; i < count; i++) net(i, ("Rede-" + String(i)).c_str(), rssi[i]);
+
+  TEST_ASSERT_EQUAL(5, selectStrongest(nets, count, 5));
+  int expected[] = {-33, -45, -45, -51, -60};
+  for (int i = 0; i < 5; i++) TEST_ASSERT_EQUAL(expected[i], nets[i].rssi);
+
+  // Nenhuma rede se perde: o resto fica depois, em qualquer ordem
+  int sum = 0;
+  for (int i = 0; i < count; i++) sum += nets[i].rssi;
+  int original = 0;
+  for (int i = 0; i < count; i++) original += rssi[i];
+  TEST_ASSERT_EQUAL(original, sum);
+  for (int i = 5; i < count; i++) TEST_ASSERT_LESS_OR_EQUAL(-60, nets[i].rssi);
+}
+
+void test_own_networks_last() {
+  net(0, "VALENCA", -30);   // base, a mais forte
+  net(1, "Rede-1", -70);
+  net(2, "Bike-0042", -35); // AP de configuração de outra bike
+  net(3, "Rede-3", -50);
+  net(4, "CAIS", -40);
+  net(5, "", -60);          // SSID oculto não é rede própria
+  net(6, "Rede-6", -80);
+
+  TEST_ASSERT_EQUAL(3, selectStrongest(nets, 7, 3));
+  TEST_ASSERT_EQUAL_STRING("Rede-3", nets[0].ssid);
+  TEST_ASSERT_EQUAL_STRING("", nets[1].ssid);
+  TEST_ASSERT_EQUAL_STRING("Rede-1", nets[2].ssid);
+
+  // As três próprias continuam no array, depois de todas as candidatas
+  TEST_ASSERT_FALSE(own(nets[3]));
+  for (int i = 4; i < 7; i++) TEST_ASSERT_TRUE(own(nets[i]));
+}
+
+void test_k_at_least_n() {
+  net(0, "Rede-0", -80);
+  net(1, "VALENCA", -20);
+  net(2, "Rede-2", -40);
+  net(3, "Rede-3", -60);
+
+  // K maior que as candidatas: devolve só as candidatas, todas ordenadas
+  TEST_ASSERT_EQUAL(3, selectStrongest(nets, 4, 10));
+  TEST_ASSERT_EQUAL(-40, nets[0].rssi);
+  TEST_ASSERT_EQUAL(-60, nets[1].rssi);
+  TEST_ASSERT_EQUAL(-80, nets[2].rssi);
+  TEST_ASSERT_EQUAL_STRING("VALENCA", nets[3].ssid);
+
+  TEST_ASSERT_EQUAL(3, selectStrongest(nets, 4, 3));
+  TEST_ASSERT_EQUAL(-40, nets[0].rssi);
+}
+
+void test_edge_cases() {
+  TEST_ASSERT_EQUAL(0, selectStrongest(nets, 0, 5));
+
+  net(0, "Rede-0", -50);
+  net(1, "Rede-1", -40);
+  TEST_ASSERT_EQUAL(0, selectStrongest(nets, 2, 0));
+
+  // Só redes próprias
+  net(0, "VALENCA", -50);
+  net(1, "Bike-0001", -40);
+  TEST_ASSERT_EQUAL(0, selectStrongest(nets, 2, 5));
+
+  // Já em ordem crescente: cada rede nova entra no topo
+  for (int i = 0; i < 30; i++) net(i, ("Rede-" + String(i)).c_str(), -95 + i * 2);
+  TEST_ASSERT_EQUAL(10, selectStrongest(nets, 30, 10));
+  for (int i = 0; i < 10; i++) TEST_ASSERT_EQUAL(-37 - i * 2, nets[i].rssi);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_descending_order);
+  RUN_TEST(test_own_networks_last);
+  RUN_TEST(test_k_at_least_n);
+  RUN_TEST(test_edge_cases);
+  return UNITY_END();
+}
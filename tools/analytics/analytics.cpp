@@ -0,0 +1,738 @@
+// Análise da frota sobre os dados exportados, no host e em paralelo.
+//
+//   analytics [--out frota.bprc] [--threads N] [--bike <id>] arquivos...
+//
+// Entradas (o formato é detectado por arquivo):
+//   - exportação serial (comando "exportar"), com ou sem o texto do console
+//   - árvore do Firebase ({"bikes":{"sl01":{"scans":{..}}}}) ou o scans.json
+//     de uma bike (id por --bike, pelo nome do arquivo ou pelo diretório)
+//   - NDJSON do coletor (tools/collector)
+//
+// Os arquivos são mapeados em memória e cortados em pedaços de alguns MB,
+// divididos entre as threads; o parser (scan_parser.h) lê os registros no
+// próprio buffer, sem alocar. Cada thread junta seus scans e avistamentos;
+// no fim tudo é ordenado e intercalado, scans repetidos em mais de uma
+// exportação são descartados, e sai um arquivo colunar (columnar.h) com:
+//
+//   bikes     id, faixa de scans, primeira/última época
+//   scans     trajetos: um scan ou posição por linha, por bike/boot/ticks
+//   sightings avistamentos (bssid, scan, rssi, canal), ordenados por BSSID
+//   bssids    índice por BSSID: faixa em sightings, épocas, RSSI, bikes, SSID
+//   heatmap   ocupação por hora (época / 3600) e canal
+//   strings   bytes dos ids das bikes e SSIDs (como no JSON, com escapes)
+
+#include "columnar.h"
+#include "scan_parser.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define CHUNK_BYTES (4 << 20)
+#define NO_BIKE 0xFFFF
+#define DUPLICATE 0xFFFFFFFF
+
+struct Options {
+  std::string out = "frota.bprc";
+  int threads = 0;
+  std::string bike;
+  std::vector<std::string> files;
+};
+
+struct MappedFile {
+  std::string path;
+  const char* data;
+  size_t size;
+};
+
+// Trecho de um arquivo com a mesma bike (ou NO_BIKE: bike em cada linha)
+struct Chunk {
+  const char* begin; // registros que começam em [begin, end) são deste pedaço
+  const char* end;
+  const char* limit; // fim do trecho: o último registro pode passar de end
+  bool first;        // begin é o início do trecho
+  bool ndjson;
+  uint16_t bike;
+};
+
+struct ScanRow {
+  uint32_t boot;
+  uint32_t ticks;
+  uint32_t epoch;
+  int32_t latE7;
+  int32_t lonE7;
+  uint16_t bike;
+  uint8_t type; // 0 scan, 1 posição
+  uint8_t networks;
+  uint8_t confidence;
+  uint8_t matched;
+};
+
+#pragma pack(push, 4)
+struct Sighting {
+  uint64_t key; // bssid << 16 | rssi << 8 | canal
+  uint32_t scan;
+};
+#pragma pack(pop)
+
+struct SsidView {
+  const char* text;
+  uint16_t length;
+};
+
+struct HeatCell {
+  uint32_t sightings;
+  int64_t rssiSum;
+};
+
+struct Worker {
+  std::vector<ScanRow> scans;
+  std::vector<Sighting> sightings;
+  std::unordered_map<uint64_t, SsidView> ssids;
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> remap;
+  std::unordered_map<uint64_t, HeatCell> heat; // hora << 8 | canal
+  uint64_t bytes = 0;
+  uint64_t malformed = 0;
+  uint64_t dropped = 0;
+  uint64_t ignored = 0;
+  const char* lastBike = nullptr;
+  size_t lastBikeLength = 0;
+  uint16_t lastBikeId = NO_BIKE;
+};
+
+static Options opt;
+static std::mutex bikesLock;
+static std::unordered_map<std::string, uint16_t> bikeIds;
+static std::vector<std::string> bikeNames;
+
+static uint16_t bikeId(const char* text, size_t length) {
+  std::lock_guard<std::mutex> guard(bikesLock);
+  std::string name(text, length);
+  auto it = bikeIds.find(name);
+  if (it != bikeIds.end()) return it->second;
+  if (bikeNames.size() >= NO_BIKE) return NO_BIKE - 1;
+  bikeNames.push_back(name);
+  return bikeIds[name] = bikeNames.size() - 1;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---- entrada ----
+
+static bool mapFile(const std::string& path, MappedFile& file) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  file.path = path;
+  file.size = st.st_size;
+  file.data = "";
+  if (file.size > 0) {
+    void* data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    madvise(data, file.size, MADV_SEQUENTIAL);
+    file.data = (const char*)data;
+  }
+  close(fd);
+  return true;
+}
+
+// Id padrão da bike de um arquivo: --bike, o nome do arquivo ou, para
+// .../sl01/scans.json, o diretório
+static std::string defaultBike(const std::string& path) {
+  if (!opt.bike.empty()) return opt.bike;
+  std::string name = path;
+  size_t slash = name.rfind('/');
+  std::string stem = name.substr(slash == std::string::npos ? 0 : slash + 1);
+  stem = stem.substr(0, stem.find('.'));
+  if (stem == "scans" && slash != std::string::npos && slash > 0) {
+    size_t parent = name.rfind('/', slash - 1);
+    return name.substr(parent == std::string::npos ? 0 : parent + 1,
+                       slash - (parent == std::string::npos ? 0 : parent + 1));
+  }
+  return stem;
+}
+
+static const char* findText(const char* p, const char* end, const char* text) {
+  const char* found = (const char*)memmem(p, end - p, text, strlen(text));
+  return found ? found : end;
+}
+
+// Chave do objeto que abre logo antes de p ("sl01":{ "scans"...), ou vazio
+static std::string keyBefore(const char* begin, const char* p) {
+  const char* q = p;
+  auto back = [&](char c) {
+    while (q > begin && (q[-1] == ' ' || q[-1] == '\n' || q[-1] == '\r' || q[-1] == '\t')) q--;
+    if (q == begin || q[-1] != c) return false;
+    q--;
+    return true;
+  };
+  if (!back('{') || !back(':') || !back('"')) return "";
+  const char* close = q;
+  while (q > begin && q[-1] != '"') q--;
+  return q > begin ? std::string(q, close) : "";
+}
+
+static void addChunks(std::vector<Chunk>& chunks, const char* begin, const char* end, bool ndjson, uint16_t bike) {
+  for (const char* p = begin; p < end; p += CHUNK_BYTES) {
+    const char* stop = end - p > CHUNK_BYTES ? p + CHUNK_BYTES : end;
+    chunks.push_back({p, stop, end, p == begin, ndjson, bike});
+  }
+}
+
+// Corta o arquivo em trechos por bike, e cada trecho em pedaços
+static const char* splitFile(const MappedFile& file, std::vector<Chunk>& chunks) {
+  const char* begin = file.data;
+  const char* end = file.data + file.size;
+  const char* p = begin;
+  while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+  const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+  if (!lineEnd) lineEnd = end;
+  if (p < end && *p == '{' && findText(p, lineEnd, "\"bike\":") < lineEnd &&
+      findText(p, lineEnd, "\"type\":") < lineEnd) {
+    addChunks(chunks, begin, end, true, NO_BIKE);
+    return "coletor";
+  }
+
+  // Exportação serial: {"bikeId":"sl01",...,"scans":[...]}, talvez várias no mesmo log
+  std::vector<std::pair<const char*, uint16_t>> marks;
+  for (const char* m = findText(begin, end, "\"bikeId\":"); m < end; m = findText(m + 1, end, "\"bikeId\":")) {
+    const char* value = (const char*)memchr(m + 9, '"', end - m - 9);
+    const char* close = value ? (const char*)memchr(value + 1, '"', end - value - 1) : nullptr;
+    if (close) marks.push_back({m, bikeId(value + 1, close - value - 1)});
+  }
+  const char* format = "exportação serial";
+  if (marks.empty()) {
+    // Firebase: cada bike é um objeto cuja primeira chave é "scans" (o
+    // Firebase exporta as chaves em ordem alfabética)
+    format = "firebase";
+    for (const char* m = findText(begin, end, "\"scans\""); m < end; m = findText(m + 1, end, "\"scans\"")) {
+      std::string key = keyBefore(begin, m);
+      marks.push_back({m, bikeId(key.empty() ? defaultBike(file.path).c_str() : key.c_str(),
+                                 key.empty() ? defaultBike(file.path).size() : key.size())});
+    }
+  }
+  if (marks.empty()) {
+    marks.push_back({begin, bikeId(defaultBike(file.path).c_str(), defaultBike(file.path).size())});
+    format = "registros soltos";
+  }
+  for (size_t i = 0; i < marks.size(); i++) {
+    addChunks(chunks, marks[i].first, i + 1 < marks.size() ? marks[i + 1].first : end, false, marks[i].second);
+  }
+  return format;
+}
+
+// ---- leitura paralela ----
+
+static void addScan(Worker& w, uint16_t bike, const ScanView& scan) {
+  uint32_t index = w.scans.size();
+  ScanRow row;
+  row.boot = scan.boot;
+  row.ticks = scan.ticks;
+  row.epoch = scan.epoch;
+  row.latE7 = scan.position ? scan.latE7 : 0;
+  row.lonE7 = scan.position ? scan.lonE7 : 0;
+  row.bike = bike;
+  row.type = scan.position ? 1 : 0;
+  row.networks = scan.count;
+  row.confidence = scan.position ? scan.confidence : 0;
+  row.matched = scan.position ? scan.matched : 0;
+  w.scans.push_back(row);
+  w.dropped += scan.dropped;
+  for (int i = 0; i < scan.count; i++) {
+    const NetworkView& net = scan.networks[i];
+    w.sightings.push_back({net.bssid << 16 | (uint64_t)(uint8_t)net.rssi << 8 | net.channel, index});
+    if (net.ssidLength > 0) w.ssids.emplace(net.bssid, SsidView{net.ssid, net.ssidLength});
+  }
+}
+
+// Só aceita um início de registro depois de ',', ':' ou '[' - quem começa no
+// meio de um arquivo pode cair dentro de um SSID
+static const char* syncRecord(const char* p, const char* begin, const char* limit) {
+  for (p = findRecord(p, limit); p < limit; p = findRecord(p + 1, limit)) {
+    const char* q = p;
+    while (q > begin && (q[-1] == ' ' || q[-1] == '\n' || q[-1] == '\r' || q[-1] == '\t')) q--;
+    if (q == begin || q[-1] == ',' || q[-1] == ':' || q[-1] == '[') return p;
+  }
+  return limit;
+}
+
+static void readRecords(Worker& w, const Chunk& chunk) {
+  ScanView scan;
+  const char* p = syncRecord(chunk.begin, chunk.begin, chunk.limit);
+  while (p < chunk.end) {
+    const char* next = parseRecord(p, chunk.limit, scan);
+    if (!next) {
+      w.malformed++;
+      p = syncRecord(p + 1, chunk.begin, chunk.limit);
+      continue;
+    }
+    addScan(w, chunk.bike, scan);
+    p = syncRecord(next, chunk.begin, chunk.limit);
+  }
+}
+
+static void readLines(Worker& w, const Chunk& chunk) {
+  ScanView scan;
+  const char* p = chunk.begin;
+  if (!chunk.first) {
+    const char* nl = (const char*)memchr(p - 1, '\n', chunk.limit - p + 1);
+    p = nl ? nl + 1 : chunk.limit;
+  }
+  while (p < chunk.end) {
+    const char* nl = (const char*)memchr(p, '\n', chunk.limit - p);
+    if (!nl) nl = chunk.limit;
+    const char* bike;
+    size_t bikeLength;
+    if (parseCollectorLine(p, nl, scan, &bike, &bikeLength)) {
+      if (bikeLength != w.lastBikeLength || memcmp(bike, w.lastBike, bikeLength) != 0) {
+        w.lastBike = bike;
+        w.lastBikeLength = bikeLength;
+        w.lastBikeId = bikeId(bike, bikeLength);
+      }
+      addScan(w, w.lastBikeId, scan);
+    } else if (nl > p + 1) {
+      w.ignored++; // viagens, status e linhas quebradas
+    }
+    p = nl + 1;
+  }
+}
+
+// Cada thread fica com um Worker e pega os trabalhos 0..jobs-1 em sequência
+template <typename Job> static void parallel(std::vector<Worker>& workers, size_t jobs, Job job) {
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  for (Worker& w : workers) {
+    threads.emplace_back([&] {
+      for (size_t i; (i = next++) < jobs;) job(w, i);
+    });
+  }
+  for (std::thread& t : threads) t.join();
+}
+
+// ---- ordenação e junção ----
+
+static bool scanBefore(const ScanRow& a, const ScanRow& b) {
+  if (a.bike != b.bike) return a.bike < b.bike;
+  if (a.boot != b.boot) return a.boot < b.boot;
+  if (a.ticks != b.ticks) return a.ticks < b.ticks;
+  return a.type < b.type;
+}
+
+static bool sameScan(const ScanRow& a, const ScanRow& b) {
+  return a.bike == b.bike && a.boot == b.boot && a.ticks == b.ticks && a.type == b.type;
+}
+
+static bool sightingBefore(const Sighting& a, const Sighting& b) {
+  if (a.key >> 16 != b.key >> 16) return a.key >> 16 < b.key >> 16;
+  return a.scan < b.scan;
+}
+
+struct Output {
+  // bikes
+  std::vector<uint32_t> bikeName, bikeFirst, bikeScans, bikeFirstEpoch, bikeLastEpoch;
+  std::vector<uint16_t> bikeNameLength;
+  // scans
+  std::vector<uint16_t> scanBike;
+  std::vector<uint32_t> scanBoot, scanTicks, scanEpoch;
+  std::vector<uint8_t> scanType, scanNetworks, scanConfidence, scanMatched;
+  std::vector<int32_t> scanLat, scanLon;
+  // sightings
+  std::vector<uint64_t> sightBssid;
+  std::vector<uint32_t> sightScan;
+  std::vector<int8_t> sightRssi;
+  std::vector<uint8_t> sightChannel;
+  // bssids
+  std::vector<uint64_t> apBssid;
+  std::vector<uint32_t> apFirst, apCount, apFirstEpoch, apLastEpoch, apSsid;
+  std::vector<int8_t> apRssiMax, apRssiMean;
+  std::vector<uint8_t> apChannel;
+  std::vector<uint16_t> apBikes, apSsidLength;
+  // heatmap
+  std::vector<uint32_t> heatHour, heatSightings;
+  std::vector<uint8_t> heatChannel;
+  std::vector<int8_t> heatRssiMean;
+  // strings
+  std::vector<uint8_t> strings;
+};
+
+static Output out;
+static uint64_t duplicates = 0;
+
+static uint32_t addString(const char* text, size_t length) {
+  uint32_t at = out.strings.size();
+  out.strings.insert(out.strings.end(), text, text + length);
+  return at;
+}
+
+// Intercala os scans já ordenados de cada thread; repetidos (mesma bike,
+// boot, ticks e tipo) ficam só na primeira ocorrência
+static void mergeScans(std::vector<Worker>& workers) {
+  typedef std::pair<int, uint32_t> Head; // worker, posição em order
+  auto later = [&](const Head& a, const Head& b) {
+    return scanBefore(workers[b.first].scans[workers[b.first].order[b.second]],
+                      workers[a.first].scans[workers[a.first].order[a.second]]);
+  };
+  std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+  for (size_t i = 0; i < workers.size(); i++) {
+    if (!workers[i].order.empty()) heads.push({(int)i, 0});
+  }
+  const ScanRow* last = nullptr;
+  while (!heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    Worker& w = workers[head.first];
+    uint32_t local = w.order[head.second];
+    const ScanRow& row = w.scans[local];
+    if (last && sameScan(*last, row)) {
+      w.remap[local] = DUPLICATE;
+      duplicates++;
+    } else {
+      w.remap[local] = out.scanBike.size();
+      out.scanBike.push_back(row.bike);
+      out.scanBoot.push_back(row.boot);
+      out.scanTicks.push_back(row.ticks);
+      out.scanEpoch.push_back(row.epoch);
+      out.scanType.push_back(row.type);
+      out.scanNetworks.push_back(row.networks);
+      out.scanLat.push_back(row.latE7);
+      out.scanLon.push_back(row.lonE7);
+      out.scanConfidence.push_back(row.confidence);
+      out.scanMatched.push_back(row.matched);
+      last = &row;
+    }
+    if (head.second + 1 < w.order.size()) heads.push({head.first, head.second + 1});
+  }
+}
+
+static void mergeSightings(std::vector<Worker>& workers) {
+  typedef std::pair<int, size_t> Head;
+  auto later = [&](const Head& a, const Head& b) {
+    return sightingBefore(workers[b.first].sightings[b.second], workers[a.first].sightings[a.second]);
+  };
+  std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+  size_t total = 0;
+  for (size_t i = 0; i < workers.size(); i++) {
+    total += workers[i].sightings.size();
+    if (!workers[i].sightings.empty()) heads.push({(int)i, 0});
+  }
+  out.sightBssid.reserve(total);
+  out.sightScan.reserve(total);
+  out.sightRssi.reserve(total);
+  out.sightChannel.reserve(total);
+
+  std::unordered_map<uint64_t, SsidView> ssids;
+  for (Worker& w : workers) {
+    for (auto& s : w.ssids) ssids.emplace(s.first, s.second);
+    w.ssids.clear();
+  }
+
+  uint64_t bssid = 0;
+  int64_t rssiSum = 0;
+  uint16_t lastBike = NO_BIKE;
+  auto finish = [&] {
+    size_t i = out.apBssid.size() - 1;
+    out.apRssiMean[i] = (int8_t)(rssiSum / (int64_t)out.apCount[i]);
+    auto name = ssids.find(bssid);
+    if (name != ssids.end()) {
+      out.apSsid[i] = addString(name->second.text, name->second.length);
+      out.apSsidLength[i] = name->second.length;
+    }
+  };
+  while (!heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    const Sighting& s = workers[head.first].sightings[head.second];
+    uint64_t ap = s.key >> 16;
+    int8_t rssi = (int8_t)(s.key >> 8);
+    uint8_t channel = s.key & 0xFF;
+    uint32_t epoch = out.scanEpoch[s.scan];
+    uint16_t bike = out.scanBike[s.scan];
+
+    if (out.apBssid.empty() || ap != bssid) {
+      if (!out.apBssid.empty()) finish();
+      bssid = ap;
+      rssiSum = 0;
+      lastBike = NO_BIKE;
+      out.apBssid.push_back(ap);
+      out.apFirst.push_back(out.sightBssid.size());
+      out.apCount.push_back(0);
+      out.apFirstEpoch.push_back(0);
+      out.apLastEpoch.push_back(0);
+      out.apRssiMax.push_back(rssi);
+      out.apRssiMean.push_back(0);
+      out.apChannel.push_back(channel);
+      out.apBikes.push_back(0);
+      out.apSsid.push_back(0);
+      out.apSsidLength.push_back(0);
+    }
+    size_t i = out.apBssid.size() - 1;
+    out.apCount[i]++;
+    rssiSum += rssi;
+    out.apRssiMax[i] = std::max(out.apRssiMax[i], rssi);
+    if (epoch != 0) {
+      if (out.apFirstEpoch[i] == 0 || epoch < out.apFirstEpoch[i]) out.apFirstEpoch[i] = epoch;
+      if (epoch >= out.apLastEpoch[i]) {
+        out.apLastEpoch[i] = epoch;
+        out.apChannel[i] = channel;
+      }
+    }
+    // Os avistamentos de um BSSID vêm em ordem de scan, e os scans em ordem de bike
+    if (bike != lastBike) {
+      out.apBikes[i]++;
+      lastBike = bike;
+    }
+
+    out.sightBssid.push_back(ap);
+    out.sightScan.push_back(s.scan);
+    out.sightRssi.push_back(rssi);
+    out.sightChannel.push_back(channel);
+    if (head.second + 1 < workers[head.first].sightings.size()) heads.push({head.first, head.second + 1});
+  }
+  if (!out.apBssid.empty()) finish();
+}
+
+static void buildBikes() {
+  for (size_t b = 0; b < bikeNames.size(); b++) {
+    out.bikeName.push_back(addString(bikeNames[b].data(), bikeNames[b].size()));
+    out.bikeNameLength.push_back(bikeNames[b].size());
+    out.bikeFirst.push_back(0);
+    out.bikeScans.push_back(0);
+    out.bikeFirstEpoch.push_back(0);
+    out.bikeLastEpoch.push_back(0);
+  }
+  for (size_t i = 0; i < out.scanBike.size(); i++) {
+    uint16_t b = out.scanBike[i];
+    if (out.bikeScans[b]++ == 0) out.bikeFirst[b] = i;
+    uint32_t epoch = out.scanEpoch[i];
+    if (epoch == 0) continue;
+    if (out.bikeFirstEpoch[b] == 0 || epoch < out.bikeFirstEpoch[b]) out.bikeFirstEpoch[b] = epoch;
+    out.bikeLastEpoch[b] = std::max(out.bikeLastEpoch[b], epoch);
+  }
+}
+
+static bool writeOutput() {
+  std::vector<ColumnarTable> tables(6);
+  ColumnarTable& bikes = tables[0];
+  bikes = {"bikes", (uint32_t)out.bikeName.size(), {}};
+  columnarAdd(bikes, "name", out.bikeName);
+  columnarAdd(bikes, "name_length", out.bikeNameLength);
+  columnarAdd(bikes, "first_scan", out.bikeFirst);
+  columnarAdd(bikes, "scans", out.bikeScans);
+  columnarAdd(bikes, "first_epoch", out.bikeFirstEpoch);
+  columnarAdd(bikes, "last_epoch", out.bikeLastEpoch);
+
+  ColumnarTable& scans = tables[1];
+  scans = {"scans", (uint32_t)out.scanBike.size(), {}};
+  columnarAdd(scans, "bike", out.scanBike);
+  columnarAdd(scans, "boot", out.scanBoot);
+  columnarAdd(scans, "ticks", out.scanTicks);
+  columnarAdd(scans, "epoch", out.scanEpoch);
+  columnarAdd(scans, "type", out.scanType);
+  columnarAdd(scans, "networks", out.scanNetworks);
+  columnarAdd(scans, "lat_e7", out.scanLat);
+  columnarAdd(scans, "lon_e7", out.scanLon);
+  columnarAdd(scans, "confidence", out.scanConfidence);
+  columnarAdd(scans, "matched", out.scanMatched);
+
+  ColumnarTable& sightings = tables[2];
+  sightings = {"sightings", (uint32_t)out.sightBssid.size(), {}};
+  columnarAdd(sightings, "bssid", out.sightBssid);
+  columnarAdd(sightings, "scan", out.sightScan);
+  columnarAdd(sightings, "rssi", out.sightRssi);
+  columnarAdd(sightings, "channel", out.sightChannel);
+
+  ColumnarTable& bssids = tables[3];
+  bssids = {"bssids", (uint32_t)out.apBssid.size(), {}};
+  columnarAdd(bssids, "bssid", out.apBssid);
+  columnarAdd(bssids, "first", out.apFirst);
+  columnarAdd(bssids, "count", out.apCount);
+  columnarAdd(bssids, "first_epoch", out.apFirstEpoch);
+  columnarAdd(bssids, "last_epoch", out.apLastEpoch);
+  columnarAdd(bssids, "rssi_max", out.apRssiMax);
+  columnarAdd(bssids, "rssi_mean", out.apRssiMean);
+  columnarAdd(bssids, "channel", out.apChannel);
+  columnarAdd(bssids, "bikes", out.apBikes);
+  columnarAdd(bssids, "ssid", out.apSsid);
+  columnarAdd(bssids, "ssid_length", out.apSsidLength);
+
+  ColumnarTable& heatmap = tables[4];
+  heatmap = {"heatmap", (uint32_t)out.heatHour.size(), {}};
+  columnarAdd(heatmap, "hour", out.heatHour);
+  columnarAdd(heatmap, "channel", out.heatChannel);
+  columnarAdd(heatmap, "sightings", out.heatSightings);
+  columnarAdd(heatmap, "rssi_mean", out.heatRssiMean);
+
+  ColumnarTable& strings = tables[5];
+  strings = {"strings", (uint32_t)out.strings.size(), {}};
+  columnarAdd(strings, "bytes", out.strings);
+
+  return columnarWrite(opt.out.c_str(), tables);
+}
+
+static void parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string key = argv[i];
+    if (key.compare(0, 2, "--") != 0) {
+      opt.files.push_back(key);
+      continue;
+    }
+    if (i + 1 >= argc) break;
+    const char* value = argv[++i];
+    if (key == "--out") opt.out = value;
+    else if (key == "--threads") opt.threads = atoi(value);
+    else if (key == "--bike") opt.bike = value;
+    else {
+      fprintf(stderr, "opção desconhecida: %s\n", key.c_str());
+      exit(1);
+    }
+  }
+  if (opt.files.empty()) {
+    fprintf(stderr, "uso: %s [--out frota.bprc] [--threads N] [--bike <id>] arquivos...\n", argv[0]);
+    exit(1);
+  }
+  if (opt.threads <= 0) opt.threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+int main(int argc, char** argv) {
+  parseOptions(argc, argv);
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<Chunk> chunks;
+  std::vector<MappedFile> files;
+  uint64_t totalBytes = 0;
+  for (const std::string& path : opt.files) {
+    MappedFile file;
+    if (!mapFile(path, file)) {
+      perror(path.c_str());
+      return 1;
+    }
+    const char* format = splitFile(file, chunks);
+    printf("%s: %.1f MB, %s\n", path.c_str(), file.size / 1e6, format);
+    totalBytes += file.size;
+    files.push_back(file);
+  }
+
+  std::vector<Worker> workers(opt.threads);
+  parallel(workers, chunks.size(), [&](Worker& w, size_t i) {
+    const Chunk& chunk = chunks[i];
+    if (chunk.ndjson) readLines(w, chunk);
+    else readRecords(w, chunk);
+    w.bytes += chunk.end - chunk.begin;
+  });
+  double parseS = secondsSince(start);
+
+  // Ids das bikes em ordem alfabética, para a saída não depender das threads
+  std::vector<uint16_t> bikeRemap(bikeNames.size());
+  {
+    std::vector<uint16_t> byName(bikeNames.size());
+    for (size_t i = 0; i < byName.size(); i++) byName[i] = i;
+    std::sort(byName.begin(), byName.end(), [](uint16_t a, uint16_t b) { return bikeNames[a] < bikeNames[b]; });
+    std::vector<std::string> sorted;
+    for (size_t i = 0; i < byName.size(); i++) {
+      bikeRemap[byName[i]] = i;
+      sorted.push_back(bikeNames[byName[i]]);
+    }
+    bikeNames.swap(sorted);
+  }
+
+  parallel(workers, workers.size(), [&](Worker&, size_t i) {
+    Worker& w = workers[i];
+    for (ScanRow& row : w.scans) row.bike = bikeRemap[row.bike];
+    w.order.resize(w.scans.size());
+    for (size_t k = 0; k < w.order.size(); k++) w.order[k] = k;
+    std::sort(w.order.begin(), w.order.end(),
+              [&](uint32_t a, uint32_t b) { return scanBefore(w.scans[a], w.scans[b]); });
+    w.remap.resize(w.scans.size());
+  });
+  mergeScans(workers);
+
+  // Avistamentos com o índice global do scan, sem os repetidos, e o mapa de
+  // ocupação por hora/canal
+  parallel(workers, workers.size(), [&](Worker&, size_t i) {
+    Worker& w = workers[i];
+    std::vector<ScanRow>().swap(w.scans);
+    std::vector<uint32_t>().swap(w.order);
+    size_t kept = 0;
+    for (Sighting& s : w.sightings) {
+      uint32_t scan = w.remap[s.scan];
+      if (scan == DUPLICATE) continue;
+      s.scan = scan;
+      w.sightings[kept++] = s;
+      uint32_t epoch = out.scanEpoch[scan];
+      if (epoch == 0) continue;
+      HeatCell& cell = w.heat[(uint64_t)(epoch / 3600) << 8 | (s.key & 0xFF)];
+      cell.sightings++;
+      cell.rssiSum += (int8_t)(s.key >> 8);
+    }
+    w.sightings.resize(kept);
+    std::vector<uint32_t>().swap(w.remap);
+    std::sort(w.sightings.begin(), w.sightings.end(), sightingBefore);
+  });
+  mergeSightings(workers);
+
+  std::map<uint64_t, HeatCell> heat;
+  for (Worker& w : workers) {
+    for (auto& cell : w.heat) {
+      HeatCell& total = heat[cell.first];
+      total.sightings += cell.second.sightings;
+      total.rssiSum += cell.second.rssiSum;
+    }
+  }
+  for (auto& cell : heat) {
+    out.heatHour.push_back(cell.first >> 8);
+    out.heatChannel.push_back(cell.first & 0xFF);
+    out.heatSightings.push_back(cell.second.sightings);
+    out.heatRssiMean.push_back((int8_t)(cell.second.rssiSum / (int64_t)cell.second.sightings));
+  }
+  buildBikes();
+  double mergeS = secondsSince(start) - parseS;
+
+  if (!writeOutput()) {
+    perror(opt.out.c_str());
+    return 1;
+  }
+  double totalS = secondsSince(start);
+
+  uint64_t malformed = 0, dropped = 0, ignored = 0;
+  for (Worker& w : workers) {
+    malformed += w.malformed;
+    dropped += w.dropped;
+    ignored += w.ignored;
+  }
+  printf("\n=== %zu arquivos, %.1f MB, %zu pedaços, %d threads ===\n", files.size(), totalBytes / 1e6,
+         chunks.size(), opt.threads);
+  printf("Leitura: %.2f s (%.0f MB/s) | ordenação e junção: %.2f s | gravação: %.2f s | total %.2f s\n",
+         parseS, totalBytes / 1e6 / std::max(parseS, 1e-9), mergeS, totalS - parseS - mergeS, totalS);
+  printf("Bikes: %zu | scans: %zu (%llu repetidos descartados) | avistamentos: %zu | BSSIDs: %zu | células: %zu\n",
+         bikeNames.size(), out.scanBike.size(), (unsigned long long)duplicates, out.sightBssid.size(),
+         out.apBssid.size(), out.heatHour.size());
+  printf("Descartados: %llu registros malformados, %llu redes inválidas, %llu linhas sem scan\n",
+         (unsigned long long)malformed, (unsigned long long)dropped, (unsigned long long)ignored);
+  printf("Saída: %s\n", opt.out.c_str());
+  return 0;
+}
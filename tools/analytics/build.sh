@@ -0,0 +1,15 @@
+#!/bin/bash
+# Compila a análise da frota no host (g++ 7+). Saída em tools/analytics/build/
+set -e
+cd "$(dirname "$0")/../.."
+
+OUT=tools/analytics/build
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++17 -O3 -march=${MARCH:-native} -Wall -pthread"
+mkdir -p "$OUT"
+
+$CXX $FLAGS -Itools/analytics \
+    tools/analytics/scan_parser.cpp tools/analytics/columnar.cpp tools/analytics/analytics.cpp \
+    -o "$OUT/analytics"
+
+echo "ok: $OUT/analytics --out frota.bprc export.json firebase.json dados.ndjson"
@@ -0,0 +1,62 @@
+#include "columnar.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void putName(std::vector<uint8_t>& out, const std::string& name, size_t size) {
+  size_t at = out.size();
+  out.resize(at + size, 0);
+  memcpy(&out[at], name.data(), name.size() < size ? name.size() : size);
+}
+
+template <typename T> static void put(std::vector<uint8_t>& out, T value) {
+  // host little-endian (x86/ARM), como o resto de tools/
+  size_t at = out.size();
+  out.resize(at + sizeof(T));
+  memcpy(&out[at], &value, sizeof(T));
+}
+
+static uint64_t align8(uint64_t offset) {
+  return (offset + 7) & ~7ULL;
+}
+
+bool columnarWrite(const char* path, const std::vector<ColumnarTable>& tables) {
+  size_t headerSize = 8;
+  for (const ColumnarTable& table : tables) {
+    headerSize += COLUMNAR_NAME_SIZE + 8 + table.columns.size() * (COLUMNAR_NAME_SIZE + 4 + 8);
+  }
+
+  std::vector<uint8_t> header;
+  put<uint32_t>(header, COLUMNAR_MAGIC);
+  put<uint16_t>(header, COLUMNAR_VERSION);
+  put<uint16_t>(header, tables.size());
+  uint64_t offset = align8(headerSize);
+  for (const ColumnarTable& table : tables) {
+    putName(header, table.name, COLUMNAR_NAME_SIZE);
+    put<uint32_t>(header, table.rows);
+    put<uint16_t>(header, table.columns.size());
+    put<uint16_t>(header, 0);
+    for (const ColumnarColumn& column : table.columns) {
+      putName(header, column.name, COLUMNAR_NAME_SIZE);
+      putName(header, column.type, 4);
+      put<uint64_t>(header, offset);
+      offset = align8(offset + (uint64_t)table.rows * column.width);
+    }
+  }
+
+  FILE* file = fopen(path, "wb");
+  if (!file) return false;
+  static const uint8_t zeros[8] = {0};
+  bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+  uint64_t written = header.size();
+  for (const ColumnarTable& table : tables) {
+    for (const ColumnarColumn& column : table.columns) {
+      ok = ok && fwrite(zeros, 1, align8(written) - written, file) == align8(written) - written;
+      written = align8(written);
+      size_t bytes = (size_t)table.rows * column.width;
+      ok = ok && (bytes == 0 || fwrite(column.data, 1, bytes, file) == bytes);
+      written += bytes;
+    }
+  }
+  return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,53 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+// Arquivo colunar "BPRC": tabelas com colunas em arrays little-endian
+// contíguos, alinhados em 8 bytes, legíveis direto com numpy.frombuffer
+// (ver read_bprc.py) ou mmap.
+//
+// Cabeçalho: magic u32 "BPRC", versão u16, nº de tabelas u16
+// Por tabela: nome char[16], linhas u32, nº de colunas u16, reservado u16
+//   Por coluna: nome char[16], tipo char[4] (dtype numpy: "<u4", "|i1"...),
+//               offset u64 (absoluto no arquivo)
+// Depois, os dados de cada coluna, na ordem do diretório.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#define COLUMNAR_MAGIC 0x43525042 // "BPRC" em little-endian
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_NAME_SIZE 16
+
+struct ColumnarColumn {
+  std::string name;
+  const char* type; // dtype numpy
+  size_t width;
+  const void* data; // rows * width bytes, mantidos vivos até o write
+};
+
+struct ColumnarTable {
+  std::string name;
+  uint32_t rows;
+  std::vector<ColumnarColumn> columns;
+};
+
+template <typename T> struct ColumnarType;
+template <> struct ColumnarType<uint8_t> { static constexpr const char* name = "|u1"; };
+template <> struct ColumnarType<int8_t> { static constexpr const char* name = "|i1"; };
+template <> struct ColumnarType<uint16_t> { static constexpr const char* name = "<u2"; };
+template <> struct ColumnarType<uint32_t> { static constexpr const char* name = "<u4"; };
+template <> struct ColumnarType<int32_t> { static constexpr const char* name = "<i4"; };
+template <> struct ColumnarType<uint64_t> { static constexpr const char* name = "<u8"; };
+
+template <typename T>
+void columnarAdd(ColumnarTable& table, const char* name, const std::vector<T>& values) {
+  table.columns.push_back({name, ColumnarType<T>::name, sizeof(T), values.data()});
+}
+
+// Grava as tabelas em path; false em erro de E/S
+bool columnarWrite(const char* path, const std::vector<ColumnarTable>& tables);
+
+#endif
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Lê o arquivo colunar (BPRC) gerado por tools/analytics. Sozinho, mostra
+as tabelas e um resumo; como módulo, load() devolve
+{tabela: {coluna: memoryview}} sobre o arquivo mapeado, sem copiar os dados
+(numpy.asarray(coluna) também não copia).
+
+    python3 tools/analytics/read_bprc.py frota.bprc
+"""
+import mmap
+import struct
+import sys
+from collections import Counter
+
+MAGIC = 0x43525042  # "BPRC"
+VERSION = 1
+TABLE = struct.Struct("<16sIHH")
+COLUMN = struct.Struct("<16s4sQ")
+FORMATS = {"|u1": "B", "|i1": "b", "<u2": "H", "<u4": "I", "<i4": "i", "<u8": "Q"}
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = memoryview(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ))
+    magic, version, count = struct.unpack_from("<IHH", data, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"{path}: não é um BPRC v{VERSION}")
+    tables = {}
+    at = 8
+    for _ in range(count):
+        name, rows, columns, _ = TABLE.unpack_from(data, at)
+        at += TABLE.size
+        table = {}
+        for _ in range(columns):
+            column, dtype, offset = COLUMN.unpack_from(data, at)
+            at += COLUMN.size
+            fmt = FORMATS[dtype.rstrip(b"\0").decode()]
+            size = struct.calcsize(fmt)
+            table[column.rstrip(b"\0").decode()] = data[offset:offset + rows * size].cast(fmt)
+        tables[name.rstrip(b"\0").decode()] = table
+    return tables
+
+
+def text(tables, offset, length):
+    return bytes(tables["strings"]["bytes"][offset:offset + length]).decode("utf-8", "replace")
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    tables = load(sys.argv[1])
+    for name, table in tables.items():
+        rows = len(next(iter(table.values()))) if table else 0
+        print(f"{name}: {rows} linhas ({', '.join(table)})")
+
+    bikes = tables["bikes"]
+    for i in range(min(5, len(bikes["name"]))):
+        print(f"  bike {text(tables, bikes['name'][i], bikes['name_length'][i])}: "
+              f"{bikes['scans'][i]} scans a partir do {bikes['first_scan'][i]}")
+
+    aps = tables["bssids"]
+    top = sorted(range(len(aps["count"])), key=lambda i: -aps["count"][i])[:5]
+    for i in top:
+        print(f"  {aps['bssid'][i]:012X} {text(tables, aps['ssid'][i], aps['ssid_length'][i])!r}: "
+              f"{aps['count'][i]} avistamentos, {aps['bikes'][i]} bikes, RSSI máx {aps['rssi_max'][i]}")
+
+    heat = tables["heatmap"]
+    channels = Counter()
+    for channel, sightings in zip(heat["channel"], heat["sightings"]):
+        channels[channel] += sightings
+    print("  avistamentos por canal:", dict(sorted(channels.items())))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,314 @@
+#include "scan_parser.h"
+
+#include <string.h>
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline const char* skipSpace(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+  return p;
+}
+
+static inline const char* expect(const char* p, const char* end, char c) {
+  p = skipSpace(p, end);
+  return p < end && *p == c ? p + 1 : nullptr;
+}
+
+static const char* parseInt(const char* p, const char* end, int64_t* value) {
+  p = skipSpace(p, end);
+  bool negative = p < end && *p == '-';
+  if (negative) p++;
+  if (p >= end || !isDigit(*p)) return nullptr;
+  int64_t v = 0;
+  while (p < end && isDigit(*p)) v = v * 10 + (*p++ - '0');
+  // Firebase às vezes devolve número com parte decimal: ignora
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && isDigit(*p)) p++;
+  }
+  *value = negative ? -v : v;
+  return p;
+}
+
+// p no '"' de abertura; acha o fechamento com memchr, pulando os escapados
+static const char* parseString(const char* p, const char* end, const char** text, size_t* length) {
+  p = skipSpace(p, end);
+  if (p >= end || *p != '"') return nullptr;
+  const char* start = ++p;
+  for (;;) {
+    const char* quote = (const char*)memchr(p, '"', end - p);
+    if (!quote) return nullptr;
+    const char* back = quote;
+    while (back > start && back[-1] == '\\') back--;
+    if ((quote - back) % 2 == 0) {
+      *text = start;
+      *length = quote - start;
+      return quote + 1;
+    }
+    p = quote + 1;
+  }
+}
+
+static inline int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+bool parseBssid(const char* p, size_t length, uint64_t* bssid) {
+  if (length != 17) return false;
+  uint64_t v = 0;
+  for (int i = 0; i < 6; i++) {
+    int hi = hexValue(p[i * 3]), lo = hexValue(p[i * 3 + 1]);
+    if (hi < 0 || lo < 0 || (i < 5 && p[i * 3 + 2] != ':')) return false;
+    v = (v << 8) | (hi << 4) | lo;
+  }
+  *bssid = v;
+  return true;
+}
+
+const char* findRecord(const char* p, const char* end) {
+  while (p < end) {
+    const char* open = (const char*)memchr(p, '[', end - p);
+    if (!open) return end;
+    // "[" dígitos "," dígitos "," "[" só aparece no início de um registro
+    const char* q = open + 1;
+    int field = 0;
+    while (field < 2) {
+      q = skipSpace(q, end);
+      const char* digits = q;
+      while (q < end && isDigit(*q)) q++;
+      q = skipSpace(q, end);
+      if (q == digits || q >= end || *q != ',') break;
+      q++;
+      field++;
+    }
+    q = skipSpace(q, end);
+    if (field == 2 && q < end && *q == '[') return open;
+    p = open + 1;
+  }
+  return end;
+}
+
+static const char* parseNetwork(const char* p, const char* end, NetworkView& net, bool* ok) {
+  const char* bssid;
+  size_t ssidLength, bssidLength;
+  int64_t rssi, channel;
+  if (!(p = expect(p, end, '['))) return nullptr;
+  if (!(p = parseString(p, end, &net.ssid, &ssidLength))) return nullptr;
+  if (!(p = expect(p, end, ','))) return nullptr;
+  if (!(p = parseString(p, end, &bssid, &bssidLength))) return nullptr;
+  if (!(p = expect(p, end, ','))) return nullptr;
+  if (!(p = parseInt(p, end, &rssi))) return nullptr;
+  if (!(p = expect(p, end, ','))) return nullptr;
+  if (!(p = parseInt(p, end, &channel))) return nullptr;
+  if (!(p = expect(p, end, ']'))) return nullptr;
+  net.ssidLength = ssidLength > 0xFFFF ? 0xFFFF : ssidLength;
+  net.rssi = (int8_t)rssi;
+  net.channel = (uint8_t)channel;
+  *ok = parseBssid(bssid, bssidLength, &net.bssid);
+  return p;
+}
+
+const char* parseRecord(const char* p, const char* end, ScanView& scan) {
+  int64_t ticks, epoch, boot = 0;
+  if (!(p = expect(p, end, '['))) return nullptr;
+  if (!(p = parseInt(p, end, &ticks))) return nullptr;
+  if (!(p = expect(p, end, ','))) return nullptr;
+  if (!(p = parseInt(p, end, &epoch))) return nullptr;
+  if (!(p = expect(p, end, ','))) return nullptr;
+  if (!(p = expect(p, end, '['))) return nullptr;
+
+  scan.ticks = (uint32_t)ticks;
+  scan.epoch = (uint32_t)epoch;
+  scan.count = 0;
+  scan.dropped = 0;
+  scan.position = false;
+  p = skipSpace(p, end);
+  if (p < end && (isDigit(*p) || *p == '-')) {
+    int64_t v[4];
+    for (int i = 0; i < 4; i++) {
+      if (i > 0 && !(p = expect(p, end, ','))) return nullptr;
+      if (!(p = parseInt(p, end, &v[i]))) return nullptr;
+    }
+    if (!(p = expect(p, end, ']'))) return nullptr;
+    scan.position = true;
+    scan.latE7 = (int32_t)v[0];
+    scan.lonE7 = (int32_t)v[1];
+    scan.confidence = (uint8_t)v[2];
+    scan.matched = (uint8_t)v[3];
+  } else if (p < end && *p == ']') {
+    p++;
+  } else {
+    for (;;) {
+      NetworkView scratch;
+      bool full = scan.count >= PARSER_MAX_NETWORKS;
+      NetworkView& net = full ? scratch : scan.networks[scan.count];
+      bool ok = false;
+      if (!(p = parseNetwork(p, end, net, &ok))) return nullptr;
+      if (ok && !full) scan.count++;
+      else scan.dropped++;
+      p = skipSpace(p, end);
+      if (p < end && *p == ',') {
+        p++;
+        continue;
+      }
+      if (!(p = expect(p, end, ']'))) return nullptr;
+      break;
+    }
+  }
+
+  // Exportações antigas não têm o boot
+  p = skipSpace(p, end);
+  if (p < end && *p == ',') {
+    if (!(p = parseInt(p + 1, end, &boot))) return nullptr;
+  }
+  if (!(p = expect(p, end, ']'))) return nullptr;
+  scan.boot = (uint32_t)boot;
+  return p;
+}
+
+// ---- NDJSON do coletor ----
+
+static bool keyIs(const char* key, size_t length, const char* name) {
+  return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+// Pula um valor JSON qualquer (para chaves que não interessam)
+static const char* skipValue(const char* p, const char* end) {
+  p = skipSpace(p, end);
+  if (p >= end) return nullptr;
+  if (*p == '"') {
+    const char* s;
+    size_t n;
+    return parseString(p, end, &s, &n);
+  }
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    while (p < end) {
+      char c = *p;
+      if (c == '"') {
+        const char* s;
+        size_t n;
+        if (!(p = parseString(p, end, &s, &n))) return nullptr;
+        continue;
+      }
+      if (c == '{' || c == '[') depth++;
+      if (c == '}' || c == ']') {
+        if (--depth == 0) return p + 1;
+      }
+      p++;
+    }
+    return nullptr;
+  }
+  while (p < end && *p != ',' && *p != '}' && *p != ']') p++;
+  return p;
+}
+
+static const char* parseNetworkObject(const char* p, const char* end, NetworkView& net, bool* ok) {
+  if (!(p = expect(p, end, '{'))) return nullptr;
+  *ok = false;
+  net.ssid = "";
+  net.ssidLength = 0;
+  for (;;) {
+    const char* key;
+    size_t keyLength;
+    if (!(p = parseString(p, end, &key, &keyLength))) return nullptr;
+    if (!(p = expect(p, end, ':'))) return nullptr;
+    int64_t v;
+    if (keyIs(key, keyLength, "ssid")) {
+      size_t n;
+      if (!(p = parseString(p, end, &net.ssid, &n))) return nullptr;
+      net.ssidLength = n > 0xFFFF ? 0xFFFF : n;
+    } else if (keyIs(key, keyLength, "bssid")) {
+      const char* s;
+      size_t n;
+      if (!(p = parseString(p, end, &s, &n))) return nullptr;
+      *ok = parseBssid(s, n, &net.bssid);
+    } else if (keyIs(key, keyLength, "rssi")) {
+      if (!(p = parseInt(p, end, &v))) return nullptr;
+      net.rssi = (int8_t)v;
+    } else if (keyIs(key, keyLength, "channel")) {
+      if (!(p = parseInt(p, end, &v))) return nullptr;
+      net.channel = (uint8_t)v;
+    } else if (!(p = skipValue(p, end))) {
+      return nullptr;
+    }
+    p = skipSpace(p, end);
+    if (p < end && *p == ',') {
+      p++;
+      continue;
+    }
+    return expect(p, end, '}');
+  }
+}
+
+bool parseCollectorLine(const char* p, const char* end, ScanView& scan, const char** bike, size_t* bikeLength) {
+  if (!(p = expect(p, end, '{'))) return false;
+  scan = ScanView();
+  *bike = nullptr;
+  *bikeLength = 0;
+  bool typed = false;
+  for (;;) {
+    const char* key;
+    size_t keyLength;
+    if (!(p = parseString(p, end, &key, &keyLength))) return false;
+    if (!(p = expect(p, end, ':'))) return false;
+    int64_t v = 0;
+    if (keyIs(key, keyLength, "bike")) {
+      if (!(p = parseString(p, end, bike, bikeLength))) return false;
+    } else if (keyIs(key, keyLength, "type")) {
+      const char* type;
+      size_t n;
+      if (!(p = parseString(p, end, &type, &n))) return false;
+      if (keyIs(type, n, "position")) scan.position = true;
+      else if (!keyIs(type, n, "scan")) return false; // trip/status
+      typed = true;
+    } else if (keyIs(key, keyLength, "networks")) {
+      if (!(p = expect(p, end, '['))) return false;
+      p = skipSpace(p, end);
+      if (p < end && *p == ']') {
+        p++;
+      } else {
+        for (;;) {
+          NetworkView scratch;
+          bool full = scan.count >= PARSER_MAX_NETWORKS;
+          bool ok = false;
+          if (!(p = parseNetworkObject(p, end, full ? scratch : scan.networks[scan.count], &ok))) return false;
+          if (ok && !full) scan.count++;
+          else scan.dropped++;
+          p = skipSpace(p, end);
+          if (p < end && *p == ',') {
+            p++;
+            continue;
+          }
+          if (!(p = expect(p, end, ']'))) return false;
+          break;
+        }
+      }
+    } else if (keyIs(key, keyLength, "boot") || keyIs(key, keyLength, "ticks") ||
+               keyIs(key, keyLength, "epoch") || keyIs(key, keyLength, "latE7") ||
+               keyIs(key, keyLength, "lonE7") || keyIs(key, keyLength, "confidence") ||
+               keyIs(key, keyLength, "aps")) {
+      if (!(p = parseInt(p, end, &v))) return false;
+      if (keyIs(key, keyLength, "boot")) scan.boot = (uint32_t)v;
+      else if (keyIs(key, keyLength, "ticks")) scan.ticks = (uint32_t)v;
+      else if (keyIs(key, keyLength, "epoch")) scan.epoch = (uint32_t)v;
+      else if (keyIs(key, keyLength, "latE7")) scan.latE7 = (int32_t)v;
+      else if (keyIs(key, keyLength, "lonE7")) scan.lonE7 = (int32_t)v;
+      else if (keyIs(key, keyLength, "confidence")) scan.confidence = (uint8_t)v;
+      else scan.matched = (uint8_t)v;
+    } else if (!(p = skipValue(p, end))) {
+      return false;
+    }
+    p = skipSpace(p, end);
+    if (p < end && *p == ',') {
+      p++;
+      continue;
+    }
+    return typed && *bike && expect(p, end, '}');
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef SCAN_PARSER_H
+#define SCAN_PARSER_H
+
+// Parser sem alocação dos registros exportados pelo firmware e pelo coletor,
+// direto sobre o arquivo mapeado em memória. Strings são ponteiros para o
+// próprio buffer (com escapes JSON ainda dentro).
+//
+// Registro do firmware (exportar, Firebase): [ticks,realTime,dados,boot]
+//   dados = [["ssid","AA:BB:..",rssi,canal],...] ou [latE7,lonE7,confiança,aps]
+// Linha do coletor (NDJSON): {"bike":..,"type":"scan",..,"networks":[{..}]}
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PARSER_MAX_NETWORKS 32 // o firmware grava até 10; o resto é contado e ignorado
+
+struct NetworkView {
+  const char* ssid;
+  uint16_t ssidLength;
+  uint64_t bssid; // 48 bits
+  int8_t rssi;
+  uint8_t channel;
+};
+
+struct ScanView {
+  bool position;
+  uint32_t ticks;
+  uint32_t epoch; // 0 = sem horário
+  uint32_t boot;  // 0 em exportações antigas sem o campo
+  uint8_t count;
+  uint16_t dropped;
+  NetworkView networks[PARSER_MAX_NETWORKS];
+  int32_t latE7;
+  int32_t lonE7;
+  uint8_t confidence;
+  uint8_t matched;
+};
+
+// Próximo início de registro do firmware ("[int,int,[", com espaços ou não)
+// em [p, end), ou end
+const char* findRecord(const char* p, const char* end);
+
+// Lê o registro que começa em p; devolve o ponteiro logo depois dele, ou
+// nullptr se não for um registro válido
+const char* parseRecord(const char* p, const char* end, ScanView& scan);
+
+// Lê uma linha do coletor (sem o '\n'). Só linhas "scan" e "position" contam.
+// bike/bikeLength apontam para o id dentro da linha.
+bool parseCollectorLine(const char* p, const char* end, ScanView& scan, const char** bike, size_t* bikeLength);
+
+// "AA:BB:CC:DD:EE:FF" -> 0xAABBCCDDEEFF; false se malformado
+bool parseBssid(const char* p, size_t length, uint64_t* bssid);
+
+#endif
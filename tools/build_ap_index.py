@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""Gera o índice de APs (/ap_index.bin) usado pela localização no dispositivo.
+
+Entrada: CSV com colunas bssid,lat,lon[,weight] (cabeçalho opcional).
+Saída: arquivo binário ordenado por BSSID para copiar em data/ e enviar
+com `pio run --target uploadfs`.
+
+    python3 tools/build_ap_index.py aps.csv data/ap_index.bin
+"""
+import csv
+import struct
+import sys
+
+MAGIC = 0x49525042  # "BPRI"
+VERSION = 1
+RECORD = struct.Struct("<6sHii")
+HEADER = struct.Struct("<IHHII")
+
+
+def parse_bssid(text):
+    parts = text.strip().split(":")
+    if len(parts) != 6:
+        raise ValueError(f"BSSID inválido: {text}")
+    return bytes(int(p, 16) for p in parts)
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        sys.exit(1)
+
+    records = {}
+    with open(sys.argv[1], newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].lower() == "bssid":
+                continue
+            bssid = parse_bssid(row[0])
+            lat = round(float(row[1]) * 1e7)
+            lon = round(float(row[2]) * 1e7)
+            weight = int(row[3]) if len(row) > 3 and row[3] else 1
+            records[bssid] = (max(1, min(weight, 65535)), lat, lon)
+
+    with open(sys.argv[2], "wb") as out:
+        out.write(HEADER.pack(MAGIC, VERSION, RECORD.size, len(records), 0))
+        for bssid in sorted(records):
+            weight, lat, lon = records[bssid]
+            out.write(RECORD.pack(bssid, weight, lat, lon))
+
+    print(f"{len(records)} APs -> {sys.argv[2]} "
+          f"({HEADER.size + len(records) * RECORD.size} bytes)")
+
+
+if __name__ == "__main__":
+    main()
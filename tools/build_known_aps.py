@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Gera o filtro de APs conhecidos (/known_aps.bin) para bikes sem coletor.
+
+Entrada: CSV com colunas bssid,channel[,ssid] (cabeçalho opcional), por
+exemplo os APs já mapeados vezes suficientes. Saída: o mesmo arquivo que o
+coletor serve em /known_aps (src/known_aps_format.h), para copiar em data/
+e enviar com `pio run --target uploadfs`.
+
+    python3 tools/build_known_aps.py aps.csv data/known_aps.bin [blocos]
+"""
+import csv
+import struct
+import sys
+
+MAGIC = 0x4B525042  # "BPRK"
+VERSION = 1
+HASHES = 7
+BLOCK_BYTES = 64
+BLOCK_BITS = BLOCK_BYTES * 8
+DEFAULT_BLOCKS = 1024
+MAX_BLOCKS = 4096
+HEADER = struct.Struct("<IHBBIII")
+MASK = (1 << 64) - 1
+
+
+def parse_bssid(text):
+    parts = text.strip().split(":")
+    if len(parts) != 6:
+        raise ValueError(f"BSSID inválido: {text}")
+    return bytes(int(p, 16) for p in parts)
+
+
+def ap_hash(bssid, channel, ssid):
+    """Igual a knownApHash(): FNV-1a e a finalização do splitmix64."""
+    h = 0xCBF29CE484222325
+    for byte in bssid + bytes([channel]) + ssid.encode():
+        h = ((h ^ byte) * 0x100000001B3) & MASK
+    h ^= h >> 30
+    h = (h * 0xBF58476D1CE4E5B9) & MASK
+    h ^= h >> 27
+    h = (h * 0x94D049BB133111EB) & MASK
+    return h ^ (h >> 31)
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        print(__doc__)
+        sys.exit(1)
+    blocks = int(sys.argv[3]) if len(sys.argv) == 4 else DEFAULT_BLOCKS
+    if not 1 <= blocks <= MAX_BLOCKS:
+        raise SystemExit(f"blocos entre 1 e {MAX_BLOCKS}")
+
+    bits = bytearray(blocks * BLOCK_BYTES)
+    keys = set()
+    with open(sys.argv[1], newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].lower() == "bssid":
+                continue
+            keys.add((parse_bssid(row[0]), int(row[1]), row[2] if len(row) > 2 else ""))
+
+    for bssid, channel, ssid in keys:
+        h = ap_hash(bssid, channel, ssid)
+        base = ((h >> 32) % blocks) * BLOCK_BITS
+        low = h & 0xFFFFFFFF
+        first = low % BLOCK_BITS
+        step = ((low >> 9) % BLOCK_BITS) | 1
+        for i in range(HASHES):
+            bit = base + (first + i * step) % BLOCK_BITS
+            bits[bit >> 3] |= 1 << (bit & 7)
+
+    with open(sys.argv[2], "wb") as out:
+        out.write(HEADER.pack(MAGIC, VERSION, HASHES, 0, blocks, 1, len(keys)))
+        out.write(bits)
+
+    print(f"{len(keys)} APs -> {sys.argv[2]} ({HEADER.size + len(bits)} bytes, "
+          f"{len(bits) * 8 / max(1, len(keys)):.1f} bits por AP)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,435 @@
+// Coletor de referência para o backend "coletor" do firmware.
+//
+// Recebe POST /ingest com lotes binários (src/batch_format.h), grava um
+// registro NDJSON por linha e, opcionalmente, repassa ao Firebase com as
+// mesmas chaves que o firmware usaria no envio direto.
+//
+// Com --known, mantém o filtro de APs conhecidos (src/known_aps_format.h):
+// um AP entra depois de --known-after avistamentos completos, e GET
+// /known_aps?gen=<g>&blocks=<n> devolve os bits ligados desde a geração g
+// da bike, ou o filtro inteiro se ela está muito atrás ou não tem filtro.
+//
+// Com --firmware, serve GET /firmware/<arquivo> daquele diretório (manifesto
+// e imagens de tools/ota_release.py), com Range para o download retomável.
+// GET /time devolve a época atual, para bikes que não alcançam o SNTP.
+//
+//   collector [--port 8080] [--out dados.ndjson] [--forward https://<proj>.firebaseio.com]
+//             [--known known_aps.bin] [--known-after 3] [--known-blocks 1024]
+//             [--firmware dir]
+
+#include "batch_format.h"
+#include "http_server.h"
+#include "known_aps_format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define KNOWN_LOG_MAX (1 << 20)     // bits guardados para patches
+#define KNOWN_PENDING_MAX (1 << 20) // APs ainda fora do filtro sendo contados
+
+static FILE* out = stdout;
+static std::string forwardUrl;
+static std::string firmwareDir;
+static std::mutex outputLock;
+
+struct KnownFilter {
+  std::string path;
+  uint32_t after = 3;
+  std::vector<uint8_t> file; // cabeçalho + bits, igual ao /known_aps.bin da bike
+  std::unordered_map<uint64_t, uint32_t> pending;
+  std::vector<std::pair<uint32_t, uint32_t>> log; // (geração, bit) desde logFrom
+  uint32_t logFrom = 0;
+};
+
+static KnownFilter known;
+static std::mutex knownLock;
+
+static std::string jsonString(const char* text) {
+  std::string s = "\"";
+  for (const char* p = text; *p; p++) {
+    unsigned char c = *p;
+    if (c == '"' || c == '\\') {
+      s += '\\';
+      s += c;
+    } else if (c < 0x20) {
+      char esc[8];
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      s += esc;
+    } else {
+      s += c;
+    }
+  }
+  return s + "\"";
+}
+
+static std::string bssidText(const uint8_t* b) {
+  char text[18];
+  snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", b[0], b[1], b[2], b[3], b[4], b[5]);
+  return text;
+}
+
+// Corpo no formato do arquivo do firmware: [ticks,realTime,dados,boot]
+static std::string firmwareRecord(const BatchRecord& r) {
+  std::string s = "[" + std::to_string(r.ticks) + "," + std::to_string(r.epoch) + ",[";
+  if (r.type == BATCH_POSITION) {
+    s += std::to_string(r.latE7) + "," + std::to_string(r.lonE7) + "," +
+         std::to_string(r.confidence) + "," + std::to_string(r.matched);
+  } else {
+    for (int i = 0; i < r.networkCount; i++) {
+      if (i > 0) s += ",";
+      s += "[" + jsonString(r.networks[i].ssid) + ",\"" + bssidText(r.networks[i].bssid) + "\"," +
+           std::to_string(r.networks[i].rssi) + "," + std::to_string(r.networks[i].channel) + "]";
+    }
+  }
+  return s + "]," + std::to_string(r.boot) + "]";
+}
+
+static std::string ndjsonLine(const char* bike, const BatchRecord& r) {
+  static const char* types[] = {"?", "scan", "position", "trip", "status", "summary"};
+  std::string s = "{\"bike\":" + jsonString(bike) + ",\"type\":\"" +
+                  types[r.type <= BATCH_SUMMARY ? r.type : 0] + "\"";
+  s += ",\"boot\":" + std::to_string(r.boot) + ",\"ticks\":" + std::to_string(r.ticks);
+  s += ",\"epoch\":" + std::to_string(r.epoch);
+  switch (r.type) {
+    case BATCH_SCAN:
+      s += ",\"networks\":[";
+      for (int i = 0; i < r.networkCount; i++) {
+        if (i > 0) s += ",";
+        s += "{\"ssid\":" + jsonString(r.networks[i].ssid) + ",\"bssid\":\"" +
+             bssidText(r.networks[i].bssid) + "\",\"rssi\":" + std::to_string(r.networks[i].rssi) +
+             ",\"channel\":" + std::to_string(r.networks[i].channel) + "}";
+      }
+      s += "]";
+      break;
+    case BATCH_POSITION:
+      s += ",\"latE7\":" + std::to_string(r.latE7) + ",\"lonE7\":" + std::to_string(r.lonE7);
+      s += ",\"confidence\":" + std::to_string(r.confidence) + ",\"aps\":" + std::to_string(r.matched);
+      break;
+    default:
+      s += ",\"data\":" + std::string(r.json, r.jsonLength);
+      break;
+  }
+  return s + "}";
+}
+
+static bool firebaseSend(const char* method, const std::string& path, const std::string& payload) {
+  char bodyPath[] = "/tmp/collector-XXXXXX";
+  int fd = mkstemp(bodyPath);
+  if (fd < 0) return false;
+  FILE* body = fdopen(fd, "w");
+  fwrite(payload.data(), 1, payload.size(), body);
+  fclose(body);
+
+  std::string command = "curl -s -o /dev/null -w '%{http_code}' -X " + std::string(method) +
+                        " -H 'Content-Type: application/json' --data-binary @" + bodyPath +
+                        " '" + forwardUrl + path + "'";
+  FILE* curl = popen(command.c_str(), "r");
+  char code[8] = "";
+  if (curl) {
+    if (!fgets(code, sizeof(code), curl)) code[0] = '\0';
+    pclose(curl);
+  }
+  remove(bodyPath);
+  return strcmp(code, "200") == 0;
+}
+
+struct Forward {
+  std::map<std::string, std::string> scans; // um PATCH por bike
+  std::vector<std::pair<std::string, std::string>> puts;
+};
+
+static void collectForward(Forward& fw, const char* bike, const BatchRecord& r) {
+  std::string base = "/bikes/" + std::string(bike);
+  std::string key = std::to_string(r.boot) + "_" + std::to_string(r.ticks);
+  if (r.type == BATCH_SCAN || r.type == BATCH_POSITION) {
+    std::string& scans = fw.scans[bike];
+    scans += scans.empty() ? "{" : ",";
+    scans += "\"" + key + "\":" + firmwareRecord(r);
+  } else if (r.type == BATCH_TRIP) {
+    fw.puts.emplace_back(base + "/trips/" + key + ".json", std::string(r.json, r.jsonLength));
+  } else if (r.type == BATCH_SUMMARY) {
+    fw.puts.emplace_back(base + "/summaries/" + key + ".json", std::string(r.json, r.jsonLength));
+  } else if (r.type == BATCH_STATUS) {
+    fw.puts.emplace_back(base + "/status.json", std::string(r.json, r.jsonLength));
+  }
+}
+
+// ---- filtro de APs conhecidos ----
+
+static KnownApsHeader& knownHeader() {
+  return *(KnownApsHeader*)known.file.data();
+}
+
+static bool knownLoad(const std::string& path, uint32_t blocks) {
+  known.path = path;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f) {
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) known.file.insert(known.file.end(), buf, buf + n);
+    fclose(f);
+    if (known.file.size() < sizeof(KnownApsHeader) || !knownApsHeaderValid(knownHeader()) ||
+        known.file.size() != sizeof(KnownApsHeader) + knownHeader().blocks * KNOWN_APS_BLOCK_BYTES) {
+      fprintf(stderr, "%s: filtro inválido\n", path.c_str());
+      return false;
+    }
+  } else {
+    known.file.assign(sizeof(KnownApsHeader) + blocks * KNOWN_APS_BLOCK_BYTES, 0);
+    KnownApsHeader& h = knownHeader();
+    h.magic = KNOWN_APS_MAGIC;
+    h.version = KNOWN_APS_VERSION;
+    h.hashes = KNOWN_APS_HASHES;
+    h.blocks = blocks;
+    h.generation = 1;
+  }
+  known.logFrom = knownHeader().generation;
+  return true;
+}
+
+static void knownSave() {
+  std::string tmp = known.path + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "wb");
+  if (!f) return;
+  bool ok = fwrite(known.file.data(), 1, known.file.size(), f) == known.file.size();
+  if (fclose(f) == 0 && ok) rename(tmp.c_str(), known.path.c_str());
+}
+
+// Chamado com knownLock
+static bool knownAdd(const BatchNetwork& net, uint32_t generation) {
+  uint64_t hash = knownApHash(net.bssid, net.channel, net.ssid);
+  uint32_t block = knownApBlock(hash, knownHeader().blocks);
+  uint8_t* bytes = &known.file[sizeof(KnownApsHeader) + block * KNOWN_APS_BLOCK_BYTES];
+  uint16_t bits[KNOWN_APS_HASHES];
+  knownApBits(hash, bits);
+
+  bool present = true;
+  for (int i = 0; i < KNOWN_APS_HASHES; i++) present = present && (bytes[bits[i] >> 3] & (1 << (bits[i] & 7)));
+  if (present) return false;
+  if (known.pending.size() >= KNOWN_PENDING_MAX) known.pending.clear();
+  if (++known.pending[hash] < known.after) return false;
+
+  known.pending.erase(hash);
+  for (int i = 0; i < KNOWN_APS_HASHES; i++) {
+    if (bytes[bits[i] >> 3] & (1 << (bits[i] & 7))) continue;
+    bytes[bits[i] >> 3] |= 1 << (bits[i] & 7);
+    known.log.push_back({generation, block * KNOWN_APS_BLOCK_BITS + bits[i]});
+  }
+  return true;
+}
+
+static void knownIngest(const std::vector<BatchNetwork>& networks) {
+  std::lock_guard<std::mutex> guard(knownLock);
+  KnownApsHeader& h = knownHeader();
+  uint32_t added = 0;
+  for (const BatchNetwork& net : networks) added += knownAdd(net, h.generation + 1);
+  if (added == 0) return;
+
+  h.generation++;
+  h.count += added;
+  // Esquece as gerações mais antigas; bikes paradas nelas recebem o filtro inteiro
+  if (known.log.size() > KNOWN_LOG_MAX) {
+    size_t drop = known.log.size() - KNOWN_LOG_MAX;
+    uint32_t oldest = known.log[drop - 1].first;
+    while (drop < known.log.size() && known.log[drop].first == oldest) drop++;
+    known.log.erase(known.log.begin(), known.log.begin() + drop);
+    known.logFrom = oldest;
+  }
+  knownSave();
+  fprintf(stderr, "[coletor] filtro: +%u APs (%u no total), geração %u\n", added, h.count, h.generation);
+}
+
+static long queryValue(const std::string& path, const char* name) {
+  std::string key = std::string(name) + "=";
+  size_t pos = path.find('?');
+  while (pos != std::string::npos) {
+    if (path.compare(pos + 1, key.size(), key) == 0) return atol(path.c_str() + pos + 1 + key.size());
+    pos = path.find('&', pos + 1);
+  }
+  return -1;
+}
+
+static void handleKnownAps(const HttpRequest& request, HttpResponse& response) {
+  std::lock_guard<std::mutex> guard(knownLock);
+  const KnownApsHeader& h = knownHeader();
+  long generation = queryValue(request.path, "gen");
+  long blocks = queryValue(request.path, "blocks");
+  response.contentType = "application/octet-stream";
+
+  if (blocks == (long)h.blocks && generation >= (long)known.logFrom && generation <= (long)h.generation) {
+    std::vector<uint32_t> bits;
+    for (auto it = known.log.rbegin(); it != known.log.rend() && it->first > (uint32_t)generation; ++it) {
+      bits.push_back(it->second);
+    }
+    std::sort(bits.begin(), bits.end());
+    bits.erase(std::unique(bits.begin(), bits.end()), bits.end());
+
+    // Patch grande demais sai mais caro que o filtro
+    if (bits.size() * 4 < known.file.size() / 2) {
+      KnownApsPatchHeader patch = {KNOWN_APS_PATCH_MAGIC, KNOWN_APS_VERSION, 0, (uint32_t)generation,
+                                   h.generation, (uint32_t)bits.size(), h.count};
+      response.body.assign((const char*)&patch, sizeof(patch));
+      response.body.append((const char*)bits.data(), bits.size() * 4);
+      return;
+    }
+  }
+  response.body.assign((const char*)known.file.data(), known.file.size());
+}
+
+// Arquivo estático com "Range: bytes=a-b" (ou "a-"), como o OTA da bike pede
+static void handleFirmware(const HttpRequest& request, HttpResponse& response) {
+  std::string name = request.path.substr(10);
+  if (name.empty() || name.find('/') != std::string::npos || name[0] == '.') {
+    response.status = 404;
+    return;
+  }
+  FILE* f = fopen((firmwareDir + "/" + name).c_str(), "rb");
+  if (!f) {
+    response.status = 404;
+    response.body = "não encontrado\n";
+    return;
+  }
+  std::string data;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+  fclose(f);
+
+  response.contentType = "application/octet-stream";
+  auto range = request.headers.find("range");
+  if (range == request.headers.end() || range->second.compare(0, 6, "bytes=") != 0) {
+    response.body = data;
+    return;
+  }
+  size_t first = strtoul(range->second.c_str() + 6, nullptr, 10);
+  size_t dash = range->second.find('-');
+  size_t last = data.size() - 1;
+  if (dash != std::string::npos && dash + 1 < range->second.size()) {
+    last = std::min(last, (size_t)strtoul(range->second.c_str() + dash + 1, nullptr, 10));
+  }
+  if (first >= data.size() || first > last) {
+    response.status = 416;
+    response.headers["Content-Range"] = "bytes */" + std::to_string(data.size());
+    return;
+  }
+  response.status = 206;
+  response.headers["Content-Range"] =
+      "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(data.size());
+  response.body = data.substr(first, last - first + 1);
+}
+
+static void handleIngest(const HttpRequest& request, HttpResponse& response) {
+  const uint8_t* data = (const uint8_t*)request.body.data();
+  size_t offset = 0;
+  std::string lines;
+  std::set<std::string> bikes;
+  Forward fw;
+  std::vector<BatchNetwork> networks;
+  int records = 0;
+
+  // O corpo pode trazer vários lotes concatenados, de bikes diferentes
+  // (gateway do depósito)
+  while (offset < request.body.size()) {
+    BatchReader reader;
+    if (!batchOpen(reader, data + offset, request.body.size() - offset)) {
+      response.status = 400;
+      response.body = "lote inválido\n";
+      return;
+    }
+    BatchRecord record;
+    while (batchNext(reader, record)) {
+      lines += ndjsonLine(reader.bikeId, record) + "\n";
+      if (!forwardUrl.empty()) collectForward(fw, reader.bikeId, record);
+      if (!known.path.empty() && record.type == BATCH_SCAN) {
+        networks.insert(networks.end(), record.networks, record.networks + record.networkCount);
+      }
+      records++;
+    }
+    if (reader.error) {
+      response.status = 400;
+      response.body = "registro inválido\n";
+      return;
+    }
+    bikes.insert(reader.bikeId);
+    offset += reader.pos;
+  }
+
+  std::lock_guard<std::mutex> guard(outputLock);
+  if (!forwardUrl.empty()) {
+    bool ok = true;
+    for (const auto& scans : fw.scans) {
+      ok = ok && firebaseSend("PATCH", "/bikes/" + scans.first + "/scans.json", scans.second + "}");
+    }
+    for (const auto& put : fw.puts) ok = ok && firebaseSend("PUT", put.first, put.second);
+    if (!ok) {
+      response.status = 502;
+      response.body = "falha no Firebase\n";
+      return;
+    }
+  }
+  fwrite(lines.data(), 1, lines.size(), out);
+  fflush(out);
+  if (!known.path.empty()) knownIngest(networks);
+  std::string names;
+  for (const auto& bike : bikes) names += (names.empty() ? "" : ",") + bike;
+  fprintf(stderr, "[coletor] %s: %d registros, %zu bytes\n", names.c_str(), records, request.body.size());
+  response.body = "ok\n";
+}
+
+int main(int argc, char** argv) {
+  int port = 8080;
+  std::string knownPath;
+  uint32_t knownBlocks = KNOWN_APS_DEFAULT_BLOCKS;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+      port = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+      out = fopen(argv[++i], "a");
+      if (!out) {
+        perror(argv[i]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--forward") && i + 1 < argc) {
+      forwardUrl = argv[++i];
+      while (!forwardUrl.empty() && forwardUrl.back() == '/') forwardUrl.pop_back();
+    } else if (!strcmp(argv[i], "--known") && i + 1 < argc) {
+      knownPath = argv[++i];
+    } else if (!strcmp(argv[i], "--known-after") && i + 1 < argc) {
+      known.after = std::max(1, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--known-blocks") && i + 1 < argc) {
+      knownBlocks = std::min(std::max(1, atoi(argv[++i])), KNOWN_APS_MAX_BLOCKS);
+    } else if (!strcmp(argv[i], "--firmware") && i + 1 < argc) {
+      firmwareDir = argv[++i];
+    } else {
+      fprintf(stderr, "uso: %s [--port 8080] [--out arquivo.ndjson] [--forward https://<proj>.firebaseio.com]\n"
+                      "          [--known known_aps.bin] [--known-after 3] [--known-blocks 1024]\n"
+                      "          [--firmware dir]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (!knownPath.empty() && !knownLoad(knownPath, knownBlocks)) return 1;
+
+  fprintf(stderr, "[coletor] escutando em :%d\n", port);
+  return httpServe(port, [](const HttpRequest& request, HttpResponse& response) {
+    if (request.method == "POST" && request.path == "/ingest") {
+      handleIngest(request, response);
+    } else if (request.method == "GET" && request.path.compare(0, 11, "/known_aps?") == 0 && !known.path.empty()) {
+      handleKnownAps(request, response);
+    } else if (request.method == "GET" && request.path.compare(0, 10, "/firmware/") == 0 && !firmwareDir.empty()) {
+      handleFirmware(request, response);
+    } else if (request.method == "GET" && request.path == "/time") {
+      response.body = std::to_string((long long)time(nullptr)) + "\n";
+    } else {
+      response.status = 404;
+      response.body = "não encontrado\n";
+    }
+  }) ? 0 : 1;
+}
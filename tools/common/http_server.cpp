@@ -0,0 +1,151 @@
+#include "http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+static const char* statusText(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 413: return "Payload Too Large";
+    case 416: return "Range Not Satisfiable";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+  }
+}
+
+static bool sendAll(int fd, const char* data, size_t length) {
+  while (length > 0) {
+    ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+static void serveConnection(int fd, HttpHandler handler) {
+  std::string buffer;
+  char chunk[4096];
+
+  for (;;) {
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+      if (buffer.size() > 16384) {
+        close(fd);
+        return;
+      }
+      ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0) {
+        close(fd);
+        return;
+      }
+      buffer.append(chunk, n);
+    }
+
+    HttpRequest request;
+    size_t lineEnd = buffer.find("\r\n");
+    std::string line = buffer.substr(0, lineEnd);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) {
+      close(fd);
+      return;
+    }
+    request.method = line.substr(0, sp1);
+    request.path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string version = line.substr(sp2 + 1);
+
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+      size_t end = buffer.find("\r\n", pos);
+      std::string header = buffer.substr(pos, end - pos);
+      size_t colon = header.find(':');
+      if (colon != std::string::npos) {
+        std::string name = header.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        size_t valueStart = header.find_first_not_of(' ', colon + 1);
+        request.headers[name] = valueStart == std::string::npos ? "" : header.substr(valueStart);
+      }
+      pos = end + 2;
+    }
+    buffer.erase(0, headerEnd + 4);
+
+    size_t contentLength = 0;
+    auto it = request.headers.find("content-length");
+    if (it != request.headers.end()) contentLength = strtoul(it->second.c_str(), nullptr, 10);
+    while (buffer.size() < contentLength) {
+      ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0) {
+        close(fd);
+        return;
+      }
+      buffer.append(chunk, n);
+    }
+    request.body = buffer.substr(0, contentLength);
+    buffer.erase(0, contentLength);
+
+    bool keepAlive = version == "HTTP/1.1";
+    auto connection = request.headers.find("connection");
+    if (connection != request.headers.end()) {
+      if (strcasecmp(connection->second.c_str(), "close") == 0) keepAlive = false;
+      if (strcasecmp(connection->second.c_str(), "keep-alive") == 0) keepAlive = true;
+    }
+
+    HttpResponse response;
+    handler(request, response);
+
+    std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " +
+                       statusText(response.status) + "\r\n";
+    head += "Content-Type: " + response.contentType + "\r\n";
+    head += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    for (const auto& h : response.headers) head += h.first + ": " + h.second + "\r\n";
+    head += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+
+    if (!sendAll(fd, head.data(), head.size()) ||
+        !sendAll(fd, response.body.data(), response.body.size()) || !keepAlive) {
+      close(fd);
+      return;
+    }
+  }
+}
+
+bool httpServe(int port, const HttpHandler& handler) {
+  signal(SIGPIPE, SIG_IGN);
+
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) return false;
+  int one = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0) {
+    perror("http");
+    close(listener);
+    return false;
+  }
+
+  for (;;) {
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) continue;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    std::thread(serveConnection, fd, handler).detach();
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+// Servidor HTTP/1.1 mínimo para as ferramentas do host (coletor, simulador).
+// Uma thread por conexão, keep-alive, corpo só por Content-Length.
+
+#include <functional>
+#include <map>
+#include <string>
+
+struct HttpRequest {
+  std::string method;
+  std::string path;
+  std::map<std::string, std::string> headers; // nomes em minúsculas
+  std::string body;
+};
+
+struct HttpResponse {
+  int status = 200;
+  std::string contentType = "text/plain";
+  std::map<std::string, std::string> headers;
+  std::string body;
+};
+
+using HttpHandler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
+// Bloqueia atendendo em 0.0.0.0:port; retorna false se não conseguir escutar
+bool httpServe(int port, const HttpHandler& handler);
+
+#endif
@@ -0,0 +1,38 @@
+#!/bin/bash
+# Compila o benchmark de desgaste do flash no host (g++ 7+). Saída em
+# tools/flashbench/build/. Com os fontes do littlefs (lfs.c, lfs_util.c,
+# lfs.h) também compila o motor littlefs, que vira o padrão. Sem
+# LITTLEFS_DIR, usa os do core ESP8266 instalado pelo PlatformIO; fora dele,
+# github.com/littlefs-project/littlefs.
+set -e
+cd "$(dirname "$0")/../.."
+
+PIO_LITTLEFS="$HOME/.platformio/packages/framework-arduinoespressif8266/libraries/LittleFS/lib/littlefs"
+if [ -z "$LITTLEFS_DIR" ] && [ -f "$PIO_LITTLEFS/lfs.c" ]; then
+  LITTLEFS_DIR="$PIO_LITTLEFS"
+fi
+if [ -z "$LITTLEFS_DIR" ]; then
+  echo "aviso: fontes do littlefs não encontrados; só o motor model (LITTLEFS_DIR=...)" >&2
+fi
+
+OUT=tools/flashbench/build
+CXX=${CXX:-g++}
+CC=${CC:-gcc}
+FLAGS="-std=gnu++17 -O2 -Wall -Wno-unused-parameter -pthread"
+mkdir -p "$OUT"
+
+LFS_SRC=""
+if [ -n "$LITTLEFS_DIR" ]; then
+  $CC -O2 -c "$LITTLEFS_DIR/lfs.c" -I"$LITTLEFS_DIR" -o "$OUT/lfs.o"
+  $CC -O2 -c "$LITTLEFS_DIR/lfs_util.c" -I"$LITTLEFS_DIR" -o "$OUT/lfs_util.o"
+  FLAGS="$FLAGS -DFLASHBENCH_LITTLEFS=1 -I$LITTLEFS_DIR"
+  LFS_SRC="$OUT/lfs.o $OUT/lfs_util.o"
+fi
+
+# Firmware inteiro (menos o gateway) sobre a camada host
+$CXX $FLAGS -Itools/host/include -Itools/host -Itools/common -Itools/flashbench -Isrc \
+    src/*.cpp tools/host/host_arduino.cpp tools/common/http_server.cpp \
+    tools/flashbench/nor_flash.cpp tools/flashbench/lfs_model.cpp tools/flashbench/lfs_real.cpp \
+    tools/flashbench/flashbench.cpp $LFS_SRC -o "$OUT/flashbench"
+
+echo "ok: $OUT/flashbench --workload json --hours 24"
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Confere o modelo de custo (lfs_model.cpp) contra o littlefs de verdade:
+# roda cada carga com --engine both e falha se os apagamentos divergirem
+# mais que TOLERANCE por cento (padrão 25). Precisa dos fontes do littlefs
+# (ver build.sh). Rodar depois de mexer no modelo ou no armazenamento.
+set -e
+cd "$(dirname "$0")/../.."
+
+tools/flashbench/build.sh >/dev/null
+BIN=tools/flashbench/build/flashbench
+TOLERANCE=${TOLERANCE:-25}
+if ! $BIN --engine both --hours 0 --dir /tmp/bpr-flashbench-check --port 8094 >/dev/null; then
+  exit 1
+fi
+
+status=0
+for workload in json trip batch append; do
+  if out=$($BIN --workload $workload --engine both --hours 12 --visit-h 4 --tolerance "$TOLERANCE" \
+               --dir /tmp/bpr-flashbench-check --port 8094); then
+    result=ok
+  else
+    result=FALHOU
+    status=1
+  fi
+  echo "$workload: $result | $(echo "$out" | grep -m1 'Modelo x littlefs' || echo 'sem comparação')"
+done
+exit $status
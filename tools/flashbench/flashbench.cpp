@@ -0,0 +1,399 @@
+// Desgaste do flash pelo armazenamento de scans: roda uma carga de escrita
+// (o firmware de src/ ou um formato candidato) sobre o LittleFS do host e
+// espelha cada operação num flash NOR com a geometria do nodemcuv2.
+// Conta apagamentos por bloco, bytes programados, amplificação de escrita
+// e projeta a vida útil do flash.
+//
+//   flashbench [--workload json|trip|batch|append] [--engine littlefs|model|both]
+//              [--scan-ms 5000] [--hours 24] [--visit-h 8] [--networks 15]
+//              [--top-k 5] [--flush-s 300] [--segment-kb 16] [--seed 1]
+//              [--dir /tmp/bpr-flashbench] [--port 8093] [--tolerance 25]
+//
+// json/trip: o firmware de verdade (setup()/loop()), com scan.txt gravando
+// cada scan ou só resumos de viagem; a visita à base faz o upload real para
+// um servidor falso embutido. batch/append: formatos candidatos escritos
+// aqui mesmo pela API do LittleFS, com os mesmos scans; a visita apaga o
+// que foi gravado.
+//
+// O motor padrão é o littlefs de verdade quando o build.sh acha os fontes;
+// sem eles, o modelo de custo. --engine both roda os dois sobre a mesma
+// carga, cada um no seu flash, e sai com 2 se os apagamentos divergirem
+// mais que --tolerance por cento (check_engines.sh).
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "batch_format.h"
+#include "host_env.h"
+#include "http_server.h"
+#include "lfs_model.h"
+#include "lfs_real.h"
+#include "nor_flash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+void setup();
+void loop();
+extern int dataCount;
+
+#define CITY_APS 4000
+#define DEPOT_SSID "BPR-Deposito"
+
+struct Options {
+  std::string workload = "json";
+#if FLASHBENCH_LITTLEFS
+  std::string engine = "littlefs";
+#else
+  std::string engine = "model";
+#endif
+  int scanMs = 5000;
+  double hours = 24;
+  double visitH = 8;
+  int networks = 15;
+  int topK = 5;
+  int flushS = 300;
+  int segmentKb = 16;
+  unsigned seed = 1;
+  std::string dir = "/tmp/bpr-flashbench";
+  int port = 8093;
+  int tolerance = 25; // %, só com --engine both
+};
+
+static Options opt;
+
+// ---- cenário: mesma rua circular do simulador de frota ----
+
+static std::vector<HostNetwork> cityScan(int position, std::mt19937& rng) {
+  std::vector<HostNetwork> nets;
+  std::uniform_int_distribution<int> noise(-6, 6);
+  int half = opt.networks / 2;
+  for (int k = -half; k < opt.networks - half; k++) {
+    int ap = ((position + k) % CITY_APS + CITY_APS) % CITY_APS;
+    char bssid[18];
+    snprintf(bssid, sizeof(bssid), "02:%02X:%02X:%02X:%02X:42", (ap >> 24) & 0xFF, (ap >> 16) & 0xFF,
+             (ap >> 8) & 0xFF, ap & 0xFF);
+    std::string ssid = ap % 5 == 0 ? "" : "Rede-" + std::to_string(ap % 700);
+    nets.push_back({ssid, bssid, -45 - 4 * abs(k) + noise(rng), 1 + ap % 11, 4});
+  }
+  return nets;
+}
+
+static std::vector<HostNetwork> depotScan() {
+  std::vector<HostNetwork> nets = {{DEPOT_SSID, "02:DE:70:00:00:01", -52, 6, 4}};
+  for (int i = 0; i < 4; i++) {
+    nets.push_back({"Vizinho-" + std::to_string(i), "02:DE:70:00:01:0" + std::to_string(i), -70 - 3 * i, 1 + i, 4});
+  }
+  return nets;
+}
+
+static void writeFile(const char* path, const std::string& content) {
+  File file = LittleFS.open(path, "w");
+  file.write((const uint8_t*)content.data(), content.size());
+  file.close();
+}
+
+static int filesWithPrefix(const char* prefix) {
+  int count = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    if (dir.fileName().startsWith(prefix)) count++;
+  }
+  return count;
+}
+
+static void removeWithPrefix(const char* prefix) {
+  std::vector<String> names;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    if (dir.fileName().startsWith(prefix)) names.push_back(dir.fileName());
+  }
+  for (const String& name : names) LittleFS.remove(("/" + name).c_str());
+}
+
+// ---- cargas ----
+
+// Firmware: um ciclo do loop() por scan, como no replay
+static void firmwareScan(const std::vector<HostNetwork>& nets) {
+  hostSetScan(nets);
+  hostAdvance(opt.scanMs);
+  uint32_t scans = hostStats().scans;
+  while (hostStats().scans == scans) loop();
+}
+
+static void firmwareVisit() {
+  hostSetScan(depotScan());
+  hostSetRealtime(true);
+  for (int cycle = 0; cycle < 20; cycle++) {
+    firmwareScan(depotScan());
+    if (dataCount == 0 && filesWithPrefix("trip_") == 0) break;
+  }
+  hostSetRealtime(false);
+}
+
+// Candidatos: os mesmos scans, top K por RSSI
+static std::vector<HostNetwork> strongest(std::vector<HostNetwork> nets) {
+  std::sort(nets.begin(), nets.end(), [](const HostNetwork& a, const HostNetwork& b) { return a.rssi > b.rssi; });
+  if ((int)nets.size() > opt.topK) nets.resize(opt.topK);
+  return nets;
+}
+
+static std::string jsonLine(const std::vector<HostNetwork>& nets, uint32_t ticks) {
+  std::string data = "[" + std::to_string(ticks) + ",0,[";
+  for (size_t i = 0; i < nets.size(); i++) {
+    if (i > 0) data += ",";
+    data += "[\"" + nets[i].ssid + "\",\"" + nets[i].bssid + "\"," + std::to_string(nets[i].rssi) + "," +
+            std::to_string(nets[i].channel) + "]";
+  }
+  return data + "],1]\n";
+}
+
+// batch: lote BPRB em RAM, um arquivo por lote cheio ou a cada flush-s
+static uint8_t batchBuf[4096];
+static BatchWriter writer;
+static int batchFiles = 0;
+static uint32_t batchStarted = 0;
+
+static void batchFlush() {
+  if (writer.recordCount == 0) return;
+  size_t length = batchFinish(writer);
+  File file = LittleFS.open(("/batch_" + std::to_string(batchFiles++) + ".bin").c_str(), "w");
+  file.write(batchBuf, length);
+  file.close();
+  batchBegin(writer, batchBuf, sizeof(batchBuf), "bench");
+}
+
+static void batchScan(const std::vector<HostNetwork>& nets, uint32_t ticks) {
+  BatchRecord record = {};
+  record.type = BATCH_SCAN;
+  record.boot = 1;
+  record.ticks = ticks;
+  for (const HostNetwork& n : strongest(nets)) {
+    BatchNetwork& b = record.networks[record.networkCount++];
+    snprintf(b.ssid, sizeof(b.ssid), "%s", n.ssid.c_str());
+    unsigned v[6];
+    sscanf(n.bssid.c_str(), "%x:%x:%x:%x:%x:%x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+    for (int k = 0; k < 6; k++) b.bssid[k] = v[k];
+    b.rssi = n.rssi;
+    b.channel = n.channel;
+  }
+  if (writer.recordCount == 0) batchStarted = ticks;
+  if (!batchAdd(writer, record)) {
+    batchFlush();
+    batchStarted = ticks;
+    batchAdd(writer, record);
+  }
+  if (ticks - batchStarted >= (uint32_t)opt.flushS * 1000) batchFlush();
+}
+
+// append: uma linha JSON por scan acrescentada ao segmento atual
+static int segment = 0;
+
+static void appendScan(const std::vector<HostNetwork>& nets, uint32_t ticks) {
+  std::string path = "/seg_" + std::to_string(segment) + ".txt";
+  File file = LittleFS.open(path.c_str(), "a");
+  std::string line = jsonLine(strongest(nets), ticks);
+  file.write((const uint8_t*)line.data(), line.size());
+  size_t size = file.size();
+  file.close();
+  if (size >= (size_t)opt.segmentKb * 1024) segment++;
+}
+
+// --engine both: cada operação vai para os dois motores
+struct FsTee : HostFsObserver {
+  HostFsObserver* first;
+  HostFsObserver* second;
+  FsTee(HostFsObserver* first, HostFsObserver* second) : first(first), second(second) {}
+  bool opened(const std::string& path, const char* mode, bool created) override {
+    bool ok = first->opened(path, mode, created);
+    return second->opened(path, mode, created) && ok;
+  }
+  bool wrote(const std::string& path, const uint8_t* data, size_t length) override {
+    bool ok = first->wrote(path, data, length);
+    return second->wrote(path, data, length) && ok;
+  }
+  void closed(const std::string& path) override {
+    first->closed(path);
+    second->closed(path);
+  }
+  void removed(const std::string& path) override {
+    first->removed(path);
+    second->removed(path);
+  }
+  void renamed(const std::string& from, const std::string& to) override {
+    first->renamed(from, to);
+    second->renamed(from, to);
+  }
+};
+
+// ---- main ----
+
+static void parseOptions(int argc, char** argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    const char* value = argv[i + 1];
+    if (key == "--workload") opt.workload = value;
+    else if (key == "--engine") opt.engine = value;
+    else if (key == "--scan-ms") opt.scanMs = atoi(value);
+    else if (key == "--hours") opt.hours = atof(value);
+    else if (key == "--visit-h") opt.visitH = atof(value);
+    else if (key == "--networks") opt.networks = atoi(value);
+    else if (key == "--top-k") opt.topK = atoi(value);
+    else if (key == "--flush-s") opt.flushS = atoi(value);
+    else if (key == "--segment-kb") opt.segmentKb = atoi(value);
+    else if (key == "--seed") opt.seed = atoi(value);
+    else if (key == "--dir") opt.dir = value;
+    else if (key == "--port") opt.port = atoi(value);
+    else if (key == "--tolerance") opt.tolerance = atoi(value);
+    else {
+      fprintf(stderr, "opção desconhecida: %s\n", key.c_str());
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  parseOptions(argc, argv);
+  bool firmware = opt.workload == "json" || opt.workload == "trip";
+  if (!firmware && opt.workload != "batch" && opt.workload != "append") {
+    fprintf(stderr, "carga desconhecida: %s\n", opt.workload.c_str());
+    return 1;
+  }
+  if (opt.engine != "model" && opt.engine != "littlefs" && opt.engine != "both") {
+    fprintf(stderr, "motor desconhecido: %s\n", opt.engine.c_str());
+    return 1;
+  }
+
+  std::thread([] {
+    httpServe(opt.port, [](const HttpRequest& request, HttpResponse& response) {
+      response.contentType = "application/json";
+      response.body = request.method == "POST" ? "{}" : request.body;
+    });
+  }).detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  hostSetRedirect("127.0.0.1", opt.port);
+  hostSetFsRoot(opt.dir);
+  LittleFS.begin();
+  LittleFS.format();
+
+  // Com os dois motores, o relatório é o do littlefs e o modelo usa modelFlash
+  NorFlash flash, modelFlash;
+  norInit(flash);
+  norInit(modelFlash);
+  bool both = opt.engine == "both";
+  LfsModel* model = nullptr;
+#if FLASHBENCH_LITTLEFS
+  LfsReal* real = nullptr;
+  if (opt.engine == "littlefs") hostSetFsObserver(real = new LfsReal(flash));
+  if (both) hostSetFsObserver(new FsTee(real = new LfsReal(flash), model = new LfsModel(modelFlash)));
+#else
+  if (opt.engine != "model") {
+    fprintf(stderr, "compilado sem o littlefs: rode o build.sh com LITTLEFS_DIR=<fontes do littlefs>\n");
+    return 1;
+  }
+#endif
+  if (opt.engine == "model") hostSetFsObserver(model = new LfsModel(flash));
+
+  // Configuração como no aparelho (também passa pelo flash simulado)
+  std::mt19937 rng(opt.seed);
+  writeFile("/bike.txt", "bench");
+  writeFile("/timing.txt", std::to_string(opt.scanMs) + "\n30000");
+  writeFile("/bases.txt", DEPOT_SSID "\nsenha123\n\n\n\n");
+  writeFile("/collector.txt", "127.0.0.1:" + std::to_string(opt.port));
+  writeFile("/scan.txt", std::to_string(opt.topK) + "\n0\n0\n" + (opt.workload == "trip" ? "1" : "0") + "\n6");
+  int position = std::uniform_int_distribution<int>(0, CITY_APS - 1)(rng);
+  if (firmware) {
+    hostSetScan(cityScan(position, rng));
+    setup();
+  } else {
+    batchBegin(writer, batchBuf, sizeof(batchBuf), "bench");
+  }
+
+  // Desconta a formatação e a configuração: mede só o regime
+  uint64_t erasesBase = flash.eraseCount, progBase = flash.bytesProgrammed;
+  uint64_t modelErasesBase = modelFlash.eraseCount;
+  uint64_t payloadBase = hostStats().fsBytesWritten;
+  std::vector<uint32_t> erasesAtStart = flash.erases;
+
+  long scans = (long)(opt.hours * 3600000.0 / opt.scanMs);
+  long visitEvery = opt.visitH > 0 ? (long)(opt.visitH * 3600000.0 / opt.scanMs) : 0;
+  long firstFull = -1;
+  uint32_t refused = 0;
+  int visits = 0;
+  for (long i = 0; i < scans; i++) {
+    position += std::uniform_int_distribution<int>(0, 3)(rng);
+    std::vector<HostNetwork> nets = cityScan(position, rng);
+    uint32_t ticks = (uint32_t)(i * opt.scanMs);
+    if (firmware) firmwareScan(nets);
+    else if (opt.workload == "batch") batchScan(nets, ticks);
+    else appendScan(nets, ticks);
+
+    refused = model ? model->outOfSpace : 0;
+#if FLASHBENCH_LITTLEFS
+    if (real) refused = real->outOfSpace;
+#endif
+    if (refused > 0 && firstFull < 0) firstFull = i;
+
+    if (visitEvery > 0 && (i + 1) % visitEvery == 0) {
+      visits++;
+      if (firmware) {
+        firmwareVisit();
+      } else {
+        if (opt.workload == "batch") batchFlush();
+        removeWithPrefix(opt.workload == "batch" ? "batch_" : "seg_");
+        segment = 0;
+      }
+    }
+  }
+
+  uint64_t erases = flash.eraseCount - erasesBase;
+  uint64_t programmed = flash.bytesProgrammed - progBase;
+  uint64_t payload = hostStats().fsBytesWritten - payloadBase;
+  uint32_t maxBlock = 0;
+  for (uint32_t b = 0; b < flash.blockCount; b++) maxBlock = std::max(maxBlock, flash.erases[b] - erasesAtStart[b]);
+  double days = opt.hours / 24.0;
+  double perDay = erases / days;
+  double leveled = perDay > 0 ? (double)NOR_ENDURANCE * flash.blockCount / perDay : 0;
+  double worst = maxBlock > 0 ? NOR_ENDURANCE / (maxBlock / days) : 0;
+
+  printf("\n=== Flash %u blocos x %u bytes (nodemcuv2, 4m2m), prog %u, motor %s ===\n", flash.blockCount,
+         flash.blockSize, flash.progSize, opt.engine.c_str());
+  printf("Carga %s: %ld scans a cada %d ms (%.1f h), %d redes vistas, top %d, %d visitas à base\n",
+         opt.workload.c_str(), scans, opt.scanMs, opt.hours, opt.networks, opt.topK, visits);
+  printf("Gravado pela aplicação: %llu bytes | programado no flash: %llu bytes | amplificação %.1fx\n",
+         (unsigned long long)payload, (unsigned long long)programmed, payload ? (double)programmed / payload : 0.0);
+  printf("Apagamentos: %llu (%.0f por dia, %.2f por scan) | bloco mais apagado: %u\n", (unsigned long long)erases,
+         perDay, scans ? (double)erases / scans : 0.0, maxBlock);
+  printf("Bytes apagados por byte gravado: %.1f\n", payload ? (double)erases * flash.blockSize / payload : 0.0);
+  if (model) {
+    printf("Metadados: %llu commits, %llu compactações, %llu realocações, %llu divisões, %u pares\n",
+           (unsigned long long)model->commits, (unsigned long long)model->compactions,
+           (unsigned long long)model->relocations, (unsigned long long)model->splits, model->pairCount());
+  }
+  if (firstFull >= 0) {
+    printf("FLASH CHEIO depois de %ld scans (%.1f h sem visita): %u escritas recusadas\n", firstFull,
+           firstFull * opt.scanMs / 3600000.0, refused);
+  }
+  printf("Vida útil (%d ciclos): %.1f anos com desgaste nivelado | %.1f anos pelo bloco mais apagado\n",
+         NOR_ENDURANCE, leveled / 365, worst / 365);
+  if (flash.violations) printf("AVISO: %u bytes programados sem apagar antes\n", flash.violations);
+
+  if (both) {
+    uint64_t modelErases = modelFlash.eraseCount - modelErasesBase;
+    double gap = erases ? std::abs((double)modelErases - (double)erases) * 100.0 / erases : (modelErases ? 100.0 : 0.0);
+    printf("Modelo x littlefs: %llu x %llu apagamentos (diferença %.0f%%, tolerância %d%%)\n",
+           (unsigned long long)modelErases, (unsigned long long)erases, gap, opt.tolerance);
+    if (gap > opt.tolerance) {
+      printf("DIVERGÊNCIA: recalibre o modelo (lfs_model.h) com esta carga\n");
+      return 2;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,288 @@
+#include "lfs_model.h"
+
+#include <algorithm>
+
+static uint32_t alignUp(uint32_t value, uint32_t align) {
+  return (value + align - 1) / align * align;
+}
+
+static std::string nameOf(const std::string& path) {
+  return path[0] == '/' ? path.substr(1) : path;
+}
+
+// Ponteiros da skip-list no início do bloco index de um arquivo CTZ
+static uint32_t ctzPointers(uint32_t index) {
+  return index == 0 ? 0 : 4 * (__builtin_ctz(index) + 1);
+}
+
+LfsModel::LfsModel(NorFlash& nor) : flash(nor), inUse(nor.blockCount, false), freeBlocks(nor.blockCount - 2) {
+  // Formatação: superbloco + raiz no par {0, 1}
+  LfsModelPair root;
+  root.block[0] = 0;
+  root.block[1] = 1;
+  inUse[0] = inUse[1] = true;
+  pairs.push_back(root);
+  norErase(flash, 0);
+  norErase(flash, 1);
+  prog(0, alignUp(4 + 4 + 8 + 24 + 8, flash.progSize));
+  pairs[0].off = alignUp(4 + 4 + 8 + 24 + 8, flash.progSize);
+  cursor = 2;
+}
+
+uint32_t LfsModel::allocate() {
+  for (uint32_t i = 0; i < flash.blockCount; i++) {
+    uint32_t block = (cursor + i) % flash.blockCount;
+    if (!inUse[block]) {
+      inUse[block] = true;
+      freeBlocks--;
+      cursor = (block + 1) % flash.blockCount;
+      norErase(flash, block);
+      return block;
+    }
+  }
+  outOfSpace++;
+  return cursor;
+}
+
+void LfsModel::release(uint32_t block) {
+  if (inUse[block]) freeBlocks++;
+  inUse[block] = false;
+}
+
+void LfsModel::prog(uint32_t block, uint32_t length) {
+  static const std::vector<uint8_t> zeros(NOR_BLOCK_SIZE, 0);
+  length = std::min(length, flash.blockSize);
+  // Só a contagem importa: o modelo não materializa os dados
+  norProg(flash, block, 0, zeros.data(), length);
+}
+
+size_t LfsModel::pairOf(const std::string& name) {
+  for (size_t i = 0; i < pairs.size(); i++) {
+    if (pairs[i].entries.count(name)) return i;
+  }
+  // Nome novo: as entradas ficam em ordem de nome ao longo da lista de pares
+  for (size_t i = pairs.size(); i-- > 1;) {
+    if (!pairs[i].entries.empty() && pairs[i].entries.begin()->first <= name) return i;
+  }
+  return 0;
+}
+
+uint32_t LfsModel::entryCost(const std::string& name) const {
+  auto it = files.find(name);
+  uint32_t data = 8; // struct CTZ (cabeça + tamanho)
+  if (it != files.end() && it->second.inlined) data = it->second.size;
+  return 4 + name.size() + 4 + data + (LFS_MODEL_TIME_ATTRS ? 2 * 12 : 0);
+}
+
+uint32_t LfsModel::liveSize(const LfsModelPair& pair) const {
+  uint32_t size = 4 + 12 + 8; // revisão, tail, CRC
+  if (&pair == &pairs[0]) size += 24 + 8; // superbloco
+  for (const auto& entry : pair.entries) size += entryCost(entry.first);
+  return size;
+}
+
+void LfsModel::compact(size_t index) {
+  LfsModelPair& pair = pairs[index];
+  compactions++;
+  int target = 1 - pair.active;
+  if (++pair.compactions % LFS_MODEL_BLOCK_CYCLES == 0 && freeBlocks > 0) {
+    // Desgaste: troca o bloco de destino por um novo (e avisa o antecessor);
+    // sem bloco livre o littlefs compacta no lugar
+    relocations++;
+    release(pair.block[target]);
+    pair.block[target] = allocate();
+    if (index > 0) commit(index - 1, 12);
+  } else {
+    norErase(flash, pair.block[target]);
+  }
+  pair.active = target;
+  pair.off = alignUp(liveSize(pair), flash.progSize);
+  prog(pair.block[target], pair.off);
+
+  // Mais de meio bloco vivo: metade das entradas vai para um par novo
+  // (se houver dois blocos livres; senão segue sem dividir)
+  if (liveSize(pair) > flash.blockSize / 2 && pair.entries.size() > 1 && freeBlocks >= 2) {
+    splits++;
+    LfsModelPair next;
+    next.block[0] = allocate();
+    next.block[1] = allocate();
+    auto middle = pair.entries.begin();
+    std::advance(middle, pair.entries.size() / 2);
+    next.entries.insert(middle, pair.entries.end());
+    pair.entries.erase(middle, pair.entries.end());
+    next.off = alignUp(liveSize(next), flash.progSize);
+    prog(next.block[0], next.off);
+    pairs.insert(pairs.begin() + index + 1, next);
+    LfsModelPair& head = pairs[index];
+    head.off = alignUp(liveSize(head), flash.progSize);
+  }
+}
+
+bool LfsModel::commit(size_t index, uint32_t tagBytes) {
+  commits++;
+  uint32_t length = alignUp(tagBytes + 8, flash.progSize); // + tag e valor do CRC
+  if (pairs[index].off + length > flash.blockSize) {
+    // Não cabe nem compactado e não há como dividir: LFS_ERR_NOSPC, sem apagar nada
+    uint32_t live = alignUp(liveSize(pairs[index]), flash.progSize);
+    if (live + length > flash.blockSize && freeBlocks < 2) return false;
+    compact(index);
+  }
+  LfsModelPair& pair = pairs[index];
+  if (pair.off + length > flash.blockSize) return false;
+  prog(pair.block[pair.active], length);
+  pair.off += length;
+  return true;
+}
+
+void LfsModel::flushProg(LfsModelFile& file) {
+  if (file.inlined || !file.extended || file.blockOff <= file.progStart) return;
+  uint32_t start = file.progStart / flash.progSize * flash.progSize;
+  uint32_t end = alignUp(file.blockOff, flash.progSize);
+  if (end > start) prog(file.lastBlock, end - start);
+  file.progStart = file.blockOff;
+}
+
+void LfsModel::nextBlock(LfsModelFile& file) {
+  flushProg(file);
+  uint32_t block = allocate();
+  file.owned.push_back(block);
+  file.lastBlock = block;
+  file.blockOff = ctzPointers(file.blocks);
+  file.progStart = 0;
+  file.blocks++;
+}
+
+bool LfsModel::opened(const std::string& path, const char* mode, bool created) {
+  std::string name = nameOf(path);
+  if (!files.count(name)) {
+    size_t index = pairOf(name);
+    pairs[index].entries[name] = true;
+    files[name] = LfsModelFile();
+    if (!commit(index, 4 + 4 + name.size() + 4)) { // CREATE, NAME, struct inline vazio
+      pairs[index].entries.erase(name);
+      files.erase(name);
+      outOfSpace++;
+      return false;
+    }
+  }
+  LfsModelFile& file = files[name];
+  if (mode[0] == 'w' && !created) {
+    // Truncar: os blocos antigos só são liberados no commit do close
+    file.released.insert(file.released.end(), file.owned.begin(), file.owned.end());
+    file.owned.clear();
+    file.size = 0;
+    file.inlined = true;
+    file.blocks = 0;
+    file.blockOff = 0;
+  }
+  file.open = true;
+  file.created = created;
+  file.extended = false;
+  return true;
+}
+
+bool LfsModel::wrote(const std::string& path, const uint8_t*, size_t length) {
+  LfsModelFile& file = files[nameOf(path)];
+  if (file.inlined && file.size + length <= LFS_MODEL_INLINE_MAX) {
+    file.size += length;
+    return true;
+  }
+
+  // Sem blocos livres o littlefs devolve LFS_ERR_NOSPC e nada é gravado
+  uint32_t start = file.inlined ? file.size : file.blockOff;
+  uint32_t needed = (file.inlined || !file.extended ? 1 : 0) + (start + length) / flash.blockSize;
+  if (needed > freeBlocks) {
+    outOfSpace++;
+    return false;
+  }
+
+  if (file.inlined) {
+    // Sai do inline: o que já havia vai para o primeiro bloco
+    file.inlined = false;
+    file.blocks = 0;
+    nextBlock(file);
+    file.extended = true;
+    file.blockOff += file.size;
+  } else if (!file.extended) {
+    // Append em arquivo fechado: o último bloco parcial é copiado para um novo
+    file.extended = true;
+    if (file.blockOff >= flash.blockSize) {
+      nextBlock(file);
+    } else {
+      uint32_t old = file.lastBlock;
+      uint32_t copy = file.blockOff;
+      file.owned.erase(std::find(file.owned.begin(), file.owned.end(), old));
+      file.released.push_back(old);
+      file.blocks--;
+      nextBlock(file);
+      file.blockOff = copy;
+      flash.bytesRead += copy;
+    }
+  }
+
+  uint32_t left = length;
+  while (left > 0) {
+    if (file.blockOff >= flash.blockSize) nextBlock(file);
+    uint32_t take = std::min(left, flash.blockSize - file.blockOff);
+    file.blockOff += take;
+    file.size += take;
+    left -= take;
+  }
+  return true;
+}
+
+void LfsModel::closed(const std::string& path) {
+  std::string name = nameOf(path);
+  LfsModelFile& file = files[name];
+  if (!file.open) return;
+  flushProg(file);
+  size_t index = pairOf(name);
+  if (!commit(index, 4 + (file.inlined ? file.size : 8))) outOfSpace++;
+  if (LFS_MODEL_TIME_ATTRS) {
+    commit(index, 4 + 8); // 't'
+    if (file.created) commit(index, 4 + 8); // 'c'
+  }
+  for (uint32_t block : file.released) release(block);
+  file.released.clear();
+  file.open = false;
+}
+
+void LfsModel::removed(const std::string& path) {
+  std::string name = nameOf(path);
+  auto it = files.find(name);
+  if (it == files.end()) return;
+  size_t index = pairOf(name);
+  pairs[index].entries.erase(name);
+  for (uint32_t block : it->second.owned) release(block);
+  for (uint32_t block : it->second.released) release(block);
+  files.erase(it);
+  commit(index, 4);
+
+  // Par vazio sai da lista (o antecessor aponta para o seguinte)
+  if (index > 0 && pairs[index].entries.empty()) {
+    release(pairs[index].block[0]);
+    release(pairs[index].block[1]);
+    pairs.erase(pairs.begin() + index);
+    commit(index - 1, 12);
+  }
+}
+
+void LfsModel::renamed(const std::string& from, const std::string& to) {
+  std::string a = nameOf(from), b = nameOf(to);
+  auto it = files.find(a);
+  if (it == files.end()) return;
+  if (files.count(b)) removed(to);
+  LfsModelFile file = it->second;
+  size_t source = pairOf(a);
+  pairs[source].entries.erase(a);
+  files.erase(a);
+  files[b] = file;
+  size_t target = pairOf(b);
+  pairs[target].entries[b] = true;
+  commit(target, 4 + 4 + b.size() + 4 + (file.inlined ? file.size : 8) + (source == target ? 4 : 0));
+  if (source != target) commit(source, 4);
+}
+
+uint32_t LfsModel::usedBlocks() const {
+  return std::count(inUse.begin(), inUse.end(), true);
+}
@@ -0,0 +1,91 @@
+#ifndef LFS_MODEL_H
+#define LFS_MODEL_H
+
+// Modelo de custo do littlefs v2 com a configuração do core ESP8266
+// (bloco 8 KB, prog/cache 64, block_cycles 16, inline até 64 bytes).
+// Recebe as operações do LittleFS do host e as traduz em apagamentos e
+// programações no NorFlash, sem guardar os dados:
+//  - diretório em pares de blocos de metadados, cada operação é um commit
+//    alinhado ao prog size; bloco cheio = compactação no outro bloco do par;
+//    par com mais de meio bloco vivo é dividido; a cada 16 compactações o
+//    par é realocado (nivelamento de desgaste)
+//  - arquivos até 64 bytes ficam inline no commit; maiores vão para blocos
+//    próprios (lista CTZ), e cada sessão de append copia o último bloco
+//    parcial para um bloco novo (copy-on-write)
+//  - o core grava os atributos 't' (mtime) e 'c' (criação), time_t de
+//    8 bytes, com setattr: cada um num commit próprio
+//  - alocador next-fit que percorre o disco todo antes de reusar um bloco
+// É uma aproximação: serve para comparar formatos, não para prever bit a bit.
+
+#include "host_env.h"
+#include "nor_flash.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define LFS_MODEL_INLINE_MAX 64
+#define LFS_MODEL_BLOCK_CYCLES 16
+#define LFS_MODEL_TIME_ATTRS 1
+
+struct LfsModelFile {
+  uint32_t size = 0;
+  bool inlined = true;
+  uint32_t blocks = 0;     // blocos na cadeia CTZ
+  uint32_t lastBlock = 0;  // bloco físico do fim da cadeia
+  uint32_t blockOff = 0;   // bytes usados no último bloco (com ponteiros)
+  std::vector<uint32_t> owned;
+  // sessão aberta para escrita
+  bool open = false;
+  bool created = false;
+  bool extended = false;   // já copiou o último bloco nesta sessão
+  uint32_t progStart = 0;  // início da região programada no bloco atual
+  std::vector<uint32_t> released; // liberados ao fechar (copy-on-write)
+};
+
+struct LfsModelPair {
+  uint32_t block[2];
+  int active = 0;
+  uint32_t off = 0;
+  uint32_t compactions = 0;
+  std::map<std::string, bool> entries; // nomes neste par, em ordem
+};
+
+class LfsModel : public HostFsObserver {
+ public:
+  explicit LfsModel(NorFlash& flash);
+  bool opened(const std::string& path, const char* mode, bool created) override;
+  bool wrote(const std::string& path, const uint8_t* data, size_t length) override;
+  void closed(const std::string& path) override;
+  void removed(const std::string& path) override;
+  void renamed(const std::string& from, const std::string& to) override;
+
+  uint32_t usedBlocks() const;
+  uint32_t pairCount() const { return pairs.size(); }
+  uint64_t commits = 0;
+  uint64_t compactions = 0;
+  uint64_t relocations = 0;
+  uint64_t splits = 0;
+  uint32_t outOfSpace = 0; // escritas recusadas por falta de bloco livre
+
+ private:
+  NorFlash& flash;
+  std::vector<bool> inUse;
+  uint32_t freeBlocks;
+  uint32_t cursor = 0;
+  std::map<std::string, LfsModelFile> files;
+  std::vector<LfsModelPair> pairs;
+
+  uint32_t allocate();
+  void release(uint32_t block);
+  void prog(uint32_t block, uint32_t length);
+  size_t pairOf(const std::string& name);
+  uint32_t entryCost(const std::string& name) const;
+  uint32_t liveSize(const LfsModelPair& pair) const;
+  void compact(size_t index);
+  bool commit(size_t index, uint32_t tagBytes);
+  void nextBlock(LfsModelFile& file);
+  void flushProg(LfsModelFile& file);
+};
+
+#endif
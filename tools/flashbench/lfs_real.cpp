@@ -0,0 +1,119 @@
+#include "lfs_real.h"
+
+#if FLASHBENCH_LITTLEFS
+
+#include "lfs.h"
+
+#include <time.h>
+
+struct LfsRealOpen {
+  lfs_file_t file;
+  bool created;
+};
+
+struct LfsRealState {
+  lfs_t lfs;
+  lfs_config cfg;
+  std::map<std::string, LfsRealOpen*> open;
+};
+
+static int bdRead(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
+  norRead(*(NorFlash*)c->context, block, off, buffer, size);
+  return 0;
+}
+
+static int bdProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer,
+                  lfs_size_t size) {
+  norProg(*(NorFlash*)c->context, block, off, buffer, size);
+  return 0;
+}
+
+static int bdErase(const struct lfs_config* c, lfs_block_t block) {
+  norErase(*(NorFlash*)c->context, block);
+  return 0;
+}
+
+static int bdSync(const struct lfs_config*) {
+  return 0;
+}
+
+// Mesmos valores de LittleFSImpl (cores/esp8266/.../LittleFS.h)
+LfsReal::LfsReal(NorFlash& flash) : state(new LfsRealState()) {
+  lfs_config& cfg = state->cfg;
+  cfg.context = &flash;
+  cfg.read = bdRead;
+  cfg.prog = bdProg;
+  cfg.erase = bdErase;
+  cfg.sync = bdSync;
+  cfg.read_size = 64;
+  cfg.prog_size = 64;
+  cfg.block_size = flash.blockSize;
+  cfg.block_count = flash.blockCount;
+  cfg.block_cycles = 16;
+  cfg.cache_size = 64;
+  cfg.lookahead_size = 64;
+  if (lfs_format(&state->lfs, &cfg) != 0 || lfs_mount(&state->lfs, &cfg) != 0) errors++;
+}
+
+LfsReal::~LfsReal() {
+  for (auto& entry : state->open) {
+    lfs_file_close(&state->lfs, &entry.second->file);
+    delete entry.second;
+  }
+  lfs_unmount(&state->lfs);
+  delete state;
+}
+
+bool LfsReal::opened(const std::string& path, const char* mode, bool created) {
+  int flags = mode[0] == 'w' ? LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC
+            : mode[0] == 'a' ? LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND
+                             : LFS_O_RDWR;
+  LfsRealOpen* open = new LfsRealOpen();
+  open->created = created;
+  int err = lfs_file_open(&state->lfs, &open->file, path.c_str(), flags);
+  if (err != 0) {
+    if (err == LFS_ERR_NOSPC) outOfSpace++;
+    else errors++;
+    delete open;
+    return false;
+  }
+  state->open[path] = open;
+  return true;
+}
+
+bool LfsReal::wrote(const std::string& path, const uint8_t* data, size_t length) {
+  auto it = state->open.find(path);
+  if (it == state->open.end()) return false;
+  lfs_ssize_t n = lfs_file_write(&state->lfs, &it->second->file, data, length);
+  if (n == LFS_ERR_NOSPC) outOfSpace++;
+  else if (n < 0) errors++;
+  return n == (lfs_ssize_t)length;
+}
+
+void LfsReal::closed(const std::string& path) {
+  auto it = state->open.find(path);
+  if (it == state->open.end()) return;
+  if (lfs_file_close(&state->lfs, &it->second->file) != 0) errors++;
+
+  // Como LittleFSFileImpl::close(): mtime e, na criação, ctime
+  time_t now = time(nullptr);
+  lfs_setattr(&state->lfs, path.c_str(), 't', &now, sizeof(now));
+  if (it->second->created) lfs_setattr(&state->lfs, path.c_str(), 'c', &now, sizeof(now));
+  delete it->second;
+  state->open.erase(it);
+}
+
+void LfsReal::removed(const std::string& path) {
+  if (lfs_remove(&state->lfs, path.c_str()) != 0) errors++;
+}
+
+void LfsReal::renamed(const std::string& from, const std::string& to) {
+  if (lfs_rename(&state->lfs, from.c_str(), to.c_str()) != 0) errors++;
+}
+
+uint32_t LfsReal::usedBlocks() {
+  lfs_ssize_t used = lfs_fs_size(&state->lfs);
+  return used < 0 ? 0 : used;
+}
+
+#endif
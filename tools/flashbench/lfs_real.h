@@ -0,0 +1,34 @@
+#ifndef LFS_REAL_H
+#define LFS_REAL_H
+
+// O littlefs de verdade (lfs.c do core ESP8266) sobre o NorFlash, com a
+// mesma configuração do LittleFS do core. Só existe quando o build.sh
+// recebe LITTLEFS_DIR apontando para os fontes do littlefs.
+
+#include "host_env.h"
+#include "nor_flash.h"
+
+#include <map>
+#include <string>
+
+struct LfsRealState;
+
+class LfsReal : public HostFsObserver {
+ public:
+  explicit LfsReal(NorFlash& flash);
+  ~LfsReal() override;
+  bool opened(const std::string& path, const char* mode, bool created) override;
+  bool wrote(const std::string& path, const uint8_t* data, size_t length) override;
+  void closed(const std::string& path) override;
+  void removed(const std::string& path) override;
+  void renamed(const std::string& from, const std::string& to) override;
+
+  uint32_t usedBlocks();
+  uint32_t outOfSpace = 0;
+  uint32_t errors = 0;
+
+ private:
+  LfsRealState* state;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "nor_flash.h"
+#include <string.h>
+
+void norInit(NorFlash& flash, uint32_t blockSize, uint32_t blockCount, uint32_t progSize) {
+  flash.blockSize = blockSize;
+  flash.blockCount = blockCount;
+  flash.progSize = progSize;
+  flash.data.assign((size_t)blockSize * blockCount, 0xFF);
+  flash.erases.assign(blockCount, 0);
+  flash.bytesProgrammed = 0;
+  flash.bytesRead = 0;
+  flash.eraseCount = 0;
+  flash.violations = 0;
+}
+
+void norRead(NorFlash& flash, uint32_t block, uint32_t offset, void* buf, size_t length) {
+  memcpy(buf, &flash.data[(size_t)block * flash.blockSize + offset], length);
+  flash.bytesRead += length;
+}
+
+void norProg(NorFlash& flash, uint32_t block, uint32_t offset, const void* buf, size_t length) {
+  uint8_t* dst = &flash.data[(size_t)block * flash.blockSize + offset];
+  const uint8_t* src = (const uint8_t*)buf;
+  for (size_t i = 0; i < length; i++) {
+    if (src[i] & ~dst[i]) flash.violations++;
+    dst[i] &= src[i];
+  }
+  flash.bytesProgrammed += length;
+}
+
+void norErase(NorFlash& flash, uint32_t block) {
+  memset(&flash.data[(size_t)block * flash.blockSize], 0xFF, flash.blockSize);
+  flash.erases[block]++;
+  flash.eraseCount++;
+}
+
+uint32_t norMaxErases(const NorFlash& flash) {
+  uint32_t max = 0;
+  for (uint32_t e : flash.erases) {
+    if (e > max) max = e;
+  }
+  return max;
+}
@@ -0,0 +1,37 @@
+#ifndef NOR_FLASH_H
+#define NOR_FLASH_H
+
+// Flash NOR simulado: apagar põe o bloco inteiro em 0xFF, programar só
+// derruba bits (1 -> 0). Conta apagamentos por bloco e bytes programados.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// nodemcuv2 (eagle.flash.4m2m.ld): 2 MB de FS menos 24 KB, bloco de 8 KB,
+// e a configuração do LittleFS do core ESP8266
+#define NOR_BLOCK_SIZE 8192
+#define NOR_BLOCK_COUNT 253
+#define NOR_PROG_SIZE 64
+#define NOR_ENDURANCE 100000 // ciclos de apagamento por setor (datasheet típico)
+
+struct NorFlash {
+  uint32_t blockSize;
+  uint32_t blockCount;
+  uint32_t progSize;
+  std::vector<uint8_t> data;
+  std::vector<uint32_t> erases; // por bloco
+  uint64_t bytesProgrammed;
+  uint64_t bytesRead;
+  uint64_t eraseCount;
+  uint32_t violations; // programou 0 -> 1 (bloco não apagado)
+};
+
+void norInit(NorFlash& flash, uint32_t blockSize = NOR_BLOCK_SIZE, uint32_t blockCount = NOR_BLOCK_COUNT,
+             uint32_t progSize = NOR_PROG_SIZE);
+void norRead(NorFlash& flash, uint32_t block, uint32_t offset, void* buf, size_t length);
+void norProg(NorFlash& flash, uint32_t block, uint32_t offset, const void* buf, size_t length);
+void norErase(NorFlash& flash, uint32_t block);
+uint32_t norMaxErases(const NorFlash& flash);
+
+#endif
@@ -0,0 +1,178 @@
+// Uma bike simulada: o firmware de src/ (setup/loop) sobre a camada host.
+// Pedala um trajeto em tempo virtual, espera a hora de chegada ao depósito
+// e, a partir daí, roda em tempo real contra o servidor do fleet_sim.
+// Imprime uma linha JSON com o resultado.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "config.h"
+#include "host_env.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+void setup();
+void loop();
+extern int dataCount;
+
+#define CITY_APS 4000
+#define DEPOT_SSID "BPR-Deposito"
+
+struct Options {
+  std::string id = "sl001";
+  std::string dir;
+  std::string server = "127.0.0.1:8090";
+  std::string backend = "firebase";
+  long long startUnixMs = 0;
+  unsigned long arriveMs = 0;
+  int rideScans = 120;
+  int scanMs = 5000;
+  int retryMs = 5000;
+  int tlsMs = 1500;
+  int joinMs = 3000;
+  unsigned long deadlineMs = 300000;
+  unsigned seed = 1;
+  bool echo = false;
+};
+
+static std::string bssidFor(int ap) {
+  char text[18];
+  snprintf(text, sizeof(text), "02:%02X:%02X:%02X:%02X:%02X", (ap >> 24) & 0xFF, (ap >> 16) & 0xFF,
+           (ap >> 8) & 0xFF, ap & 0xFF, 0x42);
+  return text;
+}
+
+// APs fixos numa "rua" circular; a bike avança e vê os ~15 mais próximos
+static std::vector<HostNetwork> cityScan(int position, std::mt19937& rng) {
+  std::vector<HostNetwork> nets;
+  std::uniform_int_distribution<int> noise(-6, 6);
+  for (int k = -7; k <= 7; k++) {
+    int ap = ((position + k) % CITY_APS + CITY_APS) % CITY_APS;
+    std::string ssid = ap % 5 == 0 ? "" : "Rede-" + std::to_string(ap % 700);
+    nets.push_back({ssid, bssidFor(ap), -45 - 4 * abs(k) + noise(rng), 1 + ap % 11, 4});
+  }
+  return nets;
+}
+
+static std::vector<HostNetwork> depotScan() {
+  std::vector<HostNetwork> nets = {{DEPOT_SSID, "02:DE:70:00:00:01", -52, 6, 4}};
+  for (int i = 0; i < 6; i++) {
+    nets.push_back({"Vizinho-" + std::to_string(i), "02:DE:70:00:01:0" + std::to_string(i), -70 - 3 * i, 1 + i, 4});
+  }
+  return nets;
+}
+
+static void writeFile(const char* path, const std::string& content) {
+  File file = LittleFS.open(path, "w");
+  file.write((const uint8_t*)content.data(), content.size());
+  file.close();
+}
+
+static int pendingTrips() {
+  int count = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    if (dir.fileName().startsWith("trip_")) count++;
+  }
+  return count;
+}
+
+static long long unixMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static Options parseOptions(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    const char* value = argv[i + 1];
+    if (key == "--id") o.id = value;
+    else if (key == "--dir") o.dir = value;
+    else if (key == "--server") o.server = value;
+    else if (key == "--backend") o.backend = value;
+    else if (key == "--start") o.startUnixMs = atoll(value);
+    else if (key == "--arrive-ms") o.arriveMs = atol(value);
+    else if (key == "--ride-scans") o.rideScans = atoi(value);
+    else if (key == "--scan-ms") o.scanMs = atoi(value);
+    else if (key == "--retry-ms") o.retryMs = atoi(value);
+    else if (key == "--tls-ms") o.tlsMs = atoi(value);
+    else if (key == "--join-ms") o.joinMs = atoi(value);
+    else if (key == "--deadline-ms") o.deadlineMs = atol(value);
+    else if (key == "--seed") o.seed = atoi(value);
+    else if (key == "--echo") o.echo = atoi(value) != 0;
+  }
+  if (o.dir.empty()) o.dir = "/tmp/bpr-fleet/" + o.id;
+  if (o.startUnixMs == 0) o.startUnixMs = unixMs();
+  return o;
+}
+
+int main(int argc, char** argv) {
+  Options o = parseOptions(argc, argv);
+  std::mt19937 rng(o.seed);
+
+  size_t colon = o.server.find(':');
+  hostSetRedirect(o.server.substr(0, colon), atoi(o.server.substr(colon + 1).c_str()));
+  hostSetTlsDelay(o.tlsMs);
+  hostSetJoinDelay(o.joinMs);
+  hostSetSerialEcho(o.echo);
+  hostSetFsRoot(o.dir);
+
+  // Flash limpa com a configuração da frota
+  LittleFS.begin();
+  LittleFS.format();
+  writeFile("/bike.txt", o.id);
+  writeFile("/timing.txt", std::to_string(o.scanMs) + "\n" + std::to_string(o.retryMs));
+  writeFile("/bases.txt", DEPOT_SSID "\nsenha123\n\n\n\n");
+  writeFile("/firebase.txt", "https://frota-sim.firebaseio.com\nchave-sim");
+  if (o.backend == "collector") writeFile("/collector.txt", o.server);
+
+  // Passeio em tempo virtual
+  int position = std::uniform_int_distribution<int>(0, CITY_APS - 1)(rng);
+  hostSetScan(cityScan(position, rng));
+  setup();
+  for (int i = 0; i < o.rideScans; i++) {
+    position += std::uniform_int_distribution<int>(0, 3)(rng);
+    hostSetScan(cityScan(position, rng));
+    hostAdvance(o.scanMs);
+    loop();
+  }
+  int stored = dataCount;
+  uint64_t rideFsBytes = hostStats().fsBytesWritten;
+
+  // Chegada ao depósito na hora sorteada pelo fleet_sim
+  long long wait = o.startUnixMs + (long long)o.arriveMs - unixMs();
+  if (wait > 0) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+  long long arrived = unixMs() - o.startUnixMs;
+
+  hostSetScan(depotScan());
+  hostSetRealtime(true);
+  long long done = -1;
+  int cycles = 0;
+  unsigned long deadline = millis() + o.deadlineMs;
+  while (millis() < deadline) {
+    uint32_t joins = hostStats().wifiJoins;
+    loop();
+    if (hostStats().wifiJoins != joins) cycles++;
+    if (cycles > 0 && dataCount == 0 && pendingTrips() == 0) {
+      done = unixMs() - o.startUnixMs;
+      break;
+    }
+  }
+
+  const HostStats& s = hostStats();
+  printf("{\"bike\":\"%s\",\"stored\":%d,\"arrive_ms\":%lld,\"done_ms\":%lld,\"cycles\":%d,"
+         "\"connects\":%u,\"connect_failures\":%u,\"tls\":%u,\"bytes_out\":%llu,\"bytes_in\":%llu,"
+         "\"left\":%d,\"fs_ride_bytes\":%llu}\n",
+         o.id.c_str(), stored, arrived, done, cycles, s.netConnects, s.netConnectFailures, s.tlsHandshakes,
+         (unsigned long long)s.netBytesOut, (unsigned long long)s.netBytesIn, dataCount + pendingTrips(),
+         (unsigned long long)rideFsBytes);
+  fflush(stdout);
+  return done >= 0 ? 0 : 2;
+}
@@ -0,0 +1,20 @@
+#!/bin/bash
+# Compila o simulador de frota no host (g++ 7+). Saída em tools/fleet/build/
+set -e
+cd "$(dirname "$0")/../.."
+
+OUT=tools/fleet/build
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++17 -O2 -Wall -Wno-unused-parameter -pthread"
+mkdir -p "$OUT"
+
+# Firmware inteiro (menos o gateway) sobre a camada host
+$CXX $FLAGS -Itools/host/include -Itools/host -Isrc \
+    src/*.cpp tools/host/host_arduino.cpp tools/fleet/bike_sim.cpp \
+    -o "$OUT/bike_sim"
+
+$CXX $FLAGS -Isrc -Itools/common \
+    tools/fleet/fleet_sim.cpp tools/common/http_server.cpp src/batch_format.cpp \
+    -o "$OUT/fleet_sim"
+
+echo "ok: $OUT/fleet_sim --bike-bin $OUT/bike_sim"
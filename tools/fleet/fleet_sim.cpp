@@ -0,0 +1,266 @@
+// Simulador de frota: N processos bike_sim chegando ao depósito contra um
+// servidor local que imita o Firebase REST (e o /ingest do coletor), com
+// latência, falhas e limite de conexões configuráveis.
+//
+//   fleet_sim [--bikes 200] [--window-s 60] [--backend firebase|collector]
+//             [--latency-ms 150] [--jitter-ms 100] [--fail-rate 0.02]
+//             [--max-concurrent 64] [--tls-ms 1500] [--join-ms 3000]
+//             [--ride-scans 120] [--retry-ms 5000] [--deadline-s 300]
+//             [--port 8090] [--seed 1] [--bike-bin ./bike_sim]
+
+#include "batch_format.h"
+#include "http_server.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+  int bikes = 200;
+  int windowS = 60;
+  std::string backend = "firebase";
+  int latencyMs = 150;
+  int jitterMs = 100;
+  double failRate = 0.02;
+  int maxConcurrent = 64;
+  int tlsMs = 1500;
+  int joinMs = 3000;
+  int rideScans = 120;
+  int retryMs = 5000;
+  int deadlineS = 300;
+  int port = 8090;
+  unsigned seed = 1;
+  std::string bikeBin = "./bike_sim";
+};
+
+struct RequestEvent {
+  long long atMs;
+  std::string bike;
+  int status;
+  size_t bytes;
+  bool retry; // a bike já tinha recebido uma falha antes
+};
+
+static Options opt;
+static long long startUnixMs;
+static std::mutex eventsLock;
+static std::vector<RequestEvent> events;
+static std::set<std::string> failedBikes;
+static std::atomic<int> inFlight(0);
+static std::atomic<int> peakInFlight(0);
+
+static long long unixMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string bikeFromRequest(const HttpRequest& request) {
+  if (request.path.compare(0, 7, "/bikes/") == 0) {
+    size_t end = request.path.find('/', 7);
+    return request.path.substr(7, end == std::string::npos ? std::string::npos : end - 7);
+  }
+  BatchReader reader;
+  if (batchOpen(reader, (const uint8_t*)request.body.data(), request.body.size())) return reader.bikeId;
+  return "?";
+}
+
+static void handle(const HttpRequest& request, HttpResponse& response) {
+  int now = ++inFlight;
+  int peak = peakInFlight;
+  while (now > peak && !peakInFlight.compare_exchange_weak(peak, now)) {}
+
+  static thread_local std::mt19937 rng(std::random_device{}());
+  std::string bike = bikeFromRequest(request);
+  bool isFirebase = request.method == "PATCH" || request.method == "PUT";
+  bool isIngest = request.method == "POST" && request.path == "/ingest";
+
+  if (!isFirebase && !isIngest) {
+    response.status = 404;
+  } else if (now > opt.maxConcurrent) {
+    response.status = 503;
+  } else {
+    int jitter = opt.jitterMs > 0 ? std::uniform_int_distribution<int>(0, opt.jitterMs)(rng) : 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(opt.latencyMs + jitter));
+    if (std::uniform_real_distribution<double>(0, 1)(rng) < opt.failRate) {
+      response.status = 500;
+    } else {
+      response.contentType = "application/json";
+      response.body = isFirebase ? request.body : "{}";
+    }
+  }
+  --inFlight;
+
+  std::lock_guard<std::mutex> guard(eventsLock);
+  bool retry = failedBikes.count(bike) > 0;
+  if (response.status != 200) failedBikes.insert(bike);
+  events.push_back({unixMs() - startUnixMs, bike, response.status, request.body.size(), retry});
+}
+
+static long long field(const std::string& line, const char* name) {
+  std::string key = "\"" + std::string(name) + "\":";
+  size_t pos = line.find(key);
+  return pos == std::string::npos ? -1 : atoll(line.c_str() + pos + key.size());
+}
+
+static double percentile(std::vector<long long> values, double p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t index = std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5));
+  return values[index] / 1000.0;
+}
+
+static void parseOptions(int argc, char** argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    const char* value = argv[i + 1];
+    if (key == "--bikes") opt.bikes = atoi(value);
+    else if (key == "--window-s") opt.windowS = atoi(value);
+    else if (key == "--backend") opt.backend = value;
+    else if (key == "--latency-ms") opt.latencyMs = atoi(value);
+    else if (key == "--jitter-ms") opt.jitterMs = atoi(value);
+    else if (key == "--fail-rate") opt.failRate = atof(value);
+    else if (key == "--max-concurrent") opt.maxConcurrent = atoi(value);
+    else if (key == "--tls-ms") opt.tlsMs = atoi(value);
+    else if (key == "--join-ms") opt.joinMs = atoi(value);
+    else if (key == "--ride-scans") opt.rideScans = atoi(value);
+    else if (key == "--retry-ms") opt.retryMs = atoi(value);
+    else if (key == "--deadline-s") opt.deadlineS = atoi(value);
+    else if (key == "--port") opt.port = atoi(value);
+    else if (key == "--seed") opt.seed = atoi(value);
+    else if (key == "--bike-bin") opt.bikeBin = value;
+    else {
+      fprintf(stderr, "opção desconhecida: %s\n", key.c_str());
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  parseOptions(argc, argv);
+
+  std::thread([] { httpServe(opt.port, handle); }).detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // Todas as bikes pedalam ao mesmo tempo (tempo virtual) e chegam
+  // espalhadas na janela; o relógio começa depois de uma folga para o passeio
+  std::mt19937 rng(opt.seed);
+  startUnixMs = unixMs() + 2000;
+  int out[2];
+  if (pipe(out) != 0) return 1;
+
+  std::vector<pid_t> children;
+  std::string server = "127.0.0.1:" + std::to_string(opt.port);
+  for (int i = 0; i < opt.bikes; i++) {
+    char id[16];
+    snprintf(id, sizeof(id), "sim%03d", i);
+    long arrive = std::uniform_int_distribution<long>(0, opt.windowS * 1000L)(rng);
+    std::vector<std::string> args = {
+        opt.bikeBin, "--id", id, "--server", server, "--backend", opt.backend,
+        "--start", std::to_string(startUnixMs), "--arrive-ms", std::to_string(arrive),
+        "--ride-scans", std::to_string(opt.rideScans), "--retry-ms", std::to_string(opt.retryMs),
+        "--tls-ms", std::to_string(opt.tlsMs), "--join-ms", std::to_string(opt.joinMs),
+        "--deadline-ms", std::to_string(opt.deadlineS * 1000L), "--seed", std::to_string(opt.seed * 1000 + i)};
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      dup2(out[1], STDOUT_FILENO);
+      close(out[0]);
+      close(out[1]);
+      std::vector<char*> argvChild;
+      for (std::string& a : args) argvChild.push_back(&a[0]);
+      argvChild.push_back(nullptr);
+      execv(opt.bikeBin.c_str(), argvChild.data());
+      perror(opt.bikeBin.c_str());
+      _exit(127);
+    }
+    children.push_back(pid);
+  }
+  close(out[1]);
+
+  std::vector<std::string> reports;
+  std::string pending;
+  char buf[4096];
+  ssize_t n;
+  while ((n = read(out[0], buf, sizeof(buf))) > 0) {
+    pending.append(buf, n);
+    size_t nl;
+    while ((nl = pending.find('\n')) != std::string::npos) {
+      reports.push_back(pending.substr(0, nl));
+      pending.erase(0, nl + 1);
+    }
+  }
+  for (pid_t pid : children) waitpid(pid, nullptr, 0);
+
+  // ---- relatório ----
+  std::lock_guard<std::mutex> guard(eventsLock);
+  std::vector<long long> completion;
+  long long bytesOut = 0, bytesIn = 0, maxOut = 0, storedTotal = 0;
+  int unfinished = 0, extraCycles = 0, tlsTotal = 0;
+  for (const std::string& line : reports) {
+    long long arrive = field(line, "arrive_ms"), done = field(line, "done_ms");
+    if (done < 0) unfinished++;
+    else completion.push_back(done - arrive);
+    long long sent = field(line, "bytes_out");
+    bytesOut += sent;
+    bytesIn += field(line, "bytes_in");
+    maxOut = std::max(maxOut, sent);
+    storedTotal += field(line, "stored");
+    extraCycles += std::max(0LL, field(line, "cycles") - 1);
+    tlsTotal += field(line, "tls");
+  }
+
+  std::map<long long, int> perSecond, retriesPerSecond;
+  int ok = 0, failures = 0, retries = 0;
+  long long lastMs = 1;
+  for (const RequestEvent& e : events) {
+    perSecond[e.atMs / 1000]++;
+    if (e.status == 200) ok++;
+    else failures++;
+    if (e.retry) {
+      retries++;
+      retriesPerSecond[e.atMs / 1000]++;
+    }
+    lastMs = std::max(lastMs, e.atMs);
+  }
+  int peakRps = 0, peakRetryRps = 0;
+  for (auto& s : perSecond) peakRps = std::max(peakRps, s.second);
+  for (auto& s : retriesPerSecond) peakRetryRps = std::max(peakRetryRps, s.second);
+
+  int reported = std::max<int>(1, reports.size());
+  printf("\n=== Frota: %d bikes, chegada em %d s, backend %s ===\n", opt.bikes, opt.windowS, opt.backend.c_str());
+  printf("Servidor: latência %d+%d ms, falha %.1f%%, máx %d conexões\n", opt.latencyMs, opt.jitterMs,
+         opt.failRate * 100, opt.maxConcurrent);
+  printf("Requisições: %zu (ok %d, erro %d) | média %.1f req/s | pico %d req/s | pico simultâneo %d\n",
+         events.size(), ok, failures, events.size() * 1000.0 / lastMs, peakRps, peakInFlight.load());
+  printf("Retentativas: %d requisições após falha (pico %d req/s) | %d ciclos extras na base\n", retries,
+         peakRetryRps, extraCycles);
+  printf("Conclusão (chegada → tudo enviado): p50 %.1f s | p90 %.1f s | p99 %.1f s | máx %.1f s\n",
+         percentile(completion, 0.5), percentile(completion, 0.9), percentile(completion, 0.99),
+         percentile(completion, 1.0));
+  printf("Bikes sem concluir: %d de %zu\n", unfinished, reports.size());
+  printf("Por bike: %lld scans, envio %lld bytes (máx %lld), recebido %lld bytes, %.1f handshakes TLS\n",
+         storedTotal / reported, bytesOut / reported, maxOut, bytesIn / reported, (double)tlsTotal / reported);
+
+  printf("\nReq/s (# = 1 requisição, r = retentativa):\n");
+  for (auto& s : perSecond) {
+    int r = retriesPerSecond.count(s.first) ? retriesPerSecond[s.first] : 0;
+    printf("%4llds %4d %s%s\n", s.first, s.second, std::string(std::min(60, s.second - r), '#').c_str(),
+           std::string(std::min(20, r), 'r').c_str());
+  }
+  return unfinished == 0 ? 0 : 2;
+}
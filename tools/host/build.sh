@@ -0,0 +1,16 @@
+#!/bin/bash
+# Compila os benchmarks da camada host (g++ 7+). Saída em tools/host/build/
+set -e
+cd "$(dirname "$0")/../.."
+
+OUT=tools/host/build
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++17 -O2 -Wall -Wno-unused-parameter -pthread"
+mkdir -p "$OUT"
+
+# selectStrongest() x ordenação completa, com o firmware inteiro linkado
+$CXX $FLAGS -Itools/host/include -Itools/host -Isrc \
+    src/*.cpp tools/host/host_arduino.cpp tools/host/select_bench.cpp \
+    -o "$OUT/select_bench"
+
+echo "ok: $OUT/select_bench"
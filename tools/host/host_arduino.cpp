@@ -0,0 +1,726 @@
+// Implementação host da camada Arduino/ESP8266 de tools/host/include.
+// Um processo = um dispositivo: estado global, sem threads.
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <Updater.h>
+#include <WiFiClientSecure.h>
+#include <bearssl/bearssl_hash.h>
+#include <coredecls.h>
+
+#include "host_env.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+FS LittleFS;
+UpdaterClass Update;
+
+static HostStats stats;
+static std::string fsRoot = ".";
+static bool realtime = false;
+static uint64_t virtualMs = 0;
+static std::chrono::steady_clock::time_point realStart = std::chrono::steady_clock::now();
+static std::vector<HostNetwork> scanResult;
+static unsigned long joinDelay = 0;
+static int batteryAdc = 900;
+static std::string redirectHost;
+static int redirectPort = 0;
+static unsigned long tlsDelay = 0;
+static bool serialEcho = false;
+static std::function<void()> timeSetCallback;
+static HostFsObserver* fsObserver = nullptr;
+static std::string otaImagePath;
+
+HostStats& hostStats() { return stats; }
+void hostSetFsRoot(const std::string& dir) { fsRoot = dir; }
+void hostAdvance(unsigned long ms) { virtualMs += ms; }
+void hostSetScan(const std::vector<HostNetwork>& networks) { scanResult = networks; }
+void hostSetJoinDelay(unsigned long ms) { joinDelay = ms; }
+void hostSetBatteryAdc(int value) { batteryAdc = value; }
+void hostSetRedirect(const std::string& host, int port) { redirectHost = host; redirectPort = port; }
+void hostSetTlsDelay(unsigned long ms) { tlsDelay = ms; }
+void hostSetSerialEcho(bool echo) { serialEcho = echo; }
+void hostSetFsObserver(HostFsObserver* observer) { fsObserver = observer; }
+void hostSetOtaImagePath(const std::string& path) { otaImagePath = path; }
+
+static uint64_t realMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - realStart).count();
+}
+
+void hostSetRealtime(bool on) {
+  // Congela ou retoma a parte real sem saltos no millis()
+  if (on && !realtime) virtualMs -= realMs();
+  if (!on && realtime) virtualMs += realMs();
+  realtime = on;
+}
+
+// ---- tempo e pinos ----
+
+unsigned long millis() {
+  return (unsigned long)(realtime ? virtualMs + realMs() : virtualMs);
+}
+
+unsigned long micros() {
+  return millis() * 1000UL;
+}
+
+void delay(unsigned long ms) {
+  if (realtime) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  } else {
+    virtualMs += ms;
+  }
+}
+
+void yield() {
+  if (realtime) std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+int digitalRead(int) { return HIGH; }
+int analogRead(int) { return batteryAdc; }
+
+// SNTP: o relógio do host já está certo; avisa quando a rede sobe
+void configTime(int, int, const char*, const char*, const char*) {}
+void settimeofday_cb(std::function<void()> cb) { timeSetCallback = cb; }
+
+// ---- Serial ----
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (serialEcho) fputc(c, stderr);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* b, size_t n) {
+  if (serialEcho) fwrite(b, 1, n, stderr);
+  return n;
+}
+
+int HardwareSerial::available() { return 0; }
+int HardwareSerial::read() { return -1; }
+int HardwareSerial::peek() { return -1; }
+int HardwareSerial::availableForWrite() { return 128; }
+
+// ---- ESP ----
+
+static uint32_t rtcMemory[128];
+
+void EspClass::restart() {
+  fprintf(stderr, "[host] ESP.restart()\n");
+  exit(0);
+}
+
+// ~40 KB livres depois do boot, menos o que o firmware tem alocado agora
+// (host_heap.cpp, quando linkado)
+__attribute__((weak)) size_t hostHeapLive() { return 0; }
+__attribute__((weak)) void hostHeapSuspend(bool) {}
+
+uint32_t EspClass::getFreeHeap() {
+  size_t live = hostHeapLive();
+  return live < 40000 ? 40000 - live : 0;
+}
+
+// Tempo de CPU da thread, não de relógio: espera de rede e delay() não contam
+uint32_t EspClass::getCycleCount() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec) * 80 / 1000);
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset * 4 + size > sizeof(rtcMemory)) return false;
+  memcpy(data, rtcMemory + offset, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset * 4 + size > sizeof(rtcMemory)) return false;
+  memcpy(rtcMemory + offset, data, size);
+  return true;
+}
+
+// ---- Updater (OTA) ----
+
+// A imagem fica em memória até o end(); como no core, aceita binário cru
+// (0xE9) ou gzip (o eboot descompacta no boot seguinte)
+static std::string otaImage;
+
+bool UpdaterClass::begin(size_t size) {
+  expected = size;
+  written = 0;
+  error = UPDATE_ERROR_OK;
+  otaImage.clear();
+  if (size == 0 || size > ESP.getFreeSketchSpace()) {
+    error = UPDATE_ERROR_SPACE;
+    return false;
+  }
+  return true;
+}
+
+size_t UpdaterClass::writeStream(Stream& data) {
+  if (expected == 0 || hasError()) return 0;
+  uint8_t buf[1024];
+  size_t start = written;
+  while (written < expected) {
+    size_t n = data.readBytes(buf, std::min(sizeof(buf), expected - written));
+    if (n == 0) {
+      error = UPDATE_ERROR_STREAM;
+      break;
+    }
+    if (written == 0 && buf[0] != 0xE9 && buf[0] != 0x1F) {
+      error = UPDATE_ERROR_MAGIC_BYTE;
+      break;
+    }
+    otaImage.append((const char*)buf, n);
+    written += n;
+  }
+  return written - start;
+}
+
+bool UpdaterClass::end(bool evenIfRemaining) {
+  if (hasError() || (written != expected && !evenIfRemaining)) {
+    if (!hasError()) error = UPDATE_ERROR_SIZE;
+    expected = 0;
+    return false;
+  }
+  if (!otaImagePath.empty()) {
+    FILE* f = fopen(otaImagePath.c_str(), "wb");
+    if (f) {
+      fwrite(otaImage.data(), 1, otaImage.size(), f);
+      fclose(f);
+    }
+  }
+  fprintf(stderr, "[host] Update: %zu bytes gravados\n", written);
+  stats.otaInstalls++;
+  expected = 0;
+  return true;
+}
+
+// ---- SHA-256 (bearssl/bearssl_hash.h) ----
+
+static const uint32_t sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static void sha256Block(uint32_t* state, const uint8_t* block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t)block[4 * i] << 24 | block[4 * i + 1] << 16 | block[4 * i + 2] << 8 | block[4 * i + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t v[8];
+  memcpy(v, state, sizeof(v));
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = v[7] + (rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25)) + ((v[4] & v[5]) ^ (~v[4] & v[6])) +
+                  sha256K[i] + w[i];
+    uint32_t t2 = (rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22)) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+    memmove(v + 1, v, 7 * sizeof(uint32_t));
+    v[4] += t1;
+    v[0] = t1 + t2;
+  }
+  for (int i = 0; i < 8; i++) state[i] += v[i];
+}
+
+void br_sha256_init(br_sha256_context* ctx) {
+  static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  memcpy(ctx->state, initial, sizeof(initial));
+  ctx->count = 0;
+}
+
+void br_sha256_update(br_sha256_context* ctx, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (len > 0) {
+    size_t used = ctx->count % 64;
+    size_t n = std::min(len, 64 - used);
+    memcpy(ctx->buf + used, p, n);
+    ctx->count += n;
+    p += n;
+    len -= n;
+    if (used + n == 64) sha256Block(ctx->state, ctx->buf);
+  }
+}
+
+void br_sha256_out(const br_sha256_context* ctx, void* out) {
+  br_sha256_context copy = *ctx;
+  uint64_t bits = ctx->count * 8;
+  uint8_t pad[72] = {0x80};
+  size_t padLength = (copy.count % 64 < 56 ? 56 : 120) - copy.count % 64;
+  for (int i = 0; i < 8; i++) pad[padLength + i] = bits >> (56 - 8 * i);
+  br_sha256_update(&copy, pad, padLength + 8);
+  for (int i = 0; i < 32; i++) ((uint8_t*)out)[i] = copy.state[i / 4] >> (24 - 8 * (i % 4));
+}
+
+// ---- WiFi ----
+
+static WiFiMode_t wifiMode = WIFI_STA;
+static bool wifiConnected = false;
+static std::vector<HostNetwork> lastScan;
+
+bool ESP8266WiFiClass::mode(WiFiMode_t m) { wifiMode = m; return true; }
+WiFiMode_t ESP8266WiFiClass::getMode() { return wifiMode; }
+
+int8_t ESP8266WiFiClass::scanNetworks(bool, bool) {
+  lastScan = scanResult;
+  stats.scans++;
+  return (int8_t)std::min<size_t>(lastScan.size(), 127);
+}
+
+int8_t ESP8266WiFiClass::scanComplete() { return (int8_t)lastScan.size(); }
+void ESP8266WiFiClass::scanDelete() { lastScan.clear(); }
+String ESP8266WiFiClass::SSID(uint8_t i) { return i < lastScan.size() ? String(lastScan[i].ssid.c_str()) : String(); }
+String ESP8266WiFiClass::SSID() { return String(); }
+String ESP8266WiFiClass::BSSIDstr(uint8_t i) { return i < lastScan.size() ? String(lastScan[i].bssid.c_str()) : String(); }
+
+uint8_t* ESP8266WiFiClass::BSSID(uint8_t i) {
+  static uint8_t mac[6];
+  unsigned v[6] = {0};
+  if (i < lastScan.size()) sscanf(lastScan[i].bssid.c_str(), "%x:%x:%x:%x:%x:%x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+  for (int k = 0; k < 6; k++) mac[k] = v[k];
+  return mac;
+}
+
+int32_t ESP8266WiFiClass::RSSI(uint8_t i) { return i < lastScan.size() ? lastScan[i].rssi : 0; }
+int32_t ESP8266WiFiClass::RSSI() { return wifiConnected ? -60 : 31; }
+int32_t ESP8266WiFiClass::channel(uint8_t i) { return i < lastScan.size() ? lastScan[i].channel : 0; }
+uint8_t ESP8266WiFiClass::encryptionType(uint8_t i) { return i < lastScan.size() ? lastScan[i].encryption : 0; }
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char*) {
+  wifiConnected = false;
+  for (const HostNetwork& net : scanResult) {
+    if (net.ssid == ssid) wifiConnected = true;
+  }
+  if (wifiConnected) {
+    delay(joinDelay);
+    stats.wifiJoins++;
+    if (timeSetCallback) timeSetCallback();
+  }
+  return status();
+}
+
+wl_status_t ESP8266WiFiClass::status() { return wifiConnected ? WL_CONNECTED : WL_DISCONNECTED; }
+bool ESP8266WiFiClass::disconnect(bool) { wifiConnected = false; return true; }
+IPAddress ESP8266WiFiClass::localIP() { return wifiConnected ? IPAddress(192, 168, 4, 100) : IPAddress(); }
+IPAddress ESP8266WiFiClass::gatewayIP() { return wifiConnected ? IPAddress(192, 168, 4, 1) : IPAddress(); }
+IPAddress ESP8266WiFiClass::softAPIP() { return IPAddress(192, 168, 4, 1); }
+bool ESP8266WiFiClass::softAP(const char*, const char*, int, int, int) { wifiMode = WIFI_AP; return true; }
+uint8_t ESP8266WiFiClass::softAPgetStationNum() { return 0; }
+bool ESP8266WiFiClass::forceSleepBegin(uint32_t) { return true; }
+bool ESP8266WiFiClass::forceSleepWake() { return true; }
+String ESP8266WiFiClass::macAddress() { return String("5C:CF:7F:00:00:01"); }
+
+// ---- TCP ----
+
+// Cópias de WiFiClient compartilham o socket, como no core
+struct WiFiClient::Shared {
+  int fd = -1;
+  int refs = 1;
+  IPAddress remote;
+};
+
+WiFiClient::WiFiClient() {}
+
+WiFiClient::WiFiClient(const WiFiClient& other) : fd(other.fd), sh(other.sh) {
+  if (sh) sh->refs++;
+}
+
+WiFiClient& WiFiClient::operator=(const WiFiClient& other) {
+  if (this == &other) return *this;
+  if (sh && --sh->refs == 0) {
+    if (sh->fd >= 0) close(sh->fd);
+    delete sh;
+  }
+  sh = other.sh;
+  fd = other.fd;
+  if (sh) sh->refs++;
+  return *this;
+}
+
+WiFiClient::~WiFiClient() {
+  if (sh && --sh->refs == 0) {
+    if (sh->fd >= 0) close(sh->fd);
+    delete sh;
+  }
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  stop();
+  if (!wifiConnected && WiFi.getMode() != WIFI_AP) {
+    stats.netConnectFailures++;
+    return 0;
+  }
+
+  std::string target = redirectHost.empty() ? host : redirectHost;
+  int targetPort = redirectPort ? redirectPort : port;
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (getaddrinfo(target.c_str(), std::to_string(targetPort).c_str(), &hints, &res) != 0) {
+    stats.netConnectFailures++;
+    return 0;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 || ::connect(s, res->ai_addr, res->ai_addrlen) < 0) {
+    if (s >= 0) close(s);
+    freeaddrinfo(res);
+    stats.netConnectFailures++;
+    return 0;
+  }
+  int one = 1;
+  setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  sh = new Shared();
+  sh->fd = s;
+  sh->remote.fromString(inet_ntoa(((sockaddr_in*)res->ai_addr)->sin_addr));
+  fd = s;
+  freeaddrinfo(res);
+  stats.netConnects++;
+  return 1;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* b, size_t n) {
+  if (!sh || sh->fd < 0) return 0;
+  size_t sent = 0;
+  while (sent < n) {
+    ssize_t r = send(sh->fd, b + sent, n - sent, MSG_NOSIGNAL);
+    if (r <= 0) break;
+    sent += r;
+  }
+  stats.netBytesOut += sent;
+  return sent;
+}
+
+int WiFiClient::available() {
+  if (!sh || sh->fd < 0) return 0;
+  int n = 0;
+  ioctl(sh->fd, FIONREAD, &n);
+  return n;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* b, size_t n) {
+  if (!sh || sh->fd < 0) return -1;
+  ssize_t r = recv(sh->fd, b, n, MSG_DONTWAIT);
+  if (r <= 0) return -1;
+  stats.netBytesIn += r;
+  return (int)r;
+}
+
+int WiFiClient::peek() {
+  if (!sh || sh->fd < 0) return -1;
+  uint8_t c;
+  return recv(sh->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+uint8_t WiFiClient::connected() {
+  if (!sh || sh->fd < 0) return 0;
+  if (available() > 0) return 1;
+  uint8_t c;
+  ssize_t r = recv(sh->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return r != 0; // 0 = o outro lado fechou
+}
+
+void WiFiClient::stop() {
+  if (sh && sh->fd >= 0) {
+    close(sh->fd);
+    sh->fd = -1;
+  }
+  fd = -1;
+}
+
+IPAddress WiFiClient::remoteIP() {
+  return sh ? sh->remote : IPAddress();
+}
+
+// Servidor em 0.0.0.0:porta (gateway); available() não bloqueia
+void WiFiServer::begin() {
+  stop();
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (s < 0 || bind(s, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(s, 16) < 0) {
+    if (s >= 0) close(s);
+    return;
+  }
+  fcntl(s, F_SETFL, O_NONBLOCK);
+  fd = s;
+}
+
+WiFiClient WiFiServer::available() {
+  WiFiClient client;
+  if (fd < 0) return client;
+  sockaddr_in addr = {};
+  socklen_t length = sizeof(addr);
+  int s = ::accept(fd, (sockaddr*)&addr, &length);
+  if (s < 0) return client;
+  int one = 1;
+  setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  client.sh = new WiFiClient::Shared();
+  client.sh->fd = s;
+  client.sh->remote.fromString(inet_ntoa(addr.sin_addr));
+  client.fd = s;
+  return client;
+}
+
+void WiFiServer::stop() {
+  if (fd >= 0) close(fd);
+  fd = -1;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+  if (!WiFiClient::connect(host, port)) return 0;
+  delay(tlsDelay);
+  stats.tlsHandshakes++;
+  return 1;
+}
+
+// ---- LittleFS sobre um diretório do host ----
+
+struct HostFileImpl {
+  FILE* fp;
+  std::string name;
+  int refs;
+  std::string path; // com a barra, como o firmware abriu
+  bool writing;
+};
+
+static std::string hostPath(const char* path) {
+  return fsRoot + (path[0] == '/' ? "" : "/") + path;
+}
+
+File::File(const File& other) : Stream(), impl(other.impl) {
+  if (impl) impl->refs++;
+}
+
+File& File::operator=(const File& other) {
+  if (this == &other) return *this;
+  close();
+  impl = other.impl;
+  if (impl) impl->refs++;
+  return *this;
+}
+
+File::~File() { close(); }
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t* b, size_t n) {
+  if (!impl) return 0;
+  // O flash simulado pode estar cheio: falha como o LittleFS do aparelho
+  if (fsObserver && impl->writing && !fsObserver->wrote(impl->path, b, n)) return 0;
+  size_t w = fwrite(b, 1, n, impl->fp);
+  stats.fsBytesWritten += w;
+  return w;
+}
+
+int File::available() {
+  if (!impl) return 0;
+  long pos = ftell(impl->fp);
+  return (int)(size() - pos);
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* b, size_t n) {
+  if (!impl) return 0;
+  size_t r = fread(b, 1, n, impl->fp);
+  stats.fsBytesRead += r;
+  return r;
+}
+
+int File::peek() {
+  if (!impl) return -1;
+  int c = fgetc(impl->fp);
+  if (c != EOF) ungetc(c, impl->fp);
+  return c == EOF ? -1 : c;
+}
+
+String File::readString() {
+  String r;
+  char buf[512];
+  size_t n;
+  while ((n = read((uint8_t*)buf, sizeof(buf))) > 0) r.concat(buf, n);
+  return r;
+}
+
+String File::readStringUntil(char t) {
+  String r;
+  int c;
+  while ((c = read()) >= 0 && c != t) r += (char)c;
+  return r;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!impl) return false;
+  return fseek(impl->fp, pos, mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END) == 0;
+}
+
+size_t File::position() const { return impl ? ftell(impl->fp) : 0; }
+
+size_t File::size() const {
+  if (!impl) return 0;
+  fflush(impl->fp);
+  struct stat st;
+  return fstat(fileno(impl->fp), &st) == 0 ? st.st_size : 0;
+}
+
+void File::close() {
+  if (impl && --impl->refs == 0) {
+    fclose(impl->fp);
+    if (fsObserver && impl->writing) fsObserver->closed(impl->path);
+    delete impl;
+  }
+  impl = nullptr;
+}
+
+const char* File::name() const { return impl ? impl->name.c_str() : ""; }
+
+bool Dir::next() {
+  // Lista uma vez só: com milhares de arquivos (semana offline), reler a cada
+  // next() fica quadrático. A foto é coisa do host e fica fora da conta de
+  // heap do firmware.
+  if (!listing) {
+    hostHeapSuspend(true);
+    listing = std::make_shared<std::vector<std::string>>();
+    if (DIR* d = opendir(fsRoot.c_str())) {
+      while (dirent* e = readdir(d)) {
+        if (e->d_name[0] != '.') listing->push_back(e->d_name);
+      }
+      closedir(d);
+    }
+    std::sort(listing->begin(), listing->end());
+    hostHeapSuspend(false);
+  }
+
+  // Pula o que foi apagado depois da foto
+  struct stat st;
+  while (++index < (int)listing->size()) {
+    const std::string& name = (*listing)[index];
+    if (stat(hostPath(name.c_str()).c_str(), &st) != 0) continue;
+    current = String(name.c_str());
+    currentSize = st.st_size;
+    return true;
+  }
+  return false;
+}
+
+Dir::~Dir() {
+  hostHeapSuspend(true);
+  listing.reset();
+  hostHeapSuspend(false);
+}
+
+String Dir::fileName() const { return current; }
+size_t Dir::fileSize() const { return currentSize; }
+File Dir::openFile(const char* mode) { return LittleFS.open(("/" + current).c_str(), mode); }
+
+bool FS::begin() {
+  for (size_t pos = 1; pos != std::string::npos; pos = fsRoot.find('/', pos + 1)) {
+    mkdir(fsRoot.substr(0, pos).c_str(), 0755);
+  }
+  mkdir(fsRoot.c_str(), 0755);
+  struct stat st;
+  return stat(fsRoot.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool FS::format() {
+  Dir dir = openDir("/");
+  while (dir.next()) remove(("/" + dir.fileName()).c_str());
+  return true;
+}
+
+bool FS::info(FSInfo& i) {
+  memset(&i, 0, sizeof(i));
+  i.totalBytes = 2 * 1024 * 1024 - 8192;
+  i.blockSize = 8192;
+  i.pageSize = 256;
+  i.maxOpenFiles = 5;
+  i.maxPathLength = 32;
+  Dir dir = openDir("/");
+  while (dir.next()) i.usedBytes += (dir.fileSize() + i.blockSize - 1) / i.blockSize * i.blockSize;
+  return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+  std::string full = hostPath(path);
+  bool creating = mode[0] != 'r' && access(full.c_str(), F_OK) != 0;
+  const char* fmode = mode[0] == 'r' ? (mode[1] == '+' ? "r+b" : "rb") : mode[0] == 'a' ? "ab" : "wb";
+  FILE* fp = fopen(full.c_str(), fmode);
+  if (!fp) return File();
+  std::string withSlash = path[0] == '/' ? path : "/" + std::string(path);
+  bool writing = mode[0] != 'r' || mode[1] == '+';
+  if (fsObserver && writing && !fsObserver->opened(withSlash, mode, creating)) {
+    fclose(fp);
+    if (creating) ::remove(full.c_str());
+    return File();
+  }
+  if (creating) stats.fsFilesCreated++;
+  const char* base = strrchr(path, '/');
+  return File(new HostFileImpl{fp, base ? base + 1 : path, 1, withSlash, writing});
+}
+
+bool FS::exists(const char* path) { return access(hostPath(path).c_str(), F_OK) == 0; }
+
+bool FS::remove(const char* path) {
+  bool ok = ::remove(hostPath(path).c_str()) == 0;
+  if (ok) stats.fsFilesRemoved++;
+  if (ok && fsObserver) fsObserver->removed(path[0] == '/' ? path : "/" + std::string(path));
+  return ok;
+}
+
+bool FS::rename(const char* a, const char* b) {
+  bool ok = ::rename(hostPath(a).c_str(), hostPath(b).c_str()) == 0;
+  if (ok && fsObserver) {
+    fsObserver->renamed(a[0] == '/' ? a : "/" + std::string(a), b[0] == '/' ? b : "/" + std::string(b));
+  }
+  return ok;
+}
+Dir FS::openDir(const char* path) { return Dir(String(path)); }
@@ -0,0 +1,80 @@
+#ifndef HOST_ENV_H
+#define HOST_ENV_H
+
+// Controle do ambiente simulado pela camada host (tools/host/include):
+// relógio, rádio, flash e rede vistos pelo src/ rodando no PC.
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct HostNetwork {
+  std::string ssid;
+  std::string bssid;
+  int rssi;
+  int channel;
+  int encryption;
+};
+
+struct HostStats {
+  uint64_t netBytesOut = 0;   // bytes enviados por WiFiClient/WiFiClientSecure
+  uint64_t netBytesIn = 0;
+  uint32_t netConnects = 0;
+  uint32_t netConnectFailures = 0;
+  uint32_t tlsHandshakes = 0;
+  uint32_t wifiJoins = 0;     // WiFi.begin() bem-sucedidos
+  uint32_t scans = 0;
+  uint64_t fsBytesWritten = 0;
+  uint64_t fsBytesRead = 0;
+  uint32_t fsFilesCreated = 0;
+  uint32_t fsFilesRemoved = 0;
+  uint32_t otaInstalls = 0;   // Update.end() bem-sucedidos
+};
+
+// Arquivos do LittleFS ficam neste diretório do host
+void hostSetFsRoot(const std::string& dir);
+
+// Relógio: millis() = tempo virtual acumulado + tempo real (se realtime).
+// Com realtime desligado, delay() só avança o relógio virtual.
+void hostAdvance(unsigned long ms);
+void hostSetRealtime(bool realtime);
+
+// Resultado do próximo WiFi.scanNetworks(); WiFi.begin() só conecta em SSIDs daqui
+void hostSetScan(const std::vector<HostNetwork>& networks);
+void hostSetJoinDelay(unsigned long ms);
+void hostSetBatteryAdc(int value);
+
+// Todas as conexões TCP vão para este endereço; TLS vira TCP simples com
+// um atraso fixo de handshake (o custo real no ESP8266 é de ~1-2 s)
+void hostSetRedirect(const std::string& host, int port);
+void hostSetTlsDelay(unsigned long ms);
+
+// Espelho das escritas no LittleFS, para medir o custo num flash simulado
+// (tools/flashbench). Leituras não passam por aqui.
+struct HostFsObserver {
+  virtual ~HostFsObserver() {}
+  virtual bool opened(const std::string& path, const char* mode, bool created) { return true; }
+  virtual bool wrote(const std::string& path, const uint8_t* data, size_t length) { return true; } // false = sem espaço
+  virtual void closed(const std::string& path) {}
+  virtual void removed(const std::string& path) {}
+  virtual void renamed(const std::string& from, const std::string& to) {}
+};
+void hostSetFsObserver(HostFsObserver* observer);
+
+// Imagem gravada pelo Updater (OTA) vai para este arquivo do host; vazio = descartada
+void hostSetOtaImagePath(const std::string& path);
+
+// Saída do Serial (logs): stderr ou descartada
+void hostSetSerialEcho(bool echo);
+
+HostStats& hostStats();
+
+// Heap (só com tools/host/host_heap.cpp linkado): conta as alocações da
+// thread que chamou hostHeapTrackThread(); getFreeHeap() = 40 KB - vivo
+void hostHeapTrackThread();
+void hostHeapSuspend(bool suspend); // alocações da própria camada host
+void hostHeapResetPeak();
+long long hostHeapPeak();
+size_t hostHeapLive();
+
+#endif
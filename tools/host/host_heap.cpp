@@ -0,0 +1,54 @@
+// Contabilidade de heap do firmware no host: new/delete e malloc/free
+// (via -Wl,--wrap=malloc,--wrap=free) da thread marcada com
+// hostHeapTrackThread(). Threads de servidor falso ficam de fora.
+
+#include "host_env.h"
+
+#include <malloc.h>
+#include <cstdlib>
+#include <new>
+
+extern "C" void* __real_malloc(size_t);
+extern "C" void __real_free(void*);
+
+static thread_local bool tracked = false;
+static thread_local int suspended = 0;
+static long long live = 0;
+static long long peak = 0;
+
+static void* counted(void* p) {
+  if (p && tracked && !suspended) {
+    live += malloc_usable_size(p);
+    if (live > peak) peak = live;
+  }
+  return p;
+}
+
+static void uncount(void* p) {
+  if (p && tracked && !suspended) live -= malloc_usable_size(p);
+}
+
+void hostHeapTrackThread() { tracked = true; }
+void hostHeapSuspend(bool on) { suspended += on ? 1 : -1; }
+void hostHeapResetPeak() { peak = live; }
+long long hostHeapPeak() { return peak; }
+size_t hostHeapLive() { return live > 0 ? live : 0; }
+
+extern "C" void* __wrap_malloc(size_t size) { return counted(__real_malloc(size)); }
+
+extern "C" void __wrap_free(void* p) {
+  uncount(p);
+  __real_free(p);
+}
+
+void* operator new(size_t size) {
+  void* p = counted(__real_malloc(size ? size : 1));
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { __wrap_free(p); }
+void operator delete[](void* p) noexcept { __wrap_free(p); }
+void operator delete(void* p, size_t) noexcept { __wrap_free(p); }
+void operator delete[](void* p, size_t) noexcept { __wrap_free(p); }
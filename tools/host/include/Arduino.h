@@ -0,0 +1,164 @@
+#pragma once
+// Camada mínima do core Arduino/ESP8266 para compilar o src/ no host
+// (simulador de frota, replay de traces). Só o que o firmware usa.
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#define PI 3.1415926535897932384626433832795
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LED_BUILTIN 2
+#define A0 17
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(s) (s)
+#define vsnprintf_P vsnprintf
+#define snprintf_P snprintf
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define PGM_P const char*
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+using std::min; using std::max;
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+typedef bool boolean;
+typedef uint8_t byte;
+unsigned long millis();
+void configTime(int tz, int dst, const char* s1, const char* s2 = nullptr, const char* s3 = nullptr);
+unsigned long micros();
+void delay(unsigned long);
+void yield();
+void pinMode(int,int);
+void digitalWrite(int,int);
+int digitalRead(int);
+int analogRead(int);
+class __FlashStringHelper;
+class String {
+ public:
+  std::string s;
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& x) : s(x) {}
+  String(char c) : s(1, c) {}
+  String(int v) : s(std::to_string(v)) {}
+  String(unsigned v) : s(std::to_string(v)) {}
+  String(long v) : s(std::to_string(v)) {}
+  String(unsigned long v) : s(std::to_string(v)) {}
+  String(long long v) : s(std::to_string(v)) {}
+  String(unsigned long long v) : s(std::to_string(v)) {}
+  String(float v, unsigned char d = 2) { char b[32]; snprintf(b, 32, "%.*f", d, v); s = b; }
+  String(double v, unsigned char d = 2) { char b[32]; snprintf(b, 32, "%.*f", d, v); s = b; }
+  unsigned int length() const { return s.size(); }
+  const char* c_str() const { return s.c_str(); }
+  bool reserve(unsigned n) { s.reserve(n); return true; }
+  String& operator+=(const String& o) { s += o.s; return *this; }
+  String& operator+=(const char* o) { s += o; return *this; }
+  String& operator+=(char o) { s += o; return *this; }
+  String& operator+=(int o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned o) { s += std::to_string(o); return *this; }
+  String& operator+=(long o) { s += std::to_string(o); return *this; }
+  String& operator+=(unsigned long o) { s += std::to_string(o); return *this; }
+  bool concat(const char* c, unsigned n) { s.append(c, n); return true; }
+  bool concat(const String& o) { s += o.s; return true; }
+  bool concat(char c) { s += c; return true; }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator==(const char* o) const { return s == o; }
+  bool operator!=(const String& o) const { return s != o.s; }
+  bool operator!=(const char* o) const { return s != o; }
+  char operator[](unsigned i) const { return i < s.size() ? s[i] : 0; }
+  char charAt(unsigned i) const { return (*this)[i]; }
+  int indexOf(char c, unsigned from = 0) const { auto p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const String& c, unsigned from = 0) const { auto p = s.find(c.s, from); return p == std::string::npos ? -1 : (int)p; }
+  int lastIndexOf(char c) const { auto p = s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+  String substring(unsigned a) const { return a >= s.size() ? String() : String(s.substr(a)); }
+  String substring(unsigned a, unsigned b) const { if (b > s.size()) b = s.size(); if (a >= b) return String(); return String(s.substr(a, b - a)); }
+  bool startsWith(const String& p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+  bool endsWith(const String& p) const { return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0; }
+  void replace(const String& a, const String& b) { if (a.s.empty()) return; size_t p = 0; while ((p = s.find(a.s, p)) != std::string::npos) { s.replace(p, a.s.size(), b.s); p += b.s.size(); } }
+  void trim() { size_t a = s.find_first_not_of(" \t\r\n"); size_t b = s.find_last_not_of(" \t\r\n"); s = a == std::string::npos ? "" : s.substr(a, b - a + 1); }
+  void toLowerCase() { for (auto& c : s) c = tolower(c); }
+  void toUpperCase() { for (auto& c : s) c = toupper(c); }
+  long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s.c_str(), nullptr); }
+  double toDouble() const { return strtod(s.c_str(), nullptr); }
+  void toCharArray(char* buf, unsigned n) const { if (!n) return; size_t l = std::min<size_t>(n - 1, s.size()); memcpy(buf, s.data(), l); buf[l] = 0; }
+  void remove(unsigned i) { if (i < s.size()) s.erase(i); }
+  void remove(unsigned i, unsigned n) { if (i < s.size()) s.erase(i, n); }
+  bool isEmpty() const { return s.empty(); }
+  friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+  friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+  friend String operator+(const String& a, char b) { return String(a.s + b); }
+};
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* b, size_t n) { size_t r = 0; while (n--) r += write(*b++); return r; }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+  virtual int availableForWrite() { return 256; }
+  virtual void flush() {}
+  size_t print(const String& s) { return write(s.c_str(), s.length()); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned v) { return print(String(v)); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(double v, int d = 2) { return print(String(v, d)); }
+  size_t println() { return print("\r\n"); }
+  template <typename T> size_t println(const T& v) { size_t r = print(v); return r + println(); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) { char buf[1024]; va_list ap; va_start(ap, fmt); int n = vsnprintf(buf, sizeof(buf), fmt, ap); va_end(ap); return write(buf, std::min<int>(n, sizeof(buf) - 1)); }
+  size_t printf_P(const char* fmt, ...) { char buf[1024]; va_list ap; va_start(ap, fmt); int n = vsnprintf(buf, sizeof(buf), fmt, ap); va_end(ap); return write(buf, std::min<int>(n, sizeof(buf) - 1)); }
+};
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  unsigned long _timeout = 1000;
+  void setTimeout(unsigned long t) { _timeout = t; }
+  size_t readBytes(uint8_t* b, size_t n) { size_t r = 0; while (r < n) { int c = timedRead(); if (c < 0) break; b[r++] = c; } return r; }
+  size_t readBytes(char* b, size_t n) { return readBytes((uint8_t*)b, n); }
+  // Como no core: espera até _timeout ms por cada byte
+  int timedRead() { unsigned long start = millis(); do { int c = read(); if (c >= 0) return c; yield(); } while (millis() - start < _timeout); return -1; }
+  String readString() { String r; int c; while ((c = timedRead()) >= 0) r += (char)c; return r; }
+  String readStringUntil(char t) { String r; int c; while ((c = timedRead()) >= 0 && c != t) r += (char)c; return r; }
+};
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* b, size_t n) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  int availableForWrite() override;
+};
+extern HardwareSerial Serial;
+class EspClass {
+ public:
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getChipId() { return 0x123456; }
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+  uint32_t getFreeSketchSpace() { return 1 << 20; }
+  String getResetReason() { return "Power On"; }
+  uint32_t getCycleCount();
+};
+extern EspClass ESP;
@@ -0,0 +1,38 @@
+#pragma once
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 };
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+class ESP8266WiFiClass {
+ public:
+  bool mode(WiFiMode_t m);
+  WiFiMode_t getMode();
+  int8_t scanNetworks(bool async = false, bool show_hidden = false);
+  int8_t scanComplete();
+  void scanDelete();
+  String SSID(uint8_t i);
+  String SSID();
+  String BSSIDstr(uint8_t i);
+  uint8_t* BSSID(uint8_t i);
+  int32_t RSSI(uint8_t i);
+  int32_t RSSI();
+  int32_t channel(uint8_t i);
+  uint8_t encryptionType(uint8_t i);
+  wl_status_t begin(const char* ssid, const char* pass = nullptr);
+  wl_status_t status();
+  bool disconnect(bool wifioff = false);
+  bool isConnected() { return status() == WL_CONNECTED; }
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress softAPIP();
+  bool softAP(const char* ssid, const char* pass = nullptr, int channel = 1, int hidden = 0, int max_connection = 4);
+  uint8_t softAPgetStationNum();
+  bool setAutoReconnect(bool) { return true; }
+  bool forceSleepBegin(uint32_t us = 0);
+  bool forceSleepWake();
+  String macAddress();
+};
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,49 @@
+#pragma once
+#include "ESP8266WiFi.h"
+#include "FS.h"
+#include <functional>
+// Só para compilar src/ no host: as rotas são registradas, nunca chamadas
+typedef enum { HTTP_GET = 0b00000001, HTTP_POST = 0b00000010, HTTP_ANY = 0b01111111 } WebRequestMethod;
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+class AsyncWebParameter {
+ public:
+  const String& value() const { return _value; }
+  String _value;
+};
+class AsyncWebServerResponse {
+ public:
+  virtual ~AsyncWebServerResponse() {}
+  void addHeader(const String&, const String&) {}
+};
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+ public:
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t n) override { return n; }
+  using Print::write;
+};
+typedef std::function<String(const String&)> AwsTemplateProcessor;
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+typedef std::function<void()> ArDisconnectHandler;
+class AsyncWebServerRequest {
+ public:
+  void send(int, const String& = String(), const String& = String()) {}
+  void send(AsyncWebServerResponse* response) { delete response; }
+  void send(FS&, const String&, const String& = String(), bool = false) {}
+  void send_P(int, const String&, PGM_P, AwsTemplateProcessor = nullptr) {}
+  AsyncWebServerResponse* beginResponse(int, const String& = String(), const String& = String()) { return new AsyncWebServerResponse(); }
+  AsyncWebServerResponse* beginResponse(FS&, const String&, const String& = String(), bool = false) { return new AsyncWebServerResponse(); }
+  AsyncWebServerResponse* beginResponse_P(int, const String&, PGM_P, AwsTemplateProcessor = nullptr) { return new AsyncWebServerResponse(); }
+  AsyncWebServerResponse* beginChunkedResponse(const String&, AwsResponseFiller, AwsTemplateProcessor = nullptr) { return new AsyncWebServerResponse(); }
+  AsyncResponseStream* beginResponseStream(const String&, size_t = 1460) { return new AsyncResponseStream(); }
+  bool hasParam(const String&, bool = false, bool = false) const { return false; }
+  AsyncWebParameter* getParam(const String&, bool = false, bool = false) const { return nullptr; }
+  void onDisconnect(ArDisconnectHandler) {}
+};
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+class AsyncWebServer {
+ public:
+  explicit AsyncWebServer(uint16_t) {}
+  void begin() {}
+  void on(const char*, WebRequestMethod, ArRequestHandlerFunction) {}
+  void onNotFound(ArRequestHandlerFunction) {}
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include "Arduino.h"
+#include <memory>
+#include <string>
+#include <vector>
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+struct FSInfo { size_t totalBytes; size_t usedBytes; size_t blockSize; size_t pageSize; size_t maxOpenFiles; size_t maxPathLength; };
+struct HostFileImpl;
+class File : public Stream {
+ public:
+  File() {}
+  explicit File(HostFileImpl* p) : impl(p) {}
+  File(const File&);
+  File& operator=(const File&);
+  ~File();
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* b, size_t n) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t read(uint8_t* b, size_t n);
+  String readString(); // até o fim do arquivo, sem timeout
+  String readStringUntil(char t);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  void flush() override {}
+  const char* name() const;
+  operator bool() const { return impl != nullptr; }
+ private:
+  HostFileImpl* impl = nullptr;
+};
+class Dir {
+ public:
+  Dir() {}
+  explicit Dir(const String& p) : prefix(p) {}
+  ~Dir();
+  bool next();
+  String fileName() const;
+  size_t fileSize() const;
+  bool isFile() const { return true; }
+  bool isDirectory() const { return false; }
+  File openFile(const char* mode);
+ private:
+  String prefix;
+  String current;
+  size_t currentSize = 0;
+  int index = -1;
+  std::shared_ptr<std::vector<std::string>> listing; // foto do diretório no 1º next()
+};
+class FS {
+ public:
+  bool begin();
+  void end() {}
+  bool format();
+  bool info(FSInfo& i);
+  File open(const char* path, const char* mode);
+  File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* a, const char* b);
+  bool rename(const String& a, const String& b) { return rename(a.c_str(), b.c_str()); }
+  Dir openDir(const char* path);
+  Dir openDir(const String& path) { return openDir(path.c_str()); }
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include "Arduino.h"
+class IPAddress {
+ public:
+  uint8_t b[4] = {0, 0, 0, 0};
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t c, uint8_t d, uint8_t e) { b[0] = a; b[1] = c; b[2] = d; b[3] = e; }
+  String toString() const { char s[16]; snprintf(s, 16, "%u.%u.%u.%u", b[0], b[1], b[2], b[3]); return String(s); }
+  bool fromString(const char* s) { unsigned v[4]; if (sscanf(s, "%u.%u.%u.%u", &v[0], &v[1], &v[2], &v[3]) != 4) return false; for (int i = 0; i < 4; i++) b[i] = v[i]; return true; }
+  uint8_t operator[](int i) const { return b[i]; }
+  bool isSet() const { return b[0] || b[1] || b[2] || b[3]; }
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "Arduino.h"
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_STREAM 6
+#define UPDATE_ERROR_MAGIC_BYTE 10
+class UpdaterClass {
+ public:
+  bool begin(size_t size);
+  size_t writeStream(Stream& data);
+  bool end(bool evenIfRemaining = false);
+  uint8_t getError() { return error; }
+  bool hasError() { return error != UPDATE_ERROR_OK; }
+  size_t progress() { return written; }
+ private:
+  size_t expected = 0;
+  size_t written = 0;
+  uint8_t error = UPDATE_ERROR_OK;
+};
+extern UpdaterClass Update;
@@ -0,0 +1,40 @@
+#pragma once
+#include "Arduino.h"
+#include "IPAddress.h"
+class WiFiClient : public Stream {
+ public:
+  WiFiClient();
+  WiFiClient(const WiFiClient&);
+  WiFiClient& operator=(const WiFiClient&);
+  virtual ~WiFiClient();
+  virtual int connect(const char* host, uint16_t port);
+  int connect(const String& host, uint16_t port) { return connect(host.c_str(), port); }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* b, size_t n) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(uint8_t* b, size_t n);
+  int peek() override;
+  uint8_t connected();
+  void stop();
+  void setNoDelay(bool) {}
+  void setInsecure() {}
+  IPAddress remoteIP();
+  operator bool() { return connected(); }
+  int fd = -1;
+ protected:
+  friend class WiFiServer;
+  struct Shared;
+  Shared* sh = nullptr;
+};
+class WiFiServer {
+ public:
+  explicit WiFiServer(uint16_t port) : port(port) {}
+  void begin();
+  WiFiClient available();
+  WiFiClient accept() { return available(); }
+  void stop();
+  uint16_t port;
+  int fd = -1;
+};
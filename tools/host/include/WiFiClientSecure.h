@@ -0,0 +1,9 @@
+#pragma once
+#include "WiFiClient.h"
+class WiFiClientSecure : public WiFiClient {
+ public:
+  int connect(const char* host, uint16_t port) override;
+  using WiFiClient::connect;
+  void setInsecure() {}
+  void setBufferSizes(int, int) {}
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#define br_sha256_SIZE 32
+typedef struct {
+  uint32_t state[8];
+  uint64_t count;
+  uint8_t buf[64];
+} br_sha256_context;
+void br_sha256_init(br_sha256_context* ctx);
+void br_sha256_update(br_sha256_context* ctx, const void* data, size_t len);
+void br_sha256_out(const br_sha256_context* ctx, void* out);
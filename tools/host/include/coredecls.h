@@ -0,0 +1,3 @@
+#pragma once
+#include <functional>
+void settimeofday_cb(std::function<void()> cb);
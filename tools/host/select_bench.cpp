@@ -0,0 +1,106 @@
+// Benchmark de selectStrongest() (seleção parcial O(N*K)) contra separar as
+// redes próprias e ordenar tudo, nos tamanhos do firmware: N <= 30 redes por
+// scan (perfil survey-max guarda até 48), K = 3, 5 e 10.
+//
+//   tools/host/build.sh && tools/host/build/select_bench [--iterations 200000]
+//
+// Confere também que os dois devolvem as mesmas K redes, na mesma ordem de RSSI.
+
+#include <Arduino.h>
+#include "config.h"
+#include "wifi_scanner.h"
+#include "host_env.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static int sortStrongest(WiFiNetwork* nets, int count, int k) {
+  WiFiNetwork* own = std::stable_partition(nets, nets + count, [](const WiFiNetwork& n) {
+    return !isOwnNetwork(n.ssid);
+  });
+  int candidates = own - nets;
+  std::sort(nets, own, [](const WiFiNetwork& a, const WiFiNetwork& b) { return a.rssi > b.rssi; });
+  return std::min(k, candidates);
+}
+
+// Scan sintético: RSSI uniforme em -95..-30, uma base e uma bike por scan
+static std::vector<WiFiNetwork> makeScan(std::mt19937& rng, int n) {
+  std::vector<WiFiNetwork> nets(n);
+  std::uniform_int_distribution<int> rssi(-95, -30);
+  for (int i = 0; i < n; i++) {
+    WiFiNetwork& net = nets[i];
+    memset(&net, 0, sizeof(net));
+    if (i == n / 3) snprintf(net.ssid, sizeof(net.ssid), "%s", config.baseSSID1);
+    else if (i == 2 * n / 3) snprintf(net.ssid, sizeof(net.ssid), "Bike-%d", i);
+    else snprintf(net.ssid, sizeof(net.ssid), "Rede-%d", i);
+    snprintf(net.bssid, sizeof(net.bssid), "5C:CF:7F:00:00:%02X", i & 0xFF);
+    net.rssi = rssi(rng);
+    net.channel = 1 + i % 13;
+  }
+  return nets;
+}
+
+template <typename Select>
+static double nsPerCall(Select select, const std::vector<std::vector<WiFiNetwork>>& scans, int k, long iterations) {
+  WiFiNetwork work[64];
+  volatile int sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iterations; i++) {
+    const std::vector<WiFiNetwork>& scan = scans[i % scans.size()];
+    memcpy(work, scan.data(), scan.size() * sizeof(WiFiNetwork));
+    sink += select(work, (int)scan.size(), k);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  (void)sink;
+  return elapsed.count() / iterations;
+}
+
+static bool sameSelection(const std::vector<WiFiNetwork>& scan, int k) {
+  WiFiNetwork a[64], b[64];
+  memcpy(a, scan.data(), scan.size() * sizeof(WiFiNetwork));
+  memcpy(b, scan.data(), scan.size() * sizeof(WiFiNetwork));
+  int n = selectStrongest(a, (int)scan.size(), k);
+  if (n != sortStrongest(b, (int)scan.size(), k)) return false;
+  for (int i = 0; i < n; i++) {
+    if (a[i].rssi != b[i].rssi) return false; // empates podem trocar de lugar
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  long iterations = 200000;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = atol(argv[++i]);
+    } else {
+      fprintf(stderr, "uso: %s [--iterations 200000]\n", argv[0]);
+      return 1;
+    }
+  }
+  hostSetSerialEcho(false);
+  snprintf(config.baseSSID1, sizeof(config.baseSSID1), "VALENCA");
+
+  std::mt19937 rng(42);
+  printf("%4s %4s %14s %14s %8s\n", "N", "K", "seleção ns", "sort ns", "ganho");
+  for (int n : {5, 10, 20, 30}) {
+    std::vector<std::vector<WiFiNetwork>> scans;
+    for (int s = 0; s < 64; s++) scans.push_back(makeScan(rng, n));
+    for (int k : {3, 5, 10}) {
+      for (const auto& scan : scans) {
+        if (!sameSelection(scan, k)) {
+          fprintf(stderr, "seleção diferente do sort: N=%d K=%d\n", n, k);
+          return 1;
+        }
+      }
+      double partial = nsPerCall(selectStrongest, scans, k, iterations);
+      double sorted = nsPerCall(sortStrongest, scans, k, iterations);
+      printf("%4d %4d %14.1f %14.1f %7.2fx\n", n, k, partial, sorted, sorted / partial);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+"""Publica um firmware para o OTA das bikes (src/ota.h).
+
+Compacta o .bin com gzip (o Updater do ESP8266 grava a imagem gzip e o
+eboot descompacta no boot) e escreve o manifesto que a bike lê em
+/firmware/manifest.txt: versão, caminho da imagem, tamanho e SHA-256.
+O diretório de saída é o que o coletor serve com --firmware.
+
+    pio run -e nodemcuv2
+    python3 tools/ota_release.py .pio/build/nodemcuv2/firmware.bin 1.1.0 firmware/
+
+A versão tem que ser a mesma do FIRMWARE_VERSION do build, senão as bikes
+atualizam de novo a cada visita.
+"""
+import gzip
+import hashlib
+import os
+import sys
+
+
+def main():
+    if len(sys.argv) != 4:
+        print(__doc__)
+        sys.exit(1)
+    source, version, out_dir = sys.argv[1:]
+    with open(source, "rb") as f:
+        image = f.read()
+    if not image or image[0] != 0xE9:
+        sys.exit(f"{source}: não parece um firmware do ESP8266")
+
+    # mtime fixo: o mesmo .bin gera a mesma imagem (e o mesmo hash)
+    packed = gzip.compress(image, compresslevel=9, mtime=0)
+    name = f"bpr-{version}.bin.gz"
+    os.makedirs(out_dir, exist_ok=True)
+    with open(os.path.join(out_dir, name), "wb") as f:
+        f.write(packed)
+
+    # Manifesto por último: a bike nunca vê um manifesto sem a imagem
+    manifest = os.path.join(out_dir, "manifest.txt")
+    with open(manifest + ".tmp", "w") as f:
+        f.write(f"{version}\n/firmware/{name}\n{len(packed)}\n{hashlib.sha256(packed).hexdigest()}\n")
+    os.replace(manifest + ".tmp", manifest)
+
+    print(f"{source}: {len(image)} -> {len(packed)} bytes ({100 * len(packed) / len(image):.0f}%), "
+          f"manifesto em {manifest}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,17 @@
+#!/bin/bash
+# Compila o replay de traces no host (g++ 7+). Saída em tools/replay/build/
+set -e
+cd "$(dirname "$0")/../.."
+
+OUT=tools/replay/build
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++17 -O2 -Wall -Wno-unused-parameter -pthread -DPROFILE_STAGES=1"
+mkdir -p "$OUT"
+
+# Firmware inteiro (menos o gateway), com o heap contado por host_heap.cpp
+$CXX $FLAGS -Itools/host/include -Itools/host -Itools/common -Isrc \
+    src/*.cpp tools/host/host_arduino.cpp tools/host/host_heap.cpp \
+    tools/common/http_server.cpp tools/replay/replay.cpp \
+    -Wl,--wrap=malloc,--wrap=free -o "$OUT/replay"
+
+echo "ok: $OUT/replay tools/replay/traces/city_ride.bin"
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Gera os traces de referência (formato BPRT, ver src/trace_format.h) usados
+pelo replay. Determinístico: rodar de novo dá os mesmos bytes.
+
+    python3 tools/replay/make_traces.py tools/replay/traces
+
+city_ride     30 min pedalando na cidade (scan a cada 5 s) e chegada ao depósito
+depot_idle    chegada e 12 h parada no depósito (scan a cada 30 s)
+week_offline  7 dias, 2 passeios de 15 min por dia, sem passar pela base;
+              chega no fim com a semana inteira para enviar
+"""
+import os
+import random
+import struct
+import sys
+
+MAGIC = b"BPRT"
+VERSION = 1
+SCAN = 1
+REPEAT = 2
+DEPOT_SSID = "BPR-Deposito"
+CITY_APS = 4000
+ACTIVE_MS = 5000
+INACTIVE_MS = 30000
+
+
+def header():
+    return MAGIC + bytes([VERSION, 0, 0, 0])
+
+
+def scan(ticks, networks, adc, scan_ms=2100):
+    out = struct.pack("<BIHHB", SCAN, ticks, scan_ms, adc, len(networks))
+    for ssid, bssid, rssi, channel in networks:
+        raw = ssid.encode()
+        out += bytes([len(raw)]) + raw + bssid + struct.pack("<bBB", rssi, channel, 4)
+    return out
+
+
+def repeat(ticks, interval, count):
+    return struct.pack("<BIII", REPEAT, ticks, interval, count)
+
+
+def city_networks(position, rng):
+    # APs fixos numa rua circular; a bike vê os mais próximos
+    nets = []
+    for k in range(-5, 6):
+        ap = (position + k) % CITY_APS
+        if rng.random() < 0.25:
+            continue
+        ssid = "" if ap % 5 == 0 else "Rede-%d" % (ap % 700)
+        bssid = bytes([0x02, (ap >> 16) & 0xFF, (ap >> 8) & 0xFF, ap & 0xFF, 0x42, 0x01])
+        nets.append((ssid, bssid, -45 - 4 * abs(k) + rng.randint(-6, 6), 1 + ap % 11))
+    return nets
+
+
+def depot_networks():
+    nets = [(DEPOT_SSID, bytes([0x02, 0xDE, 0x70, 0, 0, 1]), -52, 6)]
+    for i in range(4):
+        nets.append(("Vizinho-%d" % i, bytes([0x02, 0xDE, 0x70, 0, 1, i]), -70 - 3 * i, 1 + i))
+    return nets
+
+
+class Trace:
+    def __init__(self, seed):
+        self.rng = random.Random(seed)
+        self.data = bytearray(header())
+        self.ticks = 1000
+        self.adc = 980
+        self.position = self.rng.randrange(CITY_APS)
+
+    def ride(self, scans):
+        for _ in range(scans):
+            self.position += self.rng.randint(0, 3)
+            self.data += scan(self.ticks, city_networks(self.position, self.rng), self.adc)
+            self.ticks += ACTIVE_MS
+            if self.rng.random() < 0.02:
+                self.adc -= 1
+
+    def depot(self, scans):
+        # Primeiro scan completo, o resto é igual: vira um REPEAT
+        self.data += scan(self.ticks, depot_networks(), self.adc)
+        self.ticks += INACTIVE_MS
+        if scans > 1:
+            self.data += repeat(self.ticks, INACTIVE_MS, scans - 1)
+            self.ticks += INACTIVE_MS * (scans - 1)
+
+    def pause(self, ms):
+        self.ticks += ms
+
+
+def city_ride():
+    t = Trace(1)
+    t.ride(360)
+    t.depot(10)
+    return t.data
+
+
+def depot_idle():
+    t = Trace(2)
+    t.ride(6)
+    t.depot(12 * 120)
+    return t.data
+
+
+def week_offline():
+    t = Trace(3)
+    day = 24 * 3600 * 1000
+    for _ in range(7):
+        start = t.ticks
+        t.pause(8 * 3600 * 1000)
+        t.ride(180)
+        t.pause(9 * 3600 * 1000)
+        t.ride(180)
+        t.ticks = start + day
+    t.depot(10)
+    return t.data
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    os.makedirs(sys.argv[1], exist_ok=True)
+    for name, build in (("city_ride", city_ride), ("depot_idle", depot_idle), ("week_offline", week_offline)):
+        path = os.path.join(sys.argv[1], name + ".bin")
+        data = build()
+        with open(path, "wb") as f:
+            f.write(data)
+        print("%s: %d bytes" % (path, len(data)))
+
+
+if __name__ == "__main__":
+    main()
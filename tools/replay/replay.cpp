@@ -0,0 +1,205 @@
+// Replay de um trace de scans (src/trace_format.h) pelo firmware de src/ no
+// host: cada registro vira o resultado do próximo WiFi.scanNetworks() e o
+// loop() roda de verdade, com LittleFS num diretório e upload para um
+// servidor falso embutido. Mede, por etapa do ciclo (profiler.h), o tempo de
+// CPU no host, o pico de heap, os bytes gravados no flash e os enviados.
+//
+//   replay <trace.bin> [--backend collector|firebase] [--base BPR-Deposito]
+//          [--dir /tmp/bpr-replay] [--port 8091] [--echo 0]
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "config.h"
+#include "host_env.h"
+#include "http_server.h"
+#include "profiler.h"
+#include "trace_format.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+void setup();
+void loop();
+extern int dataCount;
+
+struct Options {
+  std::string trace;
+  std::string backend = "collector";
+  std::string base = "BPR-Deposito";
+  std::string dir = "/tmp/bpr-replay";
+  int port = 8091;
+  bool echo = false;
+};
+
+static std::vector<HostNetwork> toHost(const TraceScan& scan) {
+  std::vector<HostNetwork> nets;
+  for (int i = 0; i < scan.count; i++) {
+    const TraceNetwork& n = scan.networks[i];
+    char bssid[18];
+    snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X", n.bssid[0], n.bssid[1], n.bssid[2],
+             n.bssid[3], n.bssid[4], n.bssid[5]);
+    nets.push_back({n.ssid, bssid, n.rssi, n.channel, n.encryption});
+  }
+  return nets;
+}
+
+static bool seesBase(const std::vector<HostNetwork>& nets, const std::string& base) {
+  for (const HostNetwork& n : nets) {
+    if (n.ssid == base) return true;
+  }
+  return false;
+}
+
+static void writeFile(const char* path, const std::string& content) {
+  File file = LittleFS.open(path, "w");
+  file.write((const uint8_t*)content.data(), content.size());
+  file.close();
+}
+
+static int filesLeft() {
+  int count = 0;
+  Dir dir = LittleFS.openDir("/");
+  while (dir.next()) {
+    if (dir.fileName().startsWith("scan_") || dir.fileName().startsWith("trip_")) count++;
+  }
+  return count;
+}
+
+static Options parseOptions(int argc, char** argv) {
+  Options o;
+  if (argc < 2) {
+    fprintf(stderr, "uso: replay <trace.bin> [--backend collector|firebase] [--base SSID] [--dir DIR] "
+                    "[--port 8091] [--echo 0]\n");
+    exit(1);
+  }
+  o.trace = argv[1];
+  for (int i = 2; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    const char* value = argv[i + 1];
+    if (key == "--backend") o.backend = value;
+    else if (key == "--base") o.base = value;
+    else if (key == "--dir") o.dir = value;
+    else if (key == "--port") o.port = atoi(value);
+    else if (key == "--echo") o.echo = atoi(value) != 0;
+    else {
+      fprintf(stderr, "opção desconhecida: %s\n", key.c_str());
+      exit(1);
+    }
+  }
+  return o;
+}
+
+static std::vector<uint8_t> readTrace(const std::string& path) {
+  std::vector<uint8_t> data;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return data;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return data;
+}
+
+// Um scan do trace: espera o intervalo gravado e roda o loop() até ele escanear.
+// Na base o relógio passa a correr em tempo real, para o upload ver a rede de
+// verdade; o tempo gasto no ciclo anterior vira atraso (drift), como no aparelho.
+static long long drift = 0;
+
+static void replayScan(const std::vector<HostNetwork>& nets, uint32_t ticks, const Options& o) {
+  hostSetScan(nets);
+  hostSetRealtime(seesBase(nets, o.base));
+  unsigned long target = ticks + drift + 1;
+  if (millis() < target) hostAdvance(target - millis());
+
+  unsigned long start = 0;
+  uint32_t scans = hostStats().scans;
+  while (hostStats().scans == scans) {
+    start = millis();
+    loop();
+  }
+  drift = (long long)start - ticks;
+}
+
+int main(int argc, char** argv) {
+  Options o = parseOptions(argc, argv);
+  std::vector<uint8_t> trace = readTrace(o.trace);
+  size_t pos = TRACE_HEADER_SIZE;
+  if (trace.size() < TRACE_HEADER_SIZE || memcmp(trace.data(), TRACE_MAGIC, 4) != 0) {
+    fprintf(stderr, "%s: não é um trace BPRT\n", o.trace.c_str());
+    return 1;
+  }
+
+  // Servidor falso: aceita tudo (Firebase REST e /ingest do coletor)
+  std::thread([&o] {
+    httpServe(o.port, [](const HttpRequest& request, HttpResponse& response) {
+      response.contentType = "application/json";
+      response.body = request.method == "POST" ? "{}" : request.body;
+    });
+  }).detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  hostSetRedirect("127.0.0.1", o.port);
+  hostSetSerialEcho(o.echo);
+  hostSetFsRoot(o.dir);
+  LittleFS.begin();
+  LittleFS.format();
+  writeFile("/bike.txt", "replay");
+  writeFile("/bases.txt", o.base + "\nsenha123\n\n\n\n");
+  writeFile("/firebase.txt", "https://replay.firebaseio.com\nchave-replay");
+  if (o.backend == "collector") writeFile("/collector.txt", "127.0.0.1:" + std::to_string(o.port));
+  uint64_t fsBase = hostStats().fsBytesWritten;
+
+  hostHeapTrackThread();
+  long long heapBase = hostHeapLive();
+
+  TraceScan* scan = new TraceScan();
+  std::vector<HostNetwork> last;
+  uint32_t records = 0, scans = 0;
+  bool started = false;
+  while (traceDecode(trace.data(), trace.size(), &pos, *scan)) {
+    records++;
+    if (scan->type == TRACE_SCAN) {
+      last = toHost(*scan);
+      hostSetBatteryAdc(scan->batteryAdc);
+      if (!started) {
+        // O primeiro scan é o do setup()
+        hostSetScan(last);
+        hostAdvance(scan->ticks);
+        setup();
+        drift = (long long)millis() - scan->ticks;
+        started = true;
+      } else {
+        replayScan(last, scan->ticks, o);
+      }
+      scans++;
+      continue;
+    }
+    for (uint32_t k = 0; k < scan->repeat && started; k++, scans++) {
+      replayScan(last, scan->ticks + k * scan->interval, o);
+    }
+  }
+  if (pos != trace.size()) fprintf(stderr, "aviso: trace truncado em %zu de %zu bytes\n", pos, trace.size());
+  delete scan;
+
+  const HostStats& s = hostStats();
+  printf("\n=== Replay: %s (%u registros, %u scans, %.1f h) ===\n", o.trace.c_str(), records, scans,
+         (millis() - drift) / 3600000.0);
+  printf("Backend %s | base %s\n", o.backend.c_str(), o.base.c_str());
+  printf("\nEtapa    chamadas   total ms   média us    máx us   (CPU do host)\n");
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    const StageStats& st = profileStats(i);
+    printf("%-7s %9u %10.1f %10.1f %9u\n", profileName(i), st.calls, st.totalUs / 1000.0,
+           st.calls ? (double)st.totalUs / st.calls : 0.0, st.maxUs);
+  }
+  printf("\nHeap: pico %lld bytes acima do início | heap livre mínimo %u\n", hostHeapPeak() - heapBase,
+         profileMinFreeHeap());
+  printf("Flash: %llu bytes gravados, %u arquivos criados, %u apagados, %d ainda pendentes\n",
+         (unsigned long long)(s.fsBytesWritten - fsBase), s.fsFilesCreated, s.fsFilesRemoved, filesLeft());
+  printf("Rede: %llu bytes enviados, %llu recebidos, %u conexões, %u handshakes TLS\n",
+         (unsigned long long)s.netBytesOut, (unsigned long long)s.netBytesIn, s.netConnects, s.tlsHandshakes);
+  return 0;
+}
@@ -0,0 +1,66 @@
+"""Relatório de RAM depois de cada build (extra_scripts do platformio.ini).
+
+Mostra o perfil de capacidade do env (src/capacity.h), o tamanho dos
+buffers que ele dimensiona e os maiores símbolos em .data/.bss do
+firmware.elf. Os limites do perfil já são conferidos na compilação
+(static_assert em src/capacity.cpp); aqui é só para acompanhar.
+
+Também roda fora do PlatformIO, direto sobre um .elf:
+
+    python3 tools/size_report.py .pio/build/nodemcuv2/firmware.elf
+"""
+import re
+import subprocess
+import sys
+
+PROFILES = ["low-memory", "standard", "survey-max"]
+PROFILE_SYMBOLS = ["networks", "connectionHistory", "batteryHistory", "logBuffer"]
+DRAM_BYTES = 81920
+TOP = 12
+
+
+def ram_symbols(nm, elf):
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", elf], capture_output=True, text=True, check=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in "bBdD":
+            symbols.append((parts[3], int(parts[1], 16)))
+    return symbols
+
+
+def report(nm, elf, profile):
+    symbols = ram_symbols(nm, elf)
+    total = sum(size for _, size in symbols)
+    print(f"\n=== RAM ({profile}) ===")
+    for name in PROFILE_SYMBOLS:
+        size = next((s for n, s in symbols if n == name), None)
+        if size is not None:
+            print(f"  {name:<24}{size:>7} B")
+    print(f"  {'.data + .bss':<24}{total:>7} B de {DRAM_BYTES} ({total * 100 // DRAM_BYTES}%)")
+    print(f"  maiores símbolos:")
+    for name, size in sorted(symbols, key=lambda s: -s[1])[:TOP]:
+        print(f"    {size:>7} B  {name[:60]}")
+
+
+def profile_of(defines):
+    for define in defines:
+        if isinstance(define, (list, tuple)) and define[0] == "CAPACITY_PROFILE":
+            value = str(define[1])
+            return PROFILES[int(value)] if value.isdigit() else value.replace("CAPACITY_", "").replace("_", "-").lower()
+    return "standard"
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    report("xtensa-lx106-elf-nm", sys.argv[1], "perfil do build")
+else:
+    Import("env")  # noqa: F821 (injetado pelo SCons do PlatformIO)
+
+    def after_elf(source, target, env):
+        nm = re.sub(r"gcc$", "nm", env.subst("$CC"))
+        report(nm, str(target[0]), profile_of(env.get("CPPDEFINES", [])))
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_elf)  # noqa: F821